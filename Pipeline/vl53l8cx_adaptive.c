@@ -0,0 +1,271 @@
+#include <string.h>
+
+#include "vl53l8cx_adaptive.h"
+#include "vl53l8cx_pipeline.h"
+
+/*
+ * Switch command, run by the acquisition thread while the ranging is stopped.
+ * Frames ready after this point have the new resolution.
+ */
+static uint8_t _vl53l8cx_adaptive_switch(
+		VL53L8CX_Configuration		*p_dev,
+		void				*p_arg)
+{
+	VL53L8CX_Adaptive *p_ad = (VL53L8CX_Adaptive *)p_arg;
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= vl53l8cx_set_resolution(p_dev, p_ad->resolution);
+	status |= vl53l8cx_set_ranging_frequency_hz(p_dev,
+			(p_ad->resolution == VL53L8CX_RESOLUTION_8X8)
+			? p_ad->config.frequency_8x8_hz
+			: p_ad->config.frequency_4x4_hz);
+	p_ad->t_switch_ns = vl53l8cx_capture_now_ns();
+
+	return status;
+}
+
+/*
+ * Nearest valid distance and variance of the valid distances of a frame.
+ * Returns 0 when no zone is valid.
+ */
+static uint8_t _vl53l8cx_adaptive_scene(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		int16_t				*p_nearest_mm,
+		uint32_t			*p_variance_mm2)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	int64_t sum = 0, sum_sq = 0;
+	uint64_t valid;
+	uint32_t nb_valid = 0, idx;
+	int16_t distance, nearest = INT16_MAX;
+	uint8_t zone, is_valid;
+
+	valid = vl53l8cx_valid_zones(p_results, nb_zones);
+	if (valid == 0U)
+	{
+		return 0;
+	}
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		idx = (uint32_t)zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		distance = p_results->distance_mm[idx];
+		is_valid = (uint8_t)((valid >> zone) & 1U);
+		if (!is_valid)
+		{
+			continue;
+		}
+		if (distance < nearest)
+		{
+			nearest = distance;
+		}
+		sum += distance;
+		sum_sq += (int64_t)distance * distance;
+		nb_valid++;
+	}
+
+	if (nb_valid == 0U)
+	{
+		return 0;
+	}
+	*p_nearest_mm = nearest;
+	*p_variance_mm2 = (uint32_t)((sum_sq - ((sum * sum) / nb_valid))
+		/ nb_valid);
+
+	return 1;
+#else
+	(void)p_results;
+	(void)nb_zones;
+	(void)p_nearest_mm;
+	(void)p_variance_mm2;
+
+	return 0;
+#endif
+}
+
+/* Queues a switch to the other resolution */
+static void _vl53l8cx_adaptive_submit(
+		VL53L8CX_Adaptive		*p_ad,
+		uint8_t				resolution)
+{
+	if (vl53l8cx_command_init_custom(&p_ad->command,
+			_vl53l8cx_adaptive_switch, p_ad, NULL, NULL)
+			!= VL53L8CX_STATUS_OK)
+	{
+		return;
+	}
+	p_ad->resolution = resolution;
+	p_ad->is_command_pending = 1;
+	vl53l8cx_capture_submit(p_ad->p_cap, &p_ad->command);
+}
+
+void vl53l8cx_adaptive_init(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_Capture		*p_cap,
+		const VL53L8CX_AdaptiveConfig	*p_config)
+{
+	(void)memset(p_ad, 0, sizeof(*p_ad));
+	p_ad->p_cap = p_cap;
+	if (p_config != NULL)
+	{
+		p_ad->config = *p_config;
+	}
+	else
+	{
+		p_ad->config.frequency_4x4_hz =
+			(uint8_t)VL53L8CX_ADAPTIVE_FREQUENCY_4X4_HZ;
+		p_ad->config.frequency_8x8_hz =
+			(uint8_t)VL53L8CX_ADAPTIVE_FREQUENCY_8X8_HZ;
+		p_ad->config.near_min_mm = VL53L8CX_ADAPTIVE_NEAR_MIN_MM;
+		p_ad->config.near_max_mm = VL53L8CX_ADAPTIVE_NEAR_MAX_MM;
+		p_ad->config.variance_mm2 = VL53L8CX_ADAPTIVE_VARIANCE_MM2;
+		p_ad->config.hysteresis_ms = VL53L8CX_ADAPTIVE_HYSTERESIS_MS;
+	}
+	p_ad->resolution = VL53L8CX_RESOLUTION_4X4;
+	p_ad->frame_resolution = VL53L8CX_RESOLUTION_4X4;
+}
+
+uint8_t vl53l8cx_adaptive_configure(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	p_ad->resolution = VL53L8CX_RESOLUTION_4X4;
+	p_ad->frame_resolution = VL53L8CX_RESOLUTION_4X4;
+	/* A change still pending was completed by vl53l8cx_capture_stop() */
+	if (p_ad->is_command_pending
+		&& vl53l8cx_command_wait(&p_ad->command, 0))
+	{
+		vl53l8cx_command_deinit(&p_ad->command);
+	}
+	p_ad->is_command_pending = 0;
+	p_ad->is_switching = 0;
+	p_ad->t_last_frame_ns = 0;
+	p_ad->t_retry_ns = 0;
+	status |= vl53l8cx_set_resolution(p_dev, VL53L8CX_RESOLUTION_4X4);
+	status |= vl53l8cx_set_ranging_frequency_hz(p_dev,
+			p_ad->config.frequency_4x4_hz);
+
+	return status;
+}
+
+uint8_t vl53l8cx_adaptive_update(
+		VL53L8CX_Adaptive		*p_ad,
+		const VL53L8CX_CaptureFrame	*p_frame)
+{
+	uint64_t t_ready_ns = p_frame->t_ready_ns, elapsed_ns;
+	uint32_t switch_us;
+	uint8_t is_trigger = 0;
+
+	if (p_ad->is_command_pending
+		&& vl53l8cx_command_wait(&p_ad->command, 0))
+	{
+		vl53l8cx_command_deinit(&p_ad->command);
+		p_ad->is_command_pending = 0;
+		if (p_ad->command.status == VL53L8CX_STATUS_OK)
+		{
+			p_ad->is_switching = 1;
+		}
+		else
+		{
+			/* Retry after a hysteresis interval, not on each frame */
+			p_ad->resolution = p_ad->frame_resolution;
+			p_ad->t_retry_ns = t_ready_ns
+				+ ((uint64_t)p_ad->config.hysteresis_ms
+					* 1000000U);
+		}
+	}
+
+	if (p_ad->is_switching && (t_ready_ns > p_ad->t_switch_ns))
+	{
+		/* First frame of the new resolution */
+		p_ad->is_switching = 0;
+		p_ad->frame_resolution = p_ad->resolution;
+		if (p_ad->resolution == VL53L8CX_RESOLUTION_8X8)
+		{
+			p_ad->report.switches_up++;
+		}
+		else
+		{
+			p_ad->report.switches_down++;
+		}
+		if (p_ad->t_last_frame_ns != 0U)
+		{
+			switch_us = (uint32_t)((t_ready_ns
+				- p_ad->t_last_frame_ns) / 1000U);
+			p_ad->report.last_switch_us = switch_us;
+			p_ad->report.total_switch_us += switch_us;
+			if (switch_us > p_ad->report.max_switch_us)
+			{
+				p_ad->report.max_switch_us = switch_us;
+			}
+		}
+		/* The new resolution gets a full hysteresis interval */
+		p_ad->t_last_trigger_ns = t_ready_ns;
+	}
+	else if ((p_ad->t_last_frame_ns != 0U)
+		&& (t_ready_ns > p_ad->t_last_frame_ns))
+	{
+		elapsed_ns = t_ready_ns - p_ad->t_last_frame_ns;
+		if (p_ad->frame_resolution == VL53L8CX_RESOLUTION_8X8)
+		{
+			p_ad->time_8x8_ns += elapsed_ns;
+		}
+		else
+		{
+			p_ad->time_4x4_ns += elapsed_ns;
+		}
+	}
+	p_ad->t_last_frame_ns = t_ready_ns;
+
+	if ((p_frame->status == VL53L8CX_STATUS_OK)
+		&& _vl53l8cx_adaptive_scene(&p_frame->results,
+			p_ad->frame_resolution, &p_ad->report.nearest_mm,
+			&p_ad->report.variance_mm2))
+	{
+		is_trigger = (uint8_t)(((p_ad->report.nearest_mm
+				>= p_ad->config.near_min_mm)
+			&& (p_ad->report.nearest_mm
+				<= p_ad->config.near_max_mm))
+			|| ((p_ad->config.variance_mm2 != 0U)
+			&& (p_ad->report.variance_mm2
+				> p_ad->config.variance_mm2)));
+	}
+	if (is_trigger)
+	{
+		p_ad->t_last_trigger_ns = t_ready_ns;
+	}
+
+	if (!p_ad->is_command_pending && !p_ad->is_switching
+		&& (t_ready_ns >= p_ad->t_retry_ns))
+	{
+		if ((p_ad->resolution == VL53L8CX_RESOLUTION_4X4) && is_trigger)
+		{
+			_vl53l8cx_adaptive_submit(p_ad,
+					VL53L8CX_RESOLUTION_8X8);
+		}
+		else if ((p_ad->resolution == VL53L8CX_RESOLUTION_8X8)
+			&& !is_trigger
+			&& ((t_ready_ns - p_ad->t_last_trigger_ns)
+				>= ((uint64_t)p_ad->config.hysteresis_ms
+					* 1000000U)))
+		{
+			_vl53l8cx_adaptive_submit(p_ad,
+					VL53L8CX_RESOLUTION_4X4);
+		}
+	}
+
+	return p_ad->frame_resolution;
+}
+
+void vl53l8cx_adaptive_get_report(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_AdaptiveReport		*p_report)
+{
+	*p_report = p_ad->report;
+	p_report->resolution = p_ad->frame_resolution;
+	p_report->time_8x8_ms = p_ad->time_8x8_ns / 1000000U;
+	p_report->time_4x4_ms = p_ad->time_4x4_ns / 1000000U;
+}
@@ -0,0 +1,148 @@
+#ifndef VL53L8CX_ADAPTIVE_H_
+#define VL53L8CX_ADAPTIVE_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_capture.h"
+#include "vl53l8cx_command.h"
+
+/**
+ * @brief Default policy: 4x4 at 60 Hz, 8x8 at 15 Hz when a target is closer
+ * than 1 m or when the distances spread, back to 4x4 after 1 s without
+ * either.
+ */
+
+#define VL53L8CX_ADAPTIVE_FREQUENCY_4X4_HZ	60U
+#define VL53L8CX_ADAPTIVE_FREQUENCY_8X8_HZ	15U
+#define VL53L8CX_ADAPTIVE_NEAR_MIN_MM		0
+#define VL53L8CX_ADAPTIVE_NEAR_MAX_MM		1000
+#define VL53L8CX_ADAPTIVE_VARIANCE_MM2		250000U
+#define VL53L8CX_ADAPTIVE_HYSTERESIS_MS		1000U
+
+/**
+ * @brief Structure VL53L8CX_AdaptiveConfig contains the switching policy.
+ */
+
+typedef struct
+{
+	/* Ranging frequency of each resolution, in Hz */
+	uint8_t			frequency_4x4_hz;
+	uint8_t			frequency_8x8_hz;
+	/* 8x8 is used while the nearest valid target is into this band */
+	int16_t			near_min_mm;
+	int16_t			near_max_mm;
+	/* 8x8 is used while the variance of the valid distances is above
+	 * this value, in mm^2. 0 disables the variance trigger */
+	uint32_t		variance_mm2;
+	/* Time without trigger before going back to 4x4, in ms */
+	uint32_t		hysteresis_ms;
+} VL53L8CX_AdaptiveConfig;
+
+/**
+ * @brief Structure VL53L8CX_AdaptiveReport contains the state of the engine
+ * and the cost of the switches. A switch costs the time between the last
+ * frame of the previous resolution and the first frame of the new one.
+ */
+
+typedef struct
+{
+	/* Resolution of the frames received now */
+	uint8_t			resolution;
+	/* Switches to 8x8 and back to 4x4 */
+	uint32_t		switches_up;
+	uint32_t		switches_down;
+	/* Frame gap of the last switch, longest one, and sum, in us */
+	uint32_t		last_switch_us;
+	uint32_t		max_switch_us;
+	uint64_t		total_switch_us;
+	/* Time spent in 8x8 and in 4x4, frame gaps excluded, in ms */
+	uint64_t		time_8x8_ms;
+	uint64_t		time_4x4_ms;
+	/* Statistics of the last frame */
+	int16_t			nearest_mm;
+	uint32_t		variance_mm2;
+} VL53L8CX_AdaptiveReport;
+
+/**
+ * @brief Structure VL53L8CX_Adaptive switches a capture engine between 4x4
+ * and 8x8 from the content of the frames. Switches are queued to the capture
+ * engine as a single command setting the resolution and the frequency, so the
+ * ranging is restarted once per switch.
+ */
+
+typedef struct
+{
+	VL53L8CX_Capture	*p_cap;
+	VL53L8CX_AdaptiveConfig	config;
+	/* Resolution requested to the sensor, and of the frames received */
+	uint8_t			resolution;
+	uint8_t			frame_resolution;
+	VL53L8CX_Command	command;
+	uint8_t			is_command_pending;
+	/* Data ready time of the last frame received, and of the last frame
+	 * meeting a trigger, in ns */
+	uint64_t		t_last_frame_ns;
+	uint64_t		t_last_trigger_ns;
+	/* Set when the next frame is the first one of a new resolution */
+	uint8_t			is_switching;
+	uint64_t		t_switch_ns;
+	/* No switch is queued before this time after a failed one, in ns */
+	uint64_t		t_retry_ns;
+	/* Time spent in each resolution, in ns */
+	uint64_t		time_8x8_ns;
+	uint64_t		time_4x4_ns;
+	VL53L8CX_AdaptiveReport	report;
+} VL53L8CX_Adaptive;
+
+/**
+ * @brief This function initializes the engine.
+ * @param (VL53L8CX_Adaptive) *p_ad : Engine structure.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine receiving the switches.
+ * @param (VL53L8CX_AdaptiveConfig) *p_config : Policy, or NULL to use the
+ * default one.
+ */
+
+void vl53l8cx_adaptive_init(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_Capture		*p_cap,
+		const VL53L8CX_AdaptiveConfig	*p_config);
+
+/**
+ * @brief This function sets the 4x4 resolution and its frequency. It must be
+ * called before vl53l8cx_capture_start().
+ * @param (VL53L8CX_Adaptive) *p_ad : Engine structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device, not ranging.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_adaptive_configure(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function evaluates a frame, and queues a switch when the policy
+ * asks for the other resolution. It is called by the consumer thread for each
+ * frame taken from the capture engine. Zones are valid when their target
+ * status is 5 or 9.
+ * @param (VL53L8CX_Adaptive) *p_ad : Engine structure.
+ * @param (VL53L8CX_CaptureFrame) *p_frame : Frame taken from the capture.
+ * @return (uint8_t) resolution : Resolution of the frame, to read its zones.
+ */
+
+uint8_t vl53l8cx_adaptive_update(
+		VL53L8CX_Adaptive		*p_ad,
+		const VL53L8CX_CaptureFrame	*p_frame);
+
+/**
+ * @brief This function gives the state of the engine and the cost of the
+ * switches.
+ * @param (VL53L8CX_Adaptive) *p_ad : Engine structure.
+ * @param (VL53L8CX_AdaptiveReport) *p_report : State and costs.
+ */
+
+void vl53l8cx_adaptive_get_report(
+		VL53L8CX_Adaptive		*p_ad,
+		VL53L8CX_AdaptiveReport		*p_report);
+
+#endif /* VL53L8CX_ADAPTIVE_H_ */
@@ -0,0 +1,340 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "vl53l8cx_capture.h"
+
+#define CAPTURE_RING_MASK	(VL53L8CX_CAPTURE_RING_SIZE - 1U)
+
+/*
+ * Acquisition thread. It is the only producer of the ring: a slot is written
+ * only while it is outside [tail, head), then published by incrementing head
+ * with release semantics. When the ring is full the frame is not read, and an
+ * overrun is counted, so a slow consumer never blocks the sensor path. The
+ * temporary buffer of the device is only held during each poll (see
+ * vl53l8cx_pool_begin()).
+ */
+static void *_vl53l8cx_capture_thread(void *arg)
+{
+	VL53L8CX_Capture *p_cap = (VL53L8CX_Capture *)arg;
+	const VL53L8CX_FrameStats *p_start = &p_cap->frame_stats_start;
+	const VL53L8CX_FrameStats *p_stats = &p_cap->p_dev->frame_stats;
+	VL53L8CX_CaptureFrame *p_slot;
+	uint8_t status, is_ready;
+	unsigned int head, tail, dropped, overruns;
+	uint64_t t_ready_ns;
+
+	while (atomic_load_explicit(&p_cap->running, memory_order_acquire))
+	{
+		if (vl53l8cx_pool_begin(p_cap->p_dev) != VL53L8CX_STATUS_OK)
+		{
+			atomic_fetch_add_explicit(&p_cap->read_errors, 1,
+					memory_order_relaxed);
+			(void)usleep(p_cap->poll_period_us);
+			continue;
+		}
+
+		atomic_fetch_add_explicit(&p_cap->commands_applied,
+				vl53l8cx_command_queue_apply(&p_cap->commands,
+					p_cap->p_dev, 1),
+				memory_order_relaxed);
+
+		is_ready = 0;
+		status = vl53l8cx_check_data_ready(p_cap->p_dev, &is_ready);
+		if (status != VL53L8CX_STATUS_OK)
+		{
+			atomic_fetch_add_explicit(&p_cap->read_errors, 1,
+					memory_order_relaxed);
+		}
+
+		if (!is_ready)
+		{
+			vl53l8cx_pool_end(p_cap->p_dev);
+			(void)usleep(p_cap->poll_period_us);
+			continue;
+		}
+		t_ready_ns = vl53l8cx_capture_now_ns();
+
+		head = atomic_load_explicit(&p_cap->head, memory_order_relaxed);
+		tail = atomic_load_explicit(&p_cap->tail, memory_order_acquire);
+		if ((head - tail) >= VL53L8CX_CAPTURE_RING_SIZE)
+		{
+			atomic_fetch_add_explicit(&p_cap->overruns, 1,
+					memory_order_relaxed);
+			vl53l8cx_pool_end(p_cap->p_dev);
+			continue;
+		}
+
+		p_slot = &p_cap->slots[head & CAPTURE_RING_MASK];
+		p_slot->t_ready_ns = t_ready_ns;
+		p_slot->status = vl53l8cx_read_ranging_data(p_cap->p_dev);
+		p_slot->t_read_ns = vl53l8cx_capture_now_ns();
+		if (p_slot->status == VL53L8CX_STATUS_OK)
+		{
+			p_slot->status = vl53l8cx_decode_ranging_data(
+					p_cap->p_dev, &p_slot->results);
+		}
+		if (p_slot->status == VL53L8CX_STATUS_CORRUPTED_FRAME)
+		{
+			p_slot->status = vl53l8cx_reread_ranging_data(
+					p_cap->p_dev, &p_slot->results);
+		}
+		vl53l8cx_pool_end(p_cap->p_dev);
+		p_slot->t_decoded_ns = vl53l8cx_capture_now_ns();
+		p_slot->t_handoff_ns = 0;
+		p_slot->streamcount = p_cap->p_dev->streamcount;
+		if (p_slot->status != VL53L8CX_STATUS_OK)
+		{
+			atomic_fetch_add_explicit(&p_cap->read_errors, 1,
+					memory_order_relaxed);
+		}
+
+		/* The frames not read on overruns are also seen as dropped by
+		 * the driver, they are only counted as overruns */
+		dropped = p_stats->frames_dropped - p_start->frames_dropped;
+		overruns = atomic_load_explicit(&p_cap->overruns,
+				memory_order_relaxed);
+		atomic_store_explicit(&p_cap->frames_dropped,
+				(dropped > overruns) ? (dropped - overruns) : 0U,
+				memory_order_relaxed);
+		atomic_store_explicit(&p_cap->frames_corrupted,
+				p_stats->frames_corrupted
+				- p_start->frames_corrupted,
+				memory_order_relaxed);
+		atomic_store_explicit(&p_cap->frames_late,
+				p_stats->frames_late - p_start->frames_late,
+				memory_order_relaxed);
+
+		atomic_store_explicit(&p_cap->head, head + 1U,
+				memory_order_release);
+		atomic_fetch_add_explicit(&p_cap->frames_captured, 1,
+				memory_order_relaxed);
+		(void)sem_post(&p_cap->frames_posted);
+	}
+
+	return NULL;
+}
+
+uint8_t vl53l8cx_capture_init(
+		VL53L8CX_Capture		*p_cap)
+{
+	(void)memset(p_cap, 0, sizeof(*p_cap));
+	vl53l8cx_command_queue_init(&p_cap->commands);
+	if (sem_init(&p_cap->frames_posted, 0, 0) != 0)
+	{
+		return VL53L8CX_STATUS_ERROR;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+void vl53l8cx_capture_deinit(
+		VL53L8CX_Capture		*p_cap)
+{
+	(void)sem_destroy(&p_cap->frames_posted);
+}
+
+uint8_t vl53l8cx_capture_start(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			poll_period_us)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	p_cap->p_dev = p_dev;
+	p_cap->poll_period_us = (poll_period_us != 0U)
+		? poll_period_us : VL53L8CX_CAPTURE_POLL_PERIOD_US;
+	atomic_init(&p_cap->head, 0U);
+	atomic_init(&p_cap->tail, 0U);
+	atomic_init(&p_cap->frames_captured, 0U);
+	atomic_init(&p_cap->overruns, 0U);
+	atomic_init(&p_cap->read_errors, 0U);
+	atomic_init(&p_cap->frames_skipped, 0U);
+	p_cap->frame_stats_start = p_dev->frame_stats;
+	atomic_init(&p_cap->frames_dropped, 0U);
+	atomic_init(&p_cap->frames_corrupted, 0U);
+	atomic_init(&p_cap->frames_late, 0U);
+	atomic_init(&p_cap->commands_applied, 0U);
+	atomic_init(&p_cap->running, 1);
+
+	/* Forget the wakeups of the previous session */
+	while (sem_trywait(&p_cap->frames_posted) == 0)
+	{
+	}
+
+	status |= vl53l8cx_pool_begin(p_dev);
+	if (status == VL53L8CX_STATUS_OK)
+	{
+		status |= vl53l8cx_start_ranging(p_dev);
+	}
+	vl53l8cx_pool_end(p_dev);
+	if (status != VL53L8CX_STATUS_OK)
+	{
+		return status;
+	}
+
+	if (pthread_create(&p_cap->thread, NULL,
+			_vl53l8cx_capture_thread, p_cap) != 0)
+	{
+		if (vl53l8cx_pool_begin(p_dev) == VL53L8CX_STATUS_OK)
+		{
+			(void)vl53l8cx_stop_ranging(p_dev);
+		}
+		vl53l8cx_pool_end(p_dev);
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_capture_stop(
+		VL53L8CX_Capture		*p_cap)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	atomic_store_explicit(&p_cap->running, 0, memory_order_release);
+	(void)pthread_join(p_cap->thread, NULL);
+	status |= vl53l8cx_pool_begin(p_cap->p_dev);
+	if (status == VL53L8CX_STATUS_OK)
+	{
+		status |= vl53l8cx_stop_ranging(p_cap->p_dev);
+	}
+	vl53l8cx_pool_end(p_cap->p_dev);
+	(void)vl53l8cx_command_queue_cancel(&p_cap->commands,
+			VL53L8CX_STATUS_ERROR);
+	(void)sem_post(&p_cap->frames_posted);
+
+	return status;
+}
+
+void vl53l8cx_capture_submit(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_Command		*p_cmd)
+{
+	vl53l8cx_command_queue_push(&p_cap->commands, p_cmd);
+}
+
+uint8_t vl53l8cx_capture_wait(
+		VL53L8CX_Capture		*p_cap,
+		uint32_t			timeout_ms)
+{
+	struct timespec ts;
+	int ret;
+
+	(void)clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += (time_t)(timeout_ms / 1000U);
+	ts.tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	do {
+		ret = sem_timedwait(&p_cap->frames_posted, &ts);
+	} while ((ret != 0) && (errno == EINTR));
+
+	return (ret == 0) ? 1U : 0U;
+}
+
+uint8_t vl53l8cx_capture_pop(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_CaptureFrame		*p_frame)
+{
+	const VL53L8CX_CaptureFrame *p_slot;
+
+	p_slot = vl53l8cx_capture_peek(p_cap);
+	if (p_slot == NULL)
+	{
+		return 0;
+	}
+
+	(void)memcpy(p_frame, p_slot, sizeof(*p_frame));
+	vl53l8cx_capture_release(p_cap);
+
+	return 1;
+}
+
+const VL53L8CX_CaptureFrame *vl53l8cx_capture_peek(
+		VL53L8CX_Capture		*p_cap)
+{
+	VL53L8CX_CaptureFrame *p_slot;
+	unsigned int head, tail;
+
+	tail = atomic_load_explicit(&p_cap->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&p_cap->head, memory_order_acquire);
+	if (head == tail)
+	{
+		return NULL;
+	}
+
+	p_slot = &p_cap->slots[tail & CAPTURE_RING_MASK];
+	if (p_slot->t_handoff_ns == 0U)
+	{
+		p_slot->t_handoff_ns = vl53l8cx_capture_now_ns();
+	}
+
+	return p_slot;
+}
+
+const VL53L8CX_CaptureFrame *vl53l8cx_capture_peek_latest(
+		VL53L8CX_Capture		*p_cap)
+{
+	VL53L8CX_CaptureFrame *p_slot;
+	unsigned int head, tail;
+
+	tail = atomic_load_explicit(&p_cap->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&p_cap->head, memory_order_acquire);
+	if (head == tail)
+	{
+		return NULL;
+	}
+
+	/* Hand older slots back to the producer */
+	if ((head - tail) > 1U)
+	{
+		atomic_fetch_add_explicit(&p_cap->frames_skipped,
+				head - tail - 1U, memory_order_relaxed);
+		atomic_store_explicit(&p_cap->tail, head - 1U,
+				memory_order_release);
+	}
+
+	p_slot = &p_cap->slots[(head - 1U) & CAPTURE_RING_MASK];
+	if (p_slot->t_handoff_ns == 0U)
+	{
+		p_slot->t_handoff_ns = vl53l8cx_capture_now_ns();
+	}
+
+	return p_slot;
+}
+
+void vl53l8cx_capture_release(
+		VL53L8CX_Capture		*p_cap)
+{
+	unsigned int tail;
+
+	tail = atomic_load_explicit(&p_cap->tail, memory_order_relaxed);
+	atomic_store_explicit(&p_cap->tail, tail + 1U, memory_order_release);
+}
+
+void vl53l8cx_capture_get_stats(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_CaptureStats		*p_stats)
+{
+	p_stats->frames_captured = atomic_load_explicit(
+			&p_cap->frames_captured, memory_order_relaxed);
+	p_stats->overruns = atomic_load_explicit(
+			&p_cap->overruns, memory_order_relaxed);
+	p_stats->frames_skipped = atomic_load_explicit(
+			&p_cap->frames_skipped, memory_order_relaxed);
+	p_stats->read_errors = atomic_load_explicit(
+			&p_cap->read_errors, memory_order_relaxed);
+	p_stats->frames_dropped = atomic_load_explicit(
+			&p_cap->frames_dropped, memory_order_relaxed);
+	p_stats->frames_corrupted = atomic_load_explicit(
+			&p_cap->frames_corrupted, memory_order_relaxed);
+	p_stats->frames_late = atomic_load_explicit(
+			&p_cap->frames_late, memory_order_relaxed);
+	p_stats->commands_applied = atomic_load_explicit(
+			&p_cap->commands_applied, memory_order_relaxed);
+}
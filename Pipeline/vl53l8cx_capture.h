@@ -0,0 +1,279 @@
+#ifndef VL53L8CX_CAPTURE_H_
+#define VL53L8CX_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_command.h"
+#include "vl53l8cx_pool.h"
+
+/**
+ * @brief Number of frame slots into the capture ring. Must be a power of 2.
+ * All slots are preallocated into the VL53L8CX_Capture structure.
+ */
+
+#define VL53L8CX_CAPTURE_RING_SIZE		8U
+
+/**
+ * @brief Default period used by the acquisition thread to poll the sensor
+ * when no frame is ready, in microseconds.
+ */
+
+#define VL53L8CX_CAPTURE_POLL_PERIOD_US		1000U
+
+/**
+ * @brief Structure VL53L8CX_CaptureFrame contains one decoded frame, as pushed
+ * into the ring by the acquisition thread.
+ */
+
+typedef struct
+{
+	/* CLOCK_MONOTONIC time when data ready was detected, in ns */
+	uint64_t		t_ready_ns;
+	/* CLOCK_MONOTONIC time when the SPI read completed, in ns */
+	uint64_t		t_read_ns;
+	/* CLOCK_MONOTONIC time when the decoding completed, in ns */
+	uint64_t		t_decoded_ns;
+	/* CLOCK_MONOTONIC time when the frame was handed to the consumer, in ns.
+	 * Set by vl53l8cx_capture_pop() and vl53l8cx_capture_peek*() */
+	uint64_t		t_handoff_ns;
+	/* Sensor streamcount of this frame */
+	uint8_t			streamcount;
+	/* Status returned by vl53l8cx_get_ranging_data() */
+	uint8_t			status;
+	/* Decoded ranging results */
+	VL53L8CX_ResultsData	results;
+} VL53L8CX_CaptureFrame;
+
+/**
+ * @brief Structure VL53L8CX_CaptureStats contains the capture engine counters.
+ */
+
+typedef struct
+{
+	/* Frames pushed into the ring */
+	uint32_t		frames_captured;
+	/* Frames not read because the ring was full */
+	uint32_t		overruns;
+	/* Frames discarded by the consumer to reach the latest one */
+	uint32_t		frames_skipped;
+	/* Failed bus accesses (data ready check or frame read) */
+	uint32_t		read_errors;
+	/* Driver frames accounting since vl53l8cx_capture_start(), see
+	 * VL53L8CX_FrameStats. The overruns are not counted as dropped */
+	uint32_t		frames_dropped;
+	uint32_t		frames_corrupted;
+	uint32_t		frames_late;
+	/* Commands applied by the acquisition thread */
+	uint32_t		commands_applied;
+} VL53L8CX_CaptureStats;
+
+/**
+ * @brief Structure VL53L8CX_Capture is the capture engine. The acquisition
+ * thread owns the device between vl53l8cx_capture_start() and
+ * vl53l8cx_capture_stop(): no other thread may access it meanwhile, the
+ * configuration is changed through vl53l8cx_capture_submit(). Frames are
+ * exchanged through a lock-free single-producer/single-consumer ring: the
+ * acquisition thread is the only producer, and a single consumer thread may
+ * call vl53l8cx_capture_pop(), vl53l8cx_capture_peek*() and
+ * vl53l8cx_capture_release().
+ */
+
+typedef struct
+{
+	/* Device driven by the acquisition thread */
+	VL53L8CX_Configuration	*p_dev;
+	/* Polling period when no frame is ready, in us */
+	uint32_t		poll_period_us;
+	pthread_t		thread;
+	atomic_int		running;
+	/* Posted for each frame pushed, used by vl53l8cx_capture_wait() */
+	sem_t			frames_posted;
+	/* Next slot written by the producer */
+	_Alignas(64) atomic_uint head;
+	/* Next slot read by the consumer */
+	_Alignas(64) atomic_uint tail;
+	/* Counters, see VL53L8CX_CaptureStats */
+	_Alignas(64) atomic_uint frames_captured;
+	atomic_uint		overruns;
+	atomic_uint		read_errors;
+	atomic_uint		frames_skipped;
+	/* Driver frames accounting when the engine was started */
+	VL53L8CX_FrameStats	frame_stats_start;
+	/* Driver frames accounting since the start, published after each
+	 * frame */
+	atomic_uint		frames_dropped;
+	atomic_uint		frames_corrupted;
+	atomic_uint		frames_late;
+	atomic_uint		commands_applied;
+	/* Configuration changes, applied by the acquisition thread */
+	VL53L8CX_CommandQueue	commands;
+	/* Preallocated frame slots */
+	VL53L8CX_CaptureFrame	slots[VL53L8CX_CAPTURE_RING_SIZE];
+} VL53L8CX_Capture;
+
+/**
+ * @brief This function returns the current CLOCK_MONOTONIC time, used to
+ * timestamp each stage of a frame.
+ * @return (uint64_t) time : Monotonic time in ns.
+ */
+
+static inline uint64_t vl53l8cx_capture_now_ns(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * (uint64_t)1000000000U)
+		+ (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief This function converts a CLOCK_MONOTONIC time into a deadline for the
+ * functions sleeping until an absolute time.
+ * @param (uint64_t) t_ns : Monotonic time in ns.
+ * @param (struct timespec) *p_ts : Deadline.
+ */
+
+static inline void vl53l8cx_capture_to_timespec(
+		uint64_t			t_ns,
+		struct timespec			*p_ts)
+{
+	p_ts->tv_sec = (time_t)(t_ns / 1000000000U);
+	p_ts->tv_nsec = (long)(t_ns % 1000000000U);
+}
+
+/**
+ * @brief This function initializes the capture engine. It is called once,
+ * before the first vl53l8cx_capture_start().
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_capture_init(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function releases the resources of the capture engine. The
+ * engine must be stopped.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ */
+
+void vl53l8cx_capture_deinit(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function starts a ranging session on the device, and starts the
+ * acquisition thread. The engine must be initialized, and the device
+ * initialized and configured before.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint32_t) poll_period_us : Polling period when no frame is ready.
+ * Set to 0 to use VL53L8CX_CAPTURE_POLL_PERIOD_US.
+ * @return (uint8_t) status : 0 if the engine is started.
+ */
+
+uint8_t vl53l8cx_capture_start(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			poll_period_us);
+
+/**
+ * @brief This function stops the acquisition thread and the ranging session.
+ * Frames still into the ring can be consumed after this call. Commands still
+ * queued are completed with VL53L8CX_STATUS_ERROR, without being applied.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @return (uint8_t) status : 0 if the engine is stopped.
+ */
+
+uint8_t vl53l8cx_capture_stop(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function queues a configuration change. It can be called from
+ * any thread and never blocks: the acquisition thread applies the queued
+ * commands between two frames, restarting the ranging once per batch. The
+ * command completes through vl53l8cx_command_wait() or its callback. Commands
+ * queued when the engine stops are cancelled by vl53l8cx_capture_stop().
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @param (VL53L8CX_Command) *p_cmd : Prepared command, see
+ * vl53l8cx_command_init().
+ */
+
+void vl53l8cx_capture_submit(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_Command		*p_cmd);
+
+/**
+ * @brief This function waits until a frame is pushed, or until the timeout
+ * expires. It never blocks the acquisition thread.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @param (uint32_t) timeout_ms : Maximum time to wait.
+ * @return (uint8_t) is_ready : 1 if a frame may be available, 0 on timeout.
+ */
+
+uint8_t vl53l8cx_capture_wait(
+		VL53L8CX_Capture		*p_cap,
+		uint32_t			timeout_ms);
+
+/**
+ * @brief This function copies the oldest frame of the ring and releases it.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @param (VL53L8CX_CaptureFrame) *p_frame : Copied frame.
+ * @return (uint8_t) is_ready : 1 if a frame was copied, 0 if the ring is
+ * empty.
+ */
+
+uint8_t vl53l8cx_capture_pop(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_CaptureFrame		*p_frame);
+
+/**
+ * @brief This function gives access to the oldest frame of the ring without
+ * copying it. The frame stays valid until vl53l8cx_capture_release() is
+ * called.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @return (VL53L8CX_CaptureFrame*) p_frame : Oldest frame, or NULL if the ring
+ * is empty.
+ */
+
+const VL53L8CX_CaptureFrame *vl53l8cx_capture_peek(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function gives access to the latest frame of the ring without
+ * copying it. Older frames are discarded and counted as skipped. The frame
+ * stays valid until vl53l8cx_capture_release() is called.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @return (VL53L8CX_CaptureFrame*) p_frame : Latest frame, or NULL if the ring
+ * is empty.
+ */
+
+const VL53L8CX_CaptureFrame *vl53l8cx_capture_peek_latest(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function releases the frame returned by the last call to
+ * vl53l8cx_capture_peek() or vl53l8cx_capture_peek_latest(), so that its slot
+ * can be reused by the acquisition thread.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ */
+
+void vl53l8cx_capture_release(
+		VL53L8CX_Capture		*p_cap);
+
+/**
+ * @brief This function reads the capture engine counters. It can be called
+ * from any thread while the engine runs.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine structure.
+ * @param (VL53L8CX_CaptureStats) *p_stats : Counters values.
+ */
+
+void vl53l8cx_capture_get_stats(
+		VL53L8CX_Capture		*p_cap,
+		VL53L8CX_CaptureStats		*p_stats);
+
+#endif /* VL53L8CX_CAPTURE_H_ */
@@ -0,0 +1,304 @@
+#define _GNU_SOURCE	/* sem_clockwait() */
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "vl53l8cx_command.h"
+
+/*
+ * Takes the oldest command out of the queue (Vyukov intrusive MPSC queue).
+ * Returns NULL when the queue is empty, or when a producer has swapped the
+ * head but not linked its command yet: that command is taken by the next
+ * call.
+ */
+static VL53L8CX_Command *_vl53l8cx_command_queue_pop(
+		VL53L8CX_CommandQueue		*p_queue)
+{
+	VL53L8CX_CommandNode *p_tail = p_queue->tail;
+	VL53L8CX_CommandNode *p_next;
+
+	p_next = atomic_load_explicit(&p_tail->next, memory_order_acquire);
+	if (p_tail == &p_queue->stub)
+	{
+		if (p_next == NULL)
+		{
+			return NULL;
+		}
+		p_queue->tail = p_next;
+		p_tail = p_next;
+		p_next = atomic_load_explicit(&p_tail->next,
+				memory_order_acquire);
+	}
+	if (p_next != NULL)
+	{
+		p_queue->tail = p_next;
+		return (VL53L8CX_Command *)p_tail;
+	}
+
+	if (p_tail != atomic_load_explicit(&p_queue->head,
+			memory_order_acquire))
+	{
+		return NULL;
+	}
+
+	/* Last command: push the stub behind it so it can be taken */
+	atomic_store_explicit(&p_queue->stub.next, NULL, memory_order_relaxed);
+	p_next = atomic_exchange_explicit(&p_queue->head, &p_queue->stub,
+			memory_order_acq_rel);
+	atomic_store_explicit(&p_next->next, &p_queue->stub,
+			memory_order_release);
+	p_next = atomic_load_explicit(&p_tail->next, memory_order_acquire);
+	if (p_next != NULL)
+	{
+		p_queue->tail = p_next;
+		return (VL53L8CX_Command *)p_tail;
+	}
+
+	return NULL;
+}
+
+/* Runs the setter of a command */
+static uint8_t _vl53l8cx_command_run(
+		VL53L8CX_Command		*p_cmd,
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	switch (p_cmd->type)
+	{
+		case VL53L8CX_COMMAND_RESOLUTION:
+			status |= vl53l8cx_set_resolution(p_dev,
+					(uint8_t)p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_FREQUENCY_HZ:
+			status |= vl53l8cx_set_ranging_frequency_hz(p_dev,
+					(uint8_t)p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_INTEGRATION_TIME_MS:
+			status |= vl53l8cx_set_integration_time_ms(p_dev,
+					p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_SHARPENER_PERCENT:
+			status |= vl53l8cx_set_sharpener_percent(p_dev,
+					(uint8_t)p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_TARGET_ORDER:
+			status |= vl53l8cx_set_target_order(p_dev,
+					(uint8_t)p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_RANGING_MODE:
+			status |= vl53l8cx_set_ranging_mode(p_dev,
+					(uint8_t)p_cmd->value);
+			break;
+		case VL53L8CX_COMMAND_CUSTOM:
+			status |= p_cmd->custom(p_dev, p_cmd->p_arg);
+			break;
+		default:
+			status |= VL53L8CX_STATUS_INVALID_PARAM;
+			break;
+	}
+
+	return status;
+}
+
+/*
+ * Completes a command. This is the last access to it: once the post is taken
+ * or the callback is called, the owner may reuse or free the command.
+ */
+static void _vl53l8cx_command_complete(
+		VL53L8CX_Command		*p_cmd,
+		uint8_t				status)
+{
+	VL53L8CX_CommandDone done = p_cmd->done;
+
+	p_cmd->status = status;
+	if (done != NULL)
+	{
+		done(p_cmd, p_cmd->p_user);
+	}
+	else
+	{
+		(void)sem_post(&p_cmd->applied);
+	}
+}
+
+uint8_t vl53l8cx_command_init(
+		VL53L8CX_Command		*p_cmd,
+		uint8_t				type,
+		uint32_t			value,
+		VL53L8CX_CommandDone		done,
+		void				*p_user)
+{
+	if (type > VL53L8CX_COMMAND_CUSTOM)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	(void)memset(p_cmd, 0, sizeof(*p_cmd));
+	p_cmd->type = type;
+	p_cmd->value = value;
+	p_cmd->done = done;
+	p_cmd->p_user = p_user;
+	atomic_init(&p_cmd->node.next, NULL);
+	if (sem_init(&p_cmd->applied, 0, 0) != 0)
+	{
+		return VL53L8CX_STATUS_ERROR;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_command_init_custom(
+		VL53L8CX_Command		*p_cmd,
+		VL53L8CX_CommandFn		custom,
+		void				*p_arg,
+		VL53L8CX_CommandDone		done,
+		void				*p_user)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if (custom == NULL)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	status |= vl53l8cx_command_init(p_cmd, VL53L8CX_COMMAND_CUSTOM, 0,
+			done, p_user);
+	p_cmd->custom = custom;
+	p_cmd->p_arg = p_arg;
+
+	return status;
+}
+
+void vl53l8cx_command_deinit(
+		VL53L8CX_Command		*p_cmd)
+{
+	(void)sem_destroy(&p_cmd->applied);
+}
+
+uint8_t vl53l8cx_command_wait(
+		VL53L8CX_Command		*p_cmd,
+		uint32_t			timeout_ms)
+{
+	struct timespec ts;
+	int ret;
+
+	if (p_cmd->is_done)
+	{
+		return 1;
+	}
+
+	if (timeout_ms == 0U)
+	{
+		ret = sem_trywait(&p_cmd->applied);
+	}
+	else
+	{
+		(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+		ts.tv_sec += (time_t)(timeout_ms / 1000U);
+		ts.tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L)
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+
+		do {
+			ret = sem_clockwait(&p_cmd->applied, CLOCK_MONOTONIC,
+					&ts);
+		} while ((ret != 0) && (errno == EINTR));
+	}
+
+	if (ret == 0)
+	{
+		p_cmd->is_done = 1;
+	}
+
+	return p_cmd->is_done;
+}
+
+void vl53l8cx_command_queue_init(
+		VL53L8CX_CommandQueue		*p_queue)
+{
+	atomic_init(&p_queue->stub.next, NULL);
+	atomic_init(&p_queue->head, &p_queue->stub);
+	p_queue->tail = &p_queue->stub;
+}
+
+void vl53l8cx_command_queue_push(
+		VL53L8CX_CommandQueue		*p_queue,
+		VL53L8CX_Command		*p_cmd)
+{
+	VL53L8CX_CommandNode *p_prev;
+
+	atomic_store_explicit(&p_cmd->node.next, NULL, memory_order_relaxed);
+	p_prev = atomic_exchange_explicit(&p_queue->head, &p_cmd->node,
+			memory_order_acq_rel);
+	atomic_store_explicit(&p_prev->next, &p_cmd->node,
+			memory_order_release);
+}
+
+uint32_t vl53l8cx_command_queue_apply(
+		VL53L8CX_CommandQueue		*p_queue,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				is_ranging)
+{
+	VL53L8CX_Command *p_first, *p_last, *p_cmd, *p_next;
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint32_t nb_applied = 0;
+
+	p_first = _vl53l8cx_command_queue_pop(p_queue);
+	if (p_first == NULL)
+	{
+		return 0;
+	}
+
+	/* Apply the whole batch with a single restart */
+	if (is_ranging)
+	{
+		status |= vl53l8cx_stop_ranging(p_dev);
+	}
+	p_last = NULL;
+	for (p_cmd = p_first; p_cmd != NULL;
+			p_cmd = _vl53l8cx_command_queue_pop(p_queue))
+	{
+		p_cmd->status = _vl53l8cx_command_run(p_cmd, p_dev);
+		p_cmd->p_batch_next = NULL;
+		if (p_last != NULL)
+		{
+			p_last->p_batch_next = p_cmd;
+		}
+		p_last = p_cmd;
+	}
+	if (is_ranging)
+	{
+		status |= vl53l8cx_start_ranging(p_dev);
+	}
+
+	for (p_cmd = p_first; p_cmd != NULL; p_cmd = p_next)
+	{
+		p_next = p_cmd->p_batch_next;
+		_vl53l8cx_command_complete(p_cmd, p_cmd->status | status);
+		nb_applied++;
+	}
+
+	return nb_applied;
+}
+
+uint32_t vl53l8cx_command_queue_cancel(
+		VL53L8CX_CommandQueue		*p_queue,
+		uint8_t				status)
+{
+	VL53L8CX_Command *p_cmd;
+	uint32_t nb_cancelled = 0;
+
+	for (p_cmd = _vl53l8cx_command_queue_pop(p_queue); p_cmd != NULL;
+			p_cmd = _vl53l8cx_command_queue_pop(p_queue))
+	{
+		_vl53l8cx_command_complete(p_cmd, status);
+		nb_cancelled++;
+	}
+
+	return nb_cancelled;
+}
@@ -0,0 +1,206 @@
+#ifndef VL53L8CX_COMMAND_H_
+#define VL53L8CX_COMMAND_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Configuration changes which can be queued. VL53L8CX_COMMAND_CUSTOM
+ * runs any function of the driver, given by the command.
+ */
+
+#define VL53L8CX_COMMAND_RESOLUTION		((uint8_t) 0U)
+#define VL53L8CX_COMMAND_FREQUENCY_HZ		((uint8_t) 1U)
+#define VL53L8CX_COMMAND_INTEGRATION_TIME_MS	((uint8_t) 2U)
+#define VL53L8CX_COMMAND_SHARPENER_PERCENT	((uint8_t) 3U)
+#define VL53L8CX_COMMAND_TARGET_ORDER		((uint8_t) 4U)
+#define VL53L8CX_COMMAND_RANGING_MODE		((uint8_t) 5U)
+#define VL53L8CX_COMMAND_CUSTOM			((uint8_t) 6U)
+
+struct VL53L8CX_Command;
+
+/**
+ * @brief Function run by a VL53L8CX_COMMAND_CUSTOM command, from the thread
+ * owning the device.
+ */
+
+typedef uint8_t (*VL53L8CX_CommandFn)(
+		VL53L8CX_Configuration		*p_dev,
+		void				*p_arg);
+
+/**
+ * @brief Callback called from the thread owning the device when a command is
+ * applied. It replaces vl53l8cx_command_wait(): the command is not accessed
+ * after the callback, so it can be reused or freed by the callback.
+ */
+
+typedef void (*VL53L8CX_CommandDone)(
+		struct VL53L8CX_Command		*p_cmd,
+		void				*p_user);
+
+/**
+ * @brief Structure VL53L8CX_CommandNode links the commands of a queue.
+ */
+
+typedef struct VL53L8CX_CommandNode
+{
+	_Atomic(struct VL53L8CX_CommandNode *) next;
+} VL53L8CX_CommandNode;
+
+/**
+ * @brief Structure VL53L8CX_Command is a configuration change, allocated by
+ * the caller. It is also the future of the change: its status is valid once
+ * vl53l8cx_command_wait() returns 1 or the done callback is called. A command
+ * must not be modified while it is queued, and the thread applying it does not
+ * access it anymore once it has completed.
+ */
+
+typedef struct VL53L8CX_Command
+{
+	/* Must stay the first field, see VL53L8CX_CommandQueue */
+	VL53L8CX_CommandNode	node;
+	/* One of VL53L8CX_COMMAND_* */
+	uint8_t			type;
+	/* Value given to the setter of the command */
+	uint32_t		value;
+	/* Function and argument of a VL53L8CX_COMMAND_CUSTOM command */
+	VL53L8CX_CommandFn	custom;
+	void			*p_arg;
+	/* Completion callback, or NULL */
+	VL53L8CX_CommandDone	done;
+	void			*p_user;
+	/* Status of the change, including the restart of the ranging */
+	uint8_t			status;
+	/* Posted when a command without callback is applied */
+	sem_t			applied;
+	/* Set by vl53l8cx_command_wait() once it has taken the post */
+	uint8_t			is_done;
+	/* Link to the next command of the batch being applied, internal use */
+	struct VL53L8CX_Command	*p_batch_next;
+} VL53L8CX_Command;
+
+/**
+ * @brief Structure VL53L8CX_CommandQueue is a lock-free multi-producer,
+ * single-consumer queue of commands. Any thread can push a command without
+ * waiting, and the thread owning the device applies them between two frames.
+ * Commands are linked through their node, so pushing never allocates.
+ */
+
+typedef struct
+{
+	/* Last command pushed, swapped by the producers */
+	_Alignas(64) _Atomic(VL53L8CX_CommandNode *) head;
+	/* Next command to apply, only used by the consumer */
+	_Alignas(64) VL53L8CX_CommandNode *tail;
+	/* Placeholder keeping the queue never empty */
+	VL53L8CX_CommandNode	stub;
+} VL53L8CX_CommandQueue;
+
+/**
+ * @brief This function prepares a command.
+ * @param (VL53L8CX_Command) *p_cmd : Command structure.
+ * @param (uint8_t) type : One of VL53L8CX_COMMAND_*.
+ * @param (uint32_t) value : New value of the setting.
+ * @param (VL53L8CX_CommandDone) done : Completion callback, or NULL.
+ * @param (void) *p_user : Argument given to the callback.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_command_init(
+		VL53L8CX_Command		*p_cmd,
+		uint8_t				type,
+		uint32_t			value,
+		VL53L8CX_CommandDone		done,
+		void				*p_user);
+
+/**
+ * @brief This function prepares a VL53L8CX_COMMAND_CUSTOM command.
+ * @param (VL53L8CX_Command) *p_cmd : Command structure.
+ * @param (VL53L8CX_CommandFn) custom : Function run with the device.
+ * @param (void) *p_arg : Argument given to the function.
+ * @param (VL53L8CX_CommandDone) done : Completion callback, or NULL.
+ * @param (void) *p_user : Argument given to the callback.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_command_init_custom(
+		VL53L8CX_Command		*p_cmd,
+		VL53L8CX_CommandFn		custom,
+		void				*p_arg,
+		VL53L8CX_CommandDone		done,
+		void				*p_user);
+
+/**
+ * @brief This function releases the resources of a command prepared by
+ * vl53l8cx_command_init(). It must be called once the command has completed,
+ * or if it was never queued, before the structure is prepared again or freed.
+ * @param (VL53L8CX_Command) *p_cmd : Command structure.
+ */
+
+void vl53l8cx_command_deinit(
+		VL53L8CX_Command		*p_cmd);
+
+/**
+ * @brief This function waits until a command without callback is applied. It
+ * must be called by a single thread.
+ * @param (VL53L8CX_Command) *p_cmd : Command structure.
+ * @param (uint32_t) timeout_ms : Maximum time to wait, 0 to only check.
+ * @return (uint8_t) is_done : 1 if the command is applied, 0 on timeout.
+ */
+
+uint8_t vl53l8cx_command_wait(
+		VL53L8CX_Command		*p_cmd,
+		uint32_t			timeout_ms);
+
+/**
+ * @brief This function initializes an empty queue.
+ * @param (VL53L8CX_CommandQueue) *p_queue : Queue structure.
+ */
+
+void vl53l8cx_command_queue_init(
+		VL53L8CX_CommandQueue		*p_queue);
+
+/**
+ * @brief This function pushes a command. It can be called from any thread,
+ * and never blocks.
+ * @param (VL53L8CX_CommandQueue) *p_queue : Queue structure.
+ * @param (VL53L8CX_Command) *p_cmd : Prepared command.
+ */
+
+void vl53l8cx_command_queue_push(
+		VL53L8CX_CommandQueue		*p_queue,
+		VL53L8CX_Command		*p_cmd);
+
+/**
+ * @brief This function completes all queued commands without applying them,
+ * with the given status. It must be called by the thread owning the device,
+ * for example when the device is released while commands are pending.
+ * @param (VL53L8CX_CommandQueue) *p_queue : Queue structure.
+ * @param (uint8_t) status : Status given to the commands.
+ * @return (uint32_t) nb_cancelled : Number of commands completed.
+ */
+
+uint32_t vl53l8cx_command_queue_cancel(
+		VL53L8CX_CommandQueue		*p_queue,
+		uint8_t				status);
+
+/**
+ * @brief This function applies all queued commands. It must be called by the
+ * thread owning the device, between two frames. When the device is ranging,
+ * ranging is stopped before the first command and restarted after the last
+ * one, so the whole batch costs a single restart.
+ * @param (VL53L8CX_CommandQueue) *p_queue : Queue structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device owned by the caller.
+ * @param (uint8_t) is_ranging : 1 if the device is ranging.
+ * @return (uint32_t) nb_applied : Number of commands applied.
+ */
+
+uint32_t vl53l8cx_command_queue_apply(
+		VL53L8CX_CommandQueue		*p_queue,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				is_ranging);
+
+#endif /* VL53L8CX_COMMAND_H_ */
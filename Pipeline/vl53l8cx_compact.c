@@ -0,0 +1,318 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "vl53l8cx_compact.h"
+
+/* Fractional bits of the rates decoded by the driver */
+#ifdef VL53L8CX_USE_RAW_FORMAT
+#define COMPACT_DRIVER_FRAC_BITS	11U
+#else
+#define COMPACT_DRIVER_FRAC_BITS	0U
+#endif
+
+/* Outputs converted one value at a time, the others are copied as is */
+#if !defined(VL53L8CX_DISABLE_SIGNAL_PER_SPAD) \
+	|| !defined(VL53L8CX_DISABLE_AMBIENT_PER_SPAD) \
+	|| !defined(VL53L8CX_DISABLE_NB_SPADS_ENABLED)
+#define COMPACT_CONVERTED_OUTPUTS
+#endif
+
+/* Outputs stored by this build, see VL53L8CX_CompactHeader */
+static const uint16_t compact_outputs = (uint16_t)(0U
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	| VL53L8CX_OUTPUT_DISTANCE_MM
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	| VL53L8CX_OUTPUT_RANGE_SIGMA_MM
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	| VL53L8CX_OUTPUT_SIGNAL_PER_SPAD
+#endif
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	| VL53L8CX_OUTPUT_AMBIENT_PER_SPAD
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	| VL53L8CX_OUTPUT_NB_SPADS_ENABLED
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	| VL53L8CX_OUTPUT_TARGET_STATUS
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	| VL53L8CX_OUTPUT_REFLECTANCE_PERCENT
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	| VL53L8CX_OUTPUT_NB_TARGET_DETECTED
+#endif
+	);
+
+/*
+ * Places the arrays after the header, in the order documented into
+ * vl53l8cx_compact.h, and returns the frame size. p_buffer may be NULL to only
+ * compute the size.
+ */
+static uint32_t _vl53l8cx_compact_map(
+		uint8_t				*p_buffer,
+		uint8_t				nb_zones,
+		VL53L8CX_CompactView		*p_view)
+{
+	uint32_t zones = nb_zones;
+	uint32_t slots = zones * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+	uint32_t pos = sizeof(VL53L8CX_CompactHeader);
+
+	(void)memset(p_view, 0, sizeof(*p_view));
+	p_view->p_header = (VL53L8CX_CompactHeader *)p_buffer;
+
+#define COMPACT_MAP(field, type, count) \
+	do { \
+		p_view->field = (p_buffer != NULL) \
+			? (type *)(void *)&p_buffer[pos] : NULL; \
+		pos += (uint32_t)sizeof(type) * (count); \
+	} while (0)
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	COMPACT_MAP(distance_mm, int16_t, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	COMPACT_MAP(range_sigma_mm, uint16_t, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	COMPACT_MAP(signal_per_spad, uint16_t, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	COMPACT_MAP(ambient_per_spad, uint16_t, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	COMPACT_MAP(nb_spads_enabled, uint16_t, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	COMPACT_MAP(target_status, uint8_t, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	COMPACT_MAP(reflectance, uint8_t, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	COMPACT_MAP(nb_target_detected, uint8_t, zones);
+#endif
+
+#undef COMPACT_MAP
+
+	(void)slots;
+	return pos;
+}
+
+static inline uint16_t _vl53l8cx_compact_sat16(uint32_t value)
+{
+	return (value > 0xFFFFU) ? (uint16_t)0xFFFFU : (uint16_t)value;
+}
+
+/* Driver rate to 16 bits fixed point */
+static inline uint16_t _vl53l8cx_compact_rate(uint32_t value)
+{
+#if COMPACT_DRIVER_FRAC_BITS >= VL53L8CX_COMPACT_RATE_FRAC_BITS
+	return _vl53l8cx_compact_sat16(value
+		>> (COMPACT_DRIVER_FRAC_BITS - VL53L8CX_COMPACT_RATE_FRAC_BITS));
+#else
+	if (value > (0xFFFFU >> VL53L8CX_COMPACT_RATE_FRAC_BITS))
+	{
+		return 0xFFFFU;
+	}
+	return (uint16_t)(value << VL53L8CX_COMPACT_RATE_FRAC_BITS);
+#endif
+}
+
+/* 16 bits fixed point with 'frac_bits' fractional bits to driver rate */
+static inline uint32_t _vl53l8cx_compact_unrate(
+		uint16_t			value,
+		uint8_t				frac_bits)
+{
+#if COMPACT_DRIVER_FRAC_BITS == 0U
+	return (uint32_t)value >> frac_bits;
+#else
+	if (frac_bits >= COMPACT_DRIVER_FRAC_BITS)
+	{
+		return (uint32_t)value >> (frac_bits - COMPACT_DRIVER_FRAC_BITS);
+	}
+	return (uint32_t)value << (COMPACT_DRIVER_FRAC_BITS - frac_bits);
+#endif
+}
+
+uint32_t vl53l8cx_compact_size(
+		uint8_t				nb_zones)
+{
+	VL53L8CX_CompactView view;
+
+	return _vl53l8cx_compact_map(NULL, nb_zones, &view);
+}
+
+uint8_t vl53l8cx_compact_pack(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		uint8_t				*p_buffer,
+		uint32_t			buffer_size)
+{
+	VL53L8CX_CompactView view;
+	uint32_t size, zones, slots;
+#ifdef COMPACT_CONVERTED_OUTPUTS
+	uint32_t i;
+#endif
+
+	if ((nb_zones != VL53L8CX_RESOLUTION_4X4)
+	    && (nb_zones != VL53L8CX_RESOLUTION_8X8))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	size = _vl53l8cx_compact_map(p_buffer, nb_zones, &view);
+	if (size > buffer_size)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	zones = nb_zones;
+	slots = zones * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+
+	view.p_header->size = (uint16_t)size;
+	view.p_header->outputs = compact_outputs;
+	view.p_header->nb_zones = nb_zones;
+	view.p_header->nb_targets = (uint8_t)VL53L8CX_NB_TARGET_PER_ZONE;
+	view.p_header->silicon_temp_degc = p_results->silicon_temp_degc;
+	view.p_header->rate_frac_bits = (uint8_t)VL53L8CX_COMPACT_RATE_FRAC_BITS;
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	(void)memcpy(view.distance_mm, p_results->distance_mm,
+			slots * sizeof(int16_t));
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	(void)memcpy(view.range_sigma_mm, p_results->range_sigma_mm,
+			slots * sizeof(uint16_t));
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	for (i = 0; i < slots; i++)
+	{
+		view.signal_per_spad[i] = _vl53l8cx_compact_rate(
+				p_results->signal_per_spad[i]);
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	for (i = 0; i < zones; i++)
+	{
+		view.ambient_per_spad[i] = _vl53l8cx_compact_rate(
+				p_results->ambient_per_spad[i]);
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	for (i = 0; i < zones; i++)
+	{
+		view.nb_spads_enabled[i] = _vl53l8cx_compact_sat16(
+				p_results->nb_spads_enabled[i]);
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	(void)memcpy(view.target_status, p_results->target_status, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	(void)memcpy(view.reflectance, p_results->reflectance, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	(void)memcpy(view.nb_target_detected, p_results->nb_target_detected,
+			zones);
+#endif
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_compact_view(
+		uint8_t				*p_buffer,
+		VL53L8CX_CompactView		*p_view)
+{
+	const VL53L8CX_CompactHeader *p_header =
+		(const VL53L8CX_CompactHeader *)(void *)p_buffer;
+
+	if (((p_header->nb_zones != VL53L8CX_RESOLUTION_4X4)
+	     && (p_header->nb_zones != VL53L8CX_RESOLUTION_8X8))
+	    || (p_header->nb_targets != (uint8_t)VL53L8CX_NB_TARGET_PER_ZONE)
+	    || (p_header->outputs != compact_outputs)
+	    || (p_header->rate_frac_bits > 16U))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	if (_vl53l8cx_compact_map(p_buffer, p_header->nb_zones, p_view)
+			!= p_header->size)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_compact_unpack(
+		const uint8_t			*p_buffer,
+		uint32_t			buffer_size,
+		VL53L8CX_ResultsData		*p_results)
+{
+	VL53L8CX_CompactView view;
+	uint32_t zones, slots;
+#ifdef COMPACT_CONVERTED_OUTPUTS
+	uint32_t i;
+#endif
+
+	if ((buffer_size < sizeof(VL53L8CX_CompactHeader))
+	    || (vl53l8cx_compact_view((uint8_t *)p_buffer, &view)
+			!= VL53L8CX_STATUS_OK)
+	    || (view.p_header->size > buffer_size))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	zones = view.p_header->nb_zones;
+	slots = zones * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+
+	p_results->silicon_temp_degc = view.p_header->silicon_temp_degc;
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	(void)memcpy(p_results->distance_mm, view.distance_mm,
+			slots * sizeof(int16_t));
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	(void)memcpy(p_results->range_sigma_mm, view.range_sigma_mm,
+			slots * sizeof(uint16_t));
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	for (i = 0; i < slots; i++)
+	{
+		p_results->signal_per_spad[i] = _vl53l8cx_compact_unrate(
+				view.signal_per_spad[i],
+				view.p_header->rate_frac_bits);
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	for (i = 0; i < zones; i++)
+	{
+		p_results->ambient_per_spad[i] = _vl53l8cx_compact_unrate(
+				view.ambient_per_spad[i],
+				view.p_header->rate_frac_bits);
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	for (i = 0; i < zones; i++)
+	{
+		p_results->nb_spads_enabled[i] = view.nb_spads_enabled[i];
+	}
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	(void)memcpy(p_results->target_status, view.target_status, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	(void)memcpy(p_results->reflectance, view.reflectance, slots);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	(void)memcpy(p_results->nb_target_detected, view.nb_target_detected,
+			zones);
+#endif
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+	/* The validity is not stored, it is computed again */
+	(void)vl53l8cx_update_validity(p_results, (uint8_t)zones);
+#endif
+
+	return VL53L8CX_STATUS_OK;
+}
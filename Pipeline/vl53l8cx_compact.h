@@ -0,0 +1,131 @@
+#ifndef VL53L8CX_COMPACT_H_
+#define VL53L8CX_COMPACT_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Number of fractional bits of the signal and ambient rates stored into
+ * a compact frame (unsigned fixed point on 16 bits). With 2 bits, rates up to
+ * 16383 kcps/spad are kept with a 0.25 kcps/spad step; larger rates saturate.
+ */
+
+#ifndef VL53L8CX_COMPACT_RATE_FRAC_BITS
+#define VL53L8CX_COMPACT_RATE_FRAC_BITS		2U
+#endif
+
+/**
+ * @brief Structure VL53L8CX_CompactHeader starts each compact frame. A compact
+ * frame is a variable length buffer: the header is followed by one array per
+ * output enabled into 'platform.h', sized for 'nb_zones' zones only. Arrays
+ * are stored in this order (16 bits arrays first, so all of them are
+ * aligned):
+ * - distance_mm (int16_t, per target)
+ * - range_sigma_mm (uint16_t, per target)
+ * - signal_per_spad (uint16_t fixed point, per target)
+ * - ambient_per_spad (uint16_t fixed point, per zone)
+ * - nb_spads_enabled (uint16_t saturated, per zone)
+ * - target_status (uint8_t, per target)
+ * - reflectance (uint8_t, per target)
+ * - nb_target_detected (uint8_t, per zone)
+ * Values use the host byte order. The motion indicator is not stored.
+ */
+
+typedef struct
+{
+	/* Size of the compact frame in bytes, header included */
+	uint16_t		size;
+	/* Arrays present into the frame, using macros VL53L8CX_OUTPUT_* */
+	uint16_t		outputs;
+	/* Number of zones, 16 or 64 */
+	uint8_t			nb_zones;
+	/* Number of targets per zone */
+	uint8_t			nb_targets;
+	/* Internal sensor silicon temperature */
+	int8_t			silicon_temp_degc;
+	/* Fractional bits of the rates, VL53L8CX_COMPACT_RATE_FRAC_BITS */
+	uint8_t			rate_frac_bits;
+} VL53L8CX_CompactHeader;
+
+/**
+ * @brief Maximum size of a compact frame in bytes (8x8, all outputs enabled).
+ * Use vl53l8cx_compact_size() for the exact size.
+ */
+
+#define VL53L8CX_COMPACT_MAX_SIZE	((uint32_t)sizeof(VL53L8CX_CompactHeader) \
+	+ ((uint32_t)VL53L8CX_RESOLUTION_8X8 \
+	* ((8U * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE) + 5U)))
+
+/**
+ * @brief Structure VL53L8CX_CompactView gives typed access to the arrays of a
+ * compact frame. Pointers of outputs disabled into 'platform.h' are NULL.
+ */
+
+typedef struct
+{
+	VL53L8CX_CompactHeader	*p_header;
+	int16_t			*distance_mm;
+	uint16_t		*range_sigma_mm;
+	uint16_t		*signal_per_spad;
+	uint16_t		*ambient_per_spad;
+	uint16_t		*nb_spads_enabled;
+	uint8_t			*target_status;
+	uint8_t			*reflectance;
+	uint8_t			*nb_target_detected;
+} VL53L8CX_CompactView;
+
+/**
+ * @brief This function gives the size of a compact frame.
+ * @param (uint8_t) nb_zones : Number of zones, 16 or 64.
+ * @return (uint32_t) size : Size in bytes, header included.
+ */
+
+uint32_t vl53l8cx_compact_size(
+		uint8_t				nb_zones);
+
+/**
+ * @brief This function packs the results of a frame into a compact frame.
+ * @param (VL53L8CX_ResultsData) *p_results : Results to pack.
+ * @param (uint8_t) nb_zones : Resolution of the results,
+ * VL53L8CX_RESOLUTION_4X4 or VL53L8CX_RESOLUTION_8X8.
+ * @param (uint8_t) *p_buffer : Destination buffer, aligned on 2 bytes.
+ * @param (uint32_t) buffer_size : Size of the destination buffer.
+ * @return (uint8_t) status : 0 if OK, or 127 if the resolution is not valid
+ * or the buffer is too small.
+ */
+
+uint8_t vl53l8cx_compact_pack(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		uint8_t				*p_buffer,
+		uint32_t			buffer_size);
+
+/**
+ * @brief This function unpacks a compact frame into a full results structure.
+ * Zones above 'nb_zones' and the motion indicator are left untouched.
+ * @param (uint8_t) *p_buffer : Compact frame, aligned on 2 bytes.
+ * @param (uint32_t) buffer_size : Number of bytes available into the buffer.
+ * @param (VL53L8CX_ResultsData) *p_results : Unpacked results.
+ * @return (uint8_t) status : 0 if OK, or 127 if the frame does not match the
+ * outputs and the number of targets of this build.
+ */
+
+uint8_t vl53l8cx_compact_unpack(
+		const uint8_t			*p_buffer,
+		uint32_t			buffer_size,
+		VL53L8CX_ResultsData		*p_results);
+
+/**
+ * @brief This function maps the arrays of a compact frame, to read it in place.
+ * The header must be valid (see vl53l8cx_compact_pack()).
+ * @param (uint8_t) *p_buffer : Compact frame, aligned on 2 bytes.
+ * @param (VL53L8CX_CompactView) *p_view : Arrays of the frame.
+ * @return (uint8_t) status : 0 if OK, or 127 if the header is not valid.
+ */
+
+uint8_t vl53l8cx_compact_view(
+		uint8_t				*p_buffer,
+		VL53L8CX_CompactView		*p_view);
+
+#endif /* VL53L8CX_COMPACT_H_ */
@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "vl53l8cx_filter.h"
+#include "vl53l8cx_pipeline.h"
+#include "vl53l8cx_simd.h"
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+/*
+ * Weight of each measurement for the EMA and alpha-beta gains:
+ * min(1, sigma_ref / sigma).
+ */
+static inline vl53l8cx_v4f _vl53l8cx_filter_weight(
+		const VL53L8CX_Filter		*p_flt,
+		uint32_t			i)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+
+	return vl53l8cx_simd_min(one, p_flt->config.sigma_ref_mm
+		/ VL53L8CX_V4F(&p_flt->sigma_mm[i]));
+}
+
+static void _vl53l8cx_filter_ema(
+		VL53L8CX_Filter			*p_flt)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	vl53l8cx_v4f z, e, gain, tracked, valid;
+	uint32_t i;
+
+	for (i = 0; i < p_flt->nb_zones; i += VL53L8CX_SIMD_LANES)
+	{
+		z = VL53L8CX_V4F(&p_flt->measure_mm[i]);
+		e = VL53L8CX_V4F(&p_flt->estimate_mm[i]);
+		tracked = VL53L8CX_V4F(&p_flt->is_tracked[i]);
+		valid = VL53L8CX_V4F(&p_flt->is_valid[i]);
+
+		/* A zone not tracked takes the measurement as is */
+		gain = p_flt->config.alpha * _vl53l8cx_filter_weight(p_flt, i);
+		gain = valid * ((tracked * gain) + (one - tracked));
+		VL53L8CX_V4F(&p_flt->estimate_mm[i]) = e + (gain * (z - e));
+	}
+}
+
+static void _vl53l8cx_filter_alpha_beta(
+		VL53L8CX_Filter			*p_flt)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	vl53l8cx_v4f z, v, predict, residual, w, a, b, tracked, valid;
+	uint32_t i;
+
+	for (i = 0; i < p_flt->nb_zones; i += VL53L8CX_SIMD_LANES)
+	{
+		z = VL53L8CX_V4F(&p_flt->measure_mm[i]);
+		v = VL53L8CX_V4F(&p_flt->velocity_mm[i]);
+		tracked = VL53L8CX_V4F(&p_flt->is_tracked[i]);
+		valid = VL53L8CX_V4F(&p_flt->is_valid[i]);
+
+		/* Invalid zones are extrapolated */
+		predict = VL53L8CX_V4F(&p_flt->estimate_mm[i])
+			+ (tracked * v);
+		residual = z - predict;
+		w = _vl53l8cx_filter_weight(p_flt, i);
+		a = valid * ((tracked * p_flt->config.alpha * w)
+			+ (one - tracked));
+		b = valid * tracked * p_flt->config.beta * w;
+		VL53L8CX_V4F(&p_flt->estimate_mm[i]) = predict + (a * residual);
+		VL53L8CX_V4F(&p_flt->velocity_mm[i]) = tracked
+			* (v + (b * residual));
+	}
+}
+
+static void _vl53l8cx_filter_kalman(
+		VL53L8CX_Filter			*p_flt)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	vl53l8cx_v4f z, e, p, r, gain, tracked, valid;
+	uint32_t i;
+
+	for (i = 0; i < p_flt->nb_zones; i += VL53L8CX_SIMD_LANES)
+	{
+		z = VL53L8CX_V4F(&p_flt->measure_mm[i]);
+		e = VL53L8CX_V4F(&p_flt->estimate_mm[i]);
+		r = VL53L8CX_V4F(&p_flt->sigma_mm[i]);
+		r = r * r;
+		tracked = VL53L8CX_V4F(&p_flt->is_tracked[i]);
+		valid = VL53L8CX_V4F(&p_flt->is_valid[i]);
+
+		p = VL53L8CX_V4F(&p_flt->variance_mm2[i])
+			+ p_flt->config.process_noise_mm2;
+		gain = valid * ((tracked * (p / (p + r))) + (one - tracked));
+		VL53L8CX_V4F(&p_flt->estimate_mm[i]) = e + (gain * (z - e));
+		/* A zone starting to be tracked gets the measurement variance */
+		VL53L8CX_V4F(&p_flt->variance_mm2[i]) =
+			(tracked * (one - gain) * p)
+			+ ((one - tracked) * valid * r);
+	}
+}
+
+/*
+ * Ages the zones, ends the tracking of zones invalid for too long, and gives
+ * the output distances: zones not tracked have no estimate, and give the
+ * distance of the settings.
+ */
+static void _vl53l8cx_filter_output(
+		VL53L8CX_Filter			*p_flt)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	const vl53l8cx_v4f zero = {0.0f, 0.0f, 0.0f, 0.0f};
+	const vl53l8cx_v4f half = {0.5f, 0.5f, 0.5f, 0.5f};
+	vl53l8cx_v4f valid, tracked, age;
+	vl53l8cx_v4i rounded, is_tracked;
+	float hold = (float)p_flt->config.hold_frames;
+	uint32_t i, lane;
+
+	p_flt->tracked_mask = 0;
+
+	for (i = 0; i < p_flt->nb_zones; i += VL53L8CX_SIMD_LANES)
+	{
+		valid = VL53L8CX_V4F(&p_flt->is_valid[i]);
+		tracked = VL53L8CX_V4F(&p_flt->is_tracked[i]);
+
+		age = (VL53L8CX_V4F(&p_flt->age[i]) + one) * (one - valid);
+		tracked = vl53l8cx_simd_select(age <= hold,
+			one - ((one - tracked) * (one - valid)), zero);
+		VL53L8CX_V4F(&p_flt->age[i]) = age;
+		VL53L8CX_V4F(&p_flt->is_tracked[i]) = tracked;
+
+		is_tracked = tracked > half;
+		rounded = __builtin_convertvector(
+			VL53L8CX_V4F(&p_flt->estimate_mm[i]) + half,
+			vl53l8cx_v4i);
+		for (lane = 0; lane < VL53L8CX_SIMD_LANES; lane++)
+		{
+			p_flt->distance_mm[i + lane] = is_tracked[lane]
+				? (int16_t)rounded[lane]
+				: p_flt->config.no_target_mm;
+			p_flt->tracked_mask |= (uint64_t)(is_tracked[lane] & 1)
+				<< (i + lane);
+		}
+	}
+}
+#endif
+
+void vl53l8cx_filter_init(
+		VL53L8CX_Filter			*p_flt,
+		const VL53L8CX_FilterConfig	*p_config)
+{
+	(void)memset(p_flt, 0, sizeof(*p_flt));
+	if (p_config != NULL)
+	{
+		p_flt->config = *p_config;
+	}
+	else
+	{
+		p_flt->config.mode = VL53L8CX_FILTER_DEFAULT_MODE;
+		p_flt->config.alpha = VL53L8CX_FILTER_DEFAULT_ALPHA;
+		p_flt->config.beta = VL53L8CX_FILTER_DEFAULT_BETA;
+		p_flt->config.process_noise_mm2 =
+			VL53L8CX_FILTER_DEFAULT_PROCESS_NOISE_MM2;
+		p_flt->config.sigma_ref_mm = VL53L8CX_FILTER_DEFAULT_SIGMA_REF_MM;
+		p_flt->config.hold_frames = VL53L8CX_FILTER_DEFAULT_HOLD_FRAMES;
+		p_flt->config.no_target_mm =
+			VL53L8CX_FILTER_DEFAULT_NO_TARGET_MM;
+	}
+}
+
+void vl53l8cx_filter_reset(
+		VL53L8CX_Filter			*p_flt)
+{
+	(void)memset(p_flt->is_tracked, 0, sizeof(p_flt->is_tracked));
+	(void)memset(p_flt->age, 0, sizeof(p_flt->age));
+	(void)memset(p_flt->velocity_mm, 0, sizeof(p_flt->velocity_mm));
+	(void)memset(p_flt->variance_mm2, 0, sizeof(p_flt->variance_mm2));
+	p_flt->tracked_mask = 0;
+}
+
+uint8_t vl53l8cx_filter_update(
+		VL53L8CX_Filter			*p_flt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	uint64_t valid;
+	float sigma;
+	uint32_t zone, idx;
+	uint8_t is_valid;
+
+	if (((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+		|| (p_flt->config.mode > VL53L8CX_FILTER_MODE_KALMAN))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	if (nb_zones != p_flt->nb_zones)
+	{
+		vl53l8cx_filter_reset(p_flt);
+		p_flt->nb_zones = nb_zones;
+	}
+
+#ifdef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	/* Without sigma, all measurements have the reference weight */
+	sigma = p_flt->config.sigma_ref_mm;
+	if (sigma < 1.0f)
+	{
+		sigma = 1.0f;
+	}
+#endif
+
+	/* Gather the first target of each zone */
+	valid = vl53l8cx_valid_zones(p_results, nb_zones);
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		p_flt->measure_mm[zone] = (float)p_results->distance_mm[idx];
+		is_valid = (uint8_t)((valid >> zone) & 1U);
+		p_flt->is_valid[zone] = is_valid ? 1.0f : 0.0f;
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+		sigma = (float)p_results->range_sigma_mm[idx];
+		if (sigma < 1.0f)
+		{
+			sigma = 1.0f;
+		}
+#endif
+		p_flt->sigma_mm[zone] = sigma;
+	}
+
+	switch (p_flt->config.mode)
+	{
+		case VL53L8CX_FILTER_MODE_EMA:
+			_vl53l8cx_filter_ema(p_flt);
+			break;
+		case VL53L8CX_FILTER_MODE_ALPHA_BETA:
+			_vl53l8cx_filter_alpha_beta(p_flt);
+			break;
+		default:
+			_vl53l8cx_filter_kalman(p_flt);
+			break;
+	}
+	_vl53l8cx_filter_output(p_flt);
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_flt;
+	(void)p_results;
+	(void)nb_zones;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
@@ -0,0 +1,132 @@
+#ifndef VL53L8CX_FILTER_H_
+#define VL53L8CX_FILTER_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Macros VL53L8CX_FILTER_MODE_* select the filter applied to the
+ * distance of each zone:
+ * - EMA : exponential moving average,
+ * - ALPHA_BETA : position and velocity, for targets moving at constant speed,
+ * - KALMAN : 1D Kalman filter (random walk), the gain follows the sigma of
+ * each measurement.
+ */
+
+#define VL53L8CX_FILTER_MODE_EMA		((uint8_t) 0U)
+#define VL53L8CX_FILTER_MODE_ALPHA_BETA		((uint8_t) 1U)
+#define VL53L8CX_FILTER_MODE_KALMAN		((uint8_t) 2U)
+
+/**
+ * @brief Default filter: Kalman, with a target moving by about 10 mm between
+ * two frames. EMA and alpha-beta gains apply to a measurement with a sigma of
+ * 10 mm, and are reduced for noisier measurements. An estimate is held for 5
+ * frames without valid measurement. Zones which are not tracked give 0 mm, like
+ * the targets of the driver which are not detected.
+ */
+
+#define VL53L8CX_FILTER_DEFAULT_MODE		VL53L8CX_FILTER_MODE_KALMAN
+#define VL53L8CX_FILTER_DEFAULT_ALPHA		0.5f
+#define VL53L8CX_FILTER_DEFAULT_BETA		0.1f
+#define VL53L8CX_FILTER_DEFAULT_PROCESS_NOISE_MM2	100.0f
+#define VL53L8CX_FILTER_DEFAULT_SIGMA_REF_MM	10.0f
+#define VL53L8CX_FILTER_DEFAULT_HOLD_FRAMES	5U
+#define VL53L8CX_FILTER_DEFAULT_NO_TARGET_MM	0
+
+/**
+ * @brief Structure VL53L8CX_FilterConfig contains the filter settings.
+ */
+
+typedef struct
+{
+	/* Filter, using macros VL53L8CX_FILTER_MODE_* */
+	uint8_t			mode;
+	/* EMA gain, or alpha-beta position gain, from 0 to 1 */
+	float			alpha;
+	/* Alpha-beta velocity gain, from 0 to 1 */
+	float			beta;
+	/* Kalman process noise: variance of the distance change between two
+	 * frames, in mm^2 */
+	float			process_noise_mm2;
+	/* EMA and alpha-beta gains are scaled by sigma_ref / sigma when the
+	 * sigma of a measurement is above this value, in mm */
+	float			sigma_ref_mm;
+	/* Frames an estimate is held (or extrapolated) without a valid
+	 * measurement before the zone is reset */
+	uint32_t		hold_frames;
+	/* Distance given by the zones which are not tracked, in mm */
+	int16_t			no_target_mm;
+} VL53L8CX_FilterConfig;
+
+/**
+ * @brief Structure VL53L8CX_Filter contains the state of all zones, stored as
+ * one array per variable so the zones are filtered 4 at a time with SIMD
+ * instructions (SSE or NEON). Zones are valid when their target status is 5 or
+ * 9: other zones keep their estimate, which is not updated by the
+ * measurement. A zone which is not tracked (never valid, or invalid for more
+ * than 'hold_frames' frames) has no estimate: it gives 'no_target_mm', and its
+ * bit of tracked_mask is cleared.
+ */
+
+typedef struct
+{
+	VL53L8CX_FilterConfig	config;
+	/* Resolution of the last frame, the state is reset when it changes */
+	uint8_t			nb_zones;
+	/* State, in mm and mm per frame */
+	_Alignas(16) float	estimate_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	velocity_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	variance_mm2[VL53L8CX_RESOLUTION_8X8];
+	/* 1.0 when the zone is tracked, and frames since its last valid
+	 * measurement */
+	_Alignas(16) float	is_tracked[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	age[VL53L8CX_RESOLUTION_8X8];
+	/* Measurements of the last frame */
+	_Alignas(16) float	measure_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	sigma_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	is_valid[VL53L8CX_RESOLUTION_8X8];
+	/* Filtered distance of each zone (first target), in mm */
+	int16_t			distance_mm[VL53L8CX_RESOLUTION_8X8];
+	/* Bit z is set when zone z is tracked, so its distance is filtered */
+	uint64_t		tracked_mask;
+} VL53L8CX_Filter;
+
+/**
+ * @brief This function initializes a filter.
+ * @param (VL53L8CX_Filter) *p_flt : Filter structure.
+ * @param (VL53L8CX_FilterConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_filter_init(
+		VL53L8CX_Filter			*p_flt,
+		const VL53L8CX_FilterConfig	*p_config);
+
+/**
+ * @brief This function resets all zones. The next valid measurement of each
+ * zone is taken as is.
+ * @param (VL53L8CX_Filter) *p_flt : Filter structure.
+ */
+
+void vl53l8cx_filter_reset(
+		VL53L8CX_Filter			*p_flt);
+
+/**
+ * @brief This function filters the distances of a frame. The result is
+ * given by p_flt->distance_mm and p_flt->tracked_mask. The distance, the sigma
+ * and the target status must be read for each frame (see
+ * vl53l8cx_set_partial_read()).
+ * @param (VL53L8CX_Filter) *p_flt : Filter structure.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame to filter.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution or the mode is not valid.
+ */
+
+uint8_t vl53l8cx_filter_update(
+		VL53L8CX_Filter			*p_flt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones);
+
+#endif /* VL53L8CX_FILTER_H_ */
@@ -0,0 +1,325 @@
+#include <string.h>
+
+#include "vl53l8cx_fusion.h"
+#include "vl53l8cx_capture.h"
+
+/*
+ * Converts the frame of a sensor into its slice, and keeps the valid points
+ * only, in place.
+ */
+static void _vl53l8cx_fusion_convert(
+		VL53L8CX_Fusion			*p_fus,
+		uint8_t				sensor)
+{
+	VL53L8CX_FusionSlice *p_slice = &p_fus->slices[sensor];
+	uint64_t mask;
+	uint32_t target, zone, idx, nb_points = 0;
+
+	p_slice->nb_points = 0;
+	if (((p_fus->sensor_mask >> sensor) & 1U) == 0U)
+	{
+		return;
+	}
+	if (vl53l8cx_pointcloud_convert(&p_fus->converters[sensor],
+			p_fus->p_results[sensor], p_fus->nb_zones,
+			&p_slice->cloud) != VL53L8CX_STATUS_OK)
+	{
+		return;
+	}
+
+	for (target = 0; target < (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+			target++)
+	{
+		for (mask = p_slice->cloud.valid_mask[target]; mask != 0U;
+				mask &= mask - 1U)
+		{
+			zone = (uint32_t)__builtin_ctzll(mask);
+			idx = (target * (uint32_t)p_fus->nb_zones) + zone;
+			p_slice->x_mm[nb_points] = p_slice->x_mm[idx];
+			p_slice->y_mm[nb_points] = p_slice->y_mm[idx];
+			p_slice->z_mm[nb_points] = p_slice->z_mm[idx];
+			p_slice->zone[nb_points] = (uint8_t)zone;
+			nb_points++;
+		}
+	}
+	p_slice->nb_points = nb_points;
+}
+
+/* Converts the sensors of a thread: ids equal to its id modulo the threads */
+static void _vl53l8cx_fusion_convert_share(
+		VL53L8CX_Fusion			*p_fus,
+		uint8_t				id)
+{
+	uint8_t sensor;
+
+	for (sensor = id; sensor < p_fus->nb_sensors;
+			sensor = (uint8_t)(sensor + p_fus->nb_workers + 1U))
+	{
+		_vl53l8cx_fusion_convert(p_fus, sensor);
+	}
+}
+
+static void *_vl53l8cx_fusion_worker_thread(
+		void				*p_arg)
+{
+	VL53L8CX_FusionWorker *p_worker = (VL53L8CX_FusionWorker *)p_arg;
+	VL53L8CX_Fusion *p_fus = p_worker->p_fus;
+	uint32_t generation = p_worker->generation;
+
+	(void)pthread_mutex_lock(&p_fus->lock);
+	for (;;)
+	{
+		while (p_fus->running && (p_fus->generation == generation))
+		{
+			(void)pthread_cond_wait(&p_fus->start, &p_fus->lock);
+		}
+		if (!p_fus->running)
+		{
+			break;
+		}
+		generation = p_fus->generation;
+		(void)pthread_mutex_unlock(&p_fus->lock);
+
+		_vl53l8cx_fusion_convert_share(p_fus, p_worker->id);
+
+		(void)pthread_mutex_lock(&p_fus->lock);
+		p_fus->nb_pending--;
+		if (p_fus->nb_pending == 0U)
+		{
+			(void)pthread_cond_signal(&p_fus->done);
+		}
+	}
+	(void)pthread_mutex_unlock(&p_fus->lock);
+
+	return NULL;
+}
+
+uint8_t vl53l8cx_fusion_init(
+		VL53L8CX_Fusion			*p_fus)
+{
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	(void)memset(p_fus, 0, sizeof(*p_fus));
+	for (i = 0; i < VL53L8CX_FUSION_MAX_SENSORS; i++)
+	{
+		p_fus->slices[i].cloud.p_x_mm = p_fus->slices[i].x_mm;
+		p_fus->slices[i].cloud.p_y_mm = p_fus->slices[i].y_mm;
+		p_fus->slices[i].cloud.p_z_mm = p_fus->slices[i].z_mm;
+		p_fus->slices[i].cloud.capacity =
+			VL53L8CX_POINTCLOUD_MAX_POINTS;
+	}
+	if ((pthread_mutex_init(&p_fus->lock, NULL) != 0)
+		|| (pthread_cond_init(&p_fus->start, NULL) != 0)
+		|| (pthread_cond_init(&p_fus->done, NULL) != 0))
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_fusion_add_sensor(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_PointCloudPose	*p_pose,
+		uint8_t				*p_sensor_id)
+{
+	if (p_fus->running
+		|| (p_fus->nb_sensors >= VL53L8CX_FUSION_MAX_SENSORS))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	vl53l8cx_pointcloud_init(&p_fus->converters[p_fus->nb_sensors], p_pose);
+	*p_sensor_id = p_fus->nb_sensors;
+	p_fus->nb_sensors++;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_fusion_start(
+		VL53L8CX_Fusion			*p_fus,
+		uint8_t				nb_workers)
+{
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	if (p_fus->running || (nb_workers > VL53L8CX_FUSION_MAX_WORKERS))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_fus->running = 1;
+	p_fus->nb_workers = nb_workers;
+	for (i = 0; i < nb_workers; i++)
+	{
+		/* Id 0 is the caller of vl53l8cx_fusion_process() */
+		p_fus->workers[i].p_fus = p_fus;
+		p_fus->workers[i].id = (uint8_t)(i + 1U);
+		p_fus->workers[i].generation = p_fus->generation;
+		if (pthread_create(&p_fus->workers[i].thread, NULL,
+				_vl53l8cx_fusion_worker_thread,
+				&p_fus->workers[i]) != 0)
+		{
+			(void)vl53l8cx_fusion_stop(p_fus);
+			status |= VL53L8CX_STATUS_ERROR;
+			break;
+		}
+		p_fus->workers[i].is_started = 1;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_fusion_stop(
+		VL53L8CX_Fusion			*p_fus)
+{
+	uint8_t i;
+
+	(void)pthread_mutex_lock(&p_fus->lock);
+	p_fus->running = 0;
+	(void)pthread_cond_broadcast(&p_fus->start);
+	(void)pthread_mutex_unlock(&p_fus->lock);
+
+	for (i = 0; i < VL53L8CX_FUSION_MAX_WORKERS; i++)
+	{
+		if (p_fus->workers[i].is_started)
+		{
+			(void)pthread_join(p_fus->workers[i].thread, NULL);
+			p_fus->workers[i].is_started = 0;
+		}
+	}
+	p_fus->nb_workers = 0;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_fusion_process(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_ResultsData *const *pp_results,
+		uint16_t			sensor_mask,
+		uint8_t				nb_zones,
+		VL53L8CX_FusionCloud		*p_out)
+{
+	VL53L8CX_FusionSlice *p_slice;
+	uint64_t t_start_ns = vl53l8cx_capture_now_ns(), elapsed_ns;
+	uint32_t nb_points = 0, nb_max = 0, i;
+	uint8_t sensor;
+
+	sensor_mask &= (uint16_t)((1UL << p_fus->nb_sensors) - 1UL);
+	for (sensor = 0; sensor < p_fus->nb_sensors; sensor++)
+	{
+		if ((sensor_mask >> sensor) & 1U)
+		{
+			nb_max += (uint32_t)nb_zones
+				* (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		}
+	}
+	if (((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+		|| (p_out->capacity < nb_max))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	(void)memcpy(p_fus->p_results, pp_results,
+			(size_t)p_fus->nb_sensors * sizeof(p_fus->p_results[0]));
+	p_fus->sensor_mask = sensor_mask;
+	p_fus->nb_zones = nb_zones;
+
+	if (p_fus->nb_workers != 0U)
+	{
+		(void)pthread_mutex_lock(&p_fus->lock);
+		p_fus->nb_pending = p_fus->nb_workers;
+		p_fus->generation++;
+		(void)pthread_cond_broadcast(&p_fus->start);
+		(void)pthread_mutex_unlock(&p_fus->lock);
+	}
+
+	_vl53l8cx_fusion_convert_share(p_fus, 0);
+
+	if (p_fus->nb_workers != 0U)
+	{
+		(void)pthread_mutex_lock(&p_fus->lock);
+		while (p_fus->nb_pending != 0U)
+		{
+			(void)pthread_cond_wait(&p_fus->done, &p_fus->lock);
+		}
+		(void)pthread_mutex_unlock(&p_fus->lock);
+	}
+
+	/* Append the slices, in sensor order */
+	for (sensor = 0; sensor < p_fus->nb_sensors; sensor++)
+	{
+		p_slice = &p_fus->slices[sensor];
+		(void)memcpy(&p_out->p_x_mm[nb_points], p_slice->x_mm,
+				p_slice->nb_points * sizeof(float));
+		(void)memcpy(&p_out->p_y_mm[nb_points], p_slice->y_mm,
+				p_slice->nb_points * sizeof(float));
+		(void)memcpy(&p_out->p_z_mm[nb_points], p_slice->z_mm,
+				p_slice->nb_points * sizeof(float));
+		if (p_out->p_zone != NULL)
+		{
+			(void)memcpy(&p_out->p_zone[nb_points], p_slice->zone,
+					p_slice->nb_points);
+		}
+		if (p_out->p_sensor != NULL)
+		{
+			for (i = 0; i < p_slice->nb_points; i++)
+			{
+				p_out->p_sensor[nb_points + i] = sensor;
+			}
+		}
+		nb_points += p_slice->nb_points;
+	}
+	p_out->nb_points = nb_points;
+
+	elapsed_ns = vl53l8cx_capture_now_ns() - t_start_ns;
+	p_fus->stats.epochs++;
+	p_fus->stats.points += nb_points;
+	p_fus->stats.last_ns = elapsed_ns;
+	if (elapsed_ns > p_fus->stats.max_ns)
+	{
+		p_fus->stats.max_ns = elapsed_ns;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_fusion_process_superframe(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_SuperFrame	*p_frame,
+		uint8_t				nb_zones,
+		VL53L8CX_FusionCloud		*p_out)
+{
+	const VL53L8CX_ResultsData *p_results[VL53L8CX_FUSION_MAX_SENSORS];
+	uint16_t sensor_mask = 0;
+	uint8_t i, status;
+
+	for (i = 0; i < VL53L8CX_FUSION_MAX_SENSORS; i++)
+	{
+		p_results[i] = NULL;
+	}
+	for (i = 0; (i < p_frame->nb_sensors)
+			&& (i < VL53L8CX_FUSION_MAX_SENSORS); i++)
+	{
+		p_results[i] = &p_frame->results[i];
+		if (((p_frame->sensor_mask >> i) & 1U)
+			&& (p_frame->status[i] == VL53L8CX_STATUS_OK))
+		{
+			sensor_mask |= (uint16_t)(1U << i);
+		}
+	}
+
+	status = vl53l8cx_fusion_process(p_fus, p_results, sensor_mask,
+			nb_zones, p_out);
+	p_out->epoch = p_frame->epoch;
+	p_out->t_trigger_ns = p_frame->t_trigger_ns;
+
+	return status;
+}
+
+void vl53l8cx_fusion_get_stats(
+		VL53L8CX_Fusion			*p_fus,
+		VL53L8CX_FusionStats		*p_stats)
+{
+	*p_stats = p_fus->stats;
+}
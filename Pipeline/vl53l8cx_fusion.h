@@ -0,0 +1,224 @@
+#ifndef VL53L8CX_FUSION_H_
+#define VL53L8CX_FUSION_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pointcloud.h"
+#include "vl53l8cx_sync.h"
+
+/**
+ * @brief Maximum number of sensors merged by a fusion stage, and maximum
+ * number of worker threads.
+ */
+
+#define VL53L8CX_FUSION_MAX_SENSORS		16U
+#define VL53L8CX_FUSION_MAX_WORKERS		8U
+
+/**
+ * @brief Maximum number of points of a fused cloud (all sensors in 8x8).
+ */
+
+#define VL53L8CX_FUSION_MAX_POINTS	((uint32_t)VL53L8CX_FUSION_MAX_SENSORS \
+	* VL53L8CX_POINTCLOUD_MAX_POINTS)
+
+/**
+ * @brief Structure VL53L8CX_FusionCloud is the merged point buffer, provided
+ * by the caller: one array per coordinate, of 'capacity' entries each. Only
+ * valid points are stored, sensor after sensor.
+ */
+
+typedef struct
+{
+	/* Coordinates into the body frame, in mm */
+	float			*p_x_mm;
+	float			*p_y_mm;
+	float			*p_z_mm;
+	/* Sensor id and zone of each point, or NULL if not needed */
+	uint8_t			*p_sensor;
+	uint8_t			*p_zone;
+	/* Size of each array. It must hold all the zones of all the sensors
+	 * merged, VL53L8CX_FUSION_MAX_POINTS is always enough */
+	uint32_t		capacity;
+	/* Filled by vl53l8cx_fusion_process*() */
+	uint32_t		nb_points;
+	uint32_t		epoch;
+	uint64_t		t_trigger_ns;
+} VL53L8CX_FusionCloud;
+
+/**
+ * @brief Structure VL53L8CX_FusionStats contains the fusion counters.
+ */
+
+typedef struct
+{
+	/* Epochs merged, and points produced */
+	uint32_t		epochs;
+	uint64_t		points;
+	/* Time to merge the last epoch, and longest time, in ns */
+	uint64_t		last_ns;
+	uint64_t		max_ns;
+} VL53L8CX_FusionStats;
+
+/**
+ * @brief Structure VL53L8CX_FusionSlice contains the points of one sensor,
+ * internal use. Each slice is written by a single thread, and is aligned on a
+ * cache line.
+ */
+
+typedef struct
+{
+	_Alignas(64) float	x_mm[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	_Alignas(16) float	y_mm[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	_Alignas(16) float	z_mm[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	uint8_t			zone[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	VL53L8CX_PointCloud	cloud;
+	uint32_t		nb_points;
+} VL53L8CX_FusionSlice;
+
+struct VL53L8CX_Fusion;
+
+/**
+ * @brief Structure VL53L8CX_FusionWorker contains the state of a worker
+ * thread, internal use.
+ */
+
+typedef struct
+{
+	struct VL53L8CX_Fusion *p_fus;
+	uint8_t			id;
+	uint8_t			is_started;
+	pthread_t		thread;
+	/* Generation when the worker was started, so an epoch merged before
+	 * the thread first runs is not missed */
+	uint32_t		generation;
+} VL53L8CX_FusionWorker;
+
+/**
+ * @brief Structure VL53L8CX_Fusion merges the frames of several sensors
+ * mounted at known poses into one point cloud into the body frame. Each
+ * sensor has its own table of zone directions, already rotated by its pose
+ * (see VL53L8CX_PointCloudConverter). Sensors are converted in parallel: the
+ * caller thread and the workers each take the sensors whose id modulo the
+ * number of threads is their own id, then the caller appends the valid points
+ * of all sensors to the output.
+ */
+
+typedef struct VL53L8CX_Fusion
+{
+	VL53L8CX_PointCloudConverter converters[VL53L8CX_FUSION_MAX_SENSORS];
+	uint8_t			nb_sensors;
+	VL53L8CX_FusionSlice	slices[VL53L8CX_FUSION_MAX_SENSORS];
+	VL53L8CX_FusionWorker	workers[VL53L8CX_FUSION_MAX_WORKERS];
+	uint8_t			nb_workers;
+	uint8_t			running;
+	/* Epoch being merged */
+	const VL53L8CX_ResultsData *p_results[VL53L8CX_FUSION_MAX_SENSORS];
+	uint8_t			nb_zones;
+	uint16_t		sensor_mask;
+	/* Workers wait for a new generation, the caller for no pending worker */
+	pthread_mutex_t		lock;
+	pthread_cond_t		start;
+	pthread_cond_t		done;
+	uint32_t		generation;
+	uint8_t			nb_pending;
+	VL53L8CX_FusionStats	stats;
+} VL53L8CX_Fusion;
+
+/**
+ * @brief This function initializes a fusion stage without sensor.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_fusion_init(
+		VL53L8CX_Fusion			*p_fus);
+
+/**
+ * @brief This function adds a sensor and computes its directions into the
+ * body frame. Ids are given in order, so they can match the ids of a
+ * VL53L8CX_Sync.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @param (VL53L8CX_PointCloudPose) *p_pose : Pose of the sensor into the body
+ * frame.
+ * @param (uint8_t) *p_sensor_id : Id of the sensor.
+ * @return (uint8_t) status : 0 if OK, or 127 if the stage is full or started.
+ */
+
+uint8_t vl53l8cx_fusion_add_sensor(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_PointCloudPose	*p_pose,
+		uint8_t				*p_sensor_id);
+
+/**
+ * @brief This function starts the worker threads.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @param (uint8_t) nb_workers : Number of worker threads, besides the caller
+ * of vl53l8cx_fusion_process(). With 0, the caller converts all sensors.
+ * @return (uint8_t) status : 0 if OK, or 127 if there are too many workers.
+ */
+
+uint8_t vl53l8cx_fusion_start(
+		VL53L8CX_Fusion			*p_fus,
+		uint8_t				nb_workers);
+
+/**
+ * @brief This function stops the worker threads.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_fusion_stop(
+		VL53L8CX_Fusion			*p_fus);
+
+/**
+ * @brief This function merges the frames of one epoch. It is called by a
+ * single thread.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @param (VL53L8CX_ResultsData) **pp_results : Frame of each sensor, indexed
+ * by sensor id.
+ * @param (uint16_t) sensor_mask : Bit i is set when the frame of sensor i is
+ * valid.
+ * @param (uint8_t) nb_zones : Resolution of the frames, 16 or 64.
+ * @param (VL53L8CX_FusionCloud) *p_out : Merged points.
+ * @return (uint8_t) status : 0 if OK, or 127 if the resolution is not valid
+ * or if the output is too small.
+ */
+
+uint8_t vl53l8cx_fusion_process(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_ResultsData *const *pp_results,
+		uint16_t			sensor_mask,
+		uint8_t				nb_zones,
+		VL53L8CX_FusionCloud		*p_out);
+
+/**
+ * @brief This function merges a super-frame of a sync controller. Sensors
+ * ids of both must match. Frames read with an error are skipped.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @param (VL53L8CX_SuperFrame) *p_frame : Super-frame popped from the sync
+ * controller.
+ * @param (uint8_t) nb_zones : Resolution of the frames, 16 or 64.
+ * @param (VL53L8CX_FusionCloud) *p_out : Merged points.
+ * @return (uint8_t) status : 0 if OK, or 127 if the resolution is not valid
+ * or if the output is too small.
+ */
+
+uint8_t vl53l8cx_fusion_process_superframe(
+		VL53L8CX_Fusion			*p_fus,
+		const VL53L8CX_SuperFrame	*p_frame,
+		uint8_t				nb_zones,
+		VL53L8CX_FusionCloud		*p_out);
+
+/**
+ * @brief This function reads the fusion counters.
+ * @param (VL53L8CX_Fusion) *p_fus : Fusion structure.
+ * @param (VL53L8CX_FusionStats) *p_stats : Counters values.
+ */
+
+void vl53l8cx_fusion_get_stats(
+		VL53L8CX_Fusion			*p_fus,
+		VL53L8CX_FusionStats		*p_stats);
+
+#endif /* VL53L8CX_FUSION_H_ */
@@ -0,0 +1,297 @@
+#include <string.h>
+
+#include "vl53l8cx_governor.h"
+
+/*
+ * Fits the integration time of the autonomous mode into the ranging period
+ * and into the latency budget, and estimates the latency of a frame.
+ */
+static void _vl53l8cx_governor_plan_integration(
+		VL53L8CX_Governor		*p_gov)
+{
+	uint32_t period_ms = 1000U / (uint32_t)p_gov->frequency_hz;
+	uint32_t integration_ms = VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS;
+
+	p_gov->report.infeasible &=
+		(uint8_t)~VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY;
+	if (period_ms > (p_gov->readout_ms + integration_ms))
+	{
+		integration_ms = period_ms - p_gov->readout_ms;
+	}
+	if (integration_ms > VL53L8CX_GOVERNOR_MAX_INTEGRATION_MS)
+	{
+		integration_ms = VL53L8CX_GOVERNOR_MAX_INTEGRATION_MS;
+	}
+
+	if (p_gov->ranging_mode == VL53L8CX_RANGING_MODE_AUTONOMOUS)
+	{
+		if ((p_gov->latency_budget_ms != 0U)
+			&& (p_gov->latency_budget_ms
+				< (p_gov->readout_ms + integration_ms)))
+		{
+			if (p_gov->latency_budget_ms >= (p_gov->readout_ms
+				+ VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS))
+			{
+				integration_ms = p_gov->latency_budget_ms
+					- p_gov->readout_ms;
+			}
+			else
+			{
+				integration_ms =
+					VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS;
+				p_gov->report.infeasible |=
+					VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY;
+			}
+		}
+		p_gov->integration_time_ms = integration_ms;
+		p_gov->report.estimated_latency_ms = integration_ms
+			+ p_gov->readout_ms;
+	}
+	else
+	{
+		/* In continuous mode the sensor integrates during the whole
+		 * period, the integration time is not used */
+		p_gov->report.estimated_latency_ms = period_ms
+			+ p_gov->readout_ms;
+		if ((p_gov->latency_budget_ms != 0U)
+			&& (p_gov->report.estimated_latency_ms
+				> p_gov->latency_budget_ms))
+		{
+			p_gov->report.infeasible |=
+				VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY;
+		}
+	}
+}
+
+/* Queues a setting change to the capture engine */
+static void _vl53l8cx_governor_submit(
+		VL53L8CX_Governor		*p_gov,
+		uint8_t				type,
+		uint32_t			value)
+{
+	if (vl53l8cx_command_init(&p_gov->command, type, value, NULL, NULL)
+			!= VL53L8CX_STATUS_OK)
+	{
+		return;
+	}
+	p_gov->is_command_pending = 1;
+	vl53l8cx_capture_submit(p_gov->p_cap, &p_gov->command);
+}
+
+/*
+ * Corrects the settings from the rate of the last window. A slow sensor first
+ * gets a shorter integration time, then a higher frequency, which also
+ * compensates a slow internal clock.
+ */
+static void _vl53l8cx_governor_adjust(
+		VL53L8CX_Governor		*p_gov)
+{
+	float goal_hz, tolerance_hz, achieved_hz = p_gov->report.achieved_hz;
+	uint32_t step_ms, integration_ms;
+
+	goal_hz = (float)((p_gov->target_hz < p_gov->max_hz)
+		? p_gov->target_hz : p_gov->max_hz);
+	tolerance_hz = goal_hz * (float)VL53L8CX_GOVERNOR_TOLERANCE_PERCENT
+		/ 100.0f;
+
+	if (achieved_hz < (goal_hz - tolerance_hz))
+	{
+		if ((p_gov->ranging_mode == VL53L8CX_RANGING_MODE_AUTONOMOUS)
+			&& (p_gov->integration_time_ms
+				> VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS))
+		{
+			/* Remove the time missing to each period */
+			step_ms = (uint32_t)((1000.0f / achieved_hz)
+				- (1000.0f / goal_hz) + 0.5f);
+			if (step_ms == 0U)
+			{
+				step_ms = 1;
+			}
+			integration_ms = VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS;
+			if (p_gov->integration_time_ms
+				> (VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS + step_ms))
+			{
+				integration_ms = p_gov->integration_time_ms
+					- step_ms;
+			}
+			_vl53l8cx_governor_submit(p_gov,
+				VL53L8CX_COMMAND_INTEGRATION_TIME_MS,
+				integration_ms);
+		}
+		else if (p_gov->frequency_hz < p_gov->max_hz)
+		{
+			_vl53l8cx_governor_submit(p_gov,
+				VL53L8CX_COMMAND_FREQUENCY_HZ,
+				(uint32_t)p_gov->frequency_hz + 1U);
+		}
+		else
+		{
+			p_gov->report.infeasible |=
+				VL53L8CX_GOVERNOR_INFEASIBLE_MEASURED;
+		}
+	}
+	else if ((achieved_hz > (goal_hz + tolerance_hz))
+		&& (p_gov->frequency_hz > 1U))
+	{
+		_vl53l8cx_governor_submit(p_gov, VL53L8CX_COMMAND_FREQUENCY_HZ,
+			(uint32_t)p_gov->frequency_hz - 1U);
+	}
+	else
+	{
+		p_gov->report.infeasible &=
+			(uint8_t)~VL53L8CX_GOVERNOR_INFEASIBLE_MEASURED;
+	}
+}
+
+/* Takes the result of the last change into account */
+static void _vl53l8cx_governor_settle(
+		VL53L8CX_Governor		*p_gov)
+{
+	vl53l8cx_command_deinit(&p_gov->command);
+	p_gov->is_command_pending = 0;
+	if (p_gov->command.status == VL53L8CX_STATUS_OK)
+	{
+		if (p_gov->command.type == VL53L8CX_COMMAND_FREQUENCY_HZ)
+		{
+			p_gov->frequency_hz = (uint8_t)p_gov->command.value;
+		}
+		else
+		{
+			p_gov->integration_time_ms = p_gov->command.value;
+		}
+		p_gov->report.estimated_latency_ms =
+			(p_gov->ranging_mode == VL53L8CX_RANGING_MODE_AUTONOMOUS)
+			? (p_gov->integration_time_ms + p_gov->readout_ms)
+			: ((1000U / (uint32_t)p_gov->frequency_hz)
+				+ p_gov->readout_ms);
+		p_gov->report.nb_adjustments++;
+	}
+
+	/* Frames ready before now may come from the previous settings, or
+	 * from before the restart of the ranging */
+	p_gov->last_t_ready_ns = vl53l8cx_capture_now_ns();
+	p_gov->last_streamcount = 255;
+	p_gov->window_frames = 0;
+	p_gov->window_ns = 0;
+}
+
+void vl53l8cx_governor_init(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_Capture		*p_cap,
+		uint8_t				target_hz,
+		uint32_t			latency_budget_ms)
+{
+	(void)memset(p_gov, 0, sizeof(*p_gov));
+	p_gov->p_cap = p_cap;
+	p_gov->target_hz = (target_hz != 0U) ? target_hz : (uint8_t)1U;
+	p_gov->latency_budget_ms = latency_budget_ms;
+	p_gov->last_streamcount = 255;
+}
+
+uint8_t vl53l8cx_governor_configure(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t resolution, status = VL53L8CX_STATUS_OK;
+
+	status |= vl53l8cx_get_resolution(p_dev, &resolution);
+	status |= vl53l8cx_get_ranging_mode(p_dev, &p_gov->ranging_mode);
+	if (resolution == VL53L8CX_RESOLUTION_8X8)
+	{
+		p_gov->max_hz = (uint8_t)VL53L8CX_GOVERNOR_MAX_HZ_8X8;
+		p_gov->readout_ms = VL53L8CX_GOVERNOR_READOUT_MS_8X8;
+	}
+	else
+	{
+		p_gov->max_hz = (uint8_t)VL53L8CX_GOVERNOR_MAX_HZ_4X4;
+		p_gov->readout_ms = VL53L8CX_GOVERNOR_READOUT_MS_4X4;
+	}
+
+	p_gov->report.infeasible = 0;
+	p_gov->report.nb_adjustments = 0;
+	p_gov->report.achieved_hz = 0.0f;
+	p_gov->frequency_hz = p_gov->target_hz;
+	if (p_gov->frequency_hz > p_gov->max_hz)
+	{
+		p_gov->frequency_hz = p_gov->max_hz;
+		p_gov->report.infeasible |= VL53L8CX_GOVERNOR_INFEASIBLE_RATE;
+	}
+	_vl53l8cx_governor_plan_integration(p_gov);
+
+	status |= vl53l8cx_set_ranging_frequency_hz(p_dev, p_gov->frequency_hz);
+	if (p_gov->ranging_mode == VL53L8CX_RANGING_MODE_AUTONOMOUS)
+	{
+		status |= vl53l8cx_set_integration_time_ms(p_dev,
+				p_gov->integration_time_ms);
+	}
+
+	/* A change still pending was completed by vl53l8cx_capture_stop() */
+	if (p_gov->is_command_pending
+		&& vl53l8cx_command_wait(&p_gov->command, 0))
+	{
+		vl53l8cx_command_deinit(&p_gov->command);
+	}
+	p_gov->is_command_pending = 0;
+	p_gov->last_t_ready_ns = 0;
+	p_gov->last_streamcount = 255;
+	p_gov->window_frames = 0;
+	p_gov->window_ns = 0;
+
+	return status;
+}
+
+void vl53l8cx_governor_update(
+		VL53L8CX_Governor		*p_gov,
+		const VL53L8CX_CaptureFrame	*p_frame)
+{
+	uint32_t delta;
+
+	if (p_gov->is_command_pending)
+	{
+		if (vl53l8cx_command_wait(&p_gov->command, 0) == 0U)
+		{
+			return;
+		}
+		_vl53l8cx_governor_settle(p_gov);
+	}
+
+	if ((p_frame->status != VL53L8CX_STATUS_OK)
+		|| (p_frame->streamcount == (uint8_t)255)
+		|| (p_frame->t_ready_ns <= p_gov->last_t_ready_ns))
+	{
+		return;
+	}
+
+	if (p_gov->last_streamcount != (uint8_t)255)
+	{
+		/* Streamcounts go from 0 to 254, frames not taken by the
+		 * consumer are counted too */
+		delta = ((uint32_t)p_frame->streamcount + (uint32_t)255
+			- (uint32_t)p_gov->last_streamcount) % (uint32_t)255;
+		p_gov->window_frames += delta;
+		p_gov->window_ns += p_frame->t_ready_ns - p_gov->last_t_ready_ns;
+	}
+	p_gov->last_streamcount = p_frame->streamcount;
+	p_gov->last_t_ready_ns = p_frame->t_ready_ns;
+
+	if ((p_gov->window_frames >= VL53L8CX_GOVERNOR_WINDOW_FRAMES)
+		&& (p_gov->window_ns != 0U))
+	{
+		p_gov->report.achieved_hz = (float)p_gov->window_frames * 1e9f
+			/ (float)p_gov->window_ns;
+		p_gov->window_frames = 0;
+		p_gov->window_ns = 0;
+		_vl53l8cx_governor_adjust(p_gov);
+	}
+}
+
+void vl53l8cx_governor_get_report(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_GovernorReport		*p_report)
+{
+	*p_report = p_gov->report;
+	p_report->target_hz = p_gov->target_hz;
+	p_report->latency_budget_ms = p_gov->latency_budget_ms;
+	p_report->frequency_hz = p_gov->frequency_hz;
+	p_report->integration_time_ms = p_gov->integration_time_ms;
+}
@@ -0,0 +1,159 @@
+#ifndef VL53L8CX_GOVERNOR_H_
+#define VL53L8CX_GOVERNOR_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_capture.h"
+#include "vl53l8cx_command.h"
+
+/**
+ * @brief Maximum ranging frequencies of the sensor, in Hz.
+ */
+
+#define VL53L8CX_GOVERNOR_MAX_HZ_4X4		60U
+#define VL53L8CX_GOVERNOR_MAX_HZ_8X8		15U
+
+/**
+ * @brief Time spent by the sensor on a frame outside of the integration, in
+ * ms. The integration time of the autonomous mode is planned to fit into the
+ * ranging period with this margin. The governor corrects the plan from the
+ * achieved rate, so these values only need to be close.
+ */
+
+#define VL53L8CX_GOVERNOR_READOUT_MS_4X4	4U
+#define VL53L8CX_GOVERNOR_READOUT_MS_8X8	16U
+
+/**
+ * @brief Integration time limits of the driver, in ms.
+ */
+
+#define VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS	2U
+#define VL53L8CX_GOVERNOR_MAX_INTEGRATION_MS	1000U
+
+/**
+ * @brief Number of sensor frames measured before the achieved rate is
+ * compared to the target, and allowed error on the rate, in percent.
+ */
+
+#define VL53L8CX_GOVERNOR_WINDOW_FRAMES		30U
+#define VL53L8CX_GOVERNOR_TOLERANCE_PERCENT	5U
+
+/**
+ * @brief Bits of VL53L8CX_GovernorReport.infeasible:
+ * - RATE : the target is above the maximum frequency of the resolution,
+ * - LATENCY : the latency budget is shorter than the shortest frame,
+ * - MEASURED : the target is still not reached with the shortest integration
+ * time and the maximum frequency, for instance because frames are read too
+ * slowly.
+ */
+
+#define VL53L8CX_GOVERNOR_INFEASIBLE_RATE	((uint8_t) 1U)
+#define VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY	((uint8_t) 2U)
+#define VL53L8CX_GOVERNOR_INFEASIBLE_MEASURED	((uint8_t) 4U)
+
+/**
+ * @brief Structure VL53L8CX_GovernorReport contains the settings chosen by
+ * the governor and the rate achieved.
+ */
+
+typedef struct
+{
+	/* Requested rate, in Hz, and latency budget, in ms (0 if none) */
+	uint8_t			target_hz;
+	uint32_t		latency_budget_ms;
+	/* Settings given to the sensor */
+	uint8_t			frequency_hz;
+	uint32_t		integration_time_ms;
+	/* Rate measured on the last window, in Hz (0 before the first one) */
+	float			achieved_hz;
+	/* Age of a frame when it is ready, estimated from the settings, in ms */
+	uint32_t		estimated_latency_ms;
+	/* VL53L8CX_GOVERNOR_INFEASIBLE_* bits, 0 if the target is reached */
+	uint8_t			infeasible;
+	/* Settings changed since vl53l8cx_governor_configure() */
+	uint32_t		nb_adjustments;
+} VL53L8CX_GovernorReport;
+
+/**
+ * @brief Structure VL53L8CX_Governor keeps a capture engine at a target frame
+ * rate. The settings are planned from the resolution and the ranging mode,
+ * then the achieved rate is measured from the streamcounts and the data ready
+ * times of the frames, so frames lost or skipped by the consumer are counted.
+ * When the rate is off, the integration time or the frequency are corrected
+ * through the command queue of the capture engine, one change at a time.
+ */
+
+typedef struct
+{
+	VL53L8CX_Capture	*p_cap;
+	uint8_t			target_hz;
+	uint32_t		latency_budget_ms;
+	uint8_t			max_hz;
+	uint32_t		readout_ms;
+	uint8_t			ranging_mode;
+	/* Settings given to the sensor, and change in progress */
+	uint8_t			frequency_hz;
+	uint32_t		integration_time_ms;
+	VL53L8CX_Command	command;
+	uint8_t			is_command_pending;
+	/* Measurement window */
+	uint8_t			last_streamcount;
+	uint64_t		last_t_ready_ns;
+	uint32_t		window_frames;
+	uint64_t		window_ns;
+	VL53L8CX_GovernorReport	report;
+} VL53L8CX_Governor;
+
+/**
+ * @brief This function initializes a governor.
+ * @param (VL53L8CX_Governor) *p_gov : Governor structure.
+ * @param (VL53L8CX_Capture) *p_cap : Capture engine receiving the changes.
+ * @param (uint8_t) target_hz : Requested frame rate.
+ * @param (uint32_t) latency_budget_ms : Maximum age of a frame when it is
+ * ready, or 0 for no limit.
+ */
+
+void vl53l8cx_governor_init(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_Capture		*p_cap,
+		uint8_t				target_hz,
+		uint32_t			latency_budget_ms);
+
+/**
+ * @brief This function plans and sets the frequency and the integration time
+ * for the current resolution and ranging mode. It must be called before
+ * vl53l8cx_capture_start(), and again after a resolution change.
+ * @param (VL53L8CX_Governor) *p_gov : Governor structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device, not ranging.
+ * @return (uint8_t) status : 0 if OK. An infeasible target is not an error,
+ * it is given by vl53l8cx_governor_get_report().
+ */
+
+uint8_t vl53l8cx_governor_configure(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function measures a frame, and corrects the settings at the end
+ * of each window. It is called by the consumer thread for each frame taken
+ * from the capture engine.
+ * @param (VL53L8CX_Governor) *p_gov : Governor structure.
+ * @param (VL53L8CX_CaptureFrame) *p_frame : Frame taken from the capture.
+ */
+
+void vl53l8cx_governor_update(
+		VL53L8CX_Governor		*p_gov,
+		const VL53L8CX_CaptureFrame	*p_frame);
+
+/**
+ * @brief This function gives the settings and the achieved rate.
+ * @param (VL53L8CX_Governor) *p_gov : Governor structure.
+ * @param (VL53L8CX_GovernorReport) *p_report : Settings and rate.
+ */
+
+void vl53l8cx_governor_get_report(
+		VL53L8CX_Governor		*p_gov,
+		VL53L8CX_GovernorReport		*p_report);
+
+#endif /* VL53L8CX_GOVERNOR_H_ */
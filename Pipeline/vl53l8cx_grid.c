@@ -0,0 +1,448 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_grid.h"
+#include "vl53l8cx_pipeline.h"
+
+#define _VL53L8CX_GRID_HALF_WIDTH	((int32_t)VL53L8CX_GRID_WIDTH / 2)
+#define _VL53L8CX_GRID_MAX_EXIT_MM	65535.0f
+
+/* Floor of a division by 8, for negative cells too */
+static inline int32_t _vl53l8cx_grid_tile_of(
+		int32_t				cell)
+{
+	return (cell - (int32_t)((uint32_t)cell
+		& (VL53L8CX_GRID_TILE_WIDTH - 1U)))
+		/ (int32_t)VL53L8CX_GRID_TILE_WIDTH;
+}
+
+static inline int32_t _vl53l8cx_grid_cell_of(
+		const VL53L8CX_Grid		*p_grid,
+		float				pos_mm)
+{
+	return (int32_t)floorf(pos_mm / p_grid->config.cell_mm);
+}
+
+/* Tile and bit of a cell: cells wrap around every VL53L8CX_GRID_WIDTH */
+static inline uint32_t _vl53l8cx_grid_tile(
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	return ((((uint32_t)cell_z / VL53L8CX_GRID_TILE_WIDTH)
+		% VL53L8CX_GRID_NB_TILES_WIDTH) * VL53L8CX_GRID_NB_TILES_WIDTH)
+		+ (((uint32_t)cell_x / VL53L8CX_GRID_TILE_WIDTH)
+		% VL53L8CX_GRID_NB_TILES_WIDTH);
+}
+
+static inline uint32_t _vl53l8cx_grid_bit(
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	return (((uint32_t)cell_z % VL53L8CX_GRID_TILE_WIDTH)
+		* VL53L8CX_GRID_TILE_WIDTH)
+		+ ((uint32_t)cell_x % VL53L8CX_GRID_TILE_WIDTH);
+}
+
+static inline uint8_t _vl53l8cx_grid_is_inside(
+		const VL53L8CX_Grid		*p_grid,
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	return (uint8_t)((cell_x >= (p_grid->cell_x - _VL53L8CX_GRID_HALF_WIDTH))
+		&& (cell_x < (p_grid->cell_x + _VL53L8CX_GRID_HALF_WIDTH))
+		&& (cell_z >= (p_grid->cell_z - _VL53L8CX_GRID_HALF_WIDTH))
+		&& (cell_z < (p_grid->cell_z + _VL53L8CX_GRID_HALF_WIDTH)));
+}
+
+static inline void _vl53l8cx_grid_add(
+		VL53L8CX_Grid			*p_grid,
+		int32_t				cell_x,
+		int32_t				cell_z,
+		int32_t				delta)
+{
+	uint32_t tile = _vl53l8cx_grid_tile(cell_x, cell_z);
+	uint32_t bit = _vl53l8cx_grid_bit(cell_x, cell_z);
+	int32_t log_odds = (int32_t)p_grid->log_odds[tile][bit] + delta;
+
+	if (log_odds < p_grid->config.min_log_odds)
+	{
+		log_odds = p_grid->config.min_log_odds;
+	}
+	else if (log_odds > p_grid->config.max_log_odds)
+	{
+		log_odds = p_grid->config.max_log_odds;
+	}
+	p_grid->log_odds[tile][bit] = (int8_t)log_odds;
+
+	if (log_odds >= p_grid->config.occupied)
+	{
+		p_grid->occupied[tile] |= (uint64_t)1U << bit;
+	}
+	else
+	{
+		p_grid->occupied[tile] &= ~((uint64_t)1U << bit);
+	}
+}
+
+static void _vl53l8cx_grid_clear_cell(
+		VL53L8CX_Grid			*p_grid,
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	uint32_t tile = _vl53l8cx_grid_tile(cell_x, cell_z);
+	uint32_t bit = _vl53l8cx_grid_bit(cell_x, cell_z);
+
+	p_grid->log_odds[tile][bit] = 0;
+	p_grid->occupied[tile] &= ~((uint64_t)1U << bit);
+}
+
+/*
+ * Clears the cells entering the grid when the device moves from cell 'from'
+ * to cell 'to' along an axis, 'is_x' for the columns.
+ */
+static void _vl53l8cx_grid_scroll(
+		VL53L8CX_Grid			*p_grid,
+		int32_t				from,
+		int32_t				to,
+		uint8_t				is_x)
+{
+	int32_t first, last, line, i;
+
+	if (to > from)
+	{
+		first = from + _VL53L8CX_GRID_HALF_WIDTH;
+		last = to + _VL53L8CX_GRID_HALF_WIDTH - 1;
+	}
+	else
+	{
+		first = to - _VL53L8CX_GRID_HALF_WIDTH;
+		last = from - _VL53L8CX_GRID_HALF_WIDTH - 1;
+	}
+
+	for (line = first; line <= last; line++)
+	{
+		for (i = 0; i < (int32_t)VL53L8CX_GRID_WIDTH; i++)
+		{
+			if (is_x)
+			{
+				_vl53l8cx_grid_clear_cell(p_grid, line, i);
+			}
+			else
+			{
+				_vl53l8cx_grid_clear_cell(p_grid, i, line);
+			}
+		}
+	}
+}
+
+uint8_t vl53l8cx_grid_init(
+		VL53L8CX_Grid			*p_grid,
+		const VL53L8CX_GridConfig	*p_config)
+{
+	(void)memset(p_grid, 0, sizeof(*p_grid));
+	if (p_config != NULL)
+	{
+		p_grid->config = *p_config;
+	}
+	else
+	{
+		p_grid->config.cell_mm = VL53L8CX_GRID_DEFAULT_CELL_MM;
+		p_grid->config.max_range_mm = VL53L8CX_GRID_DEFAULT_MAX_RANGE_MM;
+		p_grid->config.min_height_mm =
+			VL53L8CX_GRID_DEFAULT_MIN_HEIGHT_MM;
+		p_grid->config.max_height_mm =
+			VL53L8CX_GRID_DEFAULT_MAX_HEIGHT_MM;
+		p_grid->config.hit = VL53L8CX_GRID_DEFAULT_HIT;
+		p_grid->config.miss = VL53L8CX_GRID_DEFAULT_MISS;
+		p_grid->config.min_log_odds = VL53L8CX_GRID_DEFAULT_MIN_LOG_ODDS;
+		p_grid->config.max_log_odds = VL53L8CX_GRID_DEFAULT_MAX_LOG_ODDS;
+		p_grid->config.occupied = VL53L8CX_GRID_DEFAULT_OCCUPIED;
+	}
+
+	if ((p_grid->config.cell_mm <= 0.0f)
+		|| (p_grid->config.min_log_odds > 0)
+		|| (p_grid->config.max_log_odds < p_grid->config.occupied)
+		|| (p_grid->config.occupied <= 0))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_grid_footprint_init(
+		const VL53L8CX_Grid		*p_grid,
+		VL53L8CX_GridFootprint		*p_fp,
+		const VL53L8CX_PointCloudPose	*p_pose,
+		uint8_t				nb_zones)
+{
+	VL53L8CX_PointCloudConverter conv;
+	const VL53L8CX_PointCloudLut *p_lut;
+	float cell = p_grid->config.cell_mm;
+	float u, v, hx, hz, t_max_x, t_max_z, t_delta_x, t_delta_z, t_exit;
+	int32_t ix, iz, step_x, step_z;
+	uint32_t zone, n;
+
+	if ((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	vl53l8cx_pointcloud_init(&conv, p_pose);
+	p_lut = (nb_zones == VL53L8CX_RESOLUTION_4X4)
+		? &conv.lut_4x4 : &conv.lut_8x8;
+	(void)memset(p_fp, 0, sizeof(*p_fp));
+	p_fp->nb_zones = nb_zones;
+	p_fp->y_mm = conv.pose.translation_mm[1];
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		p_fp->dir_y[zone] = p_lut->dir_y[zone];
+		hx = p_lut->dir_x[zone];
+		hz = p_lut->dir_z[zone];
+
+		/* Cells crossed by the ray (Amanatides-Woo), in cell units from
+		 * the center of the cell of the device */
+		u = 0.5f + (conv.pose.translation_mm[0] / cell);
+		v = 0.5f + (conv.pose.translation_mm[2] / cell);
+		ix = (int32_t)floorf(u);
+		iz = (int32_t)floorf(v);
+		step_x = (hx > 0.0f) ? 1 : -1;
+		step_z = (hz > 0.0f) ? 1 : -1;
+		t_delta_x = (hx != 0.0f) ? (cell / fabsf(hx)) : INFINITY;
+		t_delta_z = (hz != 0.0f) ? (cell / fabsf(hz)) : INFINITY;
+		t_max_x = (hx > 0.0f) ? (((float)(ix + 1) - u) * t_delta_x)
+			: ((u - (float)ix) * t_delta_x);
+		t_max_z = (hz > 0.0f) ? (((float)(iz + 1) - v) * t_delta_z)
+			: ((v - (float)iz) * t_delta_z);
+
+		for (n = 0; n < VL53L8CX_GRID_MAX_RAY_CELLS; n++)
+		{
+			if ((ix < -(_VL53L8CX_GRID_HALF_WIDTH - 1))
+				|| (ix > (_VL53L8CX_GRID_HALF_WIDTH - 1))
+				|| (iz < -(_VL53L8CX_GRID_HALF_WIDTH - 1))
+				|| (iz > (_VL53L8CX_GRID_HALF_WIDTH - 1)))
+			{
+				break;
+			}
+			t_exit = fminf(t_max_x, t_max_z);
+			p_fp->dx[zone][n] = (int8_t)ix;
+			p_fp->dz[zone][n] = (int8_t)iz;
+			p_fp->exit_mm[zone][n] = (uint16_t)fminf(t_exit,
+					_VL53L8CX_GRID_MAX_EXIT_MM);
+			if (t_exit >= p_grid->config.max_range_mm)
+			{
+				n++;
+				break;
+			}
+			if (t_max_x < t_max_z)
+			{
+				ix += step_x;
+				t_max_x += t_delta_x;
+			}
+			else
+			{
+				iz += step_z;
+				t_max_z += t_delta_z;
+			}
+		}
+		p_fp->nb_cells[zone] = (uint8_t)n;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+void vl53l8cx_grid_move(
+		VL53L8CX_Grid			*p_grid,
+		float				dx_mm,
+		float				dz_mm)
+{
+	int32_t cell_x, cell_z;
+
+	p_grid->x_mm += dx_mm;
+	p_grid->z_mm += dz_mm;
+	cell_x = _vl53l8cx_grid_cell_of(p_grid, p_grid->x_mm);
+	cell_z = _vl53l8cx_grid_cell_of(p_grid, p_grid->z_mm);
+
+	if ((abs(cell_x - p_grid->cell_x) >= (int32_t)VL53L8CX_GRID_WIDTH)
+		|| (abs(cell_z - p_grid->cell_z) >= (int32_t)VL53L8CX_GRID_WIDTH))
+	{
+		(void)memset(p_grid->log_odds, 0, sizeof(p_grid->log_odds));
+		(void)memset(p_grid->occupied, 0, sizeof(p_grid->occupied));
+	}
+	else
+	{
+		if (cell_x != p_grid->cell_x)
+		{
+			_vl53l8cx_grid_scroll(p_grid, p_grid->cell_x, cell_x, 1);
+		}
+		if (cell_z != p_grid->cell_z)
+		{
+			_vl53l8cx_grid_scroll(p_grid, p_grid->cell_z, cell_z, 0);
+		}
+	}
+	p_grid->cell_x = cell_x;
+	p_grid->cell_z = cell_z;
+}
+
+uint8_t vl53l8cx_grid_update(
+		VL53L8CX_Grid			*p_grid,
+		const VL53L8CX_GridFootprint	*p_fp,
+		const VL53L8CX_ResultsData	*p_results)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	uint64_t mask;
+	float distance, height;
+	uint32_t zone, idx, n;
+	uint8_t is_hit;
+
+	mask = vl53l8cx_valid_zones(p_results, p_fp->nb_zones);
+
+	for (; mask != 0U; mask &= mask - 1U)
+	{
+		zone = (uint32_t)__builtin_ctzll(mask);
+		if (zone >= p_fp->nb_zones)
+		{
+			break;
+		}
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		distance = (float)p_results->distance_mm[idx];
+		if (distance <= 0.0f)
+		{
+			continue;
+		}
+		height = p_fp->y_mm + (distance * p_fp->dir_y[zone]);
+		is_hit = (uint8_t)((distance <= p_grid->config.max_range_mm)
+			&& (height >= p_grid->config.min_height_mm)
+			&& (height <= p_grid->config.max_height_mm));
+
+		/* Free cells up to the target, then the cell of the target */
+		for (n = 0; n < p_fp->nb_cells[zone]; n++)
+		{
+			if ((float)p_fp->exit_mm[zone][n] < distance)
+			{
+				_vl53l8cx_grid_add(p_grid,
+					p_grid->cell_x + p_fp->dx[zone][n],
+					p_grid->cell_z + p_fp->dz[zone][n],
+					p_grid->config.miss);
+			}
+			else
+			{
+				if (is_hit)
+				{
+					_vl53l8cx_grid_add(p_grid,
+						p_grid->cell_x
+						+ p_fp->dx[zone][n],
+						p_grid->cell_z
+						+ p_fp->dz[zone][n],
+						p_grid->config.hit);
+				}
+				break;
+			}
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_grid;
+	(void)p_fp;
+	(void)p_results;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
+
+void vl53l8cx_grid_nearest(
+		const VL53L8CX_Grid		*p_grid,
+		VL53L8CX_GridObstacle		*p_obstacle)
+{
+	float cell = p_grid->config.cell_mm;
+	float dx, dz, d2, best = INFINITY;
+	uint64_t mask;
+	int32_t tile_x = _vl53l8cx_grid_tile_of(p_grid->cell_x);
+	int32_t tile_z = _vl53l8cx_grid_tile_of(p_grid->cell_z);
+	int32_t ring, tx, tz, cell_x, cell_z;
+	uint32_t bit;
+
+	(void)memset(p_obstacle, 0, sizeof(*p_obstacle));
+
+	for (ring = 0; ring <= (int32_t)(VL53L8CX_GRID_NB_TILES_WIDTH / 2U);
+			ring++)
+	{
+		for (tz = tile_z - ring; tz <= (tile_z + ring); tz++)
+		{
+			for (tx = tile_x - ring; tx <= (tile_x + ring); tx++)
+			{
+				if ((abs(tx - tile_x) != ring)
+					&& (abs(tz - tile_z) != ring))
+				{
+					continue;
+				}
+				mask = p_grid->occupied[_vl53l8cx_grid_tile(
+					tx * (int32_t)VL53L8CX_GRID_TILE_WIDTH,
+					tz * (int32_t)VL53L8CX_GRID_TILE_WIDTH)];
+				for (; mask != 0U; mask &= mask - 1U)
+				{
+					bit = (uint32_t)__builtin_ctzll(mask);
+					cell_x = (tx * (int32_t)VL53L8CX_GRID_TILE_WIDTH)
+						+ (int32_t)(bit
+						% VL53L8CX_GRID_TILE_WIDTH);
+					cell_z = (tz * (int32_t)VL53L8CX_GRID_TILE_WIDTH)
+						+ (int32_t)(bit
+						/ VL53L8CX_GRID_TILE_WIDTH);
+					/* The tile may wrap onto cells of the
+					 * other side of the grid */
+					if (!_vl53l8cx_grid_is_inside(p_grid,
+							cell_x, cell_z))
+					{
+						continue;
+					}
+					dx = (((float)cell_x + 0.5f) * cell)
+						- p_grid->x_mm;
+					dz = (((float)cell_z + 0.5f) * cell)
+						- p_grid->z_mm;
+					d2 = (dx * dx) + (dz * dz);
+					if (d2 < best)
+					{
+						best = d2;
+						p_obstacle->is_found = 1;
+						p_obstacle->x_mm = dx + p_grid->x_mm;
+						p_obstacle->z_mm = dz + p_grid->z_mm;
+					}
+				}
+			}
+		}
+
+		/* Cells of the next ring are at least this far */
+		dx = (((float)ring * (float)VL53L8CX_GRID_TILE_WIDTH) + 0.5f)
+			* cell;
+		if (p_obstacle->is_found && (best <= (dx * dx)))
+		{
+			break;
+		}
+	}
+
+	if (p_obstacle->is_found)
+	{
+		p_obstacle->distance_mm = sqrtf(best);
+	}
+}
+
+int8_t vl53l8cx_grid_get(
+		const VL53L8CX_Grid		*p_grid,
+		float				x_mm,
+		float				z_mm)
+{
+	int32_t cell_x = _vl53l8cx_grid_cell_of(p_grid, x_mm);
+	int32_t cell_z = _vl53l8cx_grid_cell_of(p_grid, z_mm);
+
+	if (!_vl53l8cx_grid_is_inside(p_grid, cell_x, cell_z))
+	{
+		return 0;
+	}
+
+	return p_grid->log_odds[_vl53l8cx_grid_tile(cell_x, cell_z)]
+		[_vl53l8cx_grid_bit(cell_x, cell_z)];
+}
@@ -0,0 +1,220 @@
+#ifndef VL53L8CX_GRID_H_
+#define VL53L8CX_GRID_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pointcloud.h"
+
+/**
+ * @brief Size of the grid: tiles of 8x8 cells (one 64 bytes cache line), and
+ * 16x16 tiles, so 128x128 cells around the device.
+ */
+
+#define VL53L8CX_GRID_TILE_WIDTH		8U
+#define VL53L8CX_GRID_NB_TILES_WIDTH		16U
+#define VL53L8CX_GRID_WIDTH			(VL53L8CX_GRID_TILE_WIDTH \
+		* VL53L8CX_GRID_NB_TILES_WIDTH)
+#define VL53L8CX_GRID_NB_TILES			(VL53L8CX_GRID_NB_TILES_WIDTH \
+		* VL53L8CX_GRID_NB_TILES_WIDTH)
+#define VL53L8CX_GRID_TILE_CELLS		(VL53L8CX_GRID_TILE_WIDTH \
+		* VL53L8CX_GRID_TILE_WIDTH)
+
+/**
+ * @brief Maximum number of cells crossed by the ray of a zone. Rays stop at
+ * half the grid width.
+ */
+
+#define VL53L8CX_GRID_MAX_RAY_CELLS		VL53L8CX_GRID_WIDTH
+
+/**
+ * @brief Default grid: cells of 50 mm (6.4 m around the device), obstacles
+ * between 1.5 m below and 1.5 m above the sensors. Log-odds are in tenths
+ * (10 * ln(p / (1 - p))): a hit is p = 0.7, a miss p = 0.4, and a cell is
+ * occupied after two hits.
+ */
+
+#define VL53L8CX_GRID_DEFAULT_CELL_MM		50.0f
+#define VL53L8CX_GRID_DEFAULT_MAX_RANGE_MM	4000.0f
+#define VL53L8CX_GRID_DEFAULT_MIN_HEIGHT_MM	(-1500.0f)
+#define VL53L8CX_GRID_DEFAULT_MAX_HEIGHT_MM	1500.0f
+#define VL53L8CX_GRID_DEFAULT_HIT		8
+#define VL53L8CX_GRID_DEFAULT_MISS		(-4)
+#define VL53L8CX_GRID_DEFAULT_MIN_LOG_ODDS	(-20)
+#define VL53L8CX_GRID_DEFAULT_MAX_LOG_ODDS	35
+#define VL53L8CX_GRID_DEFAULT_OCCUPIED		10
+
+/**
+ * @brief Structure VL53L8CX_GridConfig contains the grid settings.
+ */
+
+typedef struct
+{
+	/* Width of a cell, in mm */
+	float			cell_mm;
+	/* Distances above are not marked as obstacles, and rays are cleared
+	 * up to this range only, in mm */
+	float			max_range_mm;
+	/* Height band of the obstacles (body y axis), in mm. Targets out of
+	 * it (floor, ceiling) only clear the cells before them */
+	float			min_height_mm;
+	float			max_height_mm;
+	/* Log-odds added for a hit and for a miss, and bounds */
+	int8_t			hit;
+	int8_t			miss;
+	int8_t			min_log_odds;
+	int8_t			max_log_odds;
+	/* A cell is an obstacle from this log-odds */
+	int8_t			occupied;
+} VL53L8CX_GridConfig;
+
+/**
+ * @brief Structure VL53L8CX_GridObstacle is the result of a nearest obstacle
+ * query.
+ */
+
+typedef struct
+{
+	uint8_t			is_found;
+	/* Center of the cell into the grid frame, and distance to the device,
+	 * in mm */
+	float			x_mm;
+	float			z_mm;
+	float			distance_mm;
+} VL53L8CX_GridObstacle;
+
+/**
+ * @brief Structure VL53L8CX_Grid is a rolling occupancy grid on the
+ * horizontal plane (x, z) of the body frame, centered on the device. The
+ * grid frame has the axes of the body frame, and its origin where the device
+ * was initialized. Cells are stored by tiles of 8x8, and wrap around: when the
+ * device moves, only the rows and columns leaving the grid are cleared. Each
+ * tile has a bit mask of its occupied cells, so queries skip empty tiles.
+ */
+
+typedef struct
+{
+	VL53L8CX_GridConfig	config;
+	/* Position of the device into the grid frame, in mm, and its cell */
+	float			x_mm;
+	float			z_mm;
+	int32_t			cell_x;
+	int32_t			cell_z;
+	/* Log-odds of each cell, by tile */
+	_Alignas(64) int8_t	log_odds[VL53L8CX_GRID_NB_TILES]
+					[VL53L8CX_GRID_TILE_CELLS];
+	/* Bit i of occupied[t] is set when cell i of tile t is an obstacle */
+	uint64_t		occupied[VL53L8CX_GRID_NB_TILES];
+} VL53L8CX_Grid;
+
+/**
+ * @brief Structure VL53L8CX_GridFootprint contains the cells crossed by the
+ * ray of each zone of a sensor, relative to the cell of the device, with the
+ * distance at which the ray leaves each of them. It is computed once for a
+ * mounting pose, and a grid can be updated by several sensors, each with its
+ * own footprint.
+ */
+
+typedef struct
+{
+	uint8_t			nb_zones;
+	/* Mounting height, and vertical part of the direction of each zone */
+	float			y_mm;
+	float			dir_y[VL53L8CX_RESOLUTION_8X8];
+	/* Cells crossed by each zone */
+	uint8_t			nb_cells[VL53L8CX_RESOLUTION_8X8];
+	int8_t			dx[VL53L8CX_RESOLUTION_8X8]
+					[VL53L8CX_GRID_MAX_RAY_CELLS];
+	int8_t			dz[VL53L8CX_RESOLUTION_8X8]
+					[VL53L8CX_GRID_MAX_RAY_CELLS];
+	/* Distance along the ray where it leaves the cell, in mm */
+	uint16_t		exit_mm[VL53L8CX_RESOLUTION_8X8]
+					[VL53L8CX_GRID_MAX_RAY_CELLS];
+} VL53L8CX_GridFootprint;
+
+/**
+ * @brief This function initializes an empty grid, with the device at the
+ * origin.
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (VL53L8CX_GridConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ * @return (uint8_t) status : 0 if OK, or 127 if the settings are not valid.
+ */
+
+uint8_t vl53l8cx_grid_init(
+		VL53L8CX_Grid			*p_grid,
+		const VL53L8CX_GridConfig	*p_config);
+
+/**
+ * @brief This function computes the footprint of a sensor. The ray of each
+ * zone starts from the cell of the device, so the position of the device
+ * into its cell is not taken into account (half a cell at most).
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (VL53L8CX_GridFootprint) *p_fp : Footprint to compute.
+ * @param (VL53L8CX_PointCloudPose) *p_pose : Pose of the sensor into the body
+ * frame, or NULL for the sensor frame.
+ * @param (uint8_t) nb_zones : Resolution of the sensor, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or 127 if the resolution is not valid.
+ */
+
+uint8_t vl53l8cx_grid_footprint_init(
+		const VL53L8CX_Grid		*p_grid,
+		VL53L8CX_GridFootprint		*p_fp,
+		const VL53L8CX_PointCloudPose	*p_pose,
+		uint8_t				nb_zones);
+
+/**
+ * @brief This function moves the device into the grid frame (odometry). The
+ * cells leaving the grid are cleared.
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (float) dx_mm : Move along x, in mm.
+ * @param (float) dz_mm : Move along z, in mm.
+ */
+
+void vl53l8cx_grid_move(
+		VL53L8CX_Grid			*p_grid,
+		float				dx_mm,
+		float				dz_mm);
+
+/**
+ * @brief This function updates the cells crossed by the valid zones of a
+ * frame: cells before the target are free, the cell of the target is
+ * occupied. Other cells are not accessed. Invalid zones are skipped.
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (VL53L8CX_GridFootprint) *p_fp : Footprint of the sensor.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame of the sensor.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_grid_update(
+		VL53L8CX_Grid			*p_grid,
+		const VL53L8CX_GridFootprint	*p_fp,
+		const VL53L8CX_ResultsData	*p_results);
+
+/**
+ * @brief This function finds the obstacle nearest to the device, searching
+ * the tiles by rings of increasing distance.
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (VL53L8CX_GridObstacle) *p_obstacle : Nearest obstacle, is_found is
+ * 0 if the grid has none.
+ */
+
+void vl53l8cx_grid_nearest(
+		const VL53L8CX_Grid		*p_grid,
+		VL53L8CX_GridObstacle		*p_obstacle);
+
+/**
+ * @brief This function gives the log-odds of the cell containing a point.
+ * @param (VL53L8CX_Grid) *p_grid : Grid structure.
+ * @param (float) x_mm : Point into the grid frame, in mm.
+ * @param (float) z_mm : Point into the grid frame, in mm.
+ * @return (int8_t) log_odds : Log-odds of the cell, 0 (unknown) out of the
+ * grid.
+ */
+
+int8_t vl53l8cx_grid_get(
+		const VL53L8CX_Grid		*p_grid,
+		float				x_mm,
+		float				z_mm);
+
+#endif /* VL53L8CX_GRID_H_ */
@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "vl53l8cx_latency.h"
+
+#define LATENCY_SUB_BINS	(1U << VL53L8CX_LATENCY_SUB_BITS)
+
+/*
+ * Bins below LATENCY_SUB_BINS hold exact values. Above, the bin is given by
+ * the position of the leading 1 and by the VL53L8CX_LATENCY_SUB_BITS bits
+ * which follow it.
+ */
+static uint32_t _vl53l8cx_latency_bin(uint64_t value_ns)
+{
+	uint32_t msb;
+
+	if (value_ns < (uint64_t)LATENCY_SUB_BINS)
+	{
+		return (uint32_t)value_ns;
+	}
+
+	msb = 63U - (uint32_t)__builtin_clzll(value_ns);
+	if (msb >= VL53L8CX_LATENCY_MAX_BITS)
+	{
+		return VL53L8CX_LATENCY_NB_BINS - 1U;
+	}
+
+	return (LATENCY_SUB_BINS * (msb - VL53L8CX_LATENCY_SUB_BITS + 1U))
+		+ (uint32_t)((value_ns >> (msb - VL53L8CX_LATENCY_SUB_BITS))
+			& (LATENCY_SUB_BINS - 1U));
+}
+
+/* Middle of the values range covered by a bin */
+static uint64_t _vl53l8cx_latency_bin_value(uint32_t bin)
+{
+	uint32_t msb, sub;
+	uint64_t width;
+
+	if (bin < LATENCY_SUB_BINS)
+	{
+		return (uint64_t)bin;
+	}
+
+	msb = (bin / LATENCY_SUB_BINS) + VL53L8CX_LATENCY_SUB_BITS - 1U;
+	sub = bin % LATENCY_SUB_BINS;
+	width = (uint64_t)1 << (msb - VL53L8CX_LATENCY_SUB_BITS);
+
+	return ((uint64_t)1 << msb) + ((uint64_t)sub * width) + (width / 2U);
+}
+
+static uint64_t _vl53l8cx_latency_percentile(
+		const VL53L8CX_LatencyHistogram	*p_hist,
+		uint32_t			percent)
+{
+	uint64_t target, cumul = 0, value;
+	uint32_t i;
+
+	if (p_hist->count == 0U)
+	{
+		return 0;
+	}
+
+	target = (((uint64_t)p_hist->count * percent) + 99U) / 100U;
+	for (i = 0; i < VL53L8CX_LATENCY_NB_BINS; i++)
+	{
+		cumul += p_hist->bins[i];
+		if (cumul >= target)
+		{
+			break;
+		}
+	}
+
+	/* The last bin also holds the clamped values, only bounded by max */
+	if (i >= (VL53L8CX_LATENCY_NB_BINS - 1U))
+	{
+		return p_hist->max_ns;
+	}
+
+	value = _vl53l8cx_latency_bin_value(i);
+	return (value > p_hist->max_ns) ? p_hist->max_ns : value;
+}
+
+void vl53l8cx_latency_reset(
+		VL53L8CX_Latency		*p_lat)
+{
+	(void)memset(p_lat, 0, sizeof(*p_lat));
+}
+
+void vl53l8cx_latency_record(
+		VL53L8CX_Latency		*p_lat,
+		uint8_t				stage,
+		uint64_t			value_ns)
+{
+	VL53L8CX_LatencyHistogram *p_hist;
+
+	if (stage >= VL53L8CX_LATENCY_NB_STAGES)
+	{
+		return;
+	}
+
+	p_hist = &p_lat->stage[stage];
+	p_hist->bins[_vl53l8cx_latency_bin(value_ns)]++;
+	p_hist->count++;
+	if (value_ns > p_hist->max_ns)
+	{
+		p_hist->max_ns = value_ns;
+	}
+}
+
+void vl53l8cx_latency_record_frame(
+		VL53L8CX_Latency		*p_lat,
+		const VL53L8CX_CaptureFrame	*p_frame)
+{
+	vl53l8cx_latency_record(p_lat, VL53L8CX_LATENCY_STAGE_READ,
+			p_frame->t_read_ns - p_frame->t_ready_ns);
+	vl53l8cx_latency_record(p_lat, VL53L8CX_LATENCY_STAGE_DECODE,
+			p_frame->t_decoded_ns - p_frame->t_read_ns);
+	vl53l8cx_latency_record(p_lat, VL53L8CX_LATENCY_STAGE_QUEUE,
+			p_frame->t_handoff_ns - p_frame->t_decoded_ns);
+	vl53l8cx_latency_record(p_lat, VL53L8CX_LATENCY_STAGE_TOTAL,
+			p_frame->t_handoff_ns - p_frame->t_ready_ns);
+}
+
+void vl53l8cx_latency_get_report(
+		const VL53L8CX_Latency		*p_lat,
+		VL53L8CX_LatencyReport		*p_report)
+{
+	uint8_t i;
+
+	for (i = 0; i < VL53L8CX_LATENCY_NB_STAGES; i++)
+	{
+		p_report->stage[i].count = p_lat->stage[i].count;
+		p_report->stage[i].p50_ns = _vl53l8cx_latency_percentile(
+				&p_lat->stage[i], 50);
+		p_report->stage[i].p99_ns = _vl53l8cx_latency_percentile(
+				&p_lat->stage[i], 99);
+		p_report->stage[i].max_ns = p_lat->stage[i].max_ns;
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef VL53L8CX_LATENCY_H_
+#define VL53L8CX_LATENCY_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_capture.h"
+
+/**
+ * @brief Macros VL53L8CX_LATENCY_STAGE_* identify the measured intervals of a
+ * frame:
+ * - READ : data ready detected to SPI read completed.
+ * - DECODE : SPI read completed to decoding completed.
+ * - QUEUE : decoding completed to hand-off to the consumer.
+ * - TOTAL : data ready detected to hand-off to the consumer.
+ */
+
+#define VL53L8CX_LATENCY_STAGE_READ		((uint8_t) 0U)
+#define VL53L8CX_LATENCY_STAGE_DECODE		((uint8_t) 1U)
+#define VL53L8CX_LATENCY_STAGE_QUEUE		((uint8_t) 2U)
+#define VL53L8CX_LATENCY_STAGE_TOTAL		((uint8_t) 3U)
+#define VL53L8CX_LATENCY_NB_STAGES		((uint8_t) 4U)
+
+/**
+ * @brief Histogram layout. Values are stored into log-linear bins: each power
+ * of 2 is split into 2^VL53L8CX_LATENCY_SUB_BITS bins, which gives a relative
+ * error below 7%. Values above 2^VL53L8CX_LATENCY_MAX_BITS ns (~18 minutes)
+ * are clamped into the last bin, and a percentile falling into it is reported
+ * as the max.
+ */
+
+#define VL53L8CX_LATENCY_SUB_BITS		4U
+#define VL53L8CX_LATENCY_MAX_BITS		40U
+#define VL53L8CX_LATENCY_NB_BINS		((1U << VL53L8CX_LATENCY_SUB_BITS) \
+	* (VL53L8CX_LATENCY_MAX_BITS - VL53L8CX_LATENCY_SUB_BITS + 1U))
+
+/**
+ * @brief Structure VL53L8CX_LatencyHistogram contains the distribution of one
+ * stage.
+ */
+
+typedef struct
+{
+	uint32_t		count;
+	uint64_t		max_ns;
+	uint32_t		bins[VL53L8CX_LATENCY_NB_BINS];
+} VL53L8CX_LatencyHistogram;
+
+/**
+ * @brief Structure VL53L8CX_Latency accumulates the per-stage distributions
+ * over a run. It is updated by a single thread, usually the frames consumer.
+ */
+
+typedef struct
+{
+	VL53L8CX_LatencyHistogram	stage[VL53L8CX_LATENCY_NB_STAGES];
+} VL53L8CX_Latency;
+
+/**
+ * @brief Structure VL53L8CX_LatencyReport contains the summary of each stage.
+ */
+
+typedef struct
+{
+	struct
+	{
+		uint32_t	count;
+		uint64_t	p50_ns;
+		uint64_t	p99_ns;
+		uint64_t	max_ns;
+	} stage[VL53L8CX_LATENCY_NB_STAGES];
+} VL53L8CX_LatencyReport;
+
+/**
+ * @brief This function clears all the distributions.
+ * @param (VL53L8CX_Latency) *p_lat : Latency structure.
+ */
+
+void vl53l8cx_latency_reset(
+		VL53L8CX_Latency		*p_lat);
+
+/**
+ * @brief This function adds one sample to a stage distribution.
+ * @param (VL53L8CX_Latency) *p_lat : Latency structure.
+ * @param (uint8_t) stage : Stage, using macros VL53L8CX_LATENCY_STAGE_*.
+ * @param (uint64_t) value_ns : Measured interval in ns.
+ */
+
+void vl53l8cx_latency_record(
+		VL53L8CX_Latency		*p_lat,
+		uint8_t				stage,
+		uint64_t			value_ns);
+
+/**
+ * @brief This function adds the intervals of a captured frame to all the
+ * stage distributions. The frame must have been handed off, using
+ * vl53l8cx_capture_pop() or vl53l8cx_capture_peek*().
+ * @param (VL53L8CX_Latency) *p_lat : Latency structure.
+ * @param (VL53L8CX_CaptureFrame) *p_frame : Captured frame.
+ */
+
+void vl53l8cx_latency_record_frame(
+		VL53L8CX_Latency		*p_lat,
+		const VL53L8CX_CaptureFrame	*p_frame);
+
+/**
+ * @brief This function computes the p50, p99 and max of each stage.
+ * @param (VL53L8CX_Latency) *p_lat : Latency structure.
+ * @param (VL53L8CX_LatencyReport) *p_report : Computed report.
+ */
+
+void vl53l8cx_latency_get_report(
+		const VL53L8CX_Latency		*p_lat,
+		VL53L8CX_LatencyReport		*p_report);
+
+#endif /* VL53L8CX_LATENCY_H_ */
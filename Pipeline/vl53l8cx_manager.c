@@ -0,0 +1,587 @@
+#include <string.h>
+#include <errno.h>
+
+#include "vl53l8cx_manager.h"
+#include "vl53l8cx_capture.h"
+
+#define MANAGER_JOB_NONE	0U
+#define MANAGER_JOB_CHECK	1U
+#define MANAGER_JOB_STEP	2U
+
+/* Value of ranging_after_op when the operation does not change the state */
+#define MANAGER_KEEP_RANGING	255U
+
+#define MANAGER_NO_WAKE		UINT64_MAX
+
+const VL53L8CX_ManagerOps vl53l8cx_manager_uld_ops = {
+	vl53l8cx_check_data_ready,
+	vl53l8cx_get_ranging_data,
+	vl53l8cx_async_step
+};
+
+/*
+ * Selects the next job of a bus, called with the lock held. Due checks come
+ * first so a ready frame is never queued behind a configuration step. When
+ * nothing is due, '*p_wake_ns' is set to the time of the next job.
+ */
+static uint8_t _vl53l8cx_manager_pick(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_ManagerBus		*p_bus,
+		uint64_t			now_ns,
+		uint8_t				*p_pos,
+		uint64_t			*p_wake_ns)
+{
+	VL53L8CX_ManagerSensor *p_sensor;
+	uint32_t now_ms = (uint32_t)(now_ns / 1000000U);
+	uint64_t wake_ns = MANAGER_NO_WAKE, step_ns;
+	int32_t delta_ms;
+	uint8_t k, pos;
+
+	for (k = 0; k < p_bus->nb_sensors; k++)
+	{
+		pos = (uint8_t)((p_bus->next + k) % p_bus->nb_sensors);
+		p_sensor = &p_mgr->sensors[p_bus->sensor_ids[pos]];
+		if ((p_sensor->p_op != NULL) || !p_sensor->is_ranging)
+		{
+			continue;
+		}
+		if (p_sensor->next_check_ns <= now_ns)
+		{
+			*p_pos = pos;
+			return MANAGER_JOB_CHECK;
+		}
+		if (p_sensor->next_check_ns < wake_ns)
+		{
+			wake_ns = p_sensor->next_check_ns;
+		}
+	}
+
+	for (k = 0; k < p_bus->nb_sensors; k++)
+	{
+		pos = (uint8_t)((p_bus->next + k) % p_bus->nb_sensors);
+		p_sensor = &p_mgr->sensors[p_bus->sensor_ids[pos]];
+		if (p_sensor->p_op == NULL)
+		{
+			continue;
+		}
+#ifdef VL53L8CX_SHARED_BUFFERS
+		/* Another operation holds a buffer until it is done */
+		if ((p_bus->op_owner != 0U) && (p_bus->op_owner
+				!= (uint8_t)(p_bus->sensor_ids[pos] + 1U)))
+		{
+			continue;
+		}
+#endif
+		delta_ms = (int32_t)(p_sensor->p_op->wake_ms - now_ms);
+		if (delta_ms <= 0)
+		{
+			*p_pos = pos;
+			return MANAGER_JOB_STEP;
+		}
+		step_ns = now_ns + ((uint64_t)delta_ms * 1000000U);
+		if (step_ns < wake_ns)
+		{
+			wake_ns = step_ns;
+		}
+	}
+
+	*p_wake_ns = wake_ns;
+	return MANAGER_JOB_NONE;
+}
+
+/*
+ * Updates the frame period estimate and plans the next check, called with the
+ * lock held. An interval longer than twice the estimate is a missed frame and
+ * is not used, unless 3 of them follow each other. The next check is planned
+ * 1/8 of a period before the next frame, then repeated every poll period until
+ * the frame is ready.
+ */
+static void _vl53l8cx_manager_plan_check(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_ManagerSensor		*p_sensor,
+		uint8_t				is_ready,
+		uint64_t			t_check_ns,
+		uint64_t			t_end_ns)
+{
+	uint64_t interval_ns, period_ns = p_sensor->stats.frame_period_ns;
+
+	if (!is_ready)
+	{
+		p_sensor->next_check_ns = t_end_ns
+			+ ((uint64_t)p_mgr->poll_period_us * 1000U);
+		return;
+	}
+
+	if (p_sensor->last_frame_ns != 0U)
+	{
+		interval_ns = t_check_ns - p_sensor->last_frame_ns;
+		if (interval_ns < (2U * period_ns))
+		{
+			period_ns = ((3U * period_ns) + interval_ns) / 4U;
+			p_sensor->nb_long_intervals = 0;
+		}
+		else if ((period_ns == 0U)
+				|| (p_sensor->nb_long_intervals >= 2U))
+		{
+			/* First interval, or the estimate was too short */
+			period_ns = interval_ns;
+			p_sensor->nb_long_intervals = 0;
+		}
+		else
+		{
+			/* Missed frame, keep the estimate */
+			p_sensor->nb_long_intervals++;
+		}
+		p_sensor->stats.frame_period_ns = period_ns;
+	}
+	p_sensor->last_frame_ns = t_check_ns;
+
+	if (period_ns != 0U)
+	{
+		p_sensor->next_check_ns = t_check_ns + period_ns
+			- (period_ns / 8U);
+	}
+	else
+	{
+		p_sensor->next_check_ns = t_end_ns
+			+ ((uint64_t)p_mgr->poll_period_us * 1000U);
+	}
+}
+
+/*
+ * Bus thread. It runs the jobs of its sensors one at a time; the lock is only
+ * held to select a job and to account it, never during bus transactions. The
+ * temporary buffer of a device is held during a check, or during a whole
+ * operation (see vl53l8cx_pool_begin()).
+ */
+static void *_vl53l8cx_manager_bus_thread(void *arg)
+{
+	VL53L8CX_ManagerBus *p_bus = (VL53L8CX_ManagerBus *)arg;
+	VL53L8CX_Manager *p_mgr = (VL53L8CX_Manager *)p_bus->p_mgr;
+	VL53L8CX_ManagerSensor *p_sensor;
+	struct timespec ts;
+	uint64_t now_ns, wake_ns = 0, t_end_ns, delay_ns;
+	uint8_t job, pos, id, is_ready, status, frame_status, state;
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	while (p_mgr->running)
+	{
+		now_ns = vl53l8cx_capture_now_ns();
+		job = _vl53l8cx_manager_pick(p_mgr, p_bus, now_ns, &pos,
+				&wake_ns);
+		if (job == MANAGER_JOB_NONE)
+		{
+			if (wake_ns == MANAGER_NO_WAKE)
+			{
+				(void)pthread_cond_wait(&p_bus->wake,
+						&p_mgr->lock);
+			}
+			else
+			{
+				vl53l8cx_capture_to_timespec(wake_ns, &ts);
+				(void)pthread_cond_timedwait(&p_bus->wake,
+						&p_mgr->lock, &ts);
+			}
+			continue;
+		}
+
+		id = p_bus->sensor_ids[pos];
+		p_sensor = &p_mgr->sensors[id];
+		p_bus->next = (uint8_t)((pos + 1U) % p_bus->nb_sensors);
+		(void)pthread_mutex_unlock(&p_mgr->lock);
+
+		if (job == MANAGER_JOB_CHECK)
+		{
+			is_ready = 0;
+			frame_status = VL53L8CX_STATUS_OK;
+			status = vl53l8cx_pool_begin(p_sensor->p_dev);
+			if (status == VL53L8CX_STATUS_OK)
+			{
+				status = p_mgr->p_ops->check_data_ready(
+						p_sensor->p_dev, &is_ready);
+			}
+			if ((status == VL53L8CX_STATUS_OK) && is_ready)
+			{
+				frame_status = p_mgr->p_ops->get_ranging_data(
+						p_sensor->p_dev,
+						&p_sensor->results);
+			}
+			vl53l8cx_pool_end(p_sensor->p_dev);
+			t_end_ns = vl53l8cx_capture_now_ns();
+			if ((status == VL53L8CX_STATUS_OK) && is_ready
+					&& (p_mgr->frame_cb != NULL))
+			{
+				p_mgr->frame_cb(p_mgr->p_user, id, frame_status,
+						&p_sensor->results);
+			}
+
+			(void)pthread_mutex_lock(&p_mgr->lock);
+			p_sensor->stats.checks++;
+			delay_ns = now_ns - p_sensor->next_check_ns;
+			if (delay_ns > p_sensor->stats.max_check_delay_ns)
+			{
+				p_sensor->stats.max_check_delay_ns = delay_ns;
+			}
+			if (status != VL53L8CX_STATUS_OK)
+			{
+				p_sensor->stats.errors++;
+				is_ready = 0;
+			}
+			if (is_ready)
+			{
+				p_sensor->stats.checks_ready++;
+				p_sensor->stats.frames_read++;
+				if (frame_status != VL53L8CX_STATUS_OK)
+				{
+					p_sensor->stats.errors++;
+				}
+			}
+			_vl53l8cx_manager_plan_check(p_mgr, p_sensor, is_ready,
+					now_ns, t_end_ns);
+		}
+		else
+		{
+			status = vl53l8cx_pool_begin(p_sensor->p_dev);
+			if (status == VL53L8CX_STATUS_OK)
+			{
+				state = p_mgr->p_ops->async_step(p_sensor->p_op,
+						(uint32_t)(now_ns / 1000000U));
+			}
+			else
+			{
+				/* No buffer, the operation fails */
+				p_sensor->p_op->status = status;
+				state = VL53L8CX_ASYNC_DONE;
+			}
+			if (state == VL53L8CX_ASYNC_DONE)
+			{
+				vl53l8cx_pool_end(p_sensor->p_dev);
+			}
+			t_end_ns = vl53l8cx_capture_now_ns();
+
+			(void)pthread_mutex_lock(&p_mgr->lock);
+			p_sensor->stats.op_steps++;
+			p_bus->op_owner = (state == VL53L8CX_ASYNC_DONE) ? 0U
+				: (uint8_t)(id + 1U);
+			if (state == VL53L8CX_ASYNC_DONE)
+			{
+				p_sensor->op_status = p_sensor->p_op->status;
+				p_sensor->p_op = NULL;
+				if ((p_sensor->op_status == VL53L8CX_STATUS_OK)
+					&& (p_sensor->ranging_after_op == 1U))
+				{
+					/* New session, the period is measured
+					 * again */
+					p_sensor->is_ranging = 1;
+					p_sensor->last_frame_ns = 0;
+					p_sensor->nb_long_intervals = 0;
+					p_sensor->stats.frame_period_ns = 0;
+				}
+				p_sensor->next_check_ns = t_end_ns;
+				(void)pthread_cond_broadcast(&p_mgr->op_done);
+			}
+		}
+
+		p_sensor->stats.busy_ns += t_end_ns - now_ns;
+		p_bus->busy_ns += t_end_ns - now_ns;
+	}
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	return NULL;
+}
+
+/*
+ * Gives an operation to the bus thread of a sensor, called with the lock held.
+ * The sensor owns the operation until the bus thread has run it.
+ */
+static uint8_t _vl53l8cx_manager_submit(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_ManagerSensor		*p_sensor,
+		VL53L8CX_AsyncOp		*p_op,
+		uint8_t				ranging_after_op)
+{
+	if (p_sensor->p_op != NULL)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_op->wake_ms = (uint32_t)(vl53l8cx_capture_now_ns() / 1000000U);
+	p_sensor->p_op = p_op;
+	p_sensor->ranging_after_op = ranging_after_op;
+	if (ranging_after_op == 0U)
+	{
+		p_sensor->is_ranging = 0;
+	}
+	(void)pthread_cond_signal(&p_mgr->buses[p_sensor->bus].wake);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_manager_init(
+		VL53L8CX_Manager		*p_mgr,
+		const VL53L8CX_ManagerOps	*p_ops,
+		VL53L8CX_ManagerFrameCb		frame_cb,
+		void				*p_user,
+		uint32_t			poll_period_us)
+{
+	pthread_condattr_t attr;
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	(void)memset(p_mgr, 0, sizeof(*p_mgr));
+	p_mgr->p_ops = (p_ops != NULL) ? p_ops : &vl53l8cx_manager_uld_ops;
+	p_mgr->frame_cb = frame_cb;
+	p_mgr->p_user = p_user;
+	p_mgr->poll_period_us = (poll_period_us != 0U)
+		? poll_period_us : VL53L8CX_MANAGER_POLL_PERIOD_US;
+
+	/* Bus threads sleep on CLOCK_MONOTONIC deadlines */
+	if ((pthread_condattr_init(&attr) != 0)
+		|| (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0))
+	{
+		return VL53L8CX_STATUS_ERROR;
+	}
+	if ((pthread_mutex_init(&p_mgr->lock, NULL) != 0)
+		|| (pthread_cond_init(&p_mgr->op_done, &attr) != 0))
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+	for (i = 0; i < VL53L8CX_MANAGER_MAX_BUSES; i++)
+	{
+		p_mgr->buses[i].p_mgr = p_mgr;
+		if (pthread_cond_init(&p_mgr->buses[i].wake, &attr) != 0)
+		{
+			status |= VL53L8CX_STATUS_ERROR;
+		}
+	}
+	(void)pthread_condattr_destroy(&attr);
+
+	return status;
+}
+
+uint8_t vl53l8cx_manager_add_sensor(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				bus,
+		uint8_t				*p_sensor_id)
+{
+	VL53L8CX_ManagerBus *p_bus;
+	VL53L8CX_ManagerSensor *p_sensor;
+
+	if ((bus >= VL53L8CX_MANAGER_MAX_BUSES) || p_mgr->running
+		|| (p_mgr->nb_sensors >= VL53L8CX_MANAGER_MAX_SENSORS))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_sensor = &p_mgr->sensors[p_mgr->nb_sensors];
+	p_sensor->p_dev = p_dev;
+	p_sensor->bus = bus;
+	p_bus = &p_mgr->buses[bus];
+	p_bus->sensor_ids[p_bus->nb_sensors] = p_mgr->nb_sensors;
+	p_bus->nb_sensors++;
+	*p_sensor_id = p_mgr->nb_sensors;
+	p_mgr->nb_sensors++;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_manager_start(
+		VL53L8CX_Manager		*p_mgr)
+{
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	p_mgr->running = 1;
+	p_mgr->start_ns = vl53l8cx_capture_now_ns();
+	for (i = 0; i < VL53L8CX_MANAGER_MAX_BUSES; i++)
+	{
+		if (p_mgr->buses[i].nb_sensors == 0U)
+		{
+			continue;
+		}
+		if (pthread_create(&p_mgr->buses[i].thread, NULL,
+				_vl53l8cx_manager_bus_thread,
+				&p_mgr->buses[i]) != 0)
+		{
+			(void)vl53l8cx_manager_stop(p_mgr);
+			status |= VL53L8CX_STATUS_ERROR;
+			break;
+		}
+		p_mgr->buses[i].is_started = 1;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_manager_stop(
+		VL53L8CX_Manager		*p_mgr)
+{
+	uint8_t i;
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	p_mgr->running = 0;
+	p_mgr->stop_ns = vl53l8cx_capture_now_ns();
+	for (i = 0; i < VL53L8CX_MANAGER_MAX_BUSES; i++)
+	{
+		(void)pthread_cond_signal(&p_mgr->buses[i].wake);
+	}
+	(void)pthread_cond_broadcast(&p_mgr->op_done);
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	for (i = 0; i < VL53L8CX_MANAGER_MAX_BUSES; i++)
+	{
+		if (p_mgr->buses[i].is_started)
+		{
+			(void)pthread_join(p_mgr->buses[i].thread, NULL);
+			p_mgr->buses[i].is_started = 0;
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_manager_submit(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id,
+		VL53L8CX_AsyncOp		*p_op)
+{
+	uint8_t status;
+
+	if (sensor_id >= p_mgr->nb_sensors)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	status = _vl53l8cx_manager_submit(p_mgr, &p_mgr->sensors[sensor_id],
+			p_op, MANAGER_KEEP_RANGING);
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	return status;
+}
+
+uint8_t vl53l8cx_manager_start_ranging(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id)
+{
+	VL53L8CX_ManagerSensor *p_sensor;
+	uint8_t status = VL53L8CX_STATUS_INVALID_PARAM;
+
+	if (sensor_id >= p_mgr->nb_sensors)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	p_sensor = &p_mgr->sensors[sensor_id];
+
+	/* internal_op is prepared and queued under the same lock, so a
+	 * concurrent call finds the sensor busy instead of overwriting it */
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	if (p_sensor->p_op == NULL)
+	{
+		(void)vl53l8cx_async_start_ranging(&p_sensor->internal_op,
+				p_sensor->p_dev, 0);
+		status = _vl53l8cx_manager_submit(p_mgr, p_sensor,
+				&p_sensor->internal_op, 1);
+	}
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	return status;
+}
+
+uint8_t vl53l8cx_manager_stop_ranging(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id)
+{
+	VL53L8CX_ManagerSensor *p_sensor;
+	uint8_t status = VL53L8CX_STATUS_INVALID_PARAM;
+
+	if (sensor_id >= p_mgr->nb_sensors)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	p_sensor = &p_mgr->sensors[sensor_id];
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	if (p_sensor->p_op == NULL)
+	{
+		(void)vl53l8cx_async_stop_ranging(&p_sensor->internal_op,
+				p_sensor->p_dev, 0);
+		status = _vl53l8cx_manager_submit(p_mgr, p_sensor,
+				&p_sensor->internal_op, 0);
+	}
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	return status;
+}
+
+uint8_t vl53l8cx_manager_wait(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id,
+		uint32_t			timeout_ms,
+		uint8_t				*p_op_status)
+{
+	VL53L8CX_ManagerSensor *p_sensor;
+	struct timespec ts;
+	uint8_t status = VL53L8CX_STATUS_OK;
+	int ret = 0;
+
+	if (sensor_id >= p_mgr->nb_sensors)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	p_sensor = &p_mgr->sensors[sensor_id];
+	vl53l8cx_capture_to_timespec(vl53l8cx_capture_now_ns()
+			+ ((uint64_t)timeout_ms * 1000000U), &ts);
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	while ((p_sensor->p_op != NULL) && p_mgr->running
+			&& (ret != ETIMEDOUT))
+	{
+		ret = pthread_cond_timedwait(&p_mgr->op_done, &p_mgr->lock,
+				&ts);
+	}
+	if (p_sensor->p_op != NULL)
+	{
+		status = VL53L8CX_STATUS_TIMEOUT_ERROR;
+	}
+	*p_op_status = p_sensor->op_status;
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+
+	return status;
+}
+
+void vl53l8cx_manager_get_stats(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_ManagerSensorStats	*p_sensors,
+		VL53L8CX_ManagerBusStats	*p_buses)
+{
+	VL53L8CX_ManagerBus *p_bus;
+	uint64_t elapsed_ns;
+	uint8_t i;
+
+	(void)pthread_mutex_lock(&p_mgr->lock);
+	elapsed_ns = (p_mgr->running ? vl53l8cx_capture_now_ns()
+			: p_mgr->stop_ns) - p_mgr->start_ns;
+	if (p_mgr->start_ns == 0U)
+	{
+		elapsed_ns = 0;
+	}
+
+	for (i = 0; (p_sensors != NULL) && (i < p_mgr->nb_sensors); i++)
+	{
+		p_sensors[i] = p_mgr->sensors[i].stats;
+		p_sensors[i].utilization = (elapsed_ns != 0U)
+			? (float)p_sensors[i].busy_ns / (float)elapsed_ns
+			: 0.0f;
+	}
+
+	for (i = 0; (p_buses != NULL) && (i < VL53L8CX_MANAGER_MAX_BUSES); i++)
+	{
+		p_bus = &p_mgr->buses[i];
+		p_buses[i].nb_sensors = p_bus->nb_sensors;
+		p_buses[i].busy_ns = p_bus->busy_ns;
+		p_buses[i].elapsed_ns = elapsed_ns;
+		p_buses[i].utilization = (elapsed_ns != 0U)
+			? (float)p_bus->busy_ns / (float)elapsed_ns : 0.0f;
+	}
+	(void)pthread_mutex_unlock(&p_mgr->lock);
+}
@@ -0,0 +1,322 @@
+#ifndef VL53L8CX_MANAGER_H_
+#define VL53L8CX_MANAGER_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pool.h"
+
+/**
+ * @brief Maximum number of sensors and of buses handled by a manager. All
+ * sensors states are preallocated into the VL53L8CX_Manager structure.
+ */
+
+#define VL53L8CX_MANAGER_MAX_SENSORS		8U
+#define VL53L8CX_MANAGER_MAX_BUSES		4U
+
+/**
+ * @brief Default period used to poll a sensor when its next frame is not
+ * ready yet, in microseconds.
+ */
+
+#define VL53L8CX_MANAGER_POLL_PERIOD_US		1000U
+
+/**
+ * @brief Structure VL53L8CX_ManagerOps contains the device functions used by
+ * the manager. vl53l8cx_manager_uld_ops uses the ULD functions; emulated
+ * devices can be driven by providing other functions.
+ */
+
+typedef struct
+{
+	uint8_t (*check_data_ready)(
+			VL53L8CX_Configuration		*p_dev,
+			uint8_t				*p_isReady);
+	uint8_t (*get_ranging_data)(
+			VL53L8CX_Configuration		*p_dev,
+			VL53L8CX_ResultsData		*p_results);
+	uint8_t (*async_step)(
+			VL53L8CX_AsyncOp		*p_op,
+			uint32_t			now_ms);
+} VL53L8CX_ManagerOps;
+
+extern const VL53L8CX_ManagerOps vl53l8cx_manager_uld_ops;
+
+/**
+ * @brief Callback receiving each frame read by the manager. It is called from
+ * the thread of the sensor bus, so it must return quickly: the bus stays idle
+ * meanwhile. The results are only valid during the call.
+ */
+
+typedef void (*VL53L8CX_ManagerFrameCb)(
+		void				*p_user,
+		uint8_t				sensor_id,
+		uint8_t				status,
+		const VL53L8CX_ResultsData	*p_results);
+
+/**
+ * @brief Structure VL53L8CX_ManagerSensorStats contains the counters of a
+ * sensor.
+ */
+
+typedef struct
+{
+	/* Frames read and given to the callback */
+	uint32_t		frames_read;
+	/* Data ready checks, and checks which found a frame */
+	uint32_t		checks;
+	uint32_t		checks_ready;
+	/* Failed checks or frame reads */
+	uint32_t		errors;
+	/* Steps run for non-blocking operations (init, start, DCI...) */
+	uint32_t		op_steps;
+	/* Bus time used by the sensor, in ns */
+	uint64_t		busy_ns;
+	/* Worst delay between the planned time of a check and its start, in ns */
+	uint64_t		max_check_delay_ns;
+	/* Estimated frame period, in ns. 0 until 2 frames are read */
+	uint64_t		frame_period_ns;
+	/* busy_ns / time since vl53l8cx_manager_start() (0.0 to 1.0) */
+	float			utilization;
+} VL53L8CX_ManagerSensorStats;
+
+/**
+ * @brief Structure VL53L8CX_ManagerBusStats contains the counters of a bus.
+ */
+
+typedef struct
+{
+	/* Sensors attached to the bus */
+	uint8_t			nb_sensors;
+	/* Time spent in bus transactions, in ns */
+	uint64_t		busy_ns;
+	/* Time since vl53l8cx_manager_start(), in ns */
+	uint64_t		elapsed_ns;
+	/* busy_ns / elapsed_ns */
+	float			utilization;
+} VL53L8CX_ManagerBusStats;
+
+/**
+ * @brief Structure VL53L8CX_ManagerSensor contains the state of a sensor,
+ * internal use.
+ */
+
+typedef struct
+{
+	VL53L8CX_Configuration	*p_dev;
+	uint8_t			bus;
+	uint8_t			is_ranging;
+	/* Operation run by the bus thread, NULL if none */
+	VL53L8CX_AsyncOp	*p_op;
+	/* Ranging state once the operation succeeds (0, 1, or 255 to keep) */
+	uint8_t			ranging_after_op;
+	/* Status of the last operation */
+	uint8_t			op_status;
+	/* Operation used by vl53l8cx_manager_start/stop_ranging(), only
+	 * written while p_op is NULL */
+	VL53L8CX_AsyncOp	internal_op;
+	/* Planned time of the next data ready check, in ns */
+	uint64_t		next_check_ns;
+	/* Data ready time of the last frame, in ns */
+	uint64_t		last_frame_ns;
+	/* Consecutive frame intervals longer than twice the period */
+	uint8_t			nb_long_intervals;
+	VL53L8CX_ManagerSensorStats stats;
+	VL53L8CX_ResultsData	results;
+} VL53L8CX_ManagerSensor;
+
+/**
+ * @brief Structure VL53L8CX_ManagerBus contains the state of a bus, internal
+ * use.
+ */
+
+typedef struct
+{
+	/* Owner, VL53L8CX_Manager */
+	void			*p_mgr;
+	pthread_t		thread;
+	uint8_t			is_started;
+	/* Signaled when the thread must reconsider its next job */
+	pthread_cond_t		wake;
+	uint8_t			sensor_ids[VL53L8CX_MANAGER_MAX_SENSORS];
+	uint8_t			nb_sensors;
+	/* Next sensor served first, for round robin */
+	uint8_t			next;
+	/* With VL53L8CX_SHARED_BUFFERS, id + 1 of the sensor whose operation
+	 * holds a temporary buffer, 0 if none */
+	uint8_t			op_owner;
+	uint64_t		busy_ns;
+} VL53L8CX_ManagerBus;
+
+/**
+ * @brief Structure VL53L8CX_Manager drives several sensors, which may share
+ * SPI buses. Each bus is served by its own thread, so transactions of a bus
+ * never wait for another bus. On a bus, the thread runs one transaction at a
+ * time, in this order of priority:
+ * - data ready checks which are due, followed by the frame read if a frame is
+ *   ready, so a ready frame is read before anything else is sent on the bus;
+ * - steps of non-blocking operations (see vl53l8cx_async_step()). Each step is
+ *   a short transaction, except the firmware download of the init, so a
+ *   configuration of one sensor delays frame reads of the others by one step
+ *   at most;
+ * - otherwise the thread sleeps until the next check or step is due.
+ * Checks are planned from the frame period measured for each sensor, and
+ * repeated every poll period until the frame is ready. Sensors are served
+ * round robin when several are due.
+ * With VL53L8CX_SHARED_BUFFERS, an operation holds its temporary buffer until
+ * it is done, so a bus runs the operations of its sensors one after the other,
+ * and needs a second buffer for the checks of its other sensors meanwhile.
+ * Between vl53l8cx_manager_start() and vl53l8cx_manager_stop(), devices must
+ * only be accessed through the manager.
+ */
+
+typedef struct
+{
+	const VL53L8CX_ManagerOps *p_ops;
+	VL53L8CX_ManagerFrameCb	frame_cb;
+	void			*p_user;
+	uint32_t		poll_period_us;
+	pthread_mutex_t		lock;
+	/* Signaled when an operation is done */
+	pthread_cond_t		op_done;
+	uint8_t			running;
+	/* CLOCK_MONOTONIC times of vl53l8cx_manager_start() and _stop(), in ns */
+	uint64_t		start_ns;
+	uint64_t		stop_ns;
+	uint8_t			nb_sensors;
+	VL53L8CX_ManagerSensor	sensors[VL53L8CX_MANAGER_MAX_SENSORS];
+	VL53L8CX_ManagerBus	buses[VL53L8CX_MANAGER_MAX_BUSES];
+} VL53L8CX_Manager;
+
+/**
+ * @brief This function initializes a manager without sensor.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (VL53L8CX_ManagerOps) *p_ops : Device functions, or NULL to use
+ * vl53l8cx_manager_uld_ops.
+ * @param (VL53L8CX_ManagerFrameCb) frame_cb : Callback receiving the frames.
+ * @param (void) *p_user : Argument given to the callback.
+ * @param (uint32_t) poll_period_us : Polling period when a frame is late. Set
+ * to 0 to use VL53L8CX_MANAGER_POLL_PERIOD_US.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_manager_init(
+		VL53L8CX_Manager		*p_mgr,
+		const VL53L8CX_ManagerOps	*p_ops,
+		VL53L8CX_ManagerFrameCb		frame_cb,
+		void				*p_user,
+		uint32_t			poll_period_us);
+
+/**
+ * @brief This function adds a sensor to the manager. It must be called before
+ * vl53l8cx_manager_start().
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) bus : Index of the bus used by the sensor, lower than
+ * VL53L8CX_MANAGER_MAX_BUSES.
+ * @param (uint8_t) *p_sensor_id : Id of the sensor, used by the other
+ * functions and by the callback.
+ * @return (uint8_t) status : 0 if OK, or 127 if the bus is not valid or if the
+ * manager is full or running.
+ */
+
+uint8_t vl53l8cx_manager_add_sensor(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				bus,
+		uint8_t				*p_sensor_id);
+
+/**
+ * @brief This function starts a thread per bus used.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_manager_start(
+		VL53L8CX_Manager		*p_mgr);
+
+/**
+ * @brief This function stops the bus threads. Sensors still ranging are not
+ * stopped.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_manager_stop(
+		VL53L8CX_Manager		*p_mgr);
+
+/**
+ * @brief This function gives an operation prepared by vl53l8cx_async_*() to
+ * the bus thread of a sensor. Frame checks of the sensor are suspended until
+ * the operation is done. The operation runs on the manager clock, the time
+ * given to vl53l8cx_async_*() is not used.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (uint8_t) sensor_id : Sensor id.
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation, valid until it is done.
+ * @return (uint8_t) status : 0 if OK, or 127 if the id is not valid or if an
+ * operation is already running on the sensor.
+ */
+
+uint8_t vl53l8cx_manager_submit(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id,
+		VL53L8CX_AsyncOp		*p_op);
+
+/**
+ * @brief This function starts a ranging session on a sensor, without waiting.
+ * Frames are read once the operation is done.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (uint8_t) sensor_id : Sensor id.
+ * @return (uint8_t) status : 0 if OK, see vl53l8cx_manager_submit().
+ */
+
+uint8_t vl53l8cx_manager_start_ranging(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id);
+
+/**
+ * @brief This function stops the ranging session of a sensor, without
+ * waiting. Frame checks stop immediately.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (uint8_t) sensor_id : Sensor id.
+ * @return (uint8_t) status : 0 if OK, see vl53l8cx_manager_submit().
+ */
+
+uint8_t vl53l8cx_manager_stop_ranging(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id);
+
+/**
+ * @brief This function waits until the operation of a sensor is done.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (uint8_t) sensor_id : Sensor id.
+ * @param (uint32_t) timeout_ms : Maximum time to wait.
+ * @param (uint8_t) *p_op_status : Status of the operation.
+ * @return (uint8_t) status : 0 if the operation is done, or 1
+ * (VL53L8CX_STATUS_TIMEOUT_ERROR) if it is still running.
+ */
+
+uint8_t vl53l8cx_manager_wait(
+		VL53L8CX_Manager		*p_mgr,
+		uint8_t				sensor_id,
+		uint32_t			timeout_ms,
+		uint8_t				*p_op_status);
+
+/**
+ * @brief This function reads the counters of the sensors and of the buses. It
+ * can be called from any thread.
+ * @param (VL53L8CX_Manager) *p_mgr : Manager structure.
+ * @param (VL53L8CX_ManagerSensorStats) *p_sensors : Array of nb_sensors
+ * counters, indexed by sensor id. Can be NULL.
+ * @param (VL53L8CX_ManagerBusStats) *p_buses : Array of
+ * VL53L8CX_MANAGER_MAX_BUSES counters, indexed by bus. Can be NULL.
+ */
+
+void vl53l8cx_manager_get_stats(
+		VL53L8CX_Manager		*p_mgr,
+		VL53L8CX_ManagerSensorStats	*p_sensors,
+		VL53L8CX_ManagerBusStats	*p_buses);
+
+#endif /* VL53L8CX_MANAGER_H_ */
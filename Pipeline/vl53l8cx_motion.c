@@ -0,0 +1,211 @@
+#include <string.h>
+
+#include "vl53l8cx_motion.h"
+#include "vl53l8cx_pipeline.h"
+#include "vl53l8cx_simd.h"
+
+/* Scores are capped, so they fit into the indicator */
+#define _VL53L8CX_MOTION_MAX_SCORE	1000000.0f
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+/* Rolling mean and variance of each zone, and its score */
+static void _vl53l8cx_motion_zones(
+		VL53L8CX_Motion			*p_mot)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	const vl53l8cx_v4f zero = {0.0f, 0.0f, 0.0f, 0.0f};
+	const vl53l8cx_v4f half = {0.5f, 0.5f, 0.5f, 0.5f};
+	vl53l8cx_v4f z, mean, variance, delta, noise;
+	vl53l8cx_v4f lo = zero + (float)p_mot->config.min_distance_mm;
+	vl53l8cx_v4f hi = zero + (float)p_mot->config.max_distance_mm;
+	vl53l8cx_v4i valid, started;
+	float alpha = p_mot->config.alpha;
+	uint32_t i;
+
+	for (i = 0; i < p_mot->nb_zones; i += VL53L8CX_SIMD_LANES)
+	{
+		z = VL53L8CX_V4F(&p_mot->measure_mm[i]);
+		z = vl53l8cx_simd_select(z < lo, lo, z);
+		z = vl53l8cx_simd_select(z > hi, hi, z);
+		valid = VL53L8CX_V4F(&p_mot->is_valid[i]) > half;
+		started = VL53L8CX_V4F(&p_mot->is_started[i]) > half;
+		mean = VL53L8CX_V4F(&p_mot->mean_mm[i]);
+		variance = VL53L8CX_V4F(&p_mot->variance_mm2[i]);
+
+		/* A zone starting takes the measurement as mean */
+		delta = z - mean;
+		VL53L8CX_V4F(&p_mot->mean_mm[i]) = vl53l8cx_simd_select(valid,
+			vl53l8cx_simd_select(started, mean + (alpha * delta),
+				z), mean);
+		variance = vl53l8cx_simd_select(valid,
+			vl53l8cx_simd_select(started, (1.0f - alpha)
+				* (variance + (alpha * delta * delta)), zero),
+			variance);
+		VL53L8CX_V4F(&p_mot->variance_mm2[i]) = variance;
+		VL53L8CX_V4F(&p_mot->is_started[i]) = vl53l8cx_simd_select(
+			valid | started, one, zero);
+
+		noise = VL53L8CX_V4F(&p_mot->sigma_mm[i]);
+		VL53L8CX_V4F(&p_mot->score[i]) = variance / (noise * noise);
+	}
+}
+
+/*
+ * Scores of the aggregates, 4 at a time. In a 8x8 frame, the 2x2 blocks of 2
+ * rows are the sums of the rows, added by pairs of lanes.
+ */
+static void _vl53l8cx_motion_aggregates(
+		VL53L8CX_Motion			*p_mot)
+{
+	const vl53l8cx_v4i lane_bits = {1, 2, 4, 8};
+	const vl53l8cx_v4i even = {0, 2, 4, 6};
+	const vl53l8cx_v4i odd = {1, 3, 5, 7};
+	VL53L8CX_MotionIndicator *p_ind = &p_mot->indicator;
+	vl53l8cx_v4f left, right, aggregate, sum = {0.0f, 0.0f, 0.0f, 0.0f};
+	vl53l8cx_v4i moving, bits = {0, 0, 0, 0}, count = {0, 0, 0, 0};
+	vl53l8cx_v4i scaled;
+	const float *p_row;
+	uint32_t k, lane;
+
+	for (k = 0; k < (VL53L8CX_MOTION_NB_AGGREGATES
+		/ VL53L8CX_SIMD_LANES); k++)
+	{
+		if (p_mot->nb_zones == VL53L8CX_RESOLUTION_4X4)
+		{
+			aggregate = VL53L8CX_V4F(&p_mot->score[k
+				* VL53L8CX_SIMD_LANES]);
+		}
+		else
+		{
+			p_row = &p_mot->score[k * 16U];
+			left = VL53L8CX_V4F(&p_row[0])
+				+ VL53L8CX_V4F(&p_row[8]);
+			right = VL53L8CX_V4F(&p_row[4])
+				+ VL53L8CX_V4F(&p_row[12]);
+			aggregate = (__builtin_shuffle(left, right, even)
+				+ __builtin_shuffle(left, right, odd)) * 0.25f;
+		}
+		aggregate = vl53l8cx_simd_min(aggregate,
+			(vl53l8cx_v4f){_VL53L8CX_MOTION_MAX_SCORE,
+			_VL53L8CX_MOTION_MAX_SCORE, _VL53L8CX_MOTION_MAX_SCORE,
+			_VL53L8CX_MOTION_MAX_SCORE});
+		moving = aggregate >= p_mot->config.threshold;
+		bits |= (lane_bits & moving)
+			<< (int32_t)(k * VL53L8CX_SIMD_LANES);
+		count -= moving;
+		sum += aggregate;
+
+		scaled = __builtin_convertvector((aggregate
+			* (float)VL53L8CX_MOTION_SCORE_ONE) + 0.5f,
+			vl53l8cx_v4i);
+		for (lane = 0; lane < VL53L8CX_SIMD_LANES; lane++)
+		{
+			p_ind->motion[(k * VL53L8CX_SIMD_LANES) + lane] =
+				(uint32_t)scaled[lane];
+		}
+	}
+
+	p_ind->global_indicator_1 = (uint32_t)(bits[0] | bits[1] | bits[2]
+		| bits[3]);
+	p_ind->global_indicator_2 = (uint32_t)((((sum[0] + sum[1] + sum[2]
+		+ sum[3]) / (float)VL53L8CX_MOTION_NB_AGGREGATES)
+		* (float)VL53L8CX_MOTION_SCORE_ONE) + 0.5f);
+	p_ind->nb_of_detected_aggregates = (uint8_t)(count[0] + count[1]
+		+ count[2] + count[3]);
+	p_ind->nb_of_aggregates = (uint8_t)VL53L8CX_MOTION_NB_AGGREGATES;
+	p_ind->status = (uint8_t)(p_ind->nb_of_detected_aggregates
+		>= p_mot->config.min_aggregates);
+}
+#endif
+
+void vl53l8cx_motion_init(
+		VL53L8CX_Motion			*p_mot,
+		const VL53L8CX_MotionConfig	*p_config)
+{
+	(void)memset(p_mot, 0, sizeof(*p_mot));
+	if (p_config != NULL)
+	{
+		p_mot->config = *p_config;
+	}
+	else
+	{
+		p_mot->config.min_distance_mm =
+			VL53L8CX_MOTION_DEFAULT_MIN_DISTANCE_MM;
+		p_mot->config.max_distance_mm =
+			VL53L8CX_MOTION_DEFAULT_MAX_DISTANCE_MM;
+		p_mot->config.alpha = VL53L8CX_MOTION_DEFAULT_ALPHA;
+		p_mot->config.noise_mm = VL53L8CX_MOTION_DEFAULT_NOISE_MM;
+		p_mot->config.threshold = VL53L8CX_MOTION_DEFAULT_THRESHOLD;
+		p_mot->config.min_aggregates =
+			VL53L8CX_MOTION_DEFAULT_MIN_AGGREGATES;
+	}
+}
+
+void vl53l8cx_motion_reset(
+		VL53L8CX_Motion			*p_mot)
+{
+	(void)memset(p_mot->is_started, 0, sizeof(p_mot->is_started));
+	(void)memset(p_mot->variance_mm2, 0, sizeof(p_mot->variance_mm2));
+	(void)memset(p_mot->score, 0, sizeof(p_mot->score));
+	(void)memset(&p_mot->indicator, 0, sizeof(p_mot->indicator));
+}
+
+uint8_t vl53l8cx_motion_update(
+		VL53L8CX_Motion			*p_mot,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	uint64_t valid;
+	float sigma;
+	uint32_t zone, idx;
+	uint8_t is_valid;
+
+	if (((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+		|| (p_mot->config.min_distance_mm
+			> p_mot->config.max_distance_mm))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	if (nb_zones != p_mot->nb_zones)
+	{
+		vl53l8cx_motion_reset(p_mot);
+		p_mot->nb_zones = nb_zones;
+	}
+
+	/* Gather the first target of each zone */
+	valid = vl53l8cx_valid_zones(p_results, nb_zones);
+	sigma = p_mot->config.noise_mm;
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		p_mot->measure_mm[zone] = (float)p_results->distance_mm[idx];
+		is_valid = (uint8_t)((valid >> zone) & 1U);
+		p_mot->is_valid[zone] = is_valid ? 1.0f : 0.0f;
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+		sigma = (float)p_results->range_sigma_mm[idx];
+		if (!is_valid || (sigma < p_mot->config.noise_mm))
+		{
+			sigma = p_mot->config.noise_mm;
+		}
+#endif
+		if (sigma < 1.0f)
+		{
+			sigma = 1.0f;
+		}
+		p_mot->sigma_mm[zone] = sigma;
+	}
+
+	_vl53l8cx_motion_zones(p_mot);
+	_vl53l8cx_motion_aggregates(p_mot);
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_mot;
+	(void)p_results;
+	(void)nb_zones;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
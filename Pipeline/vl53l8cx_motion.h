@@ -0,0 +1,153 @@
+#ifndef VL53L8CX_MOTION_H_
+#define VL53L8CX_MOTION_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Number of motion aggregates: zones of a 4x4 frame, or blocks of 2x2
+ * zones of a 8x8 frame, as the firmware motion indicator.
+ */
+
+#define VL53L8CX_MOTION_NB_AGGREGATES		16U
+
+/**
+ * @brief Scale of the motion scores: a score of VL53L8CX_MOTION_SCORE_ONE
+ * is a variance equal to the noise of the measurements.
+ */
+
+#define VL53L8CX_MOTION_SCORE_ONE		256U
+
+/**
+ * @brief Default motion detection: distances from 0 to 4000 mm, variance
+ * over about 8 frames, and noise of 10 mm at least. An aggregate moves when
+ * its variance is 9 times the noise (3 sigma), and motion is reported when 1
+ * aggregate moves.
+ */
+
+#define VL53L8CX_MOTION_DEFAULT_MIN_DISTANCE_MM	0
+#define VL53L8CX_MOTION_DEFAULT_MAX_DISTANCE_MM	4000
+#define VL53L8CX_MOTION_DEFAULT_ALPHA		0.25f
+#define VL53L8CX_MOTION_DEFAULT_NOISE_MM	10.0f
+#define VL53L8CX_MOTION_DEFAULT_THRESHOLD	9.0f
+#define VL53L8CX_MOTION_DEFAULT_MIN_AGGREGATES	1U
+
+/**
+ * @brief Structure VL53L8CX_MotionConfig contains the motion detection
+ * settings. Unlike the firmware motion indicator, the window has no minimum
+ * and no maximum span.
+ */
+
+typedef struct
+{
+	/* Window of distances, in mm: valid distances out of the window are
+	 * clamped to it, so a target going out of the window moves */
+	int16_t			min_distance_mm;
+	int16_t			max_distance_mm;
+	/* Gain of the rolling mean and variance, from 0 to 1: the window is
+	 * about 2 / alpha frames */
+	float			alpha;
+	/* Minimum noise of a measurement, in mm. The range sigma of each
+	 * measurement is used when it is higher */
+	float			noise_mm;
+	/* Score of a moving aggregate, in noise variances */
+	float			threshold;
+	/* Moving aggregates to report motion */
+	uint8_t			min_aggregates;
+} VL53L8CX_MotionConfig;
+
+/**
+ * @brief Structure VL53L8CX_MotionIndicator has the layout of the
+ * motion_indicator field of VL53L8CX_ResultsData, so code reading the firmware
+ * motion indicator can read it instead:
+ * - global_indicator_1 : bit a is set when aggregate a moves,
+ * - global_indicator_2 : mean score of the aggregates,
+ * - status : 1 when motion is reported, else 0,
+ * - nb_of_detected_aggregates, nb_of_aggregates : moving and total
+ * aggregates,
+ * - motion : score of each aggregate (mean of its zones), only the first 16
+ * are used.
+ * Scores use VL53L8CX_MOTION_SCORE_ONE.
+ */
+
+typedef struct
+{
+	uint32_t		global_indicator_1;
+	uint32_t		global_indicator_2;
+	uint8_t			status;
+	uint8_t			nb_of_detected_aggregates;
+	uint8_t			nb_of_aggregates;
+	uint8_t			spare;
+	uint32_t		motion[32];
+} VL53L8CX_MotionIndicator;
+
+/**
+ * @brief Structure VL53L8CX_Motion detects motion on the host, from the
+ * distances of the first target of each zone: the rolling variance of each
+ * zone is updated with its frame delta (difference with its rolling mean),
+ * and divided by the noise of the measurements. Zones are processed 4 at a
+ * time with SIMD instructions. Invalid zones keep their state. With this
+ * detection, the firmware motion indicator is not needed: build with
+ * VL53L8CX_DISABLE_MOTION_INDICATOR, or leave VL53L8CX_OUTPUT_MOTION_INDICATOR
+ * out of the partial read, to save its 144 bytes per frame.
+ */
+
+typedef struct
+{
+	VL53L8CX_MotionConfig	config;
+	/* Resolution of the last frame, the state is reset when it changes */
+	uint8_t			nb_zones;
+	/* State of each zone: rolling mean in mm and variance in mm^2, 1.0
+	 * when the zone was valid once */
+	_Alignas(16) float	mean_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	variance_mm2[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	is_started[VL53L8CX_RESOLUTION_8X8];
+	/* Measurements of the last frame */
+	_Alignas(16) float	measure_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	sigma_mm[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	is_valid[VL53L8CX_RESOLUTION_8X8];
+	/* Score of each zone */
+	_Alignas(16) float	score[VL53L8CX_RESOLUTION_8X8];
+	/* Motion of the last frame */
+	VL53L8CX_MotionIndicator	indicator;
+} VL53L8CX_Motion;
+
+/**
+ * @brief This function initializes a motion detection.
+ * @param (VL53L8CX_Motion) *p_mot : Motion structure.
+ * @param (VL53L8CX_MotionConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_motion_init(
+		VL53L8CX_Motion			*p_mot,
+		const VL53L8CX_MotionConfig	*p_config);
+
+/**
+ * @brief This function resets all zones. The next valid measurement of each
+ * zone starts its mean.
+ * @param (VL53L8CX_Motion) *p_mot : Motion structure.
+ */
+
+void vl53l8cx_motion_reset(
+		VL53L8CX_Motion			*p_mot);
+
+/**
+ * @brief This function updates the motion with a frame. The result is given
+ * by p_mot->indicator, and the score of each zone by p_mot->score. The distance
+ * and the target status must be read for each frame (see
+ * vl53l8cx_set_partial_read()).
+ * @param (VL53L8CX_Motion) *p_mot : Motion structure.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame to process.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution or the window is not valid.
+ */
+
+uint8_t vl53l8cx_motion_update(
+		VL53L8CX_Motion			*p_mot,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones);
+
+#endif /* VL53L8CX_MOTION_H_ */
@@ -0,0 +1,77 @@
+#ifndef VL53L8CX_PIPELINE_H_
+#define VL53L8CX_PIPELINE_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief This function tells whether a target of a frame is valid, like the
+ * validity mask of the driver: its status is 5 or 9 (see
+ * VL53L8CX_ResultsData), or its distance is positive when the target status is
+ * not read, and the zone has detected that many targets.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame.
+ * @param (uint32_t) zone : Zone of the target.
+ * @param (uint32_t) target : Rank of the target into the zone, lower than
+ * VL53L8CX_NB_TARGET_PER_ZONE.
+ * @return (uint8_t) is_valid : 1 if the target is valid, else 0.
+ */
+
+static inline uint8_t vl53l8cx_target_is_valid(
+		const VL53L8CX_ResultsData	*p_results,
+		uint32_t			zone,
+		uint32_t			target)
+{
+	uint32_t idx = (zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE) + target;
+	uint8_t is_valid = 1;
+
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	is_valid = (uint8_t)((p_results->target_status[idx] == 5U)
+		|| (p_results->target_status[idx] == 9U));
+#elif !defined(VL53L8CX_DISABLE_DISTANCE_MM)
+	is_valid = (uint8_t)(p_results->distance_mm[idx] > 0);
+#else
+	(void)idx;
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	is_valid &= (uint8_t)(p_results->nb_target_detected[zone] > target);
+#else
+	(void)zone;
+	(void)target;
+#endif
+
+	return is_valid;
+}
+
+/**
+ * @brief This function gives the zones whose first target is valid (see
+ * vl53l8cx_target_is_valid()). The validity mask of the driver is used when it
+ * is computed.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @return (uint64_t) mask : Bit z is set when zone z is valid.
+ */
+
+static inline uint64_t vl53l8cx_valid_zones(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+	uint64_t mask = 0;
+#if !defined(VL53L8CX_DISABLE_VALIDITY_MASK) \
+	&& !defined(VL53L8CX_DISABLE_TARGET_STATUS)
+	(void)nb_zones;
+	mask = p_results->valid_mask;
+#else
+	uint32_t zone;
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		mask |= (uint64_t)vl53l8cx_target_is_valid(p_results, zone, 0)
+			<< zone;
+	}
+#endif
+
+	return mask;
+}
+
+#endif /* VL53L8CX_PIPELINE_H_ */
@@ -0,0 +1,392 @@
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_plane.h"
+#include "vl53l8cx_capture.h"
+#include "vl53l8cx_simd.h"
+
+#define _VL53L8CX_PLANE_DEG_TO_RAD	0.017453292519943295f
+
+/* Budget is checked every few draws, reading the clock is not free */
+#define _VL53L8CX_PLANE_CLOCK_PERIOD	4U
+
+/*
+ * Valid points of a frame, packed. The last vector is padded with NaN, which
+ * is never an inlier.
+ */
+typedef struct
+{
+	_Alignas(16) float	x[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	y[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	z[VL53L8CX_RESOLUTION_8X8];
+	uint8_t			zone[VL53L8CX_RESOLUTION_8X8];
+	uint32_t		nb_points;
+} _VL53L8CX_PlanePoints;
+
+static uint32_t _vl53l8cx_plane_random(
+		VL53L8CX_Plane			*p_plane)
+{
+	uint32_t x = p_plane->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	p_plane->seed = x;
+
+	return x;
+}
+
+/*
+ * Number of points within the threshold of a plane, 4 at a time, and MSAC
+ * cost: squared distance of the inliers, squared threshold for the others, so
+ * close fits win over planes which just catch more points. If p_mask is not
+ * NULL, also gives the points under the threshold (floor, or below it).
+ */
+static uint32_t _vl53l8cx_plane_score(
+		const _VL53L8CX_PlanePoints	*p_pts,
+		const float			*p_plane,
+		float				threshold,
+		float				*p_cost,
+		uint64_t			*p_mask)
+{
+	vl53l8cx_v4f h, cost = {0.0f, 0.0f, 0.0f, 0.0f};
+	vl53l8cx_v4i inliers = {0, 0, 0, 0}, below;
+	float max_cost = threshold * threshold;
+	uint32_t i, lane;
+
+	for (i = 0; i < p_pts->nb_points; i += VL53L8CX_SIMD_LANES)
+	{
+		h = (p_plane[0] * VL53L8CX_V4F(&p_pts->x[i]))
+			+ (p_plane[1] * VL53L8CX_V4F(&p_pts->y[i]))
+			+ (p_plane[2] * VL53L8CX_V4F(&p_pts->z[i]))
+			+ p_plane[3];
+		below = h <= threshold;
+		inliers -= below & (h >= -threshold);
+		/* NaN padding takes max_cost, the same for all planes */
+		cost += vl53l8cx_simd_min(h * h, (vl53l8cx_v4f){max_cost,
+			max_cost, max_cost, max_cost});
+		if (p_mask != NULL)
+		{
+			for (lane = 0; lane < VL53L8CX_SIMD_LANES; lane++)
+			{
+				if (below[lane])
+				{
+					*p_mask |= (uint64_t)1U
+						<< p_pts->zone[i + lane];
+				}
+			}
+		}
+	}
+
+	*p_cost = cost[0] + cost[1] + cost[2] + cost[3];
+
+	return (uint32_t)(inliers[0] + inliers[1] + inliers[2] + inliers[3]);
+}
+
+/* 1 if a plane may be the floor, once its normal is oriented up */
+static uint8_t _vl53l8cx_plane_is_floor(
+		const VL53L8CX_Plane		*p_plane,
+		float				*p_candidate)
+{
+	float norm = sqrtf((p_candidate[0] * p_candidate[0])
+		+ (p_candidate[1] * p_candidate[1])
+		+ (p_candidate[2] * p_candidate[2]));
+	uint32_t i;
+
+	if (norm < 1e-6f)
+	{
+		return 0;
+	}
+	if (p_candidate[1] < 0.0f)
+	{
+		norm = -norm;
+	}
+	for (i = 0; i < 4U; i++)
+	{
+		p_candidate[i] /= norm;
+	}
+
+	return (uint8_t)((p_candidate[1] >= cosf(p_plane->config.max_tilt_deg
+			* _VL53L8CX_PLANE_DEG_TO_RAD))
+		&& (p_candidate[3] >= p_plane->config.min_height_mm));
+}
+
+/* Plane through 3 points drawn at random */
+static uint8_t _vl53l8cx_plane_draw(
+		VL53L8CX_Plane			*p_plane,
+		const _VL53L8CX_PlanePoints	*p_pts,
+		float				*p_candidate)
+{
+	uint32_t a, b, c, n = p_pts->nb_points;
+	float ux, uy, uz, vx, vy, vz;
+
+	a = _vl53l8cx_plane_random(p_plane) % n;
+	b = _vl53l8cx_plane_random(p_plane) % (n - 1U);
+	b += (uint32_t)(b >= a);
+	do
+	{
+		c = _vl53l8cx_plane_random(p_plane) % n;
+	} while ((c == a) || (c == b));
+
+	ux = p_pts->x[b] - p_pts->x[a];
+	uy = p_pts->y[b] - p_pts->y[a];
+	uz = p_pts->z[b] - p_pts->z[a];
+	vx = p_pts->x[c] - p_pts->x[a];
+	vy = p_pts->y[c] - p_pts->y[a];
+	vz = p_pts->z[c] - p_pts->z[a];
+	p_candidate[0] = (uy * vz) - (uz * vy);
+	p_candidate[1] = (uz * vx) - (ux * vz);
+	p_candidate[2] = (ux * vy) - (uy * vx);
+	p_candidate[3] = -((p_candidate[0] * p_pts->x[a])
+		+ (p_candidate[1] * p_pts->y[a])
+		+ (p_candidate[2] * p_pts->z[a]));
+
+	return _vl53l8cx_plane_is_floor(p_plane, p_candidate);
+}
+
+/*
+ * Least squares fit of y = a.x + b.z + c on the inliers of a plane. The floor
+ * is nearly horizontal, so this is well conditioned.
+ */
+static void _vl53l8cx_plane_refine(
+		const VL53L8CX_Plane		*p_plane,
+		const _VL53L8CX_PlanePoints	*p_pts,
+		float				*p_best)
+{
+	double sxx = 0, sxz = 0, szz = 0, sx = 0, sz = 0, sn = 0;
+	double sxy = 0, szy = 0, sy = 0, det, a, b, c;
+	float h, candidate[4];
+	uint32_t i;
+
+	for (i = 0; i < p_pts->nb_points; i++)
+	{
+		h = (p_best[0] * p_pts->x[i]) + (p_best[1] * p_pts->y[i])
+			+ (p_best[2] * p_pts->z[i]) + p_best[3];
+		if (fabsf(h) > p_plane->config.threshold_mm)
+		{
+			continue;
+		}
+		sxx += (double)p_pts->x[i] * p_pts->x[i];
+		sxz += (double)p_pts->x[i] * p_pts->z[i];
+		szz += (double)p_pts->z[i] * p_pts->z[i];
+		sx += p_pts->x[i];
+		sz += p_pts->z[i];
+		sn += 1.0;
+		sxy += (double)p_pts->x[i] * p_pts->y[i];
+		szy += (double)p_pts->z[i] * p_pts->y[i];
+		sy += p_pts->y[i];
+	}
+
+	/* Normal equations, by Cramer's rule */
+	det = (sxx * ((szz * sn) - (sz * sz)))
+		- (sxz * ((sxz * sn) - (sz * sx)))
+		+ (sx * ((sxz * sz) - (szz * sx)));
+	if (fabs(det) < 1e-9)
+	{
+		return;
+	}
+	a = ((sxy * ((szz * sn) - (sz * sz)))
+		- (sxz * ((szy * sn) - (sz * sy)))
+		+ (sx * ((szy * sz) - (szz * sy)))) / det;
+	b = ((sxx * ((szy * sn) - (sy * sz)))
+		- (sxy * ((sxz * sn) - (sz * sx)))
+		+ (sx * ((sxz * sy) - (szy * sx)))) / det;
+	c = ((sxx * ((szz * sy) - (sz * szy)))
+		- (sxz * ((sxz * sy) - (szy * sx)))
+		+ (sxy * ((sxz * sz) - (szz * sx)))) / det;
+
+	candidate[0] = (float)-a;
+	candidate[1] = 1.0f;
+	candidate[2] = (float)-b;
+	candidate[3] = (float)-c;
+	if (_vl53l8cx_plane_is_floor(p_plane, candidate))
+	{
+		(void)memcpy(p_best, candidate, sizeof(candidate));
+	}
+}
+
+/* Draws needed to find the best plane with the configured confidence */
+static uint32_t _vl53l8cx_plane_needed(
+		const VL53L8CX_Plane		*p_plane,
+		uint32_t			nb_inliers,
+		uint32_t			nb_points)
+{
+	float w = (float)nb_inliers / (float)nb_points;
+	float p_good = w * w * w;
+
+	if (p_good >= 1.0f)
+	{
+		return 0;
+	}
+	if (p_good <= 0.0f)
+	{
+		return p_plane->config.max_iterations;
+	}
+
+	return (uint32_t)ceilf(logf(1.0f - p_plane->config.confidence)
+		/ logf(1.0f - p_good));
+}
+
+void vl53l8cx_plane_init(
+		VL53L8CX_Plane			*p_plane,
+		const VL53L8CX_PlaneConfig	*p_config)
+{
+	(void)memset(p_plane, 0, sizeof(*p_plane));
+	p_plane->seed = 0x2545F491U;
+	if (p_config != NULL)
+	{
+		p_plane->config = *p_config;
+	}
+	else
+	{
+		p_plane->config.threshold_mm = VL53L8CX_PLANE_DEFAULT_THRESHOLD_MM;
+		p_plane->config.max_tilt_deg = VL53L8CX_PLANE_DEFAULT_MAX_TILT_DEG;
+		p_plane->config.min_height_mm =
+			VL53L8CX_PLANE_DEFAULT_MIN_HEIGHT_MM;
+		p_plane->config.min_inliers = VL53L8CX_PLANE_DEFAULT_MIN_INLIERS;
+		p_plane->config.max_iterations =
+			VL53L8CX_PLANE_DEFAULT_MAX_ITERATIONS;
+		p_plane->config.budget_ns = VL53L8CX_PLANE_DEFAULT_BUDGET_NS;
+		p_plane->config.confidence = VL53L8CX_PLANE_DEFAULT_CONFIDENCE;
+		p_plane->config.warm_iterations =
+			VL53L8CX_PLANE_DEFAULT_WARM_ITERATIONS;
+	}
+}
+
+uint8_t vl53l8cx_plane_update(
+		VL53L8CX_Plane			*p_plane,
+		const VL53L8CX_PointCloud	*p_cloud)
+{
+	_VL53L8CX_PlanePoints pts;
+	float best[4], candidate[4], cost, best_cost = INFINITY;
+	uint64_t mask, t_start_ns = vl53l8cx_capture_now_ns(), elapsed_ns;
+	uint32_t i, zone, iter, needed, score, best_score = 0;
+	uint8_t from_prior = 0;
+
+	if ((p_cloud->nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (p_cloud->nb_zones != VL53L8CX_RESOLUTION_8X8))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	/* Pack the valid points, then pad the last vector */
+	pts.nb_points = 0;
+	for (mask = p_cloud->valid_mask[0]; mask != 0U; mask &= mask - 1U)
+	{
+		zone = (uint32_t)__builtin_ctzll(mask);
+		if (zone >= p_cloud->nb_zones)
+		{
+			break;
+		}
+		pts.x[pts.nb_points] = p_cloud->p_x_mm[zone];
+		pts.y[pts.nb_points] = p_cloud->p_y_mm[zone];
+		pts.z[pts.nb_points] = p_cloud->p_z_mm[zone];
+		pts.zone[pts.nb_points] = (uint8_t)zone;
+		pts.nb_points++;
+	}
+	for (i = pts.nb_points; (i % VL53L8CX_SIMD_LANES) != 0U; i++)
+	{
+		pts.x[i] = NAN;
+		pts.y[i] = NAN;
+		pts.z[i] = NAN;
+		pts.zone[i] = 0;
+	}
+
+	p_plane->is_found = 0;
+	p_plane->floor_mask = 0;
+	p_plane->nb_inliers = 0;
+	p_plane->stats.frames++;
+	if ((pts.nb_points < 3U)
+		|| (pts.nb_points < p_plane->config.min_inliers))
+	{
+		return VL53L8CX_STATUS_OK;
+	}
+
+	/* Start from the floor of the previous frame */
+	needed = p_plane->config.max_iterations;
+	if (p_plane->has_prior)
+	{
+		score = _vl53l8cx_plane_score(&pts, p_plane->prior,
+			p_plane->config.threshold_mm, &cost, NULL);
+		if (score >= p_plane->config.min_inliers)
+		{
+			(void)memcpy(best, p_plane->prior, sizeof(best));
+			best_score = score;
+			best_cost = cost;
+			from_prior = 1;
+			/* Only look for a better plane for a few draws */
+			needed = p_plane->config.warm_iterations;
+		}
+	}
+
+	for (iter = 0; (iter < p_plane->config.max_iterations)
+		&& (iter < needed); iter++)
+	{
+		if ((p_plane->config.budget_ns != 0U)
+			&& ((iter % _VL53L8CX_PLANE_CLOCK_PERIOD) == 0U)
+			&& (iter != 0U)
+			&& ((vl53l8cx_capture_now_ns() - t_start_ns)
+				>= p_plane->config.budget_ns))
+		{
+			p_plane->stats.budget_hits++;
+			break;
+		}
+		p_plane->stats.iterations++;
+		if (!_vl53l8cx_plane_draw(p_plane, &pts, candidate))
+		{
+			continue;
+		}
+		score = _vl53l8cx_plane_score(&pts, candidate,
+			p_plane->config.threshold_mm, &cost, NULL);
+		if ((score >= p_plane->config.min_inliers)
+			&& (cost < best_cost))
+		{
+			(void)memcpy(best, candidate, sizeof(best));
+			best_score = score;
+			best_cost = cost;
+			if (!from_prior)
+			{
+				needed = _vl53l8cx_plane_needed(p_plane, score,
+					pts.nb_points);
+			}
+			from_prior = 0;
+		}
+	}
+
+	if (best_score >= p_plane->config.min_inliers)
+	{
+		_vl53l8cx_plane_refine(p_plane, &pts, best);
+		mask = 0;
+		best_score = _vl53l8cx_plane_score(&pts, best,
+			p_plane->config.threshold_mm, &cost, &mask);
+	}
+	if (best_score >= p_plane->config.min_inliers)
+	{
+		p_plane->is_found = 1;
+		p_plane->normal[0] = best[0];
+		p_plane->normal[1] = best[1];
+		p_plane->normal[2] = best[2];
+		p_plane->offset_mm = best[3];
+		p_plane->nb_inliers = (uint8_t)best_score;
+		p_plane->floor_mask = mask;
+		(void)memcpy(p_plane->prior, best, sizeof(best));
+		p_plane->has_prior = 1;
+		p_plane->stats.found++;
+		p_plane->stats.warm_starts += from_prior;
+	}
+
+	elapsed_ns = vl53l8cx_capture_now_ns() - t_start_ns;
+	if (elapsed_ns > p_plane->stats.max_ns)
+	{
+		p_plane->stats.max_ns = elapsed_ns;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+void vl53l8cx_plane_get_stats(
+		VL53L8CX_Plane			*p_plane,
+		VL53L8CX_PlaneStats		*p_stats)
+{
+	*p_stats = p_plane->stats;
+}
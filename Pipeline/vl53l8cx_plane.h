@@ -0,0 +1,135 @@
+#ifndef VL53L8CX_PLANE_H_
+#define VL53L8CX_PLANE_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pointcloud.h"
+
+/**
+ * @brief Default floor detection: points within 40 mm of the plane are on
+ * the floor, which is tilted by 20 degrees at most, at least 200 mm below
+ * the sensor, and has 6 zones at least. RANSAC draws 64 planes at most, 8
+ * when the floor of the previous frame still fits, and stops after 20 us.
+ */
+
+#define VL53L8CX_PLANE_DEFAULT_THRESHOLD_MM	40.0f
+#define VL53L8CX_PLANE_DEFAULT_MAX_TILT_DEG	20.0f
+#define VL53L8CX_PLANE_DEFAULT_MIN_HEIGHT_MM	200.0f
+#define VL53L8CX_PLANE_DEFAULT_MIN_INLIERS	6U
+#define VL53L8CX_PLANE_DEFAULT_MAX_ITERATIONS	64U
+#define VL53L8CX_PLANE_DEFAULT_WARM_ITERATIONS	8U
+#define VL53L8CX_PLANE_DEFAULT_BUDGET_NS	20000U
+#define VL53L8CX_PLANE_DEFAULT_CONFIDENCE	0.99f
+
+/**
+ * @brief Structure VL53L8CX_PlaneConfig contains the floor detection
+ * settings.
+ */
+
+typedef struct
+{
+	/* Maximum height of a floor point above the plane, in mm */
+	float			threshold_mm;
+	/* Maximum angle between the normal of the floor and the y axis */
+	float			max_tilt_deg;
+	/* Minimum height of the sensor above the floor, in mm */
+	float			min_height_mm;
+	/* Minimum number of floor zones */
+	uint8_t			min_inliers;
+	/* Maximum number of planes drawn per frame, and when the floor of the
+	 * previous frame still fits */
+	uint16_t		max_iterations;
+	uint16_t		warm_iterations;
+	/* Time budget per frame, in ns, 0 for no budget */
+	uint32_t		budget_ns;
+	/* Probability to draw 3 floor points at least once: RANSAC stops
+	 * when enough planes have been drawn for the best one found */
+	float			confidence;
+} VL53L8CX_PlaneConfig;
+
+/**
+ * @brief Structure VL53L8CX_PlaneStats contains the floor detection
+ * counters.
+ */
+
+typedef struct
+{
+	uint32_t		frames;
+	/* Frames with a floor */
+	uint32_t		found;
+	/* Frames where the plane of the previous frame was kept */
+	uint32_t		warm_starts;
+	/* Frames stopped by the time budget */
+	uint32_t		budget_hits;
+	/* Planes drawn */
+	uint64_t		iterations;
+	/* Longest time of a frame, in ns */
+	uint64_t		max_ns;
+} VL53L8CX_PlaneStats;
+
+/**
+ * @brief Structure VL53L8CX_Plane finds the floor into the point clouds of a
+ * sensor, with RANSAC. The points must be into a frame where y is up (see
+ * VL53L8CX_PointCloudPose). Each frame starts from the plane of the previous
+ * one, so a still floor is confirmed with a few draws; otherwise planes are
+ * drawn from 3 valid points until the best plane is certain enough, the
+ * maximum of draws or the time budget. Planes are ranked by their MSAC cost.
+ * The best one is then fitted on its inliers (least squares).
+ */
+
+typedef struct
+{
+	VL53L8CX_PlaneConfig	config;
+	/* Floor of the last frame: normal . p + offset_mm = 0, normal
+	 * pointing up, so the height of the sensor is offset_mm */
+	uint8_t			is_found;
+	float			normal[3];
+	float			offset_mm;
+	uint8_t			nb_inliers;
+	/* Bit z is set when zone z is on the floor (or below it) */
+	uint64_t		floor_mask;
+	/* Plane used to start the next frame */
+	uint8_t			has_prior;
+	float			prior[4];
+	/* Random generator state (xorshift) */
+	uint32_t		seed;
+	VL53L8CX_PlaneStats	stats;
+} VL53L8CX_Plane;
+
+/**
+ * @brief This function initializes a floor detection.
+ * @param (VL53L8CX_Plane) *p_plane : Floor detection structure.
+ * @param (VL53L8CX_PlaneConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_plane_init(
+		VL53L8CX_Plane			*p_plane,
+		const VL53L8CX_PlaneConfig	*p_config);
+
+/**
+ * @brief This function finds the floor of a frame, using the first target of
+ * each zone. The floor zones are given by p_plane->floor_mask.
+ * @param (VL53L8CX_Plane) *p_plane : Floor detection structure.
+ * @param (VL53L8CX_PointCloud) *p_cloud : Points of the frame, see
+ * vl53l8cx_pointcloud_convert().
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution of the cloud is not valid.
+ */
+
+uint8_t vl53l8cx_plane_update(
+		VL53L8CX_Plane			*p_plane,
+		const VL53L8CX_PointCloud	*p_cloud);
+
+/**
+ * @brief This function reads the floor detection counters.
+ * @param (VL53L8CX_Plane) *p_plane : Floor detection structure.
+ * @param (VL53L8CX_PlaneStats) *p_stats : Counters values.
+ */
+
+void vl53l8cx_plane_get_stats(
+		VL53L8CX_Plane			*p_plane,
+		VL53L8CX_PlaneStats		*p_stats);
+
+#endif /* VL53L8CX_PLANE_H_ */
@@ -0,0 +1,189 @@
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_pointcloud.h"
+#include "vl53l8cx_pipeline.h"
+#include "vl53l8cx_simd.h"
+
+#define _VL53L8CX_POINTCLOUD_DEG_TO_RAD		0.017453292519943295f
+
+/*
+ * Unit direction of the center of each zone into the sensor frame, rotated by
+ * the pose.
+ */
+static void _vl53l8cx_pointcloud_fill_lut(
+		VL53L8CX_PointCloudLut		*p_lut,
+		const VL53L8CX_PointCloudPose	*p_pose,
+		uint8_t				width)
+{
+	const float *r = p_pose->rotation;
+	float fov = VL53L8CX_POINTCLOUD_FOV_DEG
+		* _VL53L8CX_POINTCLOUD_DEG_TO_RAD;
+	float x, y, norm;
+	uint8_t row, col, zone;
+
+	for (row = 0; row < width; row++)
+	{
+		for (col = 0; col < width; col++)
+		{
+			zone = (uint8_t)((row * width) + col);
+			x = tanf(((((float)col + 0.5f) / (float)width) - 0.5f)
+				* fov);
+			y = tanf((0.5f - (((float)row + 0.5f) / (float)width))
+				* fov);
+			norm = 1.0f / sqrtf((x * x) + (y * y) + 1.0f);
+			x *= norm;
+			y *= norm;
+			p_lut->dir_x[zone] = (r[0] * x) + (r[1] * y) + (r[2] * norm);
+			p_lut->dir_y[zone] = (r[3] * x) + (r[4] * y) + (r[5] * norm);
+			p_lut->dir_z[zone] = (r[6] * x) + (r[7] * y) + (r[8] * norm);
+		}
+	}
+}
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+/* Validity of target 'target' of each zone */
+static uint64_t _vl53l8cx_pointcloud_valid(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		uint32_t			target)
+{
+	uint64_t mask = 0;
+	uint32_t zone;
+
+	if (target == 0U)
+	{
+		return vl53l8cx_valid_zones(p_results, nb_zones);
+	}
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		mask |= (uint64_t)vl53l8cx_target_is_valid(p_results, zone,
+				target) << zone;
+	}
+
+	return mask;
+}
+#endif
+
+void vl53l8cx_pointcloud_pose(
+		VL53L8CX_PointCloudPose		*p_pose,
+		float				roll_deg,
+		float				pitch_deg,
+		float				yaw_deg,
+		const float			*p_translation_mm)
+{
+	float cr = cosf(roll_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float sr = sinf(roll_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float cp = cosf(pitch_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float sp = sinf(pitch_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float cy = cosf(yaw_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float sy = sinf(yaw_deg * _VL53L8CX_POINTCLOUD_DEG_TO_RAD);
+	float *r = p_pose->rotation;
+
+	/* Ry(yaw) * Rx(pitch) * Rz(roll) */
+	r[0] = (cy * cr) + (sy * sp * sr);
+	r[1] = (-cy * sr) + (sy * sp * cr);
+	r[2] = sy * cp;
+	r[3] = cp * sr;
+	r[4] = cp * cr;
+	r[5] = -sp;
+	r[6] = (-sy * cr) + (cy * sp * sr);
+	r[7] = (sy * sr) + (cy * sp * cr);
+	r[8] = cy * cp;
+
+	if (p_translation_mm != NULL)
+	{
+		(void)memcpy(p_pose->translation_mm, p_translation_mm,
+				sizeof(p_pose->translation_mm));
+	}
+	else
+	{
+		(void)memset(p_pose->translation_mm, 0,
+				sizeof(p_pose->translation_mm));
+	}
+}
+
+void vl53l8cx_pointcloud_init(
+		VL53L8CX_PointCloudConverter	*p_conv,
+		const VL53L8CX_PointCloudPose	*p_pose)
+{
+	(void)memset(p_conv, 0, sizeof(*p_conv));
+	if (p_pose != NULL)
+	{
+		p_conv->pose = *p_pose;
+	}
+	else
+	{
+		vl53l8cx_pointcloud_pose(&p_conv->pose, 0.0f, 0.0f, 0.0f, NULL);
+	}
+
+	_vl53l8cx_pointcloud_fill_lut(&p_conv->lut_4x4, &p_conv->pose, 4);
+	_vl53l8cx_pointcloud_fill_lut(&p_conv->lut_8x8, &p_conv->pose, 8);
+}
+
+uint8_t vl53l8cx_pointcloud_convert(
+		const VL53L8CX_PointCloudConverter *p_conv,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		VL53L8CX_PointCloud		*p_cloud)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	_Alignas(16) float distance[VL53L8CX_RESOLUTION_8X8];
+	const VL53L8CX_PointCloudLut *p_lut;
+	const float *t = p_conv->pose.translation_mm;
+	vl53l8cx_v4f d, valid;
+	uint64_t mask;
+	uint32_t target, zone, base;
+
+	if (((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+		|| (p_cloud->capacity < ((uint32_t)nb_zones
+			* (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE)))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_lut = (nb_zones == VL53L8CX_RESOLUTION_8X8)
+		? &p_conv->lut_8x8 : &p_conv->lut_4x4;
+	p_cloud->nb_zones = nb_zones;
+	p_cloud->nb_valid = 0;
+
+	for (target = 0; target < (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+			target++)
+	{
+		mask = _vl53l8cx_pointcloud_valid(p_results, nb_zones, target);
+		p_cloud->valid_mask[target] = mask;
+		p_cloud->nb_valid += (uint32_t)__builtin_popcountll(mask);
+
+		/* Targets of a zone are interleaved into the results */
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			distance[zone] = (float)p_results->distance_mm[
+				(zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE)
+				+ target];
+		}
+
+		base = target * (uint32_t)nb_zones;
+		for (zone = 0; zone < nb_zones; zone += VL53L8CX_SIMD_LANES)
+		{
+			d = VL53L8CX_V4F(&distance[zone]);
+			valid = vl53l8cx_simd_mask_to_v4f(mask, zone);
+			VL53L8CX_V4F_U(&p_cloud->p_x_mm[base + zone]) = valid
+				* ((d * VL53L8CX_V4F(&p_lut->dir_x[zone])) + t[0]);
+			VL53L8CX_V4F_U(&p_cloud->p_y_mm[base + zone]) = valid
+				* ((d * VL53L8CX_V4F(&p_lut->dir_y[zone])) + t[1]);
+			VL53L8CX_V4F_U(&p_cloud->p_z_mm[base + zone]) = valid
+				* ((d * VL53L8CX_V4F(&p_lut->dir_z[zone])) + t[2]);
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_conv;
+	(void)p_results;
+	(void)nb_zones;
+	(void)p_cloud;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
@@ -0,0 +1,137 @@
+#ifndef VL53L8CX_POINTCLOUD_H_
+#define VL53L8CX_POINTCLOUD_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Field of view of the sensor, horizontal and vertical, in degrees.
+ * The zones split it evenly.
+ */
+
+#define VL53L8CX_POINTCLOUD_FOV_DEG		45.0f
+
+/**
+ * @brief Maximum number of points of a frame (8x8, all targets).
+ */
+
+#define VL53L8CX_POINTCLOUD_MAX_POINTS	((uint32_t)VL53L8CX_RESOLUTION_8X8 \
+	* (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE)
+
+/**
+ * @brief Structure VL53L8CX_PointCloudPose gives the mounting of the sensor.
+ * Into the sensor frame, z is the optical axis, x goes towards the increasing
+ * columns of zones, and y towards the decreasing rows (zone = row * width +
+ * column). A point p of the sensor frame becomes rotation * p + translation.
+ * The rotation may be any 3x3 matrix, for instance a mirror when the zones
+ * are seen flipped.
+ */
+
+typedef struct
+{
+	/* Row-major 3x3 matrix */
+	float			rotation[9];
+	/* Position of the sensor, in mm */
+	float			translation_mm[3];
+} VL53L8CX_PointCloudPose;
+
+/**
+ * @brief Structure VL53L8CX_PointCloudLut contains the unit direction of the
+ * center of each zone, already rotated by the pose.
+ */
+
+typedef struct
+{
+	_Alignas(16) float	dir_x[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	dir_y[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	dir_z[VL53L8CX_RESOLUTION_8X8];
+} VL53L8CX_PointCloudLut;
+
+/**
+ * @brief Structure VL53L8CX_PointCloudConverter contains the directions of
+ * both resolutions for one mounting pose. They are computed once by
+ * vl53l8cx_pointcloud_init(), so the conversion of a frame is a multiply per
+ * coordinate, 4 zones at a time. A converter is read-only after its
+ * initialization and can be shared by several threads.
+ */
+
+typedef struct
+{
+	VL53L8CX_PointCloudPose	pose;
+	VL53L8CX_PointCloudLut	lut_4x4;
+	VL53L8CX_PointCloudLut	lut_8x8;
+} VL53L8CX_PointCloudConverter;
+
+/**
+ * @brief Structure VL53L8CX_PointCloud is the point buffer, provided by the
+ * caller: one array per coordinate, of 'capacity' floats each. Point of target
+ * t of zone z is at index t * nb_zones + z. Invalid points are set to 0, and
+ * their bit of valid_mask[t] is cleared.
+ */
+
+typedef struct
+{
+	/* Coordinates into the output frame, in mm */
+	float			*p_x_mm;
+	float			*p_y_mm;
+	float			*p_z_mm;
+	/* Size of each array, at least nb_zones * VL53L8CX_NB_TARGET_PER_ZONE */
+	uint32_t		capacity;
+	/* Filled by vl53l8cx_pointcloud_convert() */
+	uint8_t			nb_zones;
+	uint32_t		nb_valid;
+	/* Bit z of valid_mask[t] is set when target t of zone z is valid */
+	uint64_t		valid_mask[VL53L8CX_NB_TARGET_PER_ZONE];
+} VL53L8CX_PointCloud;
+
+/**
+ * @brief This function builds a pose from the mounting angles, applied in the
+ * order roll (around z), pitch (around x) and yaw (around y). Angles follow
+ * the right-hand rule.
+ * @param (VL53L8CX_PointCloudPose) *p_pose : Pose to build.
+ * @param (float) roll_deg : Rotation around the optical axis, in degrees.
+ * @param (float) pitch_deg : Rotation around x, in degrees.
+ * @param (float) yaw_deg : Rotation around y, in degrees.
+ * @param (float) *p_translation_mm : Position of the sensor (x, y, z), in mm,
+ * or NULL for the origin.
+ */
+
+void vl53l8cx_pointcloud_pose(
+		VL53L8CX_PointCloudPose		*p_pose,
+		float				roll_deg,
+		float				pitch_deg,
+		float				yaw_deg,
+		const float			*p_translation_mm);
+
+/**
+ * @brief This function computes the directions of the zones of both
+ * resolutions for a pose.
+ * @param (VL53L8CX_PointCloudConverter) *p_conv : Converter structure.
+ * @param (VL53L8CX_PointCloudPose) *p_pose : Mounting pose, or NULL for the
+ * sensor frame.
+ */
+
+void vl53l8cx_pointcloud_init(
+		VL53L8CX_PointCloudConverter	*p_conv,
+		const VL53L8CX_PointCloudPose	*p_pose);
+
+/**
+ * @brief This function converts the distances of a frame into points. Targets
+ * are valid when their status is 5 or 9, and when the zone has detected them.
+ * Nothing is allocated.
+ * @param (VL53L8CX_PointCloudConverter) *p_conv : Converter structure.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame to convert.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @param (VL53L8CX_PointCloud) *p_cloud : Point buffer.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution is not valid, or if the buffer is too small.
+ */
+
+uint8_t vl53l8cx_pointcloud_convert(
+		const VL53L8CX_PointCloudConverter *p_conv,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		VL53L8CX_PointCloud		*p_cloud);
+
+#endif /* VL53L8CX_POINTCLOUD_H_ */
@@ -0,0 +1,282 @@
+#include <string.h>
+#include <errno.h>
+
+#include "vl53l8cx_pool.h"
+#include "vl53l8cx_capture.h"
+
+#ifdef VL53L8CX_SHARED_BUFFERS
+
+/*
+ * Gives the calibration buffer starting at p_data, or NULL. Called with the
+ * lock held.
+ */
+static VL53L8CX_PoolCaldata *_vl53l8cx_pool_find_caldata(
+		VL53L8CX_Pool			*p_pool,
+		const uint8_t			*p_data)
+{
+	uint32_t i;
+
+	for (i = 0; i < VL53L8CX_POOL_NB_CALDATA; i++)
+	{
+		if ((p_data != NULL) && (p_pool->caldata[i].p_data == p_data))
+		{
+			return &p_pool->caldata[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Drops a reference to a calibration buffer, called with the lock held */
+static void _vl53l8cx_pool_unref_caldata(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_PoolCaldata		*p_caldata)
+{
+	if ((p_caldata == NULL) || (p_caldata->nb_refs == 0U))
+	{
+		return;
+	}
+
+	p_caldata->nb_refs--;
+	p_pool->stats.caldata_refs--;
+	if (p_caldata->nb_refs == 0U)
+	{
+		p_pool->stats.caldata_used--;
+	}
+}
+
+uint8_t vl53l8cx_pool_init(
+		VL53L8CX_Pool			*p_pool)
+{
+	pthread_condattr_t attr;
+	uint32_t i;
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	(void)memset(p_pool, 0, sizeof(*p_pool));
+	p_pool->free_mask = (uint32_t)((1ULL << VL53L8CX_POOL_NB_BUFFERS) - 1U);
+	for (i = 0; i < VL53L8CX_POOL_NB_OFFSETS; i++)
+	{
+		p_pool->caldata[i].p_data = p_pool->offsets[i];
+		p_pool->caldata[i].size = VL53L8CX_OFFSET_BUFFER_SIZE;
+	}
+	for (i = 0; i < VL53L8CX_POOL_NB_XTALKS; i++)
+	{
+		p_pool->caldata[VL53L8CX_POOL_NB_OFFSETS + i].p_data =
+			p_pool->xtalks[i];
+		p_pool->caldata[VL53L8CX_POOL_NB_OFFSETS + i].size =
+			VL53L8CX_XTALK_BUFFER_SIZE;
+	}
+
+	/* Borrows wait on CLOCK_MONOTONIC deadlines */
+	if ((pthread_condattr_init(&attr) != 0)
+		|| (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0))
+	{
+		return VL53L8CX_STATUS_ERROR;
+	}
+	if ((pthread_mutex_init(&p_pool->lock, NULL) != 0)
+		|| (pthread_cond_init(&p_pool->released, &attr) != 0))
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+	(void)pthread_condattr_destroy(&attr);
+
+	return status;
+}
+
+void vl53l8cx_pool_attach(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev)
+{
+	p_dev->p_buffer_pool = p_pool;
+	p_dev->offset_data = NULL;
+	p_dev->xtalk_data = NULL;
+	p_dev->temp_buffer = NULL;
+}
+
+void vl53l8cx_pool_detach(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev)
+{
+	vl53l8cx_pool_release(p_pool, p_dev);
+
+	(void)pthread_mutex_lock(&p_pool->lock);
+	_vl53l8cx_pool_unref_caldata(p_pool,
+		_vl53l8cx_pool_find_caldata(p_pool, p_dev->offset_data));
+	_vl53l8cx_pool_unref_caldata(p_pool,
+		_vl53l8cx_pool_find_caldata(p_pool, p_dev->xtalk_data));
+	p_dev->offset_data = NULL;
+	p_dev->xtalk_data = NULL;
+	(void)pthread_mutex_unlock(&p_pool->lock);
+
+	p_dev->p_buffer_pool = NULL;
+}
+
+uint8_t vl53l8cx_pool_acquire(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			timeout_ms)
+{
+	struct timespec ts;
+	uint8_t i, used, status = VL53L8CX_STATUS_OK;
+	int ret = 0;
+
+	if (p_dev->temp_buffer != NULL)
+	{
+		return VL53L8CX_STATUS_OK;
+	}
+
+	vl53l8cx_capture_to_timespec(vl53l8cx_capture_now_ns()
+			+ ((uint64_t)timeout_ms * 1000000U), &ts);
+
+	(void)pthread_mutex_lock(&p_pool->lock);
+	if (p_pool->free_mask == 0U)
+	{
+		p_pool->stats.waits++;
+	}
+	while ((p_pool->free_mask == 0U) && (ret != ETIMEDOUT))
+	{
+		ret = pthread_cond_timedwait(&p_pool->released, &p_pool->lock,
+				&ts);
+	}
+	if (p_pool->free_mask != 0U)
+	{
+		i = (uint8_t)__builtin_ctz(p_pool->free_mask);
+		p_pool->free_mask &= ~(1UL << i);
+		p_dev->temp_buffer = p_pool->buffers[i];
+
+		used = (uint8_t)(VL53L8CX_POOL_NB_BUFFERS
+			- (uint8_t)__builtin_popcount(p_pool->free_mask));
+		p_pool->stats.buffers_used = used;
+		if (used > p_pool->stats.buffers_used_max)
+		{
+			p_pool->stats.buffers_used_max = used;
+		}
+	}
+	else
+	{
+		p_pool->stats.timeouts++;
+		status |= VL53L8CX_STATUS_TIMEOUT_ERROR;
+	}
+	(void)pthread_mutex_unlock(&p_pool->lock);
+
+	return status;
+}
+
+void vl53l8cx_pool_release(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t i;
+
+	if (p_dev->temp_buffer == NULL)
+	{
+		return;
+	}
+
+	(void)pthread_mutex_lock(&p_pool->lock);
+	for (i = 0; i < VL53L8CX_POOL_NB_BUFFERS; i++)
+	{
+		if (p_dev->temp_buffer == p_pool->buffers[i])
+		{
+			p_pool->free_mask |= (1UL << i);
+			p_pool->stats.buffers_used--;
+			(void)pthread_cond_signal(&p_pool->released);
+		}
+	}
+	p_dev->temp_buffer = NULL;
+	(void)pthread_mutex_unlock(&p_pool->lock);
+}
+
+void vl53l8cx_pool_get_stats(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_PoolStats		*p_stats)
+{
+	(void)pthread_mutex_lock(&p_pool->lock);
+	*p_stats = p_pool->stats;
+	(void)pthread_mutex_unlock(&p_pool->lock);
+}
+
+/*
+ * Driver hook, see vl53l8cx_api.h. A device using the only reference to its
+ * buffer updates it in place, so a calibration change never needs a spare
+ * buffer. Otherwise the device moves to a buffer with the same content, or to
+ * a free one.
+ */
+uint8_t vl53l8cx_share_caldata(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				**pp_caldata,
+		const uint8_t			*p_data,
+		uint16_t			size)
+{
+	VL53L8CX_Pool *p_pool = (VL53L8CX_Pool *)p_dev->p_buffer_pool;
+	VL53L8CX_PoolCaldata *p_old, *p_new = NULL, *p_free = NULL;
+	uint32_t i;
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if (p_pool == NULL)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	(void)pthread_mutex_lock(&p_pool->lock);
+	p_old = _vl53l8cx_pool_find_caldata(p_pool, *pp_caldata);
+	for (i = 0; i < VL53L8CX_POOL_NB_CALDATA; i++)
+	{
+		if (p_pool->caldata[i].size != size)
+		{
+			continue;
+		}
+		if (p_pool->caldata[i].nb_refs == 0U)
+		{
+			if (p_free == NULL)
+			{
+				p_free = &p_pool->caldata[i];
+			}
+		}
+		else if (memcmp(p_pool->caldata[i].p_data, p_data, size) == 0)
+		{
+			p_new = &p_pool->caldata[i];
+			break;
+		}
+	}
+
+	if ((p_new != NULL) && (p_new == p_old))
+	{
+		/* Same content, nothing to do */
+	}
+	else if (p_new != NULL)
+	{
+		_vl53l8cx_pool_unref_caldata(p_pool, p_old);
+		p_new->nb_refs++;
+		p_pool->stats.caldata_refs++;
+	}
+	else if ((p_old != NULL) && (p_old->nb_refs == 1U))
+	{
+		(void)memmove(p_old->p_data, p_data, size);
+		p_new = p_old;
+	}
+	else if (p_free != NULL)
+	{
+		(void)memcpy(p_free->p_data, p_data, size);
+		_vl53l8cx_pool_unref_caldata(p_pool, p_old);
+		p_new = p_free;
+		p_new->nb_refs = 1;
+		p_pool->stats.caldata_used++;
+		p_pool->stats.caldata_refs++;
+	}
+	else
+	{
+		/* No room, the device keeps its previous calibration */
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+
+	if (p_new != NULL)
+	{
+		*pp_caldata = p_new->p_data;
+	}
+	(void)pthread_mutex_unlock(&p_pool->lock);
+
+	return status;
+}
+
+#endif /* VL53L8CX_SHARED_BUFFERS */
@@ -0,0 +1,240 @@
+#ifndef VL53L8CX_POOL_H_
+#define VL53L8CX_POOL_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "vl53l8cx_api.h"
+
+#ifdef VL53L8CX_SHARED_BUFFERS
+
+/**
+ * @brief Number of temporary buffers of a pool. A device uses a temporary
+ * buffer during each transaction, so this is the number of transactions run
+ * at the same time, usually one per bus. A device also holds its buffer
+ * during a whole non-blocking operation: the manager needs a second buffer
+ * for each bus with several sensors (see VL53L8CX_Manager).
+ */
+
+#ifndef VL53L8CX_POOL_NB_BUFFERS
+#define VL53L8CX_POOL_NB_BUFFERS		2U
+#endif
+
+#if (VL53L8CX_POOL_NB_BUFFERS == 0) || (VL53L8CX_POOL_NB_BUFFERS > 32)
+#error "VL53L8CX_POOL_NB_BUFFERS must be between 1 and 32"
+#endif
+
+/**
+ * @brief Number of devices attached to a pool. Offsets come from the NVM of
+ * each sensor, so they are rarely shared: by default a pool stores one offset
+ * per device.
+ */
+
+#ifndef VL53L8CX_POOL_NB_DEVICES
+#define VL53L8CX_POOL_NB_DEVICES		32U
+#endif
+
+/**
+ * @brief Number of different offset and Xtalk calibrations stored into a
+ * pool. Xtalk is shared by all devices using the default one.
+ */
+
+#ifndef VL53L8CX_POOL_NB_OFFSETS
+#define VL53L8CX_POOL_NB_OFFSETS		VL53L8CX_POOL_NB_DEVICES
+#endif
+
+#ifndef VL53L8CX_POOL_NB_XTALKS
+#define VL53L8CX_POOL_NB_XTALKS			2U
+#endif
+
+#define VL53L8CX_POOL_NB_CALDATA \
+	(VL53L8CX_POOL_NB_OFFSETS + VL53L8CX_POOL_NB_XTALKS)
+
+/**
+ * @brief Maximum time waited by the engines (capture, manager, TDMA, sync) for
+ * a temporary buffer, see vl53l8cx_pool_begin().
+ */
+
+#ifndef VL53L8CX_POOL_TIMEOUT_MS
+#define VL53L8CX_POOL_TIMEOUT_MS		1000U
+#endif
+
+/**
+ * @brief Structure VL53L8CX_PoolCaldata is a calibration buffer, used by
+ * nb_refs devices.
+ */
+
+typedef struct
+{
+	uint8_t			*p_data;
+	uint16_t		size;
+	uint16_t		nb_refs;
+} VL53L8CX_PoolCaldata;
+
+/**
+ * @brief Structure VL53L8CX_PoolStats contains the pool counters.
+ */
+
+typedef struct
+{
+	/* Temporary buffers borrowed now, and at most since init */
+	uint8_t			buffers_used;
+	uint8_t			buffers_used_max;
+	/* Borrows which waited for a buffer, or timed out */
+	uint32_t		waits;
+	uint32_t		timeouts;
+	/* Calibration buffers used, and references to them from devices */
+	uint16_t		caldata_used;
+	uint16_t		caldata_refs;
+} VL53L8CX_PoolStats;
+
+/**
+ * @brief Structure VL53L8CX_Pool contains the buffers of the devices built with
+ * VL53L8CX_SHARED_BUFFERS. A device borrows a temporary buffer for each
+ * transaction: the buffer must be held from before the first driver call
+ * until the last one using its content, for instance from
+ * vl53l8cx_check_data_ready() to vl53l8cx_get_ranging_data(), or during a
+ * whole non-blocking operation. The engines of this directory borrow it
+ * around each of their transactions; an application calling the driver
+ * itself uses vl53l8cx_pool_begin() and vl53l8cx_pool_end() the same way.
+ * Calibration buffers are shared by devices with the same content, and
+ * replaced when a device changes its calibration.
+ */
+
+typedef struct
+{
+	pthread_mutex_t		lock;
+	pthread_cond_t		released;
+	/* Bit i is set when buffers[i] is free */
+	uint32_t		free_mask;
+	uint8_t			buffers[VL53L8CX_POOL_NB_BUFFERS]
+					[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	uint8_t			offsets[VL53L8CX_POOL_NB_OFFSETS]
+					[VL53L8CX_OFFSET_BUFFER_SIZE];
+	uint8_t			xtalks[VL53L8CX_POOL_NB_XTALKS]
+					[VL53L8CX_XTALK_BUFFER_SIZE];
+	VL53L8CX_PoolCaldata	caldata[VL53L8CX_POOL_NB_CALDATA];
+	VL53L8CX_PoolStats	stats;
+} VL53L8CX_Pool;
+
+/**
+ * @brief This function initializes a pool with all buffers free.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_pool_init(
+		VL53L8CX_Pool			*p_pool);
+
+/**
+ * @brief This function attaches a device to a pool. It must be called before
+ * vl53l8cx_init(), which stores the calibration of the device.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ */
+
+void vl53l8cx_pool_attach(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function releases all the buffers used by a device.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ */
+
+void vl53l8cx_pool_detach(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function borrows a temporary buffer for a device, waiting for
+ * one if all are used. Nothing is done if the device already has one.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ * @param (uint32_t) timeout_ms : Maximum time to wait.
+ * @return (uint8_t) status : 0 if OK, or 1 on timeout.
+ */
+
+uint8_t vl53l8cx_pool_acquire(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			timeout_ms);
+
+/**
+ * @brief This function gives the temporary buffer of a device back. Its
+ * content is lost.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ */
+
+void vl53l8cx_pool_release(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function reads the pool counters.
+ * @param (VL53L8CX_Pool) *p_pool : Pool structure.
+ * @param (VL53L8CX_PoolStats) *p_stats : Counters values.
+ */
+
+void vl53l8cx_pool_get_stats(
+		VL53L8CX_Pool			*p_pool,
+		VL53L8CX_PoolStats		*p_stats);
+
+#endif /* VL53L8CX_SHARED_BUFFERS */
+
+/**
+ * @brief This function borrows the temporary buffer needed by a transaction,
+ * from the pool the device is attached to. Without VL53L8CX_SHARED_BUFFERS it
+ * does nothing, so the engines call it around each transaction whatever the
+ * build.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ * @return (uint8_t) status : 0 if OK, 1 (VL53L8CX_STATUS_TIMEOUT_ERROR) if no
+ * buffer was released within VL53L8CX_POOL_TIMEOUT_MS, or 127 if the device
+ * has no buffer and no pool.
+ */
+
+static inline uint8_t vl53l8cx_pool_begin(
+		VL53L8CX_Configuration		*p_dev)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	if (p_dev->p_buffer_pool != NULL)
+	{
+		return vl53l8cx_pool_acquire(
+				(VL53L8CX_Pool *)p_dev->p_buffer_pool, p_dev,
+				VL53L8CX_POOL_TIMEOUT_MS);
+	}
+	if (p_dev->temp_buffer == NULL)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+#else
+	(void)p_dev;
+#endif
+
+	return VL53L8CX_STATUS_OK;
+}
+
+/**
+ * @brief This function gives back the buffer borrowed by
+ * vl53l8cx_pool_begin(). Without VL53L8CX_SHARED_BUFFERS it does nothing.
+ * @param (VL53L8CX_Configuration) *p_dev : Device structure.
+ */
+
+static inline void vl53l8cx_pool_end(
+		VL53L8CX_Configuration		*p_dev)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	if (p_dev->p_buffer_pool != NULL)
+	{
+		vl53l8cx_pool_release((VL53L8CX_Pool *)p_dev->p_buffer_pool,
+				p_dev);
+	}
+#else
+	(void)p_dev;
+#endif
+}
+
+#endif /* VL53L8CX_POOL_H_ */
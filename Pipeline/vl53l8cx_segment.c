@@ -0,0 +1,221 @@
+#include <string.h>
+
+#include "vl53l8cx_segment.h"
+#include "vl53l8cx_pipeline.h"
+#include "vl53l8cx_pointcloud.h"
+#include "vl53l8cx_simd.h"
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+/*
+ * Links of each zone with the zone 'offset' after it: bit z is set when both
+ * are at continuous distances. Zones are compared 4 at a time, and the bits
+ * of each lane are gathered in 32-bit accumulators. Distances are integers,
+ * so the float comparison is exact.
+ */
+static uint64_t _vl53l8cx_segment_links(
+		const VL53L8CX_Segment		*p_seg,
+		const float			*p_distance,
+		uint8_t				nb_zones,
+		uint8_t				offset)
+{
+	const vl53l8cx_v4i lane_bits = {1, 2, 4, 8};
+	float step = (float)p_seg->config.max_step_mm * 100.0f;
+	float percent = (float)p_seg->config.max_step_percent;
+	vl53l8cx_v4f a, b;
+	vl53l8cx_v4i links[2] = {{0, 0, 0, 0}, {0, 0, 0, 0}}, bits;
+	uint32_t zone, half;
+
+	for (zone = 0; zone < nb_zones; zone += VL53L8CX_SIMD_LANES)
+	{
+		a = VL53L8CX_V4F(&p_distance[zone]);
+		b = VL53L8CX_V4F_U(&p_distance[zone + offset]);
+		bits = lane_bits << (int32_t)(zone % 32U);
+		links[zone / 32U] |= bits & ((vl53l8cx_simd_select(a > b, a - b,
+			b - a) * 100.0f) <= (step
+			+ (vl53l8cx_simd_min(a, b) * percent)));
+	}
+	for (half = 0; half < 2U; half++)
+	{
+		links[half] |= __builtin_shuffle(links[half],
+			(vl53l8cx_v4i){2, 3, 0, 1});
+		links[half] |= __builtin_shuffle(links[half],
+			(vl53l8cx_v4i){1, 0, 3, 2});
+	}
+
+	return (uint64_t)(uint32_t)links[0][0]
+		| ((uint64_t)(uint32_t)links[1][0] << 32);
+}
+
+/* Zone stats of an obstacle */
+static void _vl53l8cx_segment_measure(
+		const float			*p_distance,
+		uint64_t			zones,
+		uint8_t				shift,
+		VL53L8CX_Obstacle		*p_obs)
+{
+	uint8_t width = (uint8_t)(1U << shift);
+	float fov = VL53L8CX_POINTCLOUD_FOV_DEG;
+	float sum = 0.0f, min = (float)INT16_MAX;
+	uint32_t i, zone, n = 0, rows = 0, sum_row = 0, sum_col = 0;
+	uint64_t mask, cols;
+
+	for (mask = zones; mask != 0U; mask &= mask - 1U)
+	{
+		zone = (uint32_t)__builtin_ctzll(mask);
+		sum += p_distance[zone];
+		min = (p_distance[zone] < min) ? p_distance[zone] : min;
+		sum_row += zone >> shift;
+		sum_col += zone & (uint32_t)(width - 1U);
+		n++;
+	}
+
+	/* Bounding box: rows which are not empty, and all rows or-ed */
+	cols = zones;
+	for (i = 0; i < width; i++)
+	{
+		rows |= (uint32_t)(((zones >> (i * width))
+			& ((1ULL << width) - 1U)) != 0U) << i;
+	}
+	for (i = (uint32_t)(width * width) / 2U; i >= width; i /= 2U)
+	{
+		cols |= cols >> i;
+	}
+	cols &= (1ULL << width) - 1U;
+
+	p_obs->zones = zones;
+	p_obs->nb_zones = (uint8_t)n;
+	p_obs->min_row = (uint8_t)__builtin_ctz(rows);
+	p_obs->max_row = (uint8_t)(31 - __builtin_clz(rows));
+	p_obs->min_col = (uint8_t)__builtin_ctzll(cols);
+	p_obs->max_col = (uint8_t)(63 - __builtin_clzll(cols));
+	p_obs->min_distance_mm = (int16_t)min;
+	p_obs->mean_distance_mm = (int16_t)((sum / (float)n) + 0.5f);
+	/* Zone centers are evenly spread in angle */
+	p_obs->azimuth_deg = (((((float)sum_col / (float)n) + 0.5f)
+		/ (float)width) - 0.5f) * fov;
+	p_obs->elevation_deg = (0.5f - ((((float)sum_row / (float)n) + 0.5f)
+		/ (float)width)) * fov;
+}
+#endif
+
+void vl53l8cx_segment_init(
+		VL53L8CX_Segment		*p_seg,
+		const VL53L8CX_SegmentConfig	*p_config)
+{
+	(void)memset(p_seg, 0, sizeof(*p_seg));
+	(void)memset(p_seg->label, VL53L8CX_SEGMENT_NO_LABEL,
+			sizeof(p_seg->label));
+	if (p_config != NULL)
+	{
+		p_seg->config = *p_config;
+	}
+	else
+	{
+		p_seg->config.max_step_mm = VL53L8CX_SEGMENT_DEFAULT_MAX_STEP_MM;
+		p_seg->config.max_step_percent =
+			VL53L8CX_SEGMENT_DEFAULT_MAX_STEP_PERCENT;
+		p_seg->config.min_zones = VL53L8CX_SEGMENT_DEFAULT_MIN_ZONES;
+	}
+}
+
+uint8_t vl53l8cx_segment_update(
+		VL53L8CX_Segment		*p_seg,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	VL53L8CX_Obstacle obs;
+	/* Padded, so the last links read past the zones */
+	_Alignas(16) float distance[VL53L8CX_RESOLUTION_8X8 + 8U];
+	uint64_t valid, right, down, remaining, comp, prev, mask;
+	uint64_t not_last_col;
+	uint32_t zone, i;
+	uint8_t width, shift;
+
+	if (nb_zones == VL53L8CX_RESOLUTION_4X4)
+	{
+		width = 4;
+		shift = 2;
+		valid = 0xFFFFU;
+		not_last_col = 0x7777U;
+	}
+	else if (nb_zones == VL53L8CX_RESOLUTION_8X8)
+	{
+		width = 8;
+		shift = 3;
+		valid = ~(uint64_t)0U;
+		not_last_col = 0x7F7F7F7F7F7F7F7FU;
+	}
+	else
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	valid &= vl53l8cx_valid_zones(p_results, nb_zones);
+
+	/* Links with the right and the lower neighbours */
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		distance[zone] = (float)p_results->distance_mm[zone
+			* (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE];
+	}
+	for (; zone < (sizeof(distance) / sizeof(distance[0])); zone++)
+	{
+		distance[zone] = 0.0f;
+	}
+	right = _vl53l8cx_segment_links(p_seg, distance, nb_zones, 1);
+	down = _vl53l8cx_segment_links(p_seg, distance, nb_zones, width);
+	right &= not_last_col & valid & (valid >> 1);
+	down &= valid & (valid >> width);
+
+	p_seg->nb_obstacles = 0;
+	for (remaining = valid; remaining != 0U; remaining &= ~comp)
+	{
+		/* Flood fill from the first zone left */
+		comp = remaining & (~remaining + 1U);
+		do
+		{
+			prev = comp;
+			comp |= ((comp & right) << 1) | ((comp >> 1) & right)
+				| ((comp & down) << width)
+				| ((comp >> width) & down);
+		} while (comp != prev);
+
+		_vl53l8cx_segment_measure(distance, comp, shift, &obs);
+		if ((obs.nb_zones < p_seg->config.min_zones)
+			|| (p_seg->nb_obstacles
+				>= VL53L8CX_SEGMENT_MAX_OBSTACLES))
+		{
+			continue;
+		}
+
+		/* Keep the obstacles sorted, nearest first */
+		for (i = p_seg->nb_obstacles; (i > 0U)
+			&& (p_seg->obstacles[i - 1U].min_distance_mm
+				> obs.min_distance_mm); i--)
+		{
+			p_seg->obstacles[i] = p_seg->obstacles[i - 1U];
+		}
+		p_seg->obstacles[i] = obs;
+		p_seg->nb_obstacles++;
+	}
+
+	(void)memset(p_seg->label, VL53L8CX_SEGMENT_NO_LABEL,
+			sizeof(p_seg->label));
+	for (i = 0; i < p_seg->nb_obstacles; i++)
+	{
+		for (mask = p_seg->obstacles[i].zones; mask != 0U;
+				mask &= mask - 1U)
+		{
+			p_seg->label[__builtin_ctzll(mask)] = (uint8_t)i;
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_seg;
+	(void)p_results;
+	(void)nb_zones;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
@@ -0,0 +1,112 @@
+#ifndef VL53L8CX_SEGMENT_H_
+#define VL53L8CX_SEGMENT_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Maximum number of obstacles of a frame: one per zone, as adjacent
+ * zones may be split by their distances.
+ */
+
+#define VL53L8CX_SEGMENT_MAX_OBSTACLES		VL53L8CX_RESOLUTION_8X8
+
+/**
+ * @brief Label of the zones which belong to no obstacle.
+ */
+
+#define VL53L8CX_SEGMENT_NO_LABEL		((uint8_t)0xFFU)
+
+/**
+ * @brief Default segmentation: adjacent zones are the same obstacle when
+ * their distances differ by less than 100 mm plus 10% of the nearest one.
+ */
+
+#define VL53L8CX_SEGMENT_DEFAULT_MAX_STEP_MM	100U
+#define VL53L8CX_SEGMENT_DEFAULT_MAX_STEP_PERCENT	10U
+#define VL53L8CX_SEGMENT_DEFAULT_MIN_ZONES	1U
+
+/**
+ * @brief Structure VL53L8CX_SegmentConfig contains the segmentation settings.
+ */
+
+typedef struct
+{
+	/* Distance discontinuity between two obstacles: fixed part, in mm,
+	 * and part proportional to the nearest of both zones, in percent */
+	uint16_t		max_step_mm;
+	uint8_t			max_step_percent;
+	/* Obstacles with fewer zones are dropped */
+	uint8_t			min_zones;
+} VL53L8CX_SegmentConfig;
+
+/**
+ * @brief Structure VL53L8CX_Obstacle contains a group of adjacent zones (4
+ * neighbours) at continuous distances.
+ */
+
+typedef struct
+{
+	/* Bit z is set for zone z of the obstacle */
+	uint64_t		zones;
+	uint8_t			nb_zones;
+	/* Bounding box, in zones (zone = row * width + column) */
+	uint8_t			min_row;
+	uint8_t			max_row;
+	uint8_t			min_col;
+	uint8_t			max_col;
+	/* Distance of the nearest zone, and mean distance, in mm */
+	int16_t			min_distance_mm;
+	int16_t			mean_distance_mm;
+	/* Direction of the centroid of the zones, from the optical axis, in
+	 * degrees: azimuth towards the increasing columns, elevation towards
+	 * the decreasing rows */
+	float			azimuth_deg;
+	float			elevation_deg;
+} VL53L8CX_Obstacle;
+
+/**
+ * @brief Structure VL53L8CX_Segment groups the valid zones of a frame into
+ * obstacles. Zones are handled as 64-bit boards: the links between
+ * neighbours are computed once, then each obstacle is flood filled from its
+ * first zone with shifts and masks, several zones per step.
+ */
+
+typedef struct
+{
+	VL53L8CX_SegmentConfig	config;
+	/* Obstacles of the last frame, nearest first */
+	uint8_t			nb_obstacles;
+	VL53L8CX_Obstacle	obstacles[VL53L8CX_SEGMENT_MAX_OBSTACLES];
+	/* Index of the obstacle of each zone, or VL53L8CX_SEGMENT_NO_LABEL */
+	uint8_t			label[VL53L8CX_RESOLUTION_8X8];
+} VL53L8CX_Segment;
+
+/**
+ * @brief This function initializes a segmentation.
+ * @param (VL53L8CX_Segment) *p_seg : Segmentation structure.
+ * @param (VL53L8CX_SegmentConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_segment_init(
+		VL53L8CX_Segment		*p_seg,
+		const VL53L8CX_SegmentConfig	*p_config);
+
+/**
+ * @brief This function segments a frame. Zones are valid when their first
+ * target has a status of 5 or 9. The obstacles are given by p_seg.
+ * @param (VL53L8CX_Segment) *p_seg : Segmentation structure.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame to segment.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution is not valid.
+ */
+
+uint8_t vl53l8cx_segment_update(
+		VL53L8CX_Segment		*p_seg,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones);
+
+#endif /* VL53L8CX_SEGMENT_H_ */
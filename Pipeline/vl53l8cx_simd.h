@@ -0,0 +1,68 @@
+#ifndef VL53L8CX_SIMD_H_
+#define VL53L8CX_SIMD_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Vector types used by the per-zone kernels of the pipeline, with GCC
+ * vector extensions. 4 floats (128 bits) map to one SSE register on x86 and to
+ * one NEON register on ARM, so 16 and 64 zones are a whole number of vectors.
+ * Comparisons give a mask of 0 or -1 per lane.
+ */
+
+#define VL53L8CX_SIMD_LANES		4U
+
+typedef float vl53l8cx_v4f __attribute__((vector_size(16)));
+typedef int32_t vl53l8cx_v4i __attribute__((vector_size(16)));
+
+/* Same as vl53l8cx_v4f, for arrays which are not aligned on 16 bytes */
+typedef float vl53l8cx_v4f_u __attribute__((vector_size(16), aligned(4)));
+
+/**
+ * @brief Macro VL53L8CX_V4F accesses 4 floats of an array aligned on 16 bytes
+ * as a vector, and VL53L8CX_V4F_U 4 floats of any array.
+ */
+
+#define VL53L8CX_V4F(p)		(*(vl53l8cx_v4f *)(void *)(p))
+#define VL53L8CX_V4F_U(p)	(*(vl53l8cx_v4f_u *)(void *)(p))
+
+/**
+ * @brief This function selects the lanes of 'a' where the mask is set, and
+ * the lanes of 'b' elsewhere.
+ */
+
+static inline vl53l8cx_v4f vl53l8cx_simd_select(
+		vl53l8cx_v4i			mask,
+		vl53l8cx_v4f			a,
+		vl53l8cx_v4f			b)
+{
+	return (vl53l8cx_v4f)(((vl53l8cx_v4i)a & mask)
+		| ((vl53l8cx_v4i)b & ~mask));
+}
+
+static inline vl53l8cx_v4f vl53l8cx_simd_min(
+		vl53l8cx_v4f			a,
+		vl53l8cx_v4f			b)
+{
+	return vl53l8cx_simd_select(a < b, a, b);
+}
+
+/**
+ * @brief This function expands 4 bits of a mask, from bit 'first', into 1.0f
+ * for the bits set and 0.0f for the others.
+ */
+
+static inline vl53l8cx_v4f vl53l8cx_simd_mask_to_v4f(
+		uint64_t			mask,
+		uint32_t			first)
+{
+	const vl53l8cx_v4i bits = {1, 2, 4, 8};
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	vl53l8cx_v4i lanes = {0, 0, 0, 0};
+
+	lanes += (int32_t)((mask >> first) & 0xFU);
+
+	return vl53l8cx_simd_select((lanes & bits) != 0, one, one - one);
+}
+
+#endif /* VL53L8CX_SIMD_H_ */
@@ -0,0 +1,391 @@
+#include <string.h>
+#include <errno.h>
+
+#include "vl53l8cx_sync.h"
+#include "vl53l8cx_capture.h"
+
+/*
+ * Moves a pending super-frame into the ring, called with the lock held. When
+ * the ring is full the oldest super-frame is overwritten.
+ */
+static void _vl53l8cx_sync_publish(
+		VL53L8CX_Sync			*p_sync,
+		uint8_t				slot)
+{
+	VL53L8CX_SuperFrame *p_pending = &p_sync->pending[slot];
+
+	if ((p_sync->head - p_sync->tail) >= VL53L8CX_SYNC_RING_SIZE)
+	{
+		p_sync->tail++;
+		p_sync->stats.overruns++;
+	}
+	(void)memcpy(&p_sync->ring[p_sync->head % VL53L8CX_SYNC_RING_SIZE],
+			p_pending, sizeof(*p_pending));
+	p_sync->head++;
+
+	if (p_pending->sensor_mask == (uint8_t)((1U << p_sync->nb_sensors) - 1U))
+	{
+		p_sync->stats.superframes_complete++;
+	}
+	else
+	{
+		p_sync->stats.superframes_partial++;
+	}
+	p_sync->pending_used[slot] = 0;
+	(void)pthread_cond_broadcast(&p_sync->published);
+}
+
+/*
+ * Publishes, in epoch order, the pending super-frames older than 'epoch',
+ * called with the lock held.
+ */
+static void _vl53l8cx_sync_publish_before(
+		VL53L8CX_Sync			*p_sync,
+		uint32_t			epoch)
+{
+	uint32_t e, oldest = 0xFFFFFFFFU;
+	uint8_t slot;
+
+	do {
+		oldest = 0xFFFFFFFFU;
+		for (slot = 0; slot < VL53L8CX_SYNC_PENDING_SIZE; slot++)
+		{
+			e = p_sync->pending[slot].epoch;
+			if (p_sync->pending_used[slot] && (e < epoch)
+					&& (e < oldest))
+			{
+				oldest = e;
+			}
+		}
+		if (oldest != 0xFFFFFFFFU)
+		{
+			_vl53l8cx_sync_publish(p_sync,
+				(uint8_t)(oldest % VL53L8CX_SYNC_PENDING_SIZE));
+		}
+	} while (oldest != 0xFFFFFFFFU);
+
+	if (epoch > p_sync->published_epochs)
+	{
+		p_sync->published_epochs = epoch;
+	}
+}
+
+/*
+ * Controller thread. Pulse deadlines are absolute, so the pulse period does
+ * not drift. A super-frame is published as partial once the next pulse has
+ * been sent, so a sensor missing a pulse delays the others by one period at
+ * most. A pulse later than max_delay_ns would come before the sensors are
+ * ready for the next one: after such a wakeup, the pulses already due are
+ * skipped and the thread waits for the next deadline.
+ */
+static void *_vl53l8cx_sync_thread(void *arg)
+{
+	VL53L8CX_Sync *p_sync = (VL53L8CX_Sync *)arg;
+	struct timespec ts;
+	uint64_t next_ns, t_ns;
+	uint32_t epoch;
+
+	next_ns = vl53l8cx_capture_now_ns();
+	while (atomic_load_explicit(&p_sync->running, memory_order_acquire))
+	{
+		vl53l8cx_capture_to_timespec(next_ns, &ts);
+		(void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+		(void)pthread_mutex_lock(&p_sync->lock);
+		t_ns = vl53l8cx_capture_now_ns();
+		if (t_ns > (next_ns + p_sync->max_delay_ns))
+		{
+			while (next_ns <= t_ns)
+			{
+				next_ns += (uint64_t)p_sync->period_us * 1000U;
+				p_sync->stats.pulses_skipped++;
+			}
+			(void)pthread_mutex_unlock(&p_sync->lock);
+			continue;
+		}
+		epoch = p_sync->nb_epochs;
+		p_sync->t_triggers_ns[epoch % VL53L8CX_SYNC_PENDING_SIZE] = t_ns;
+		p_sync->nb_epochs++;
+		p_sync->stats.triggers++;
+		if (epoch >= 1U)
+		{
+			_vl53l8cx_sync_publish_before(p_sync, epoch - 1U);
+		}
+		(void)pthread_mutex_unlock(&p_sync->lock);
+
+		p_sync->pulse(p_sync->p_user);
+		next_ns += (uint64_t)p_sync->period_us * 1000U;
+	}
+
+	return NULL;
+}
+
+uint8_t vl53l8cx_sync_init(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SyncPulse		pulse,
+		void				*p_user,
+		uint32_t			period_us)
+{
+	pthread_condattr_t attr;
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	(void)memset(p_sync, 0, sizeof(*p_sync));
+	p_sync->pulse = pulse;
+	p_sync->p_user = p_user;
+	p_sync->period_us = period_us;
+	p_sync->max_delay_ns = (uint64_t)period_us * 500U;
+	atomic_init(&p_sync->running, 0);
+
+	/* Consumers wait on CLOCK_MONOTONIC deadlines */
+	if ((pthread_condattr_init(&attr) != 0)
+		|| (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0))
+	{
+		return VL53L8CX_STATUS_ERROR;
+	}
+	if ((pthread_mutex_init(&p_sync->lock, NULL) != 0)
+		|| (pthread_cond_init(&p_sync->published, &attr) != 0))
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+	(void)pthread_condattr_destroy(&attr);
+
+	return status;
+}
+
+uint8_t vl53l8cx_sync_add_sensor(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_sensor_id)
+{
+	if (p_sync->nb_sensors >= VL53L8CX_SYNC_MAX_SENSORS)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_sync->p_devs[p_sync->nb_sensors] = p_dev;
+	*p_sensor_id = p_sync->nb_sensors;
+	p_sync->nb_sensors++;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_sync_configure(
+		VL53L8CX_Sync			*p_sync)
+{
+	VL53L8CX_Configuration *p_dev;
+	uint8_t i, frequency_hz, status = VL53L8CX_STATUS_OK;
+	uint32_t integration_time_ms, frame_period_us, max_period_us = 0;
+
+	for (i = 0; i < p_sync->nb_sensors; i++)
+	{
+		p_dev = p_sync->p_devs[i];
+		status |= vl53l8cx_pool_begin(p_dev);
+		if (status != VL53L8CX_STATUS_OK)
+		{
+			break;
+		}
+		status |= vl53l8cx_set_ranging_mode(p_dev,
+				VL53L8CX_RANGING_MODE_AUTONOMOUS);
+		status |= vl53l8cx_set_external_sync_pin_enable(p_dev, 1);
+		status |= vl53l8cx_get_integration_time_ms(p_dev,
+				&integration_time_ms);
+		status |= vl53l8cx_get_ranging_frequency_hz(p_dev,
+				&frequency_hz);
+		vl53l8cx_pool_end(p_dev);
+		if (status != VL53L8CX_STATUS_OK)
+		{
+			break;
+		}
+
+		/* The sensor must be waiting for the pulse when it comes, even
+		 * when the pulse is late */
+		frame_period_us = (frequency_hz != 0U)
+			? (1000000U / (uint32_t)frequency_hz) : UINT32_MAX;
+		if (((integration_time_ms * 1000U) >= p_sync->period_us)
+			|| (p_sync->period_us < VL53L8CX_SYNC_MIN_DELAY_US)
+			|| (frame_period_us > (p_sync->period_us
+				- VL53L8CX_SYNC_MIN_DELAY_US)))
+		{
+			status |= VL53L8CX_STATUS_INVALID_PARAM;
+			break;
+		}
+		p_sync->min_latency_ns[i] = (uint64_t)integration_time_ms
+			* 1000000U;
+		if (frame_period_us > max_period_us)
+		{
+			max_period_us = frame_period_us;
+		}
+	}
+
+	/* A late pulse must leave a frame period before the next one */
+	if (status == VL53L8CX_STATUS_OK)
+	{
+		p_sync->max_delay_ns = (uint64_t)(p_sync->period_us
+			- max_period_us) * 1000U;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_sync_start(
+		VL53L8CX_Sync			*p_sync)
+{
+	if (p_sync->period_us == 0U)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	(void)pthread_mutex_lock(&p_sync->lock);
+	p_sync->nb_epochs = 0;
+	p_sync->published_epochs = 0;
+	p_sync->head = 0;
+	p_sync->tail = 0;
+	(void)memset(p_sync->pending_used, 0, sizeof(p_sync->pending_used));
+	(void)memset(&p_sync->stats, 0, sizeof(p_sync->stats));
+	(void)pthread_mutex_unlock(&p_sync->lock);
+
+	atomic_store_explicit(&p_sync->running, 1, memory_order_release);
+	if (pthread_create(&p_sync->thread, NULL, _vl53l8cx_sync_thread,
+			p_sync) != 0)
+	{
+		atomic_store_explicit(&p_sync->running, 0,
+				memory_order_release);
+		return VL53L8CX_STATUS_ERROR;
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_sync_stop(
+		VL53L8CX_Sync			*p_sync)
+{
+	if (atomic_exchange_explicit(&p_sync->running, 0,
+			memory_order_acq_rel) != 0)
+	{
+		(void)pthread_join(p_sync->thread, NULL);
+	}
+
+	(void)pthread_mutex_lock(&p_sync->lock);
+	_vl53l8cx_sync_publish_before(p_sync, p_sync->nb_epochs);
+	(void)pthread_mutex_unlock(&p_sync->lock);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_sync_push(
+		VL53L8CX_Sync			*p_sync,
+		uint8_t				sensor_id,
+		uint64_t			t_ready_ns,
+		uint8_t				frame_status,
+		const VL53L8CX_ResultsData	*p_results)
+{
+	VL53L8CX_SuperFrame *p_pending;
+	uint32_t k, epoch, nb_candidates;
+	uint8_t slot, is_matched = 0;
+
+	if (sensor_id >= p_sync->nb_sensors)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	if (t_ready_ns == 0U)
+	{
+		t_ready_ns = vl53l8cx_capture_now_ns();
+	}
+
+	(void)pthread_mutex_lock(&p_sync->lock);
+
+	/* Latest pulse sent at least one integration time before the frame */
+	epoch = 0;
+	nb_candidates = (p_sync->nb_epochs < VL53L8CX_SYNC_PENDING_SIZE)
+		? p_sync->nb_epochs : VL53L8CX_SYNC_PENDING_SIZE;
+	for (k = 0; k < nb_candidates; k++)
+	{
+		epoch = p_sync->nb_epochs - 1U - k;
+		if ((p_sync->t_triggers_ns[epoch % VL53L8CX_SYNC_PENDING_SIZE]
+				+ p_sync->min_latency_ns[sensor_id])
+				<= t_ready_ns)
+		{
+			is_matched = 1;
+			break;
+		}
+	}
+
+	if (!is_matched)
+	{
+		p_sync->stats.frames_unmatched++;
+	}
+	else if (epoch < p_sync->published_epochs)
+	{
+		p_sync->stats.frames_late++;
+	}
+	else
+	{
+		slot = (uint8_t)(epoch % VL53L8CX_SYNC_PENDING_SIZE);
+		p_pending = &p_sync->pending[slot];
+		if (!p_sync->pending_used[slot])
+		{
+			p_pending->epoch = epoch;
+			p_pending->t_trigger_ns = p_sync->t_triggers_ns[slot];
+			p_pending->sensor_mask = 0;
+			p_pending->nb_sensors = p_sync->nb_sensors;
+			p_sync->pending_used[slot] = 1;
+		}
+		(void)memcpy(&p_pending->results[sensor_id], p_results,
+				sizeof(*p_results));
+		p_pending->status[sensor_id] = frame_status;
+		p_pending->sensor_mask |= (uint8_t)(1U << sensor_id);
+
+		/* Complete: publish it, with the older ones first */
+		if (p_pending->sensor_mask
+			== (uint8_t)((1U << p_sync->nb_sensors) - 1U))
+		{
+			_vl53l8cx_sync_publish_before(p_sync, epoch);
+			_vl53l8cx_sync_publish(p_sync, slot);
+			p_sync->published_epochs = epoch + 1U;
+		}
+	}
+
+	(void)pthread_mutex_unlock(&p_sync->lock);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_sync_pop(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SuperFrame		*p_frame,
+		uint32_t			timeout_ms)
+{
+	struct timespec ts;
+	uint8_t is_ready = 0;
+	int ret = 0;
+
+	vl53l8cx_capture_to_timespec(vl53l8cx_capture_now_ns()
+			+ ((uint64_t)timeout_ms * 1000000U), &ts);
+
+	(void)pthread_mutex_lock(&p_sync->lock);
+	while ((p_sync->head == p_sync->tail) && (ret != ETIMEDOUT))
+	{
+		ret = pthread_cond_timedwait(&p_sync->published, &p_sync->lock,
+				&ts);
+	}
+	if (p_sync->head != p_sync->tail)
+	{
+		(void)memcpy(p_frame,
+			&p_sync->ring[p_sync->tail % VL53L8CX_SYNC_RING_SIZE],
+			sizeof(*p_frame));
+		p_sync->tail++;
+		is_ready = 1;
+	}
+	(void)pthread_mutex_unlock(&p_sync->lock);
+
+	return is_ready;
+}
+
+void vl53l8cx_sync_get_stats(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SyncStats		*p_stats)
+{
+	(void)pthread_mutex_lock(&p_sync->lock);
+	*p_stats = p_sync->stats;
+	(void)pthread_mutex_unlock(&p_sync->lock);
+}
@@ -0,0 +1,238 @@
+#ifndef VL53L8CX_SYNC_H_
+#define VL53L8CX_SYNC_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pool.h"
+
+/**
+ * @brief Maximum number of sensors triggered by a sync controller.
+ */
+
+#define VL53L8CX_SYNC_MAX_SENSORS		8U
+
+/**
+ * @brief Number of super-frames being filled, and number of complete
+ * super-frames waiting for the consumer. All of them are preallocated into
+ * the VL53L8CX_Sync structure.
+ */
+
+#define VL53L8CX_SYNC_PENDING_SIZE		4U
+#define VL53L8CX_SYNC_RING_SIZE			4U
+
+/**
+ * @brief Shortest slack between the pulse period and the ranging period of the
+ * sensors, in us. It is also the latest time a pulse can be sent after its
+ * deadline, so the thread sending the pulses must wake up within it.
+ */
+
+#ifndef VL53L8CX_SYNC_MIN_DELAY_US
+#define VL53L8CX_SYNC_MIN_DELAY_US		1000U
+#endif
+
+/**
+ * @brief Callback pulsing the GPIO wired to the SYNC pins of all sensors. It
+ * is called from the controller thread and must return quickly.
+ */
+
+typedef void (*VL53L8CX_SyncPulse)(
+		void				*p_user);
+
+/**
+ * @brief Structure VL53L8CX_SuperFrame contains the frames of all sensors
+ * triggered by the same sync pulse.
+ */
+
+typedef struct
+{
+	/* Number of the sync pulse, starting from 0 */
+	uint32_t		epoch;
+	/* CLOCK_MONOTONIC time of the sync pulse, common to all frames, in ns */
+	uint64_t		t_trigger_ns;
+	/* Bit i is set when results[i] is valid. A partial super-frame is
+	 * published when a sensor missed the pulse */
+	uint8_t			sensor_mask;
+	uint8_t			nb_sensors;
+	/* Status of the read of each frame */
+	uint8_t			status[VL53L8CX_SYNC_MAX_SENSORS];
+	VL53L8CX_ResultsData	results[VL53L8CX_SYNC_MAX_SENSORS];
+} VL53L8CX_SuperFrame;
+
+/**
+ * @brief Structure VL53L8CX_SyncStats contains the sync controller counters.
+ */
+
+typedef struct
+{
+	/* Sync pulses sent, and skipped because the controller thread woke up
+	 * too late */
+	uint32_t		triggers;
+	uint32_t		pulses_skipped;
+	/* Super-frames published with all sensors, or with some missing */
+	uint32_t		superframes_complete;
+	uint32_t		superframes_partial;
+	/* Super-frames lost because the consumer was too slow */
+	uint32_t		overruns;
+	/* Frames received after their super-frame was published, or which
+	 * match no pulse */
+	uint32_t		frames_late;
+	uint32_t		frames_unmatched;
+} VL53L8CX_SyncStats;
+
+/**
+ * @brief Structure VL53L8CX_Sync is the sync controller. Sensors run in
+ * autonomous mode with the external sync pin enabled, so they all start a
+ * frame on the same pulse. Each frame is matched to the latest pulse sent at
+ * least one integration time before the frame was ready, and stored into the
+ * super-frame of that pulse. The pulse period must be longer than the
+ * integration time plus the frame read time, so a frame is always read before
+ * the next pulse starts a new one, and at least VL53L8CX_SYNC_MIN_DELAY_US
+ * longer than the ranging period of the sensors.
+ */
+
+typedef struct
+{
+	VL53L8CX_Configuration	*p_devs[VL53L8CX_SYNC_MAX_SENSORS];
+	uint8_t			nb_sensors;
+	/* Shortest delay between a pulse and a frame, in ns */
+	uint64_t		min_latency_ns[VL53L8CX_SYNC_MAX_SENSORS];
+	uint32_t		period_us;
+	/* Latest time a pulse is sent after its deadline, in ns. Later pulses
+	 * are skipped */
+	uint64_t		max_delay_ns;
+	VL53L8CX_SyncPulse	pulse;
+	void			*p_user;
+	pthread_t		thread;
+	atomic_int		running;
+	pthread_mutex_t		lock;
+	pthread_cond_t		published;
+	/* Times of the last pulses, indexed by epoch % VL53L8CX_SYNC_PENDING_SIZE */
+	uint64_t		t_triggers_ns[VL53L8CX_SYNC_PENDING_SIZE];
+	/* Number of pulses sent */
+	uint32_t		nb_epochs;
+	/* Super-frames of older epochs are published, their frames are late */
+	uint32_t		published_epochs;
+	/* Super-frames being filled */
+	VL53L8CX_SuperFrame	pending[VL53L8CX_SYNC_PENDING_SIZE];
+	uint8_t			pending_used[VL53L8CX_SYNC_PENDING_SIZE];
+	/* Complete super-frames, from ring[tail] to ring[head - 1] */
+	VL53L8CX_SuperFrame	ring[VL53L8CX_SYNC_RING_SIZE];
+	uint32_t		head;
+	uint32_t		tail;
+	VL53L8CX_SyncStats	stats;
+} VL53L8CX_Sync;
+
+/**
+ * @brief This function initializes a sync controller without sensor.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @param (VL53L8CX_SyncPulse) pulse : Callback pulsing the sync GPIO.
+ * @param (void) *p_user : Argument given to the callback.
+ * @param (uint32_t) period_us : Period of the sync pulses. A pulse later than
+ * half a period is skipped, until vl53l8cx_sync_configure() sets this delay
+ * from the ranging period of the sensors.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_sync_init(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SyncPulse		pulse,
+		void				*p_user,
+		uint32_t			period_us);
+
+/**
+ * @brief This function adds a sensor. Its id is the index of its frame into
+ * the super-frames.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Initialized sensor, not ranging.
+ * @param (uint8_t) *p_sensor_id : Id of the sensor.
+ * @return (uint8_t) status : 0 if OK, or 127 if the controller is full.
+ */
+
+uint8_t vl53l8cx_sync_add_sensor(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_sensor_id);
+
+/**
+ * @brief This function configures the sensors for synchronized ranging
+ * (autonomous mode, external sync pin enabled) and reads their integration
+ * time. A late pulse is then sent only if the sensors can still range before
+ * the next one.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @return (uint8_t) status : 0 if OK, or 127 if the pulse period is not
+ * longer than the integration time, or than the ranging period of a sensor
+ * plus VL53L8CX_SYNC_MIN_DELAY_US.
+ */
+
+uint8_t vl53l8cx_sync_configure(
+		VL53L8CX_Sync			*p_sync);
+
+/**
+ * @brief This function starts the thread sending the sync pulses. Sensors
+ * must be ranging, and their frames must be given to vl53l8cx_sync_push().
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @return (uint8_t) status : 0 if OK, or 127 if the pulse period is 0.
+ */
+
+uint8_t vl53l8cx_sync_start(
+		VL53L8CX_Sync			*p_sync);
+
+/**
+ * @brief This function stops the sync pulses. Super-frames being filled are
+ * published.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_sync_stop(
+		VL53L8CX_Sync			*p_sync);
+
+/**
+ * @brief This function stores a frame into the super-frame of its pulse. It
+ * can be called from several threads, for instance from the frame callback of
+ * a VL53L8CX_Manager.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @param (uint8_t) sensor_id : Id of the sensor.
+ * @param (uint64_t) t_ready_ns : CLOCK_MONOTONIC time when the frame was
+ * found ready, or 0 to use the current time.
+ * @param (uint8_t) frame_status : Status of the frame read.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame results, copied.
+ * @return (uint8_t) status : 0 if OK, or 127 if the id is not valid.
+ */
+
+uint8_t vl53l8cx_sync_push(
+		VL53L8CX_Sync			*p_sync,
+		uint8_t				sensor_id,
+		uint64_t			t_ready_ns,
+		uint8_t				frame_status,
+		const VL53L8CX_ResultsData	*p_results);
+
+/**
+ * @brief This function copies the oldest published super-frame, waiting for
+ * it if needed.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @param (VL53L8CX_SuperFrame) *p_frame : Copied super-frame.
+ * @param (uint32_t) timeout_ms : Maximum time to wait.
+ * @return (uint8_t) is_ready : 1 if a super-frame was copied, 0 on timeout.
+ */
+
+uint8_t vl53l8cx_sync_pop(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SuperFrame		*p_frame,
+		uint32_t			timeout_ms);
+
+/**
+ * @brief This function reads the sync controller counters.
+ * @param (VL53L8CX_Sync) *p_sync : Sync controller structure.
+ * @param (VL53L8CX_SyncStats) *p_stats : Counters values.
+ */
+
+void vl53l8cx_sync_get_stats(
+		VL53L8CX_Sync			*p_sync,
+		VL53L8CX_SyncStats		*p_stats);
+
+#endif /* VL53L8CX_SYNC_H_ */
@@ -0,0 +1,232 @@
+#include <string.h>
+
+#include "vl53l8cx_targets.h"
+#include "vl53l8cx_pipeline.h"
+#include "vl53l8cx_simd.h"
+
+#define _VL53L8CX_TARGETS_N		VL53L8CX_NB_TARGET_PER_ZONE
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+/*
+ * Associates the targets of 4 zones with their slots, and updates the
+ * slots. Pairs are assigned the closest first: a pair is closest among the
+ * pairs left when its target is the nearest of its slot and its slot the
+ * nearest of its target. All such pairs are assigned at once, and the search
+ * is repeated while a slot lost its nearest target to another slot, which is
+ * seldom as the targets of a zone are far apart. Among equal differences, the
+ * nearest target of a slot is its first one, and the nearest slot of a target
+ * its first one, so ties are broken like a closest-first loop over the slots
+ * then the targets.
+ */
+static void _vl53l8cx_targets_associate(
+		VL53L8CX_Targets		*p_tgt,
+		uint32_t			i)
+{
+	const vl53l8cx_v4f one = {1.0f, 1.0f, 1.0f, 1.0f};
+	const vl53l8cx_v4f zero = {0.0f, 0.0f, 0.0f, 0.0f};
+	const vl53l8cx_v4f half = {0.5f, 0.5f, 0.5f, 0.5f};
+	const vl53l8cx_v4i no = {0, 0, 0, 0};
+	vl53l8cx_v4f z[_VL53L8CX_TARGETS_N], e[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4f cost[_VL53L8CX_TARGETS_N][_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4f slot_min[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4f target_min[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4f taken[_VL53L8CX_TARGETS_N], c, age;
+	vl53l8cx_v4f gate = zero + p_tgt->config.gate_mm;
+	vl53l8cx_v4i tracked[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4i slot_done[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4i target_done[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4i started[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4i target_seen[_VL53L8CX_TARGETS_N];
+	vl53l8cx_v4i matched, in_gate, first, nearest, pick, any;
+	float hold = (float)p_tgt->config.hold_frames;
+	uint32_t s, m, pass;
+
+	for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+	{
+		z[s] = VL53L8CX_V4F(&p_tgt->measure_mm[s][i]);
+		target_done[s] = VL53L8CX_V4F(&p_tgt->is_valid[s][i]) <= half;
+		e[s] = VL53L8CX_V4F(&p_tgt->estimate_mm[s][i]);
+		tracked[s] = VL53L8CX_V4F(&p_tgt->is_tracked[s][i]) > half;
+		slot_done[s] = ~tracked[s];
+		taken[s] = zero;
+	}
+	for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+	{
+		for (m = 0; m < _VL53L8CX_TARGETS_N; m++)
+		{
+			/* Absolute difference: clear the sign bit */
+			cost[s][m] = (vl53l8cx_v4f)((vl53l8cx_v4i)(z[m] - e[s])
+				& INT32_MAX);
+		}
+	}
+
+	for (pass = 0; pass < _VL53L8CX_TARGETS_N; pass++)
+	{
+		/* Pairs done are NaN, which is never below a minimum */
+		for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+		{
+			slot_min[s] = gate;
+			target_min[s] = gate;
+		}
+		for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+		{
+			for (m = 0; m < _VL53L8CX_TARGETS_N; m++)
+			{
+				c = (vl53l8cx_v4f)((vl53l8cx_v4i)cost[s][m]
+					| slot_done[s] | target_done[m]);
+				cost[s][m] = c;
+				slot_min[s] = vl53l8cx_simd_select(
+					c < slot_min[s], c, slot_min[s]);
+				target_min[m] = vl53l8cx_simd_select(
+					c < target_min[m], c, target_min[m]);
+			}
+		}
+		any = no;
+		for (m = 0; m < _VL53L8CX_TARGETS_N; m++)
+		{
+			target_seen[m] = no;
+		}
+		for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+		{
+			in_gate = ~slot_done[s] & (slot_min[s] < gate);
+			first = in_gate;
+			for (m = 0; m < _VL53L8CX_TARGETS_N; m++)
+			{
+				/* Ties go to the first target of the slot and
+				 * to the first slot of the target */
+				nearest = first & (cost[s][m] == slot_min[s]);
+				first &= ~nearest;
+				pick = nearest & ~target_seen[m]
+					& (cost[s][m] == target_min[m]);
+				target_seen[m] |= cost[s][m] == target_min[m];
+				in_gate &= ~pick;
+				slot_done[s] |= pick;
+				target_done[m] |= pick;
+				taken[s] = vl53l8cx_simd_select(pick, z[m],
+					taken[s]);
+			}
+			/* The nearest target went to another slot */
+			any |= in_gate;
+		}
+		if ((any[0] | any[1] | any[2] | any[3]) == 0)
+		{
+			break;
+		}
+	}
+
+	/* Targets left start in the first free slots */
+	for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+	{
+		started[s] = no;
+		for (m = 0; m < _VL53L8CX_TARGETS_N; m++)
+		{
+			pick = ~tracked[s] & ~started[s] & ~target_done[m];
+			taken[s] = vl53l8cx_simd_select(pick, z[m], taken[s]);
+			started[s] |= pick;
+			target_done[m] |= pick;
+		}
+	}
+
+	for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+	{
+		matched = tracked[s] & slot_done[s];
+		e[s] = vl53l8cx_simd_select(matched,
+			e[s] + (p_tgt->config.alpha * (taken[s] - e[s])), e[s]);
+		e[s] = vl53l8cx_simd_select(started[s], taken[s], e[s]);
+		age = vl53l8cx_simd_select(matched | started[s], zero,
+			VL53L8CX_V4F(&p_tgt->age[s][i]) + one);
+		tracked[s] = (tracked[s] | started[s]) & (age <= hold);
+		VL53L8CX_V4F(&p_tgt->estimate_mm[s][i]) = e[s];
+		VL53L8CX_V4F(&p_tgt->age[s][i]) = age;
+		VL53L8CX_V4F(&p_tgt->is_tracked[s][i]) =
+			vl53l8cx_simd_select(tracked[s], one, zero);
+	}
+}
+#endif
+
+void vl53l8cx_targets_init(
+		VL53L8CX_Targets		*p_tgt,
+		const VL53L8CX_TargetsConfig	*p_config)
+{
+	(void)memset(p_tgt, 0, sizeof(*p_tgt));
+	if (p_config != NULL)
+	{
+		p_tgt->config = *p_config;
+	}
+	else
+	{
+		p_tgt->config.alpha = VL53L8CX_TARGETS_DEFAULT_ALPHA;
+		p_tgt->config.gate_mm = VL53L8CX_TARGETS_DEFAULT_GATE_MM;
+		p_tgt->config.hold_frames = VL53L8CX_TARGETS_DEFAULT_HOLD_FRAMES;
+	}
+}
+
+void vl53l8cx_targets_reset(
+		VL53L8CX_Targets		*p_tgt)
+{
+	(void)memset(p_tgt->is_tracked, 0, sizeof(p_tgt->is_tracked));
+	(void)memset(p_tgt->age, 0, sizeof(p_tgt->age));
+	(void)memset(p_tgt->distance_mm, 0, sizeof(p_tgt->distance_mm));
+	(void)memset(p_tgt->tracked_mask, 0, sizeof(p_tgt->tracked_mask));
+}
+
+uint8_t vl53l8cx_targets_update(
+		VL53L8CX_Targets		*p_tgt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	uint32_t zone, s, idx;
+	uint8_t is_valid;
+
+	if ((nb_zones != VL53L8CX_RESOLUTION_4X4)
+		&& (nb_zones != VL53L8CX_RESOLUTION_8X8))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	if (nb_zones != p_tgt->nb_zones)
+	{
+		vl53l8cx_targets_reset(p_tgt);
+		p_tgt->nb_zones = nb_zones;
+	}
+
+	/* Gather the targets, one array per rank in the results */
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+		{
+			idx = (zone * _VL53L8CX_TARGETS_N) + s;
+			p_tgt->measure_mm[s][zone] =
+				(float)p_results->distance_mm[idx];
+			is_valid = vl53l8cx_target_is_valid(p_results, zone, s);
+			p_tgt->is_valid[s][zone] = is_valid ? 1.0f : 0.0f;
+		}
+	}
+
+	for (zone = 0; zone < nb_zones; zone += VL53L8CX_SIMD_LANES)
+	{
+		_vl53l8cx_targets_associate(p_tgt, zone);
+	}
+
+	for (s = 0; s < _VL53L8CX_TARGETS_N; s++)
+	{
+		p_tgt->tracked_mask[s] = 0;
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			is_valid = (uint8_t)(p_tgt->is_tracked[s][zone] > 0.5f);
+			p_tgt->tracked_mask[s] |= (uint64_t)is_valid << zone;
+			p_tgt->distance_mm[(zone * _VL53L8CX_TARGETS_N) + s] =
+				is_valid ? (int16_t)(p_tgt->estimate_mm[s][zone]
+					+ 0.5f) : (int16_t)0;
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+#else
+	(void)p_tgt;
+	(void)p_results;
+	(void)nb_zones;
+
+	return VL53L8CX_STATUS_INVALID_PARAM;
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef VL53L8CX_TARGETS_H_
+#define VL53L8CX_TARGETS_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_api.h"
+
+/**
+ * @brief Default association: a target matches a slot when it is within
+ * 150 mm of its estimate, which then moves by half of the difference. A slot
+ * is held for 5 frames without target.
+ */
+
+#define VL53L8CX_TARGETS_DEFAULT_ALPHA		0.5f
+#define VL53L8CX_TARGETS_DEFAULT_GATE_MM	150.0f
+#define VL53L8CX_TARGETS_DEFAULT_HOLD_FRAMES	5U
+
+/**
+ * @brief Structure VL53L8CX_TargetsConfig contains the association settings.
+ */
+
+typedef struct
+{
+	/* Gain of the estimates (EMA), from 0 to 1 */
+	float			alpha;
+	/* Maximum difference between a target and the estimate of its slot,
+	 * in mm */
+	float			gate_mm;
+	/* Frames a slot is held without target before it is freed */
+	uint32_t		hold_frames;
+} VL53L8CX_TargetsConfig;
+
+/**
+ * @brief Structure VL53L8CX_Targets keeps the targets of each zone in stable
+ * slots across frames, whatever their order in the results (see
+ * vl53l8cx_set_target_order()): a glass pane and the wall behind it stay in
+ * their slots when their signals swap. In each zone, the pairs of a tracked
+ * slot and a valid target within the gate are assigned, the closest first;
+ * targets left take the first free slots. Zones are processed 4 at a time with
+ * SIMD instructions, with one array per slot and per variable. Nothing is
+ * allocated.
+ */
+
+typedef struct
+{
+	VL53L8CX_TargetsConfig	config;
+	/* Resolution of the last frame, the slots are freed when it changes */
+	uint8_t			nb_zones;
+	/* Slots: estimate in mm, 1.0 when tracked, and frames since the last
+	 * target */
+	_Alignas(16) float	estimate_mm[VL53L8CX_NB_TARGET_PER_ZONE]
+					[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	is_tracked[VL53L8CX_NB_TARGET_PER_ZONE]
+					[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	age[VL53L8CX_NB_TARGET_PER_ZONE]
+					[VL53L8CX_RESOLUTION_8X8];
+	/* Targets of the last frame, in the order of the results */
+	_Alignas(16) float	measure_mm[VL53L8CX_NB_TARGET_PER_ZONE]
+					[VL53L8CX_RESOLUTION_8X8];
+	_Alignas(16) float	is_valid[VL53L8CX_NB_TARGET_PER_ZONE]
+					[VL53L8CX_RESOLUTION_8X8];
+	/* Smoothed distance of slot s of zone z at [z * NB_TARGET_PER_ZONE +
+	 * s], like the results, or 0 when the slot is free */
+	int16_t			distance_mm[VL53L8CX_RESOLUTION_8X8
+					* VL53L8CX_NB_TARGET_PER_ZONE];
+	/* Bit z of tracked_mask[s] is set when slot s of zone z is tracked */
+	uint64_t		tracked_mask[VL53L8CX_NB_TARGET_PER_ZONE];
+} VL53L8CX_Targets;
+
+/**
+ * @brief This function initializes a targets association.
+ * @param (VL53L8CX_Targets) *p_tgt : Targets structure.
+ * @param (VL53L8CX_TargetsConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_targets_init(
+		VL53L8CX_Targets		*p_tgt,
+		const VL53L8CX_TargetsConfig	*p_config);
+
+/**
+ * @brief This function frees all slots.
+ * @param (VL53L8CX_Targets) *p_tgt : Targets structure.
+ */
+
+void vl53l8cx_targets_reset(
+		VL53L8CX_Targets		*p_tgt);
+
+/**
+ * @brief This function associates the targets of a frame with the slots of
+ * their zones. The result is given by p_tgt->distance_mm and
+ * p_tgt->tracked_mask. The distance and the target status must be read for
+ * each frame (see vl53l8cx_set_partial_read()).
+ * @param (VL53L8CX_Targets) *p_tgt : Targets structure.
+ * @param (VL53L8CX_ResultsData) *p_results : Frame to associate.
+ * @param (uint8_t) nb_zones : Resolution of the frame, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if the
+ * resolution is not valid.
+ */
+
+uint8_t vl53l8cx_targets_update(
+		VL53L8CX_Targets		*p_tgt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones);
+
+#endif /* VL53L8CX_TARGETS_H_ */
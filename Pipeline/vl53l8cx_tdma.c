@@ -0,0 +1,358 @@
+#include <string.h>
+
+#include "vl53l8cx_tdma.h"
+#include "vl53l8cx_capture.h"
+
+/* Maximum ranging frequencies of the sensor, in Hz */
+#define TDMA_MAX_FREQUENCY_4X4_HZ	60U
+#define TDMA_MAX_FREQUENCY_8X8_HZ	15U
+
+/*
+ * Scheduler thread. Slot deadlines are absolute, so the time spent into the
+ * trigger callbacks does not shift the following slots. A sync edge later than
+ * the guard time would make the emission overlap the next slot: after such a
+ * wakeup, the slots already started are skipped and the thread waits for the
+ * next slot boundary.
+ */
+static void *_vl53l8cx_tdma_thread(void *arg)
+{
+	VL53L8CX_Tdma *p_tdma = (VL53L8CX_Tdma *)arg;
+	struct timespec ts;
+	uint64_t slot_ns, now_ns, guard_ns;
+	uint8_t slot = 0, i, is_late;
+
+	guard_ns = (uint64_t)p_tdma->guard_us * 1000U;
+	slot_ns = vl53l8cx_capture_now_ns();
+	while (atomic_load_explicit(&p_tdma->running, memory_order_acquire))
+	{
+		vl53l8cx_capture_to_timespec(slot_ns, &ts);
+		(void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+				NULL);
+
+		now_ns = vl53l8cx_capture_now_ns();
+		is_late = (uint8_t)(now_ns > (slot_ns + guard_ns));
+		while (is_late && (slot_ns <= now_ns))
+		{
+			slot_ns += (uint64_t)p_tdma->slot_us[slot] * 1000U;
+			slot = (uint8_t)((slot + 1U) % p_tdma->nb_slots);
+			atomic_fetch_add_explicit(&p_tdma->skipped_slots, 1,
+					memory_order_relaxed);
+		}
+		if (is_late)
+		{
+			continue;
+		}
+
+		for (i = 0; i < p_tdma->nb_sensors; i++)
+		{
+			if ((p_tdma->slot_members[slot] & (1U << i)) == 0U)
+			{
+				continue;
+			}
+			p_tdma->trigger(p_tdma->p_user, i);
+			atomic_fetch_add_explicit(&p_tdma->triggers[i], 1,
+					memory_order_relaxed);
+		}
+		slot_ns += (uint64_t)p_tdma->slot_us[slot] * 1000U;
+		slot = (uint8_t)((slot + 1U) % p_tdma->nb_slots);
+	}
+
+	return NULL;
+}
+
+/* Starts or stops the ranging of a sensor, with a temporary buffer */
+static uint8_t _vl53l8cx_tdma_set_ranging(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				is_ranging)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= vl53l8cx_pool_begin(p_dev);
+	if (status == VL53L8CX_STATUS_OK)
+	{
+		status |= is_ranging ? vl53l8cx_start_ranging(p_dev)
+			: vl53l8cx_stop_ranging(p_dev);
+	}
+	vl53l8cx_pool_end(p_dev);
+
+	return status;
+}
+
+void vl53l8cx_tdma_init(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_TdmaTrigger		trigger,
+		void				*p_user,
+		uint32_t			guard_us)
+{
+	uint8_t i;
+
+	(void)memset(p_tdma, 0, sizeof(*p_tdma));
+	p_tdma->trigger = trigger;
+	p_tdma->p_user = p_user;
+	p_tdma->guard_us = (guard_us != 0U) ? guard_us : VL53L8CX_TDMA_GUARD_US;
+	atomic_init(&p_tdma->running, 0);
+	atomic_init(&p_tdma->skipped_slots, 0U);
+	for (i = 0; i < VL53L8CX_TDMA_MAX_SENSORS; i++)
+	{
+		atomic_init(&p_tdma->triggers[i], 0U);
+		atomic_init(&p_tdma->frames[i], 0U);
+	}
+}
+
+uint8_t vl53l8cx_tdma_add_sensor(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_sensor_id)
+{
+	if (p_tdma->nb_sensors >= VL53L8CX_TDMA_MAX_SENSORS)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_tdma->p_devs[p_tdma->nb_sensors] = p_dev;
+	*p_sensor_id = p_tdma->nb_sensors;
+	p_tdma->nb_sensors++;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_tdma_set_overlap(
+		VL53L8CX_Tdma			*p_tdma,
+		uint8_t				sensor_a,
+		uint8_t				sensor_b)
+{
+	if ((sensor_a >= p_tdma->nb_sensors) || (sensor_b >= p_tdma->nb_sensors)
+		|| (sensor_a == sensor_b))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	p_tdma->overlap[sensor_a] |= (uint8_t)(1U << sensor_b);
+	p_tdma->overlap[sensor_b] |= (uint8_t)(1U << sensor_a);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+void vl53l8cx_tdma_plan(
+		VL53L8CX_Tdma			*p_tdma)
+{
+	uint8_t order[VL53L8CX_TDMA_MAX_SENSORS];
+	uint8_t i, j, id, slot;
+	uint32_t min_cycle_us = 0;
+
+	/* Longest emissions first (insertion sort, at most 8 sensors) */
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		for (j = i; (j > 0U) && (p_tdma->emission_us[order[j - 1U]]
+				< p_tdma->emission_us[i]); j--)
+		{
+			order[j] = order[j - 1U];
+		}
+		order[j] = i;
+	}
+
+	/* First slot without overlap. The first sensor of a slot has its
+	 * longest emission, so it gives the slot duration */
+	p_tdma->nb_slots = 0;
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		id = order[i];
+		for (slot = 0; slot < p_tdma->nb_slots; slot++)
+		{
+			if ((p_tdma->slot_members[slot] & p_tdma->overlap[id])
+					== 0U)
+			{
+				break;
+			}
+		}
+		if (slot == p_tdma->nb_slots)
+		{
+			p_tdma->slot_members[slot] = 0;
+			p_tdma->slot_us[slot] = p_tdma->emission_us[id]
+				+ p_tdma->guard_us;
+			p_tdma->nb_slots++;
+		}
+		p_tdma->slot_members[slot] |= (uint8_t)(1U << id);
+		p_tdma->slot_of[id] = slot;
+		if (p_tdma->min_period_us[id] > min_cycle_us)
+		{
+			min_cycle_us = p_tdma->min_period_us[id];
+		}
+	}
+
+	p_tdma->cycle_us = 0;
+	for (slot = 0; slot < p_tdma->nb_slots; slot++)
+	{
+		p_tdma->cycle_us += p_tdma->slot_us[slot];
+	}
+
+	/* A sensor cannot range faster than its maximum frequency */
+	if ((p_tdma->nb_slots != 0U) && (p_tdma->cycle_us < min_cycle_us))
+	{
+		p_tdma->slot_us[p_tdma->nb_slots - 1U] +=
+			min_cycle_us - p_tdma->cycle_us;
+		p_tdma->cycle_us = min_cycle_us;
+	}
+}
+
+uint8_t vl53l8cx_tdma_configure(
+		VL53L8CX_Tdma			*p_tdma)
+{
+	VL53L8CX_Configuration *p_dev;
+	uint8_t i, resolution, frequency_hz, status = VL53L8CX_STATUS_OK;
+	uint32_t integration_time_ms;
+
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		p_dev = p_tdma->p_devs[i];
+		status |= vl53l8cx_pool_begin(p_dev);
+		if (status != VL53L8CX_STATUS_OK)
+		{
+			break;
+		}
+		status |= vl53l8cx_get_resolution(p_dev, &resolution);
+		frequency_hz = (resolution == VL53L8CX_RESOLUTION_8X8)
+			? (uint8_t)TDMA_MAX_FREQUENCY_8X8_HZ
+			: (uint8_t)TDMA_MAX_FREQUENCY_4X4_HZ;
+
+		/* In continuous mode the sensor emits during the whole period,
+		 * only the autonomous mode can be time-multiplexed */
+		status |= vl53l8cx_set_ranging_mode(p_dev,
+				VL53L8CX_RANGING_MODE_AUTONOMOUS);
+		status |= vl53l8cx_set_ranging_frequency_hz(p_dev,
+				frequency_hz);
+		status |= vl53l8cx_set_external_sync_pin_enable(p_dev, 1);
+		status |= vl53l8cx_get_integration_time_ms(p_dev,
+				&integration_time_ms);
+		vl53l8cx_pool_end(p_dev);
+
+		p_tdma->emission_us[i] = integration_time_ms * 1000U;
+		p_tdma->min_period_us[i] = 1000000U / (uint32_t)frequency_hz;
+	}
+
+	vl53l8cx_tdma_plan(p_tdma);
+
+	return status;
+}
+
+uint8_t vl53l8cx_tdma_start(
+		VL53L8CX_Tdma			*p_tdma)
+{
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	/* Nothing to schedule */
+	if (p_tdma->nb_slots == 0U)
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+	atomic_store_explicit(&p_tdma->skipped_slots, 0U, memory_order_relaxed);
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		atomic_store_explicit(&p_tdma->triggers[i], 0U,
+				memory_order_relaxed);
+		atomic_store_explicit(&p_tdma->frames[i], 0U,
+				memory_order_relaxed);
+		status |= _vl53l8cx_tdma_set_ranging(p_tdma->p_devs[i], 1);
+	}
+	if (status != VL53L8CX_STATUS_OK)
+	{
+		for (i = 0; i < p_tdma->nb_sensors; i++)
+		{
+			(void)_vl53l8cx_tdma_set_ranging(p_tdma->p_devs[i], 0);
+		}
+		return status;
+	}
+
+	p_tdma->start_ns = vl53l8cx_capture_now_ns();
+	atomic_store_explicit(&p_tdma->running, 1, memory_order_release);
+	if (pthread_create(&p_tdma->thread, NULL, _vl53l8cx_tdma_thread,
+			p_tdma) != 0)
+	{
+		atomic_store_explicit(&p_tdma->running, 0,
+				memory_order_release);
+		for (i = 0; i < p_tdma->nb_sensors; i++)
+		{
+			(void)_vl53l8cx_tdma_set_ranging(p_tdma->p_devs[i], 0);
+		}
+		status |= VL53L8CX_STATUS_ERROR;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_tdma_stop(
+		VL53L8CX_Tdma			*p_tdma)
+{
+	uint8_t i, status = VL53L8CX_STATUS_OK;
+
+	if (atomic_exchange_explicit(&p_tdma->running, 0,
+			memory_order_acq_rel) != 0)
+	{
+		(void)pthread_join(p_tdma->thread, NULL);
+		p_tdma->stop_ns = vl53l8cx_capture_now_ns();
+	}
+
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		status |= _vl53l8cx_tdma_set_ranging(p_tdma->p_devs[i], 0);
+	}
+
+	return status;
+}
+
+void vl53l8cx_tdma_frame_received(
+		VL53L8CX_Tdma			*p_tdma,
+		uint8_t				sensor_id)
+{
+	if (sensor_id < p_tdma->nb_sensors)
+	{
+		atomic_fetch_add_explicit(&p_tdma->frames[sensor_id], 1,
+				memory_order_relaxed);
+	}
+}
+
+void vl53l8cx_tdma_get_report(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_TdmaReport		*p_report)
+{
+	VL53L8CX_TdmaSensorReport *p_sensor;
+	float elapsed_s = 0.0f;
+	uint64_t end_ns;
+	uint8_t i;
+
+	(void)memset(p_report, 0, sizeof(*p_report));
+	p_report->nb_sensors = p_tdma->nb_sensors;
+	p_report->nb_slots = p_tdma->nb_slots;
+	p_report->cycle_us = p_tdma->cycle_us;
+	p_report->skipped_slots = atomic_load_explicit(&p_tdma->skipped_slots,
+			memory_order_relaxed);
+
+	if (p_tdma->start_ns != 0U)
+	{
+		end_ns = atomic_load_explicit(&p_tdma->running,
+				memory_order_acquire)
+			? vl53l8cx_capture_now_ns() : p_tdma->stop_ns;
+		elapsed_s = (float)(end_ns - p_tdma->start_ns) / 1e9f;
+	}
+
+	for (i = 0; i < p_tdma->nb_sensors; i++)
+	{
+		p_sensor = &p_report->sensors[i];
+		p_sensor->slot = p_tdma->slot_of[i];
+		p_sensor->emission_us = p_tdma->emission_us[i];
+		p_sensor->planned_hz = (p_tdma->cycle_us != 0U)
+			? 1e6f / (float)p_tdma->cycle_us : 0.0f;
+		if (elapsed_s > 0.0f)
+		{
+			p_sensor->triggered_hz = (float)atomic_load_explicit(
+					&p_tdma->triggers[i],
+					memory_order_relaxed) / elapsed_s;
+			p_sensor->received_hz = (float)atomic_load_explicit(
+					&p_tdma->frames[i],
+					memory_order_relaxed) / elapsed_s;
+		}
+		p_report->planned_aggregate_hz += p_sensor->planned_hz;
+		p_report->received_aggregate_hz += p_sensor->received_hz;
+	}
+}
@@ -0,0 +1,220 @@
+#ifndef VL53L8CX_TDMA_H_
+#define VL53L8CX_TDMA_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pool.h"
+
+/**
+ * @brief Maximum number of sensors time-multiplexed by a scheduler.
+ */
+
+#define VL53L8CX_TDMA_MAX_SENSORS		8U
+
+/**
+ * @brief Default time added to the emission of each slot, in us. It covers the
+ * sync pulse latency and the frame setup of the sensors.
+ */
+
+#define VL53L8CX_TDMA_GUARD_US			1000U
+
+/**
+ * @brief Callback producing the sync edge of a sensor, for instance by pulsing
+ * the GPIO wired to its SYNC pin. It is called from the scheduler thread at
+ * the start of each slot of the sensor, and must return quickly.
+ */
+
+typedef void (*VL53L8CX_TdmaTrigger)(
+		void				*p_user,
+		uint8_t				sensor_id);
+
+/**
+ * @brief Structure VL53L8CX_TdmaSensorReport contains the rates of a sensor.
+ */
+
+typedef struct
+{
+	/* Slot of the sensor into the cycle */
+	uint8_t			slot;
+	/* Emission time of one frame, in us */
+	uint32_t		emission_us;
+	/* Rate given by the plan, in Hz */
+	float			planned_hz;
+	/* Rate of the sync edges sent, in Hz */
+	float			triggered_hz;
+	/* Rate of the frames reported by vl53l8cx_tdma_frame_received(), in Hz */
+	float			received_hz;
+} VL53L8CX_TdmaSensorReport;
+
+/**
+ * @brief Structure VL53L8CX_TdmaReport contains the plan and the rates
+ * achieved since vl53l8cx_tdma_start().
+ */
+
+typedef struct
+{
+	uint8_t			nb_sensors;
+	uint8_t			nb_slots;
+	/* Duration of a full cycle of slots, in us */
+	uint32_t		cycle_us;
+	/* Slots skipped because the scheduler thread woke up too late */
+	uint32_t		skipped_slots;
+	/* Sum of the planned and of the received rates, in Hz */
+	float			planned_aggregate_hz;
+	float			received_aggregate_hz;
+	VL53L8CX_TdmaSensorReport sensors[VL53L8CX_TDMA_MAX_SENSORS];
+} VL53L8CX_TdmaReport;
+
+/**
+ * @brief Structure VL53L8CX_Tdma time-multiplexes the emission of sensors
+ * whose fields of view overlap. Sensors run in autonomous mode with the
+ * external sync pin enabled, so each frame starts on a sync edge sent by the
+ * scheduler thread. The cycle is split into slots: sensors which overlap are
+ * never in the same slot, and each slot lasts the longest emission of its
+ * sensors plus the guard time. Each sensor ranges once per cycle. A slot whose
+ * sync edge would be later than the guard time is skipped, so a late wakeup
+ * of the scheduler never makes slots overlap.
+ */
+
+typedef struct
+{
+	VL53L8CX_Configuration	*p_devs[VL53L8CX_TDMA_MAX_SENSORS];
+	uint8_t			nb_sensors;
+	/* Bit i of overlap[j] is set when sensors i and j overlap */
+	uint8_t			overlap[VL53L8CX_TDMA_MAX_SENSORS];
+	/* Emission time of a frame, and minimum ranging period, in us */
+	uint32_t		emission_us[VL53L8CX_TDMA_MAX_SENSORS];
+	uint32_t		min_period_us[VL53L8CX_TDMA_MAX_SENSORS];
+	uint32_t		guard_us;
+	/* Plan, see vl53l8cx_tdma_plan() */
+	uint8_t			slot_of[VL53L8CX_TDMA_MAX_SENSORS];
+	uint8_t			slot_members[VL53L8CX_TDMA_MAX_SENSORS];
+	uint32_t		slot_us[VL53L8CX_TDMA_MAX_SENSORS];
+	uint8_t			nb_slots;
+	uint32_t		cycle_us;
+	VL53L8CX_TdmaTrigger	trigger;
+	void			*p_user;
+	pthread_t		thread;
+	atomic_int		running;
+	/* CLOCK_MONOTONIC times of vl53l8cx_tdma_start() and _stop(), in ns */
+	uint64_t		start_ns;
+	uint64_t		stop_ns;
+	atomic_uint		triggers[VL53L8CX_TDMA_MAX_SENSORS];
+	atomic_uint		frames[VL53L8CX_TDMA_MAX_SENSORS];
+	atomic_uint		skipped_slots;
+} VL53L8CX_Tdma;
+
+/**
+ * @brief This function initializes a scheduler without sensor.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @param (VL53L8CX_TdmaTrigger) trigger : Callback sending the sync edges.
+ * @param (void) *p_user : Argument given to the callback.
+ * @param (uint32_t) guard_us : Time added to each slot. Set to 0 to use
+ * VL53L8CX_TDMA_GUARD_US.
+ */
+
+void vl53l8cx_tdma_init(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_TdmaTrigger		trigger,
+		void				*p_user,
+		uint32_t			guard_us);
+
+/**
+ * @brief This function adds a sensor. Its id is given to the trigger callback.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @param (VL53L8CX_Configuration) *p_dev : Initialized sensor, not ranging.
+ * @param (uint8_t) *p_sensor_id : Id of the sensor.
+ * @return (uint8_t) status : 0 if OK, or 127 if the scheduler is full.
+ */
+
+uint8_t vl53l8cx_tdma_add_sensor(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_sensor_id);
+
+/**
+ * @brief This function declares that the fields of view of 2 sensors overlap,
+ * so they must never emit at the same time.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @param (uint8_t) sensor_a : Id of the first sensor.
+ * @param (uint8_t) sensor_b : Id of the second sensor.
+ * @return (uint8_t) status : 0 if OK, or 127 if an id is not valid.
+ */
+
+uint8_t vl53l8cx_tdma_set_overlap(
+		VL53L8CX_Tdma			*p_tdma,
+		uint8_t				sensor_a,
+		uint8_t				sensor_b);
+
+/**
+ * @brief This function computes the slots from the overlaps, the emission
+ * times and the minimum periods. Sensors are taken from the longest emission
+ * to the shortest, and each one is put into the first slot without overlap,
+ * so long emissions share slots and the cycle is kept short. The cycle is
+ * extended if a sensor cannot range that fast. It is called by
+ * vl53l8cx_tdma_configure(), or directly when the emission times are known.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ */
+
+void vl53l8cx_tdma_plan(
+		VL53L8CX_Tdma			*p_tdma);
+
+/**
+ * @brief This function configures the sensors for synchronized ranging
+ * (autonomous mode, external sync pin, maximum ranging frequency of the
+ * resolution), reads their integration time, and computes the plan.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_tdma_configure(
+		VL53L8CX_Tdma			*p_tdma);
+
+/**
+ * @brief This function starts ranging on all sensors, and starts the
+ * scheduler thread sending the sync edges.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @return (uint8_t) status : 0 if OK, or 127 if there is no slot (no sensor,
+ * or no plan).
+ */
+
+uint8_t vl53l8cx_tdma_start(
+		VL53L8CX_Tdma			*p_tdma);
+
+/**
+ * @brief This function stops the scheduler thread and the ranging of all
+ * sensors.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_tdma_stop(
+		VL53L8CX_Tdma			*p_tdma);
+
+/**
+ * @brief This function counts a frame read from a sensor, for the achieved
+ * rate. It can be called from any thread.
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @param (uint8_t) sensor_id : Id of the sensor.
+ */
+
+void vl53l8cx_tdma_frame_received(
+		VL53L8CX_Tdma			*p_tdma,
+		uint8_t				sensor_id);
+
+/**
+ * @brief This function gives the plan and the rates achieved since
+ * vl53l8cx_tdma_start().
+ * @param (VL53L8CX_Tdma) *p_tdma : Scheduler structure.
+ * @param (VL53L8CX_TdmaReport) *p_report : Plan and rates.
+ */
+
+void vl53l8cx_tdma_get_report(
+		VL53L8CX_Tdma			*p_tdma,
+		VL53L8CX_TdmaReport		*p_report);
+
+#endif /* VL53L8CX_TDMA_H_ */
@@ -0,0 +1,223 @@
+#include <string.h>
+
+#include "vl53l8cx_tracker.h"
+
+#define _VL53L8CX_TRACKER_NONE		((uint8_t)0xFFU)
+
+/* Pair of a track and an obstacle within its gate */
+typedef struct
+{
+	float			cost;
+	uint8_t			track;
+	uint8_t			obstacle;
+} _VL53L8CX_TrackerPair;
+
+static void _vl53l8cx_tracker_correct(
+		const VL53L8CX_Tracker		*p_trk,
+		VL53L8CX_Track			*p_track,
+		const VL53L8CX_Obstacle		*p_obs,
+		float				dt_s)
+{
+	float alpha = p_trk->config.alpha;
+	float beta = (dt_s > 0.0f) ? (p_trk->config.beta / dt_s) : 0.0f;
+	float residual;
+
+	residual = (float)p_obs->min_distance_mm - p_track->range_mm;
+	p_track->range_mm += alpha * residual;
+	p_track->range_rate_mm_s += beta * residual;
+	residual = p_obs->azimuth_deg - p_track->azimuth_deg;
+	p_track->azimuth_deg += alpha * residual;
+	p_track->azimuth_rate_deg_s += beta * residual;
+	residual = p_obs->elevation_deg - p_track->elevation_deg;
+	p_track->elevation_deg += alpha * residual;
+	p_track->elevation_rate_deg_s += beta * residual;
+
+	p_track->nb_zones = p_obs->nb_zones;
+	p_track->missed = 0;
+	if (p_track->hits < UINT16_MAX)
+	{
+		p_track->hits++;
+	}
+	if (p_track->hits >= p_trk->config.confirm_hits)
+	{
+		p_track->is_confirmed = 1;
+	}
+}
+
+static void _vl53l8cx_tracker_start(
+		VL53L8CX_Tracker		*p_trk,
+		const VL53L8CX_Obstacle		*p_obs,
+		uint8_t				obstacle)
+{
+	VL53L8CX_Track *p_track = &p_trk->tracks[p_trk->nb_tracks];
+
+	(void)memset(p_track, 0, sizeof(*p_track));
+	p_track->id = p_trk->next_id;
+	p_trk->next_id = (uint16_t)(p_trk->next_id + 1U);
+	if (p_trk->next_id == 0U)
+	{
+		p_trk->next_id = 1;
+	}
+	p_track->obstacle = obstacle;
+	p_track->hits = 1;
+	p_track->is_confirmed = (uint8_t)(p_trk->config.confirm_hits <= 1U);
+	p_track->nb_zones = p_obs->nb_zones;
+	p_track->range_mm = (float)p_obs->min_distance_mm;
+	p_track->azimuth_deg = p_obs->azimuth_deg;
+	p_track->elevation_deg = p_obs->elevation_deg;
+	p_track->time_to_contact_s = VL53L8CX_TRACKER_NO_CONTACT;
+	p_trk->nb_tracks++;
+}
+
+void vl53l8cx_tracker_init(
+		VL53L8CX_Tracker		*p_trk,
+		const VL53L8CX_TrackerConfig	*p_config)
+{
+	(void)memset(p_trk, 0, sizeof(*p_trk));
+	p_trk->next_id = 1;
+	if (p_config != NULL)
+	{
+		p_trk->config = *p_config;
+	}
+	else
+	{
+		p_trk->config.alpha = VL53L8CX_TRACKER_DEFAULT_ALPHA;
+		p_trk->config.beta = VL53L8CX_TRACKER_DEFAULT_BETA;
+		p_trk->config.gate_mm = VL53L8CX_TRACKER_DEFAULT_GATE_MM;
+		p_trk->config.gate_deg = VL53L8CX_TRACKER_DEFAULT_GATE_DEG;
+		p_trk->config.confirm_hits = VL53L8CX_TRACKER_DEFAULT_CONFIRM_HITS;
+		p_trk->config.max_missed = VL53L8CX_TRACKER_DEFAULT_MAX_MISSED;
+		p_trk->config.min_closing_mm_s =
+			VL53L8CX_TRACKER_DEFAULT_MIN_CLOSING_MM_S;
+	}
+}
+
+uint8_t vl53l8cx_tracker_update(
+		VL53L8CX_Tracker		*p_trk,
+		const VL53L8CX_Segment		*p_seg,
+		uint64_t			t_ns)
+{
+	_VL53L8CX_TrackerPair pairs[VL53L8CX_TRACKER_MAX_TRACKS
+		* VL53L8CX_SEGMENT_MAX_OBSTACLES], pair;
+	uint8_t obs_track[VL53L8CX_SEGMENT_MAX_OBSTACLES];
+	const VL53L8CX_Obstacle *p_obs;
+	VL53L8CX_Track *p_track;
+	float dt_s, dr, da, de, cost;
+	float inv_gate_mm = 1.0f / p_trk->config.gate_mm;
+	float inv_gate_deg = 1.0f / p_trk->config.gate_deg;
+	uint32_t i, j, k, kept, nb_pairs = 0;
+
+	if ((p_trk->t_last_ns != 0U) && (t_ns <= p_trk->t_last_ns))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	dt_s = (p_trk->t_last_ns != 0U)
+		? ((float)(t_ns - p_trk->t_last_ns) * 1e-9f) : 0.0f;
+	p_trk->t_last_ns = t_ns;
+
+	/* Constant velocity prediction, and pairs within the gates, sorted
+	 * by normalized distance */
+	for (i = 0; i < p_trk->nb_tracks; i++)
+	{
+		p_track = &p_trk->tracks[i];
+		p_track->range_mm += p_track->range_rate_mm_s * dt_s;
+		p_track->azimuth_deg += p_track->azimuth_rate_deg_s * dt_s;
+		p_track->elevation_deg += p_track->elevation_rate_deg_s * dt_s;
+		p_track->obstacle = VL53L8CX_SEGMENT_NO_LABEL;
+		for (j = 0; j < p_seg->nb_obstacles; j++)
+		{
+			p_obs = &p_seg->obstacles[j];
+			dr = ((float)p_obs->min_distance_mm - p_track->range_mm)
+				* inv_gate_mm;
+			da = (p_obs->azimuth_deg - p_track->azimuth_deg)
+				* inv_gate_deg;
+			de = (p_obs->elevation_deg - p_track->elevation_deg)
+				* inv_gate_deg;
+			cost = (dr * dr) + (da * da) + (de * de);
+			if (cost > 1.0f)
+			{
+				continue;
+			}
+			pair.cost = cost;
+			pair.track = (uint8_t)i;
+			pair.obstacle = (uint8_t)j;
+			for (k = nb_pairs; (k > 0U)
+				&& (pairs[k - 1U].cost > cost); k--)
+			{
+				pairs[k] = pairs[k - 1U];
+			}
+			pairs[k] = pair;
+			nb_pairs++;
+		}
+	}
+
+	/* Closest pairs first (greedy global nearest neighbour) */
+	(void)memset(obs_track, _VL53L8CX_TRACKER_NONE, sizeof(obs_track));
+	for (k = 0; k < nb_pairs; k++)
+	{
+		p_track = &p_trk->tracks[pairs[k].track];
+		if ((p_track->obstacle == VL53L8CX_SEGMENT_NO_LABEL)
+			&& (obs_track[pairs[k].obstacle]
+				== _VL53L8CX_TRACKER_NONE))
+		{
+			p_track->obstacle = pairs[k].obstacle;
+			obs_track[pairs[k].obstacle] = pairs[k].track;
+		}
+	}
+
+	/* Correct the tracks seen, and delete the tracks lost */
+	kept = 0;
+	for (i = 0; i < p_trk->nb_tracks; i++)
+	{
+		p_track = &p_trk->tracks[i];
+		if (p_track->obstacle != VL53L8CX_SEGMENT_NO_LABEL)
+		{
+			_vl53l8cx_tracker_correct(p_trk, p_track,
+				&p_seg->obstacles[p_track->obstacle], dt_s);
+		}
+		else
+		{
+			p_track->missed++;
+			if (!p_track->is_confirmed
+				|| (p_track->missed > p_trk->config.max_missed))
+			{
+				continue;
+			}
+		}
+		if (kept != i)
+		{
+			p_trk->tracks[kept] = *p_track;
+		}
+		kept++;
+	}
+	p_trk->nb_tracks = (uint8_t)kept;
+
+	/* Obstacles left start new tracks, nearest first */
+	for (j = 0; (j < p_seg->nb_obstacles)
+		&& (p_trk->nb_tracks < VL53L8CX_TRACKER_MAX_TRACKS); j++)
+	{
+		if (obs_track[j] == _VL53L8CX_TRACKER_NONE)
+		{
+			_vl53l8cx_tracker_start(p_trk, &p_seg->obstacles[j],
+				(uint8_t)j);
+		}
+	}
+
+	for (i = 0; i < p_trk->nb_tracks; i++)
+	{
+		p_track = &p_trk->tracks[i];
+		p_track->closing_speed_mm_s = -p_track->range_rate_mm_s;
+		if (p_track->closing_speed_mm_s
+			>= p_trk->config.min_closing_mm_s)
+		{
+			p_track->time_to_contact_s = p_track->range_mm
+				/ p_track->closing_speed_mm_s;
+		}
+		else
+		{
+			p_track->time_to_contact_s = VL53L8CX_TRACKER_NO_CONTACT;
+		}
+	}
+
+	return VL53L8CX_STATUS_OK;
+}
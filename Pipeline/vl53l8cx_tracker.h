@@ -0,0 +1,132 @@
+#ifndef VL53L8CX_TRACKER_H_
+#define VL53L8CX_TRACKER_H_
+
+#include <stdint.h>
+
+#include "vl53l8cx_segment.h"
+
+/**
+ * @brief Maximum number of tracks of a tracker.
+ */
+
+#define VL53L8CX_TRACKER_MAX_TRACKS		16U
+
+/**
+ * @brief Time to contact of a track which is not closing.
+ */
+
+#define VL53L8CX_TRACKER_NO_CONTACT		(-1.0f)
+
+/**
+ * @brief Default tracker: an obstacle matches a track when it is within
+ * 300 mm and 10 degrees of its prediction. A track is confirmed after 3
+ * frames and deleted after 5 frames without obstacle. Closing speeds under
+ * 50 mm/s give no time to contact.
+ */
+
+#define VL53L8CX_TRACKER_DEFAULT_ALPHA		0.5f
+#define VL53L8CX_TRACKER_DEFAULT_BETA		0.2f
+#define VL53L8CX_TRACKER_DEFAULT_GATE_MM	300.0f
+#define VL53L8CX_TRACKER_DEFAULT_GATE_DEG	10.0f
+#define VL53L8CX_TRACKER_DEFAULT_CONFIRM_HITS	3U
+#define VL53L8CX_TRACKER_DEFAULT_MAX_MISSED	5U
+#define VL53L8CX_TRACKER_DEFAULT_MIN_CLOSING_MM_S	50.0f
+
+/**
+ * @brief Structure VL53L8CX_TrackerConfig contains the tracker settings.
+ */
+
+typedef struct
+{
+	/* Position and velocity gains, from 0 to 1 */
+	float			alpha;
+	float			beta;
+	/* Gate around the prediction of a track: range in mm, azimuth and
+	 * elevation in degrees */
+	float			gate_mm;
+	float			gate_deg;
+	/* Frames with an obstacle before a track is confirmed */
+	uint8_t			confirm_hits;
+	/* Frames without obstacle before a confirmed track is deleted.
+	 * Tentative tracks are deleted at the first missed frame */
+	uint8_t			max_missed;
+	/* Minimum closing speed to give a time to contact, in mm/s */
+	float			min_closing_mm_s;
+} VL53L8CX_TrackerConfig;
+
+/**
+ * @brief Structure VL53L8CX_Track contains the state of a tracked obstacle.
+ * The range is the distance of the nearest zone of the obstacle.
+ */
+
+typedef struct
+{
+	/* Id, unique for the tracker, never 0 */
+	uint16_t		id;
+	uint8_t			is_confirmed;
+	/* Obstacle of the last frame, or VL53L8CX_SEGMENT_NO_LABEL when
+	 * the track was not seen (its state is then predicted) */
+	uint8_t			obstacle;
+	uint16_t		hits;
+	uint8_t			missed;
+	uint8_t			nb_zones;
+	/* State: range in mm, angles in degrees, rates per second */
+	float			range_mm;
+	float			range_rate_mm_s;
+	float			azimuth_deg;
+	float			azimuth_rate_deg_s;
+	float			elevation_deg;
+	float			elevation_rate_deg_s;
+	/* Positive when the obstacle comes closer, in mm/s */
+	float			closing_speed_mm_s;
+	/* Time before the obstacle reaches the sensor at the current closing
+	 * speed, in s, or VL53L8CX_TRACKER_NO_CONTACT */
+	float			time_to_contact_s;
+} VL53L8CX_Track;
+
+/**
+ * @brief Structure VL53L8CX_Tracker follows the obstacles of a sensor across
+ * frames. Each track is predicted at constant velocity, then the obstacles
+ * within its gate are assigned, the closest pairs first, and update it with
+ * alpha-beta gains. Obstacles left start new tracks. All arrays have a fixed
+ * size: nothing is allocated.
+ */
+
+typedef struct
+{
+	VL53L8CX_TrackerConfig	config;
+	uint8_t			nb_tracks;
+	VL53L8CX_Track		tracks[VL53L8CX_TRACKER_MAX_TRACKS];
+	uint16_t		next_id;
+	/* Time of the last frame, in ns, 0 before the first one */
+	uint64_t		t_last_ns;
+} VL53L8CX_Tracker;
+
+/**
+ * @brief This function initializes a tracker without track.
+ * @param (VL53L8CX_Tracker) *p_trk : Tracker structure.
+ * @param (VL53L8CX_TrackerConfig) *p_config : Settings, or NULL to use the
+ * default ones.
+ */
+
+void vl53l8cx_tracker_init(
+		VL53L8CX_Tracker		*p_trk,
+		const VL53L8CX_TrackerConfig	*p_config);
+
+/**
+ * @brief This function updates the tracks with the obstacles of a frame.
+ * @param (VL53L8CX_Tracker) *p_trk : Tracker structure.
+ * @param (VL53L8CX_Segment) *p_seg : Obstacles of the frame, see
+ * vl53l8cx_segment_update().
+ * @param (uint64_t) t_ns : Time of the frame (CLOCK_MONOTONIC), in ns, for
+ * instance t_ready_ns of a captured frame.
+ * @return (uint8_t) status : 0 if OK, or VL53L8CX_STATUS_INVALID_PARAM if
+ * the time is not after the previous frame.
+ */
+
+uint8_t vl53l8cx_tracker_update(
+		VL53L8CX_Tracker		*p_trk,
+		const VL53L8CX_Segment		*p_seg,
+		uint64_t			t_ns);
+
+#endif /* VL53L8CX_TRACKER_H_ */
@@ -19,9 +19,6 @@
 #include <errno.h>
 #include <string.h>
 
-#define SPI_CHANNEL 0 // SPI channel (0 or 1)
-#define SPI_SPEED 500000 // SPI speed in Hz
-
 uint8_t VL53L8CX_RdByte(
 		VL53L8CX_Platform *p_platform,
 		uint16_t RegisterAdress,
@@ -30,7 +27,7 @@ uint8_t VL53L8CX_RdByte(
 	uint8_t status = 0;
 	uint8_t tx_buffer[3] = { (RegisterAdress >> 8) & 0x7F, RegisterAdress & 0xFF, 0x00 };
 	
-	if (wiringPiSPIDataRW(SPI_CHANNEL, tx_buffer, 3) < 0) {
+	if (wiringPiSPIDataRW(p_platform->spi_channel, tx_buffer, 3) < 0) {
 		printf("SPI errno: %s (errno: %d)\n", strerror(errno), errno);
 		status = 1; // Error
 	} else {
@@ -48,7 +45,7 @@ uint8_t VL53L8CX_WrByte(
 	uint8_t status = 0;
 	uint8_t tx_buffer[3] = { (RegisterAdress >> 8) | 0x80, RegisterAdress & 0xFF, value };
 
-	if (wiringPiSPIDataRW(SPI_CHANNEL, tx_buffer, 3) < 0) {
+	if (wiringPiSPIDataRW(p_platform->spi_channel, tx_buffer, 3) < 0) {
 		printf("SPI errno: %s (errno: %d)\n", strerror(errno), errno);
 		status = 1; // Error
 	}
@@ -68,7 +65,7 @@ uint8_t VL53L8CX_WrMulti(
 	tx_buffer[1] = RegisterAdress & 0xFF;
 	memcpy(&tx_buffer[2], p_values, size);
 
-	if(wiringPiSPIDataRW(SPI_CHANNEL, tx_buffer, size + 2) < 0)
+	if(wiringPiSPIDataRW(p_platform->spi_channel, tx_buffer, size + 2) < 0)
 	{
 		printf("SPI errno: %s (errno: %d)\n", strerror(errno), errno);
 		status = 1;
@@ -89,7 +86,7 @@ uint8_t VL53L8CX_RdMulti(
 	tx_buffer[1] = RegisterAdress & 0xFF;
 	memset(&tx_buffer[2], 0, size);
 
-	if (wiringPiSPIDataRW(SPI_CHANNEL, tx_buffer, size + 2) < 0) {
+	if (wiringPiSPIDataRW(p_platform->spi_channel, tx_buffer, size + 2) < 0) {
 		printf("SPI errno: %s (errno: %d)\n", strerror(errno), errno);
 		status = 1; // Error
 	} else {
@@ -27,7 +27,8 @@
 
 typedef struct
 {
-	/* SPI-specific fields for the platform */
+	/* SPI-specific fields for the platform. Sensors sharing a SPI bus use
+	 * different channels (chip-selects) */
 	int spi_channel;   // SPI channel (e.g., 0 or 1)
 	int spi_speed;     // SPI speed in Hz
 	//uint16_t  			address; // I2c/SPI address of the sensor
@@ -38,10 +39,13 @@ typedef struct
  * @brief The macro below is used to define the number of target per zone sent
  * through I2C. This value can be changed by user, in order to tune I2C
  * transaction, and also the total memory size (a lower number of target per
- * zone means a lower RAM). The value must be between 1 and 4.
+ * zone means a lower RAM). The value must be between 1 and 4. It can also be
+ * given on the command line, e.g. by the host tests.
  */
 
+#ifndef VL53L8CX_NB_TARGET_PER_ZONE
 #define 	VL53L8CX_NB_TARGET_PER_ZONE		1U
+#endif
 
 /*
  * @brief The macro below can be used to avoid data conversion into the driver.
@@ -52,6 +56,17 @@ typedef struct
 
 // #define 	VL53L8CX_USE_RAW_FORMAT
 
+/*
+ * @brief The macro below can be used to reduce the RAM used by each device when
+ * several sensors are driven. The temporary buffer is not embedded into the
+ * device structure anymore, but borrowed from a pool shared by all devices
+ * (one buffer per concurrent transaction). Offset and Xtalk buffers are also
+ * taken from the pool, and devices with the same calibration share them. See
+ * Pipeline/vl53l8cx_pool.h.
+ */
+
+// #define 	VL53L8CX_SHARED_BUFFERS
+
 /*
  * @brief All macro below are used to configure the sensor output. User can
  * define some macros if he wants to disable selected output, in order to reduce
@@ -68,6 +83,14 @@ typedef struct
 // #define VL53L8CX_DISABLE_TARGET_STATUS
 // #define VL53L8CX_DISABLE_MOTION_INDICATOR
 
+/*
+ * @brief The validity mask and the nearest valid distance are computed while
+ * decoding the target status (see VL53L8CX_ResultsData). Define this macro to
+ * skip them.
+ */
+
+// #define VL53L8CX_DISABLE_VALIDITY_MASK
+
 /**
  * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
  * structure.
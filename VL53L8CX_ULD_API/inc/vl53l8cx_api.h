@@ -263,6 +263,88 @@
 #define VL53L8CX_TEMPORARY_BUFFER_SIZE ((uint32_t) VL53L8CX_MAX_RESULTS_SIZE)
 #endif
 
+/**
+ * @brief Macros VL53L8CX_OUTPUT_* select the results blocks fetched by the
+ * partial read mode (see vl53l8cx_set_partial_read()). Values match the bits
+ * of the firmware output enables, so they can be combined with a bitwise OR.
+ * Meta-data and common-data (streamcount, temperature, header id) are always
+ * read.
+ */
+
+#define VL53L8CX_OUTPUT_AMBIENT_PER_SPAD	((uint16_t)0x0008U)
+#define VL53L8CX_OUTPUT_NB_SPADS_ENABLED	((uint16_t)0x0010U)
+#define VL53L8CX_OUTPUT_NB_TARGET_DETECTED	((uint16_t)0x0020U)
+#define VL53L8CX_OUTPUT_SIGNAL_PER_SPAD		((uint16_t)0x0040U)
+#define VL53L8CX_OUTPUT_RANGE_SIGMA_MM		((uint16_t)0x0080U)
+#define VL53L8CX_OUTPUT_DISTANCE_MM		((uint16_t)0x0100U)
+#define VL53L8CX_OUTPUT_REFLECTANCE_PERCENT	((uint16_t)0x0200U)
+#define VL53L8CX_OUTPUT_TARGET_STATUS		((uint16_t)0x0400U)
+#define VL53L8CX_OUTPUT_MOTION_INDICATOR	((uint16_t)0x0800U)
+#define VL53L8CX_OUTPUT_ALL			((uint16_t)0x0FF8U)
+
+/**
+ * @brief The validity mask is derived from the target status, so it is not
+ * available when the target status is disabled.
+ */
+
+#if defined(VL53L8CX_DISABLE_TARGET_STATUS) \
+	&& !defined(VL53L8CX_DISABLE_VALIDITY_MASK)
+#define VL53L8CX_DISABLE_VALIDITY_MASK
+#endif
+
+/**
+ * @brief Macro VL53L8CX_NO_VALID_DISTANCE is the nearest valid distance of a
+ * frame without valid zone.
+ */
+
+#define VL53L8CX_NO_VALID_DISTANCE		((int16_t)0x7FFF)
+
+/**
+ * @brief Inner values for the partial read mode. Number of output blocks
+ * programmed into the firmware, size of the first read (headers + meta-data +
+ * common-data), and maximum gap in bytes merged into a single bus read.
+ */
+
+#define VL53L8CX_NB_OUTPUT_BLOCKS		((uint8_t)12U)
+#define VL53L8CX_PARTIAL_HEADER_SIZE		((uint16_t)44U)
+#define VL53L8CX_PARTIAL_MERGE_GAP		((uint16_t)16U)
+
+
+/**
+ * @brief Macro VL53L8CX_MAX_FRAME_REREADS is the maximum number of re-reads
+ * allowed after a corrupted frame (see vl53l8cx_set_frame_rereads()). Results
+ * are double-buffered by the firmware, so a few re-reads take much less time
+ * than the next ranging period.
+ */
+
+#define VL53L8CX_MAX_FRAME_REREADS		((uint8_t)4U)
+
+/**
+ * @brief Structure VL53L8CX_FrameStats contains the frames accounting of the
+ * driver, updated each time a frame is read. It allows to measure the frames
+ * lost by the host.
+ */
+
+typedef struct
+{
+	/* Frames read from the sensor, re-reads included */
+	uint32_t		frames_received;
+	/* Frames produced by the sensor but never read, detected from the
+	 * streamcount increments */
+	uint32_t		frames_dropped;
+	/* Frames read with a header id different from the footer id, re-reads
+	 * included */
+	uint32_t		frames_corrupted;
+	/* Frames read after a newer frame replaced the one signalled by
+	 * vl53l8cx_check_data_ready() */
+	uint32_t		frames_late;
+	/* Re-reads done after a corrupted frame */
+	uint32_t		rereads;
+	/* Corrupted frames recovered by a re-read */
+	uint32_t		rereads_recovered;
+	/* Corrupted frames still corrupted after the last allowed re-read */
+	uint32_t		rereads_exhausted;
+} VL53L8CX_FrameStats;
 
 /**
  * @brief Structure VL53L8CX_Configuration contains the sensor configuration.
@@ -281,14 +363,42 @@ typedef struct
 	uint8_t		        *default_configuration;
 	/* Address of default Xtalk buffer */
 	uint8_t		        *default_xtalk;
+#ifndef VL53L8CX_SHARED_BUFFERS
 	/* Offset buffer */
 	uint8_t		        offset_data[VL53L8CX_OFFSET_BUFFER_SIZE];
 	/* Xtalk buffer */
 	uint8_t		        xtalk_data[VL53L8CX_XTALK_BUFFER_SIZE];
 	/* Temporary buffer used for internal driver processing */
 	uint8_t		        temp_buffer[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+#else
+	/* Offset and Xtalk buffers, possibly shared with other devices having
+	 * the same calibration. Only written by vl53l8cx_share_caldata() */
+	uint8_t		        *offset_data;
+	uint8_t		        *xtalk_data;
+	/* Temporary buffer borrowed from a pool, NULL when not borrowed */
+	uint8_t		        *temp_buffer;
+	/* Pool owning the buffers, see vl53l8cx_share_caldata() */
+	void		        *p_buffer_pool;
+#endif
 	/* Auto-stop flag for stopping the sensor */
 	uint8_t				is_auto_stop_enabled;
+	/* Size in bytes (block header included) of each output block, 0 if the
+	 * block is disabled. Updated by vl53l8cx_start_ranging() */
+	uint16_t		        block_size[VL53L8CX_NB_OUTPUT_BLOCKS];
+	/* Outputs fetched by the partial read mode, 0 to always read full frames */
+	uint16_t		        partial_read_mask;
+	/* Number of partial frames read between 2 full frames (0 = never full) */
+	uint8_t		        full_read_period;
+	/* Partial frames read since the last full frame */
+	uint8_t		        partial_read_count;
+	/* Outputs available into temp_buffer after the last frame read */
+	uint16_t		        fetched_outputs;
+	/* Streamcount of the last frame read, 255 if none since start */
+	uint8_t		        last_streamcount;
+	/* Frames accounting, see vl53l8cx_get_frame_stats() */
+	VL53L8CX_FrameStats	        frame_stats;
+	/* Re-reads allowed after a corrupted frame, 0 to disable */
+	uint8_t		        max_frame_rereads;
 } VL53L8CX_Configuration;
 
 
@@ -367,6 +477,17 @@ typedef struct
 	} motion_indicator;
 #endif
 
+	/* Validity of the first target of each zone, updated when the target
+	 * status is read: bit i is set when zone i has a target with status 5
+	 * or 9. Nearest distance of these targets, or
+	 * VL53L8CX_NO_VALID_DISTANCE */
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+	uint64_t valid_mask;
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	int16_t nearest_valid_mm;
+#endif
+#endif
+
 } VL53L8CX_ResultsData;
 
 
@@ -483,6 +604,128 @@ uint8_t vl53l8cx_get_ranging_data(
 		VL53L8CX_Configuration		*p_dev,
 		VL53L8CX_ResultsData		*p_results);
 
+/**
+ * @brief This function reads a frame into the temporary buffer of the device,
+ * without decoding it. It is the bus part of vl53l8cx_get_ranging_data(), and
+ * must be followed by vl53l8cx_decode_ranging_data() before any other
+ * function uses the device. It allows to timestamp the bus transfer and the
+ * decoding separately.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return (uint8_t) status : 0 if the frame is read.
+ */
+
+uint8_t vl53l8cx_read_ranging_data(
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function decodes the frame read by
+ * vl53l8cx_read_ranging_data(). It does not access the bus.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (VL53L8CX_ResultsData) *p_results : VL53L5 results structure.
+ * @return (uint8_t) status : 0 if data are decoded, or 2 if the frame is
+ * corrupted.
+ */
+
+uint8_t vl53l8cx_decode_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results);
+
+/**
+ * @brief This function re-reads the frame last read by
+ * vl53l8cx_read_ranging_data(), and decodes it, until it is no longer
+ * corrupted or 'max_frame_rereads' attempts are done (see
+ * vl53l8cx_set_frame_rereads()). It must only be called when
+ * vl53l8cx_decode_ranging_data() returned VL53L8CX_STATUS_CORRUPTED_FRAME, and
+ * is already called by vl53l8cx_get_ranging_data().
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (VL53L8CX_ResultsData) *p_results : VL53L5 results structure.
+ * @return (uint8_t) status : 0 if the frame is recovered, or 2 if it is still
+ * corrupted.
+ */
+
+uint8_t vl53l8cx_reread_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results);
+
+/**
+ * @brief This function sets the number of immediate re-reads done when a
+ * corrupted frame is detected. A re-read fetches the same results buffer,
+ * before the next frame is available, so a single bus glitch does not cost a
+ * whole ranging period. Re-reads are disabled by default.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) max_rereads : Maximum number of re-reads per frame, between
+ * 0 (disabled) and VL53L8CX_MAX_FRAME_REREADS.
+ * @return (uint8_t) status : 0 if OK, or 127 if the value is not valid.
+ */
+
+uint8_t vl53l8cx_set_frame_rereads(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				max_rereads);
+
+/**
+ * @brief This function enables the partial read mode used by
+ * vl53l8cx_get_ranging_data(). Each frame is read in 2 phases: the headers,
+ * meta-data and common-data are read first, then only the selected output
+ * blocks and the footer are fetched. Every 'full_read_period' partial frames,
+ * a full frame is read instead. Fields of p_results which are not fetched keep
+ * their previous value. This function does not access the bus and can be
+ * called while the sensor streams.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint16_t) output_mask : Outputs to fetch, using macros
+ * VL53L8CX_OUTPUT_*. Set to 0 to disable the partial read mode.
+ * @param (uint8_t) full_read_period : Number of partial frames between 2 full
+ * frames. Set to 0 to never read full frames.
+ * @return (uint8_t) status : 0 if OK, or 127 if the mask is not valid.
+ */
+
+uint8_t vl53l8cx_set_partial_read(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			output_mask,
+		uint8_t				full_read_period);
+
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+
+/**
+ * @brief This function computes the validity mask and the nearest valid
+ * distance of the results. The driver calls it when the target status is
+ * decoded, and it can be called on results built by the user (e.g. unpacked
+ * from a compact frame). Zones are processed 8 at a time, as the bytes of a
+ * 64 bits word.
+ * @param (VL53L8CX_ResultsData) *p_results : VL53L5 results structure.
+ * @param (uint8_t) nb_zones : Number of zones, 16 or 64.
+ * @return (uint8_t) status : 0 if OK, or 127 if the number of zones is not
+ * valid.
+ */
+
+uint8_t vl53l8cx_update_validity(
+		VL53L8CX_ResultsData		*p_results,
+		uint8_t				nb_zones);
+
+#endif
+
+/**
+ * @brief This function gets the frames accounting since the last call to
+ * vl53l8cx_init() or vl53l8cx_reset_frame_stats(). Dropped frames are
+ * detected from the gap between the streamcount of 2 consecutive frames read,
+ * so frames missed while the sensor is stopped are not counted.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (VL53L8CX_FrameStats) *p_stats : Frames counters.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_get_frame_stats(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_FrameStats		*p_stats);
+
+/**
+ * @brief This function clears the frames accounting.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_reset_frame_stats(
+		VL53L8CX_Configuration		*p_dev);
+
 /**
  * @brief This function gets the current resolution (4x4 or 8x8).
  * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
@@ -755,4 +998,187 @@ uint8_t vl53l8cx_dci_replace_data(
 		uint16_t			new_data_size,
 		uint16_t			new_data_pos);
 
+/**
+ * @brief Macros VL53L8CX_ASYNC_* are returned by vl53l8cx_async_step(). An
+ * operation is pending until the step function returns VL53L8CX_ASYNC_DONE.
+ */
+
+#define VL53L8CX_ASYNC_DONE			((uint8_t) 0U)
+#define VL53L8CX_ASYNC_PENDING			((uint8_t) 1U)
+
+/**
+ * @brief Structure VL53L8CX_AsyncOp contains the state of a non-blocking
+ * operation (init, start ranging, stop ranging, or DCI access). It replaces
+ * the waits of the blocking functions: instead of sleeping, the step function
+ * returns and gives the time of the next call. A device must run only one
+ * operation at a time, but an event loop can drive an operation per device.
+ */
+
+typedef struct
+{
+	/* Device used by the operation */
+	VL53L8CX_Configuration	*p_dev;
+	/* Operation and step into the operation, internal use */
+	uint8_t			operation;
+	uint8_t			step;
+	/* Step of the nested DCI transfer, internal use */
+	uint8_t			dci_step;
+	/* Accumulated status, valid when the operation is done */
+	uint8_t			status;
+	/* Resolution read when ranging starts, internal use */
+	uint8_t			resolution;
+	/* Number of polls done by the current wait, internal use */
+	uint16_t		nb_polls;
+	/* Time of the next call to vl53l8cx_async_step(), in ms */
+	uint32_t		wake_ms;
+	/* Parameters of a DCI read or write operation, internal use */
+	uint8_t			*p_data;
+	uint32_t		index;
+	uint16_t		data_size;
+} VL53L8CX_AsyncOp;
+
+/**
+ * @brief This function prepares a non-blocking vl53l8cx_init(). The operation
+ * is run by calling vl53l8cx_async_step() until it returns
+ * VL53L8CX_ASYNC_DONE.
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint32_t) now_ms : Current time in ms, from any monotonic clock.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_async_init(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms);
+
+/**
+ * @brief This function prepares a non-blocking vl53l8cx_start_ranging().
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint32_t) now_ms : Current time in ms.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_async_start_ranging(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms);
+
+/**
+ * @brief This function prepares a non-blocking vl53l8cx_stop_ranging().
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint32_t) now_ms : Current time in ms.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_async_stop_ranging(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms);
+
+/**
+ * @brief This function prepares a non-blocking vl53l8cx_dci_read_data(). The
+ * 'data' buffer must stay valid until the operation is done.
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) *data : Buffer receiving the data.
+ * @param (uint32_t) index : Index of required value.
+ * @param (uint16_t) data_size : Size of the data.
+ * @param (uint32_t) now_ms : Current time in ms.
+ * @return (uint8_t) status : 0 if OK, or 255 if the data is too large.
+ */
+
+uint8_t vl53l8cx_async_dci_read_data(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint32_t			now_ms);
+
+/**
+ * @brief This function prepares a non-blocking vl53l8cx_dci_write_data(). The
+ * 'data' buffer must stay valid until the first call to vl53l8cx_async_step().
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) *data : Data to write.
+ * @param (uint32_t) index : Index of the value.
+ * @param (uint16_t) data_size : Size of the data.
+ * @param (uint32_t) now_ms : Current time in ms.
+ * @return (uint8_t) status : 0 if OK, or 255 if the data is too large.
+ */
+
+uint8_t vl53l8cx_async_dci_write_data(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint32_t			now_ms);
+
+/**
+ * @brief This function runs an operation until it has to wait for the sensor.
+ * It never sleeps: when the operation is pending, p_op->wake_ms gives the time
+ * of the next call. Calling it earlier is allowed and does nothing.
+ * @param (VL53L8CX_AsyncOp) *p_op : Operation state.
+ * @param (uint32_t) now_ms : Current time in ms.
+ * @return (uint8_t) state : VL53L8CX_ASYNC_PENDING, or VL53L8CX_ASYNC_DONE
+ * when the operation is finished. Its status is then into p_op->status.
+ */
+
+uint8_t vl53l8cx_async_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms);
+
+/**
+ * @brief Macros VL53L8CX_CALDATA_* select the calibration buffer written by
+ * vl53l8cx_store_caldata().
+ */
+
+#define VL53L8CX_CALDATA_OFFSET			((uint8_t) 0U)
+#define VL53L8CX_CALDATA_XTALK			((uint8_t) 1U)
+
+/**
+ * @brief This function replaces the content of the offset or of the Xtalk
+ * buffer of a device. The buffer is not sent to the sensor. It is the only way
+ * used by the driver to write calibration data, so the buffers can be shared
+ * between devices (see VL53L8CX_SHARED_BUFFERS).
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) caldata : VL53L8CX_CALDATA_OFFSET or VL53L8CX_CALDATA_XTALK.
+ * @param (uint8_t) *p_data : New content, with the size of the buffer. It can
+ * point into the current buffer.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_store_caldata(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				caldata,
+		const uint8_t			*p_data);
+
+#ifdef VL53L8CX_SHARED_BUFFERS
+
+/**
+ * @brief With VL53L8CX_SHARED_BUFFERS, this function is not part of the driver
+ * but must be given by the application, like the platform functions (see
+ * Pipeline/vl53l8cx_pool.c). It makes *pp_caldata point to a buffer with the
+ * given content, and releases the previous one. The driver never writes into
+ * offset_data or xtalk_data directly.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) **pp_caldata : &p_dev->offset_data or &p_dev->xtalk_data.
+ * @param (uint8_t) *p_data : New content.
+ * @param (uint16_t) size : VL53L8CX_OFFSET_BUFFER_SIZE or
+ * VL53L8CX_XTALK_BUFFER_SIZE.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l8cx_share_caldata(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				**pp_caldata,
+		const uint8_t			*p_data,
+		uint16_t			size);
+
+#endif
+
 #endif //VL53L8CX_API_H_
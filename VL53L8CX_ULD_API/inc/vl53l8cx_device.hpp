@@ -0,0 +1,531 @@
+#ifndef VL53L8CX_DEVICE_HPP_
+#define VL53L8CX_DEVICE_HPP_
+
+#if __cplusplus < 201703L
+#error "vl53l8cx_device.hpp requires C++17"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_pool.h"
+}
+
+/**
+ * @brief Header-only C++ layer over the VL53L8CX ULD. The resolution and the
+ * number of targets per zone are template parameters, so frames are sized
+ * exactly for the sensor setup, and values which can be checked at compile
+ * time are checked with static_assert. Functions return the ULD status codes,
+ * no exception is thrown.
+ */
+
+namespace vl53l8cx {
+
+/**
+ * @brief Enum Resolution gives the number of zones of each resolution.
+ */
+
+enum class Resolution : uint8_t
+{
+	R4x4 = VL53L8CX_RESOLUTION_4X4,
+	R8x8 = VL53L8CX_RESOLUTION_8X8
+};
+
+/**
+ * @brief Maximum ranging frequency of a resolution, in Hz.
+ */
+
+template <Resolution R>
+inline constexpr uint8_t max_frequency_hz =
+	(R == Resolution::R4x4) ? (uint8_t)60U : (uint8_t)15U;
+
+/**
+ * @brief Structure Frame contains the results of one frame, sized for
+ * resolution R and for 'Targets' targets per zone. Per target arrays are
+ * indexed as [(Targets * zone) + target]. Outputs disabled into 'platform.h'
+ * are removed, as for VL53L8CX_ResultsData.
+ */
+
+template <Resolution R, uint8_t Targets = VL53L8CX_NB_TARGET_PER_ZONE>
+struct Frame
+{
+	static_assert((Targets >= 1U) && (Targets <= VL53L8CX_NB_TARGET_PER_ZONE),
+		"Targets must be between 1 and VL53L8CX_NB_TARGET_PER_ZONE");
+
+	static constexpr std::size_t nb_zones = static_cast<std::size_t>(R);
+	static constexpr std::size_t nb_targets = Targets;
+	static constexpr std::size_t nb_slots = nb_zones * nb_targets;
+
+	/* Internal sensor silicon temperature */
+	int8_t silicon_temp_degc;
+
+	/* Ambient noise in kcps/spads */
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	std::array<uint32_t, nb_zones> ambient_per_spad;
+#endif
+
+	/* Number of valid target detected for 1 zone */
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	std::array<uint8_t, nb_zones> nb_target_detected;
+#endif
+
+	/* Number of spads enabled for this ranging */
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	std::array<uint32_t, nb_zones> nb_spads_enabled;
+#endif
+
+	/* Signal returned to the sensor in kcps/spads */
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	std::array<uint32_t, nb_slots> signal_per_spad;
+#endif
+
+	/* Sigma of the current distance in mm */
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	std::array<uint16_t, nb_slots> range_sigma_mm;
+#endif
+
+	/* Measured distance in mm */
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	std::array<int16_t, nb_slots> distance_mm;
+#endif
+
+	/* Estimated reflectance in percent */
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	std::array<uint8_t, nb_slots> reflectance;
+#endif
+
+	/* Status indicating the measurement validity (5 & 9 means ranging OK)*/
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	std::array<uint8_t, nb_slots> target_status;
+#endif
+
+	/* Motion detector results */
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+	decltype(VL53L8CX_ResultsData::motion_indicator) motion_indicator;
+#endif
+};
+
+namespace detail {
+
+/**
+ * @brief Copies the per zone values of the first 'N' zones.
+ */
+
+template <std::size_t N, typename T>
+inline void copy_zones(
+		std::array<T, N>		&dst,
+		const T				*p_src)
+{
+	std::memcpy(dst.data(), p_src, sizeof(T) * N);
+}
+
+/**
+ * @brief Copies the per target values of the first zones. When the frame keeps
+ * all the targets produced by the driver, the layouts match and a single copy
+ * is done. Otherwise the first 'Targets' targets of each zone are gathered.
+ */
+
+template <std::size_t Zones, std::size_t Targets, typename T>
+inline void copy_targets(
+		std::array<T, Zones * Targets>	&dst,
+		const T				*p_src)
+{
+	if constexpr (Targets == VL53L8CX_NB_TARGET_PER_ZONE)
+	{
+		std::memcpy(dst.data(), p_src, sizeof(T) * Zones * Targets);
+	}
+	else
+	{
+		for (std::size_t z = 0; z < Zones; z++)
+		{
+			for (std::size_t t = 0; t < Targets; t++)
+			{
+				dst[(Targets * z) + t] =
+					p_src[(VL53L8CX_NB_TARGET_PER_ZONE * z) + t];
+			}
+		}
+	}
+}
+
+} /* namespace detail */
+
+/**
+ * @brief This function converts the results decoded by the driver into a
+ * sized frame. Only the zones of resolution R are copied.
+ * @param (VL53L8CX_ResultsData) &results : Results decoded by the driver.
+ * @param (Frame) &frame : Converted frame.
+ */
+
+template <Resolution R, uint8_t Targets>
+inline void decode_frame(
+		const VL53L8CX_ResultsData	&results,
+		Frame<R, Targets>		&frame)
+{
+	constexpr std::size_t Z = Frame<R, Targets>::nb_zones;
+
+	frame.silicon_temp_degc = results.silicon_temp_degc;
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	detail::copy_zones<Z>(frame.ambient_per_spad, results.ambient_per_spad);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	detail::copy_zones<Z>(frame.nb_target_detected,
+			results.nb_target_detected);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	detail::copy_zones<Z>(frame.nb_spads_enabled, results.nb_spads_enabled);
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	detail::copy_targets<Z, Targets>(frame.signal_per_spad,
+			results.signal_per_spad);
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	detail::copy_targets<Z, Targets>(frame.range_sigma_mm,
+			results.range_sigma_mm);
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	detail::copy_targets<Z, Targets>(frame.distance_mm,
+			results.distance_mm);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	detail::copy_targets<Z, Targets>(frame.reflectance,
+			results.reflectance);
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	detail::copy_targets<Z, Targets>(frame.target_status,
+			results.target_status);
+#endif
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+	frame.motion_indicator = results.motion_indicator;
+#endif
+}
+
+template <Resolution R, uint8_t Targets>
+class RangingSession;
+
+/**
+ * @brief Class Device owns a VL53L8CX_Configuration and drives it with
+ * resolution R. The object is large (temporary and calibration buffers), it
+ * should be static or allocated once. It can not be copied nor moved, because
+ * a ranging session keeps a reference on it. Each call to the driver borrows
+ * the temporary buffer (see vl53l8cx_pool_begin()): with
+ * VL53L8CX_SHARED_BUFFERS, the device is attached to a pool through raw()
+ * before init().
+ */
+
+template <Resolution R, uint8_t Targets = VL53L8CX_NB_TARGET_PER_ZONE>
+class Device
+{
+public:
+	using frame_type = Frame<R, Targets>;
+	using session_type = RangingSession<R, Targets>;
+
+	explicit Device(const VL53L8CX_Platform &platform)
+	{
+		std::memset(&m_dev, 0, sizeof(m_dev));
+		m_dev.platform = platform;
+	}
+
+	Device(const Device &) = delete;
+	Device &operator=(const Device &) = delete;
+
+	/**
+	 * @brief Checks that the sensor answers.
+	 * @param (bool) &is_alive : true if the sensor is detected.
+	 * @return (uint8_t) status : 0 if OK.
+	 */
+
+	uint8_t is_alive(bool &is_alive)
+	{
+		uint8_t alive = 0;
+		uint8_t status = transaction([&](auto *p_dev) {
+			return vl53l8cx_is_alive(p_dev, &alive);
+		});
+
+		is_alive = (alive != 0U);
+		return status;
+	}
+
+	/**
+	 * @brief Loads the firmware and applies resolution R.
+	 * @return (uint8_t) status : 0 if OK.
+	 */
+
+	uint8_t init()
+	{
+		return transaction([](auto *p_dev) {
+			uint8_t status = vl53l8cx_init(p_dev);
+
+			if (status == VL53L8CX_STATUS_OK)
+			{
+				status |= vl53l8cx_set_resolution(p_dev,
+						static_cast<uint8_t>(R));
+			}
+			return status;
+		});
+	}
+
+	/**
+	 * @brief Sets the ranging frequency, checked against the limits of
+	 * resolution R at compile time.
+	 * @return (uint8_t) status : 0 if OK.
+	 */
+
+	template <uint8_t Hz>
+	uint8_t set_ranging_frequency_hz()
+	{
+		static_assert((Hz >= 1U) && (Hz <= max_frequency_hz<R>),
+			"Ranging frequency out of range for this resolution");
+		return set_ranging_frequency_hz(Hz);
+	}
+
+	/**
+	 * @brief Sets the ranging frequency from a runtime value.
+	 * @param (uint8_t) frequency_hz : Ranging frequency in Hz.
+	 * @return (uint8_t) status : 0 if OK, or 127 if the value is out of
+	 * range for resolution R.
+	 */
+
+	uint8_t set_ranging_frequency_hz(uint8_t frequency_hz)
+	{
+		if ((frequency_hz < 1U) || (frequency_hz > max_frequency_hz<R>))
+		{
+			return VL53L8CX_STATUS_INVALID_PARAM;
+		}
+		return transaction([&](auto *p_dev) {
+			return vl53l8cx_set_ranging_frequency_hz(p_dev,
+					frequency_hz);
+		});
+	}
+
+	template <uint32_t Ms>
+	uint8_t set_integration_time_ms()
+	{
+		static_assert((Ms >= 2U) && (Ms <= 1000U),
+			"Integration time must be between 2 and 1000 ms");
+		return transaction([](auto *p_dev) {
+			return vl53l8cx_set_integration_time_ms(p_dev, Ms);
+		});
+	}
+
+	template <uint8_t Percent>
+	uint8_t set_sharpener_percent()
+	{
+		static_assert(Percent <= 99U,
+			"Sharpener must be between 0 and 99 percent");
+		return transaction([](auto *p_dev) {
+			return vl53l8cx_set_sharpener_percent(p_dev, Percent);
+		});
+	}
+
+	template <uint8_t Order>
+	uint8_t set_target_order()
+	{
+		static_assert((Order == VL53L8CX_TARGET_ORDER_CLOSEST)
+			|| (Order == VL53L8CX_TARGET_ORDER_STRONGEST),
+			"Use VL53L8CX_TARGET_ORDER_* macros");
+		return transaction([](auto *p_dev) {
+			return vl53l8cx_set_target_order(p_dev, Order);
+		});
+	}
+
+	template <uint8_t Mode>
+	uint8_t set_ranging_mode()
+	{
+		static_assert((Mode == VL53L8CX_RANGING_MODE_CONTINUOUS)
+			|| (Mode == VL53L8CX_RANGING_MODE_AUTONOMOUS),
+			"Use VL53L8CX_RANGING_MODE_* macros");
+		return transaction([](auto *p_dev) {
+			return vl53l8cx_set_ranging_mode(p_dev, Mode);
+		});
+	}
+
+	uint8_t set_partial_read(uint16_t output_mask, uint8_t full_read_period)
+	{
+		return transaction([&](auto *p_dev) {
+			return vl53l8cx_set_partial_read(p_dev, output_mask,
+					full_read_period);
+		});
+	}
+
+	/**
+	 * @brief Starts a ranging session. Ranging is stopped when the returned
+	 * session is destroyed. Check session.status() before using it.
+	 * @return (RangingSession) session : Ranging session.
+	 */
+
+	[[nodiscard]] session_type start_ranging()
+	{
+		return session_type(*this);
+	}
+
+	/**
+	 * @brief Gives access to the driver structure, to call the C API or the
+	 * plugins directly.
+	 */
+
+	VL53L8CX_Configuration *raw() { return &m_dev; }
+
+private:
+	friend session_type;
+
+	/**
+	 * @brief Runs driver calls with the temporary buffer borrowed.
+	 * @param (Fn) fn : Function taking the driver structure and returning
+	 * a status.
+	 * @return (uint8_t) status : Status of fn, or of vl53l8cx_pool_begin().
+	 */
+
+	template <typename Fn>
+	uint8_t transaction(Fn &&fn)
+	{
+		uint8_t status = vl53l8cx_pool_begin(&m_dev);
+
+		if (status == VL53L8CX_STATUS_OK)
+		{
+			status |= fn(&m_dev);
+		}
+		vl53l8cx_pool_end(&m_dev);
+		return status;
+	}
+
+	VL53L8CX_Configuration	m_dev;
+	VL53L8CX_ResultsData	m_results;
+};
+
+/**
+ * @brief Class RangingSession is a move-only handle on an active ranging. It
+ * is created by Device::start_ranging(), and stops the ranging when destroyed
+ * or when stop() is called.
+ */
+
+template <Resolution R, uint8_t Targets>
+class RangingSession
+{
+public:
+	using frame_type = Frame<R, Targets>;
+
+	RangingSession(RangingSession &&other) noexcept
+		: m_device(std::exchange(other.m_device, nullptr)),
+		  m_status(other.m_status)
+	{
+	}
+
+	RangingSession &operator=(RangingSession &&other) noexcept
+	{
+		if (this != &other)
+		{
+			(void)stop();
+			m_device = std::exchange(other.m_device, nullptr);
+			m_status = other.m_status;
+		}
+		return *this;
+	}
+
+	RangingSession(const RangingSession &) = delete;
+	RangingSession &operator=(const RangingSession &) = delete;
+
+	~RangingSession()
+	{
+		(void)stop();
+	}
+
+	/**
+	 * @brief Status returned by vl53l8cx_start_ranging().
+	 */
+
+	uint8_t status() const { return m_status; }
+
+	explicit operator bool() const { return m_device != nullptr; }
+
+	/**
+	 * @brief Checks if a new frame is available.
+	 * @param (bool) &is_ready : True when a frame can be read.
+	 * @return (uint8_t) status : 0 if OK, or 127 if the session is stopped
+	 * or moved from.
+	 */
+
+	uint8_t check_data_ready(bool &is_ready)
+	{
+		uint8_t ready = 0;
+		uint8_t status;
+
+		is_ready = false;
+		if (m_device == nullptr)
+		{
+			return VL53L8CX_STATUS_INVALID_PARAM;
+		}
+		status = m_device->transaction([&](auto *p_dev) {
+			return vl53l8cx_check_data_ready(p_dev, &ready);
+		});
+		is_ready = (ready != 0U);
+		return status;
+	}
+
+	/**
+	 * @brief Reads and decodes a frame into a sized frame.
+	 * @param (Frame) &frame : Decoded frame.
+	 * @return (uint8_t) status : 0 if OK, 2 if the frame is corrupted, or
+	 * 127 if the session is stopped or moved from.
+	 */
+
+	uint8_t get_ranging_data(frame_type &frame)
+	{
+		uint8_t status;
+
+		if (m_device == nullptr)
+		{
+			return VL53L8CX_STATUS_INVALID_PARAM;
+		}
+		status = m_device->transaction([&](auto *p_dev) {
+			return vl53l8cx_get_ranging_data(p_dev,
+					&m_device->m_results);
+		});
+
+		if (status == VL53L8CX_STATUS_OK)
+		{
+			decode_frame(m_device->m_results, frame);
+		}
+		return status;
+	}
+
+	/**
+	 * @brief Stops the ranging. Does nothing if already stopped.
+	 * @return (uint8_t) status : 0 if OK.
+	 */
+
+	uint8_t stop()
+	{
+		if (m_device == nullptr)
+		{
+			return VL53L8CX_STATUS_OK;
+		}
+		return std::exchange(m_device, nullptr)->transaction(
+				vl53l8cx_stop_ranging);
+	}
+
+private:
+	friend class Device<R, Targets>;
+
+	explicit RangingSession(Device<R, Targets> &device)
+		: m_device(&device),
+		  m_status(device.transaction(vl53l8cx_start_ranging))
+	{
+		if (m_status != VL53L8CX_STATUS_OK)
+		{
+			m_device = nullptr;
+		}
+	}
+
+	Device<R, Targets>	*m_device;
+	uint8_t			m_status;
+};
+
+} /* namespace vl53l8cx */
+
+#endif /* VL53L8CX_DEVICE_HPP_ */
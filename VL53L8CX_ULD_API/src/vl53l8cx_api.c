@@ -90,10 +90,111 @@ static uint8_t _vl53l8cx_poll_for_mcu_boot(
 
 /**
  * @brief Inner function, not available outside this file. This function is used
- * to set the offset data gathered from NVM.
+ * to request a DCI read. Data can be fetched with _vl53l8cx_dci_read_answer()
+ * once the UI command status is 0x03.
  */
 
-static uint8_t _vl53l8cx_send_offset_data(
+static uint8_t _vl53l8cx_dci_read_request(
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	uint8_t cmd[] = {0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x0f,
+			0x00, 0x02, 0x00, 0x08};
+
+	cmd[0] = (uint8_t)(index >> 8);
+	cmd[1] = (uint8_t)(index & (uint32_t)0xff);
+	cmd[2] = (uint8_t)((data_size & (uint16_t)0xff0) >> 4);
+	cmd[3] = (uint8_t)((data_size & (uint16_t)0xf) << 4);
+
+	return VL53L8CX_WrMulti(&(p_dev->platform),
+			(VL53L8CX_UI_CMD_END-(uint16_t)11),cmd, sizeof(cmd));
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to fetch the data of a DCI read request.
+ */
+
+static uint8_t _vl53l8cx_dci_read_answer(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint16_t			data_size)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	int16_t i;
+	uint32_t rd_size = (uint32_t) data_size + (uint32_t)12;
+
+	/* Read new data sent (4 bytes header + data_size + 8 bytes footer) */
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), VL53L8CX_UI_CMD_START,
+		p_dev->temp_buffer, rd_size);
+	VL53L8CX_SwapBuffer(p_dev->temp_buffer, data_size + (uint16_t)12);
+
+	/* Copy data from FW into input structure (-4 bytes to remove header) */
+	for(i = 0 ; i < (int16_t)data_size;i++){
+		data[i] = p_dev->temp_buffer[i + 4];
+	}
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to send a DCI write request, without waiting for the answer. 'data' is
+ * restored before returning.
+ */
+
+static uint8_t _vl53l8cx_dci_write_request(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	int16_t i;
+
+	uint8_t headers[] = {0x00, 0x00, 0x00, 0x00};
+	uint8_t footer[] = {0x00, 0x00, 0x00, 0x0f, 0x05, 0x01,
+			(uint8_t)((data_size + (uint16_t)8) >> 8), 
+			(uint8_t)((data_size + (uint16_t)8) & (uint8_t)0xFF)};
+
+	uint16_t address = (uint16_t)VL53L8CX_UI_CMD_END -
+		(data_size + (uint16_t)12) + (uint16_t)1;
+
+	headers[0] = (uint8_t)(index >> 8);
+	headers[1] = (uint8_t)(index & (uint32_t)0xff);
+	headers[2] = (uint8_t)(((data_size & (uint16_t)0xff0) >> 4));
+	headers[3] = (uint8_t)((data_size & (uint16_t)0xf) << 4);
+
+	/* Copy data from structure to FW format (+4 bytes to add header) */
+	VL53L8CX_SwapBuffer(data, data_size);
+	for(i = (int16_t)data_size - (int16_t)1 ; i >= 0; i--)
+	{
+		p_dev->temp_buffer[i + 4] = data[i];
+	}
+
+	/* Add headers and footer */
+	(void)memcpy(&p_dev->temp_buffer[0], headers, sizeof(headers));
+	(void)memcpy(&p_dev->temp_buffer[data_size + (uint16_t)4],
+		footer, sizeof(footer));
+
+	/* Send data to FW */
+	status |= VL53L8CX_WrMulti(&(p_dev->platform),address,
+		p_dev->temp_buffer,
+		(uint32_t)((uint32_t)data_size + (uint32_t)12));
+
+	VL53L8CX_SwapBuffer(data, data_size);
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to send the offset data gathered from NVM, without waiting for the answer.
+ */
+
+static uint8_t _vl53l8cx_write_offset_data(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t						resolution)
 {
@@ -152,6 +253,22 @@ static uint8_t _vl53l8cx_send_offset_data(
 	(void)memcpy(&(p_dev->temp_buffer[0x1E0]), footer, 8);
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2e18, p_dev->temp_buffer,
 		VL53L8CX_OFFSET_BUFFER_SIZE);
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the offset data gathered from NVM.
+ */
+
+static uint8_t _vl53l8cx_send_offset_data(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t						resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= _vl53l8cx_write_offset_data(p_dev, resolution);
 	status |=_vl53l8cx_poll_for_answer(p_dev, 4, 1,
 		VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
 
@@ -160,10 +277,11 @@ static uint8_t _vl53l8cx_send_offset_data(
 
 /**
  * @brief Inner function, not available outside this file. This function is used
- * to set the Xtalk data from generic configuration, or user's calibration.
+ * to send the Xtalk data from generic configuration, or user's calibration,
+ * without waiting for the answer.
  */
 
-static uint8_t _vl53l8cx_send_xtalk_data(
+static uint8_t _vl53l8cx_write_xtalk_data(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t				resolution)
 {
@@ -212,6 +330,22 @@ static uint8_t _vl53l8cx_send_xtalk_data(
 
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2cf8,
 			p_dev->temp_buffer, VL53L8CX_XTALK_BUFFER_SIZE);
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the Xtalk data from generic configuration, or user's calibration.
+ */
+
+static uint8_t _vl53l8cx_send_xtalk_data(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= _vl53l8cx_write_xtalk_data(p_dev, resolution);
 	status |=_vl53l8cx_poll_for_answer(p_dev, 4, 1,
 			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
 
@@ -241,17 +375,28 @@ uint8_t vl53l8cx_is_alive(
 	return status;
 }
 
-uint8_t vl53l8cx_init(
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to reset the driver fields and to reboot the sensor. It must be followed by
+ * a 1ms wait.
+ */
+
+static uint8_t _vl53l8cx_init_sw_reboot(
 		VL53L8CX_Configuration		*p_dev)
 {
 	uint8_t tmp, status = VL53L8CX_STATUS_OK;
-	uint8_t pipe_ctrl[] = {VL53L8CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
-	uint32_t single_range = 0x01;
-	uint32_t crc_checksum = 0x00;
 
 	p_dev->default_xtalk = (uint8_t*)VL53L8CX_DEFAULT_XTALK;
 	p_dev->default_configuration = (uint8_t*)VL53L8CX_DEFAULT_CONFIGURATION;
 	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
+	p_dev->partial_read_mask = 0;
+	p_dev->full_read_period = 0;
+	p_dev->partial_read_count = 0;
+	p_dev->fetched_outputs = 0;
+	p_dev->last_streamcount = 255;
+	p_dev->max_frame_rereads = 0;
+	(void)memset(p_dev->block_size, 0, sizeof(p_dev->block_size));
+	(void)memset(&(p_dev->frame_stats), 0, sizeof(p_dev->frame_stats));
 
 	/* SW reboot sequence */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
@@ -270,27 +415,21 @@ uint8_t vl53l8cx_init(
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0103, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000C, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x43);
-	status |= VL53L8CX_WaitMs(&(p_dev->platform), 1);
 
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000A, 0x01);
-	status |= VL53L8CX_WaitMs(&(p_dev->platform), 100);
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to power on the MCU and to download the firmware. It must be followed by a
+ * 5ms wait.
+ */
+
+static uint8_t _vl53l8cx_init_download_fw(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t tmp, status = VL53L8CX_STATUS_OK;
 
-	/* Wait for sensor booted (several ms required to get sensor ready ) */
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
-	status |= _vl53l8cx_poll_for_answer(p_dev, 1, 0, 0x06, 0xff, 1);
-	if(status != (uint8_t)0){
-		goto exit;
-	}
-	
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000E, 0x01);
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
-	
-	/* Enable FW access */
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
-	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x06, 0x01);
-	status |= _vl53l8cx_poll_for_answer(p_dev, 1, 0, 0x21, 0xFF, 0x4);
-	
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	
 	/* Enable host access to GO1 */
@@ -335,8 +474,21 @@ uint8_t vl53l8cx_init(
 	/* Check if FW correctly downloaded */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x06, 0x03);
-	
-	status |= VL53L8CX_WaitMs(&(p_dev->platform), 5);
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to reset the MCU after the firmware download. It must be followed by
+ * a wait for MCU boot.
+ */
+
+static uint8_t _vl53l8cx_init_reset_mcu(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t tmp, status = VL53L8CX_STATUS_OK;
+
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x7fff, &tmp);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0C, 0x01);
@@ -352,11 +504,20 @@ uint8_t vl53l8cx_init(
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0C, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0B, 0x01);
 
-	status |= _vl53l8cx_poll_for_mcu_boot(p_dev); 
-	if(status != (uint8_t)0){
-		goto exit;
-	}
-	
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to check the checksum of the downloaded firmware.
+ */
+
+static uint8_t _vl53l8cx_init_check_fw(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint32_t crc_checksum = 0x00;
+
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
 	
 	/* Firmware checksum */
@@ -367,6 +528,56 @@ uint8_t vl53l8cx_init(
 	if (crc_checksum != (uint32_t)0xc0b6c9e)
 	{
 		status |= VL53L8CX_STATUS_FW_CHECKSUM_FAIL;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_init(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {VL53L8CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
+	uint32_t single_range = 0x01;
+#if VL53L8CX_NB_TARGET_PER_ZONE != 1
+	uint8_t tmp;
+#endif
+
+	status |= _vl53l8cx_init_sw_reboot(p_dev);
+	status |= VL53L8CX_WaitMs(&(p_dev->platform), 1);
+
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000A, 0x01);
+	status |= VL53L8CX_WaitMs(&(p_dev->platform), 100);
+
+	/* Wait for sensor booted (several ms required to get sensor ready ) */
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
+	status |= _vl53l8cx_poll_for_answer(p_dev, 1, 0, 0x06, 0xff, 1);
+	if(status != (uint8_t)0){
+		goto exit;
+	}
+	
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000E, 0x01);
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
+	
+	/* Enable FW access */
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x06, 0x01);
+	status |= _vl53l8cx_poll_for_answer(p_dev, 1, 0, 0x21, 0xFF, 0x4);
+	
+	/* Power on MCU and download FW into VL53L8CX */
+	status |= _vl53l8cx_init_download_fw(p_dev);
+	
+	status |= VL53L8CX_WaitMs(&(p_dev->platform), 5);
+	status |= _vl53l8cx_init_reset_mcu(p_dev);
+
+	status |= _vl53l8cx_poll_for_mcu_boot(p_dev); 
+	if(status != (uint8_t)0){
+		goto exit;
+	}
+	
+	status |= _vl53l8cx_init_check_fw(p_dev);
+	if(status != (uint8_t)0){
 		goto exit;
 	}
 
@@ -377,13 +588,13 @@ uint8_t vl53l8cx_init(
 		VL53L8CX_UI_CMD_STATUS, 0xff, 2);
 	status |= VL53L8CX_RdMulti(&(p_dev->platform), VL53L8CX_UI_CMD_START,
 		p_dev->temp_buffer, VL53L8CX_NVM_DATA_SIZE);
-	(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
-		VL53L8CX_OFFSET_BUFFER_SIZE);
+	status |= vl53l8cx_store_caldata(p_dev, VL53L8CX_CALDATA_OFFSET,
+		p_dev->temp_buffer);
 	status |= _vl53l8cx_send_offset_data(p_dev, VL53L8CX_RESOLUTION_4X4);
 
 	/* Set default Xtalk shape. Send Xtalk to sensor */
-	(void)memcpy(p_dev->xtalk_data, (uint8_t*)VL53L8CX_DEFAULT_XTALK,
-		VL53L8CX_XTALK_BUFFER_SIZE);
+	status |= vl53l8cx_store_caldata(p_dev, VL53L8CX_CALDATA_XTALK,
+		VL53L8CX_DEFAULT_XTALK);
 	status |= _vl53l8cx_send_xtalk_data(p_dev, VL53L8CX_RESOLUTION_4X4);
 
 	/* Send default configuration to VL53L8CX firmware */
@@ -515,41 +726,43 @@ uint8_t vl53l8cx_set_power_mode(
 	return status;
 }
 
-uint8_t vl53l8cx_start_ranging(
-		VL53L8CX_Configuration		*p_dev)
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to build the output list and the output enables for a resolution, and to
+ * update the size of each block and of the frame.
+ */
+
+static void _vl53l8cx_get_output_config(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				resolution,
+		uint32_t			*output,
+		uint32_t			*output_bh_enable)
 {
-	uint8_t resolution, status = VL53L8CX_STATUS_OK;
-	uint16_t tmp;
 	uint32_t i;
-	uint32_t header_config[2] = {0, 0};
-
 	union Block_header *bh_ptr;
-	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
 
-	status |= vl53l8cx_get_resolution(p_dev, &resolution);
 	p_dev->data_read_size = 0;
-	p_dev->streamcount = 255;
+	(void)memset(p_dev->block_size, 0, sizeof(p_dev->block_size));
 
 	/* Enable mandatory output (meta and common data) */
-	uint32_t output_bh_enable[] = {
-		0x00000007U,
-		0x00000000U,
-		0x00000000U,
-		0xC0000000U};
+	output_bh_enable[0] = 0x00000007U;
+	output_bh_enable[1] = 0x00000000U;
+	output_bh_enable[2] = 0x00000000U;
+	output_bh_enable[3] = 0xC0000000U;
 
 	/* Send addresses of possible output */
-	uint32_t output[] ={VL53L8CX_START_BH,
-		VL53L8CX_METADATA_BH,
-		VL53L8CX_COMMONDATA_BH,
-		VL53L8CX_AMBIENT_RATE_BH,
-		VL53L8CX_SPAD_COUNT_BH,
-		VL53L8CX_NB_TARGET_DETECTED_BH,
-		VL53L8CX_SIGNAL_RATE_BH,
-		VL53L8CX_RANGE_SIGMA_MM_BH,
-		VL53L8CX_DISTANCE_BH,
-		VL53L8CX_REFLECTANCE_BH,
-		VL53L8CX_TARGET_STATUS_BH,
-		VL53L8CX_MOTION_DETECT_BH};
+	output[0] = VL53L8CX_START_BH;
+	output[1] = VL53L8CX_METADATA_BH;
+	output[2] = VL53L8CX_COMMONDATA_BH;
+	output[3] = VL53L8CX_AMBIENT_RATE_BH;
+	output[4] = VL53L8CX_SPAD_COUNT_BH;
+	output[5] = VL53L8CX_NB_TARGET_DETECTED_BH;
+	output[6] = VL53L8CX_SIGNAL_RATE_BH;
+	output[7] = VL53L8CX_RANGE_SIGMA_MM_BH;
+	output[8] = VL53L8CX_DISTANCE_BH;
+	output[9] = VL53L8CX_REFLECTANCE_BH;
+	output[10] = VL53L8CX_TARGET_STATUS_BH;
+	output[11] = VL53L8CX_MOTION_DETECT_BH;
 
 	/* Enable selected outputs in the 'platform.h' file */
 #ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
@@ -581,7 +794,7 @@ uint8_t vl53l8cx_start_ranging(
 #endif
 
 	/* Update data size */
-	for (i = 0; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
+	for (i = 0; i < (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS; i++)
 	{
 		if ((output[i] == (uint8_t)0) 
                     || ((output_bh_enable[i/(uint32_t)32]
@@ -604,22 +817,41 @@ uint8_t vl53l8cx_start_ranging(
 				bh_ptr->size = (uint16_t)((uint16_t)resolution
                                   * (uint16_t)VL53L8CX_NB_TARGET_PER_ZONE);
 			}
-			p_dev->data_read_size += bh_ptr->type * bh_ptr->size;
+			p_dev->block_size[i] = (uint16_t)(bh_ptr->type * bh_ptr->size);
 		}
 		else
 		{
-			p_dev->data_read_size += bh_ptr->size;
+			p_dev->block_size[i] = (uint16_t)bh_ptr->size;
 		}
-		p_dev->data_read_size += (uint32_t)4;
+		p_dev->block_size[i] += (uint16_t)4;
+		p_dev->data_read_size += p_dev->block_size[i];
 	}
 	p_dev->data_read_size += (uint32_t)24;
+}
+
+uint8_t vl53l8cx_start_ranging(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t resolution, status = VL53L8CX_STATUS_OK;
+	uint16_t tmp;
+	uint32_t header_config[2] = {0, 0};
+	uint32_t output[VL53L8CX_NB_OUTPUT_BLOCKS];
+	uint32_t output_bh_enable[4];
+
+	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
+
+	status |= vl53l8cx_get_resolution(p_dev, &resolution);
+	p_dev->streamcount = 255;
+	p_dev->last_streamcount = 255;
+	p_dev->partial_read_count = 0;
+	_vl53l8cx_get_output_config(p_dev, resolution, output, output_bh_enable);
 
 	status |= vl53l8cx_dci_write_data(p_dev,
 			(uint8_t*)&(output), VL53L8CX_DCI_OUTPUT_LIST,
 			(uint16_t)sizeof(output));
 
 	header_config[0] = p_dev->data_read_size;
-	header_config[1] = i + (uint32_t)1;
+	header_config[1] = (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS + (uint32_t)1;
 
 	status |= vl53l8cx_dci_write_data(p_dev,
 			(uint8_t*)&(header_config), VL53L8CX_DCI_OUTPUT_CONFIG,
@@ -660,13 +892,20 @@ uint8_t vl53l8cx_start_ranging(
 	return status;
 }
 
-uint8_t vl53l8cx_stop_ranging(
-		VL53L8CX_Configuration		*p_dev)
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to request a MCU stop, unless the sensor is already stopped or auto-stop is
+ * enabled. '*p_is_stopping' is set to 1 when the GO2 status must be polled.
+ */
+
+static uint8_t _vl53l8cx_stop_request(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_is_stopping)
 {
-	uint8_t tmp = 0, status = VL53L8CX_STATUS_OK;
-	uint16_t timeout = 0;
+	uint8_t status = VL53L8CX_STATUS_OK;
 	uint32_t auto_stop_flag = 0;
 
+	*p_is_stopping = 0;
 	status |= VL53L8CX_RdMulti(&(p_dev->platform),
                           0x2FFC, (uint8_t*)&auto_stop_flag, 4);
 	if((auto_stop_flag != (uint32_t)0x4FF)
@@ -677,21 +916,21 @@ uint8_t vl53l8cx_stop_ranging(
 	        /* Provoke MCU stop */
 	        status |= VL53L8CX_WrByte(&(p_dev->platform), 0x15, 0x16);
 	        status |= VL53L8CX_WrByte(&(p_dev->platform), 0x14, 0x01);
+	        *p_is_stopping = 1;
+        }
 
-	        /* Poll for G02 status 0 MCU stop */
-	        while(((tmp & (uint8_t)0x80) >> 7) == (uint8_t)0x00)
-	        {
-	        	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x6, &tmp);
-	        	status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
-	        	timeout++;	/* Timeout reached after 5 seconds */
+	return status;
+}
 
-	        	if(timeout > (uint16_t)500)
-				{
-					status |= tmp;
-					break;
-				}
-        	}
-        }
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to check the GO2 status and to release the MCU once it is stopped.
+ */
+
+static uint8_t _vl53l8cx_stop_finish(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t tmp = 0, status = VL53L8CX_STATUS_OK;
 
 	/* Check GO2 status 1 if status is still OK */
 	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x6, &tmp);
@@ -714,6 +953,35 @@ uint8_t vl53l8cx_stop_ranging(
 	return status;
 }
 
+uint8_t vl53l8cx_stop_ranging(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t is_stopping, tmp = 0, status = VL53L8CX_STATUS_OK;
+	uint16_t timeout = 0;
+
+	status |= _vl53l8cx_stop_request(p_dev, &is_stopping);
+	if(is_stopping == (uint8_t)1)
+	{
+	        /* Poll for G02 status 0 MCU stop */
+	        while(((tmp & (uint8_t)0x80) >> 7) == (uint8_t)0x00)
+	        {
+	        	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x6, &tmp);
+	        	status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
+	        	timeout++;	/* Timeout reached after 5 seconds */
+
+	        	if(timeout > (uint16_t)500)
+				{
+					status |= tmp;
+					break;
+				}
+        	}
+        }
+
+	status |= _vl53l8cx_stop_finish(p_dev);
+
+	return status;
+}
+
 uint8_t vl53l8cx_check_data_ready(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t				*p_isReady)
@@ -745,196 +1013,724 @@ uint8_t vl53l8cx_check_data_ready(
 	return status;
 }
 
-uint8_t vl53l8cx_get_ranging_data(
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+#if VL53L8CX_NB_TARGET_PER_ZONE == 1U
+
+/**
+ * @brief Inner function, not available outside this file. This function loads
+ * 8 bytes into a 64 bits word, byte 0 into the low bits. The compiler turns
+ * the copy into a single load, swapped on big endian hosts.
+ */
+
+static uint64_t _vl53l8cx_load_bytes(
+		const uint8_t			*p_bytes)
+{
+	uint64_t word;
+
+	(void)memcpy(&word, p_bytes, sizeof(word));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	word = __builtin_bswap64(word);
+#endif
+
+	return word;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function sets
+ * the high bit of each byte of a word which is not 0, and clears all other
+ * bits. There is no carry between bytes, so the result is exact.
+ */
+
+static uint64_t _vl53l8cx_nonzero_bytes(
+		uint64_t			word)
+{
+	const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+
+	return (((word & low7) + low7) | word) & ~low7;
+}
+
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+
+/**
+ * @brief Inner function, not available outside this file. This function gives
+ * the index of the lowest bit set of a non zero mask (de Bruijn sequence).
+ */
+
+static uint8_t _vl53l8cx_lowest_bit(
+		uint64_t			mask)
+{
+	static const uint8_t index[64] = {
+		0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6};
+
+	return index[((mask & (~mask + 1ULL)) * 0x03F79D71B4CB0A89ULL) >> 58];
+}
+
+#endif
+#endif
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to copy one results block from the temporary buffer into the results
+ * structure, and to convert it into the user format.
+ * @return (uint32_t) msize : Size of the block data, header excluded.
+ */
+
+static uint32_t _vl53l8cx_decode_block(
 		VL53L8CX_Configuration		*p_dev,
-		VL53L8CX_ResultsData		*p_results)
+		VL53L8CX_ResultsData		*p_results,
+		uint32_t			i,
+		uint16_t			*p_decoded)
 {
-	uint8_t status = VL53L8CX_STATUS_OK;
-	uint16_t header_id, footer_id;
 	union Block_header *bh_ptr;
-	uint32_t i, j, msize;
-	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
-			p_dev->temp_buffer, p_dev->data_read_size);
-	p_dev->streamcount = p_dev->temp_buffer[0];
-	VL53L8CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
+	uint32_t msize;
+#ifndef VL53L8CX_USE_RAW_FORMAT
+	uint32_t j;
+#endif
 
-	/* Start conversion at position 16 to avoid headers */
-	for (i = (uint32_t)16; i 
-             < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
-	{
-		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
-		if ((bh_ptr->type > (uint32_t)0x1) 
+	bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
+	if ((bh_ptr->type > (uint32_t)0x1) 
                     && (bh_ptr->type < (uint32_t)0xd))
-		{
-			msize = bh_ptr->type * bh_ptr->size;
-		}
-		else
-		{
-			msize = bh_ptr->size;
-		}
+	{
+		msize = bh_ptr->type * bh_ptr->size;
+	}
+	else
+	{
+		msize = bh_ptr->size;
+	}
 
-		switch(bh_ptr->idx){
-			case VL53L8CX_METADATA_IDX:
-				p_results->silicon_temp_degc =
-						(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
-				break;
+	switch(bh_ptr->idx){
+		case VL53L8CX_METADATA_IDX:
+			p_results->silicon_temp_degc =
+					(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
+			break;
 
 #ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
-			case VL53L8CX_AMBIENT_RATE_IDX:
-				(void)memcpy(p_results->ambient_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_AMBIENT_RATE_IDX:
+			(void)memcpy(p_results->ambient_per_spad,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < (msize / (uint32_t)4); j++)
+			{
+				p_results->ambient_per_spad[j] /= (uint32_t)2048;
+			}
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_AMBIENT_PER_SPAD;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
-			case VL53L8CX_SPAD_COUNT_IDX:
-				(void)memcpy(p_results->nb_spads_enabled,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_SPAD_COUNT_IDX:
+			(void)memcpy(p_results->nb_spads_enabled,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+			*p_decoded |= VL53L8CX_OUTPUT_NB_SPADS_ENABLED;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
-			case VL53L8CX_NB_TARGET_DETECTED_IDX:
-				(void)memcpy(p_results->nb_target_detected,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_NB_TARGET_DETECTED_IDX:
+			(void)memcpy(p_results->nb_target_detected,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+			*p_decoded |= VL53L8CX_OUTPUT_NB_TARGET_DETECTED;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
-			case VL53L8CX_SIGNAL_RATE_IDX:
-				(void)memcpy(p_results->signal_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_SIGNAL_RATE_IDX:
+			(void)memcpy(p_results->signal_per_spad,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < (msize / (uint32_t)4); j++)
+			{
+				p_results->signal_per_spad[j] /= (uint32_t)2048;
+			}
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_SIGNAL_PER_SPAD;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
-			case VL53L8CX_RANGE_SIGMA_MM_IDX:
-				(void)memcpy(p_results->range_sigma_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_RANGE_SIGMA_MM_IDX:
+			(void)memcpy(p_results->range_sigma_mm,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < (msize / (uint32_t)2); j++)
+			{
+				p_results->range_sigma_mm[j] /= (uint16_t)128;
+			}
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_RANGE_SIGMA_MM;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_DISTANCE_MM
-			case VL53L8CX_DISTANCE_IDX:
-				(void)memcpy(p_results->distance_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_DISTANCE_IDX:
+			(void)memcpy(p_results->distance_mm,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < (msize / (uint32_t)2); j++)
+			{
+				p_results->distance_mm[j] /= 4;
+			}
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_DISTANCE_MM;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
-			case VL53L8CX_REFLECTANCE_EST_PC_IDX:
-				(void)memcpy(p_results->reflectance,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX:
+			(void)memcpy(p_results->reflectance,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < msize; j++)
+			{
+				p_results->reflectance[j] /= (uint8_t)2;
+			}
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_REFLECTANCE_PERCENT;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_TARGET_STATUS
-			case VL53L8CX_TARGET_STATUS_IDX:
-				(void)memcpy(p_results->target_status,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_TARGET_STATUS_IDX:
+			(void)memcpy(p_results->target_status,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+			/* Number of targets and distances come before the
+			 * status into the frame, so they are already decoded */
+			(void)vl53l8cx_update_validity(p_results, (uint8_t)(msize
+				/ (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE));
+#endif
+			*p_decoded |= VL53L8CX_OUTPUT_TARGET_STATUS;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-			case VL53L8CX_MOTION_DETEC_IDX:
-				(void)memcpy(&p_results->motion_indicator,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+		case VL53L8CX_MOTION_DETEC_IDX:
+			(void)memcpy(&p_results->motion_indicator,
+			&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+#ifndef VL53L8CX_USE_RAW_FORMAT
+			for(j = 0; j < (uint32_t)32; j++)
+			{
+				p_results->motion_indicator.motion[j] /= (uint32_t)65535;
+			}
 #endif
-			default:
-				break;
-		}
-		i += msize;
+			*p_decoded |= VL53L8CX_OUTPUT_MOTION_INDICATOR;
+			break;
+#endif
+		default:
+			break;
 	}
 
-#ifndef VL53L8CX_USE_RAW_FORMAT
+	return msize;
+}
 
-	/* Convert data into their real format */
-#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
-	for(i = 0; i < (uint32_t)VL53L8CX_RESOLUTION_8X8; i++)
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to update the frames accounting with the streamcount of the frame just read
+ * (raw byte 0 of the temporary buffer). It must be called before
+ * p_dev->streamcount is updated. The firmware never publishes a streamcount of
+ * 255, so increments are computed modulo 255.
+ */
+
+static void _vl53l8cx_account_frame(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t sc = p_dev->temp_buffer[0];
+	uint32_t delta;
+
+	p_dev->frame_stats.frames_received++;
+	if(sc == (uint8_t)255)
 	{
-		p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		return;
 	}
-#endif
 
-	for(i = 0; i < (uint32_t)(VL53L8CX_RESOLUTION_8X8
-			*VL53L8CX_NB_TARGET_PER_ZONE); i++)
+	/* p_dev->streamcount is only ahead of last_streamcount when
+	 * vl53l8cx_check_data_ready() signalled a frame. Reading another one
+	 * means the signalled frame was replaced before being read */
+	if((p_dev->streamcount != p_dev->last_streamcount)
+	   && (p_dev->streamcount != (uint8_t)255)
+	   && (p_dev->streamcount != sc))
 	{
-#ifndef VL53L8CX_DISABLE_DISTANCE_MM
-		p_results->distance_mm[i] /= 4;
-#endif
-#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
-		p_results->reflectance[i] /= (uint8_t)2;
-#endif
-#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
-		p_results->range_sigma_mm[i] /= (uint16_t)128;
-#endif
-#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
-		p_results->signal_per_spad[i] /= (uint32_t)2048;
-#endif
+		p_dev->frame_stats.frames_late++;
 	}
 
-	/* Set target status to 255 if no target is detected for this zone */
-#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
-	for(i = 0; i < (uint32_t)VL53L8CX_RESOLUTION_8X8; i++)
+	if(p_dev->last_streamcount != (uint8_t)255)
 	{
-		if(p_results->nb_target_detected[i] == (uint8_t)0){
-			for(j = 0; j < (uint32_t)
-				VL53L8CX_NB_TARGET_PER_ZONE; j++)
-			{
-#ifndef VL53L8CX_DISABLE_TARGET_STATUS
-				p_results->target_status
-				[((uint32_t)VL53L8CX_NB_TARGET_PER_ZONE
-					*(uint32_t)i) + j]=(uint8_t)255;
-#endif
-			}
+		delta = ((uint32_t)sc + (uint32_t)255
+			- (uint32_t)p_dev->last_streamcount) % (uint32_t)255;
+		if(delta > (uint32_t)1)
+		{
+			p_dev->frame_stats.frames_dropped += delta - (uint32_t)1;
 		}
 	}
-#endif
+	p_dev->last_streamcount = sc;
+}
 
-#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-	for(i = 0; i < (uint32_t)32; i++)
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to read a full results frame into the temporary buffer.
+ */
+
+static uint8_t _vl53l8cx_read_full_frame(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, p_dev->data_read_size);
+	if(status == (uint8_t)VL53L8CX_STATUS_OK)
 	{
-		p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		_vl53l8cx_account_frame(p_dev);
 	}
-#endif
+	p_dev->streamcount = p_dev->temp_buffer[0];
+	VL53L8CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
+	p_dev->fetched_outputs = VL53L8CX_OUTPUT_ALL;
 
-#endif
+	return status;
+}
 
-	/* Check if footer id and header id are matching. This allows to detect
-	 * corrupted frames */
-	header_id = ((uint16_t)(p_dev->temp_buffer[0x8])<<8) & 0xFF00U;
-	header_id |= ((uint16_t)(p_dev->temp_buffer[0x9])) & 0x00FFU;
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to find the position of the first output block following the common-data.
+ * Headers must already be into the temporary buffer.
+ * @return (uint32_t) position : Position of the block, or 0 if not found.
+ */
 
-	footer_id = ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)4]) << 8) & 0xFF00U;
-	footer_id |= ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)3])) & 0xFFU;
+static uint32_t _vl53l8cx_find_payload(
+		VL53L8CX_Configuration		*p_dev)
+{
+	union Block_header *bh_ptr;
+	uint32_t i, msize;
 
-	if(header_id != footer_id)
+	for (i = (uint32_t)16; i < (uint32_t)VL53L8CX_PARTIAL_HEADER_SIZE;
+			i+=(uint32_t)4)
 	{
-		status |= VL53L8CX_STATUS_CORRUPTED_FRAME;
+		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
+		msize = bh_ptr->size;
+		if(bh_ptr->idx == (uint16_t)(VL53L8CX_COMMONDATA_BH >> 16))
+		{
+			return i + (uint32_t)4 + msize;
+		}
+		i += msize;
 	}
 
-	return status;
+	return 0;
 }
 
-uint8_t vl53l8cx_get_resolution(
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to read a frame in 2 phases: headers first, then the blocks selected by
+ * 'output_mask' and the footer. Contiguous blocks are merged into a single
+ * bus read. Data are placed at the same position than for a full frame.
+ */
+
+static uint8_t _vl53l8cx_read_partial_frame(
 		VL53L8CX_Configuration		*p_dev,
-		uint8_t				*p_resolution)
+		uint16_t			output_mask)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
+	uint32_t i, pos, start, end, size;
 
-	status |= vl53l8cx_dci_read_data(p_dev, p_dev->temp_buffer,
-			VL53L8CX_DCI_ZONE_CONFIG, 8);
-	*p_resolution = p_dev->temp_buffer[0x00]*p_dev->temp_buffer[0x01];
+	/* Phase 1 : headers, meta-data and common-data */
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, VL53L8CX_PARTIAL_HEADER_SIZE);
+	if(status == (uint8_t)VL53L8CX_STATUS_OK)
+	{
+		_vl53l8cx_account_frame(p_dev);
+	}
+	p_dev->streamcount = p_dev->temp_buffer[0];
+	VL53L8CX_SwapBuffer(p_dev->temp_buffer, VL53L8CX_PARTIAL_HEADER_SIZE);
+	p_dev->fetched_outputs = 0;
 
-	return status;
-}
+	pos = _vl53l8cx_find_payload(p_dev);
+	if((status != (uint8_t)0) || (pos == (uint32_t)0))
+	{
+		return status | VL53L8CX_STATUS_ERROR;
+	}
 
+	/* Phase 2 : selected blocks, then footer. Blocks follow the order of
+	 * the output list programmed by vl53l8cx_start_ranging() */
+	start = 0;
+	end = 0;
+	for (i = 3; i <= (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS; i++)
+	{
+		if(i < (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS)
+		{
+			size = p_dev->block_size[i];
+			if((size == (uint32_t)0)
+				|| ((output_mask & ((uint32_t)1 << i)) == (uint32_t)0))
+			{
+				pos += size;
+				continue;
+			}
+			p_dev->fetched_outputs |= (uint16_t)((uint32_t)1 << i);
+		}
+		else
+		{
+			/* Footer */
+			pos = p_dev->data_read_size - (uint32_t)4;
+			size = 4;
+		}
 
+		if((end != (uint32_t)0)
+		   && ((pos - end) > (uint32_t)VL53L8CX_PARTIAL_MERGE_GAP))
+		{
+			status |= VL53L8CX_RdMulti(&(p_dev->platform),
+					(uint16_t)start, &(p_dev->temp_buffer[start]),
+					end - start);
+			VL53L8CX_SwapBuffer(&(p_dev->temp_buffer[start]),
+					(uint16_t)(end - start));
+			end = 0;
+		}
 
-uint8_t vl53l8cx_set_resolution(
-		VL53L8CX_Configuration 		 *p_dev,
-		uint8_t				resolution)
-{
-	uint8_t status = VL53L8CX_STATUS_OK;
+		if(end == (uint32_t)0)
+		{
+			start = pos;
+		}
+		end = pos + size;
+		pos += size;
+	}
 
-	switch(resolution){
-		case VL53L8CX_RESOLUTION_4X4:
-			status |= vl53l8cx_dci_read_data(p_dev,
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), (uint16_t)start,
+			&(p_dev->temp_buffer[start]), end - start);
+	VL53L8CX_SwapBuffer(&(p_dev->temp_buffer[start]),
+			(uint16_t)(end - start));
+
+	return status;
+}
+
+uint8_t vl53l8cx_read_ranging_data(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if((p_dev->partial_read_mask == (uint16_t)0)
+	   || ((p_dev->full_read_period != (uint8_t)0)
+	       && (p_dev->partial_read_count >= p_dev->full_read_period)))
+	{
+		p_dev->partial_read_count = 0;
+		status |= _vl53l8cx_read_full_frame(p_dev);
+	}
+	else
+	{
+		p_dev->partial_read_count++;
+		status |= _vl53l8cx_read_partial_frame(p_dev,
+				p_dev->partial_read_mask);
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_decode_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint16_t header_id, footer_id, decoded = 0;
+	uint32_t i, pos;
+#ifndef VL53L8CX_USE_RAW_FORMAT
+	uint32_t j;
+#endif
+
+	if(p_dev->fetched_outputs == VL53L8CX_OUTPUT_ALL)
+	{
+		/* Start conversion at position 16 to avoid headers */
+		for (i = (uint32_t)16; i 
+	             < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
+		{
+			i += _vl53l8cx_decode_block(p_dev, p_results, i, &decoded);
+		}
+	}
+	else
+	{
+		/* Decode meta-data, then only the fetched blocks */
+		pos = _vl53l8cx_find_payload(p_dev);
+		for (i = (uint32_t)16; i < pos; i+=(uint32_t)4)
+		{
+			i += _vl53l8cx_decode_block(p_dev, p_results, i, &decoded);
+		}
+
+		for (i = 3; i < (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS; i++)
+		{
+			if((p_dev->fetched_outputs & ((uint32_t)1 << i))
+			   != (uint32_t)0)
+			{
+				(void)_vl53l8cx_decode_block(p_dev, p_results,
+						pos, &decoded);
+			}
+			pos += p_dev->block_size[i];
+		}
+	}
+
+#ifndef VL53L8CX_USE_RAW_FORMAT
+
+	/* Set target status to 255 if no target is detected for this zone */
+#if !defined(VL53L8CX_DISABLE_NB_TARGET_DETECTED) \
+	&& !defined(VL53L8CX_DISABLE_TARGET_STATUS)
+	if((decoded & VL53L8CX_OUTPUT_TARGET_STATUS) != (uint16_t)0)
+	{
+		for(i = 0; i < (uint32_t)VL53L8CX_RESOLUTION_8X8; i++)
+		{
+			if(p_results->nb_target_detected[i] == (uint8_t)0){
+				for(j = 0; j < (uint32_t)
+					VL53L8CX_NB_TARGET_PER_ZONE; j++)
+				{
+					p_results->target_status
+					[((uint32_t)VL53L8CX_NB_TARGET_PER_ZONE
+						*(uint32_t)i) + j]=(uint8_t)255;
+				}
+			}
+		}
+	}
+#else
+	(void)j;
+#endif
+
+#endif
+
+	/* Check if footer id and header id are matching. This allows to detect
+	 * corrupted frames */
+	header_id = ((uint16_t)(p_dev->temp_buffer[0x8])<<8) & 0xFF00U;
+	header_id |= ((uint16_t)(p_dev->temp_buffer[0x9])) & 0x00FFU;
+
+	footer_id = ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
+		- (uint32_t)4]) << 8) & 0xFF00U;
+	footer_id |= ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
+		- (uint32_t)3])) & 0xFFU;
+
+	if(header_id != footer_id)
+	{
+		p_dev->frame_stats.frames_corrupted++;
+		status |= VL53L8CX_STATUS_CORRUPTED_FRAME;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_get_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= vl53l8cx_read_ranging_data(p_dev);
+	if(status == (uint8_t)VL53L8CX_STATUS_OK)
+	{
+		status |= vl53l8cx_decode_ranging_data(p_dev, p_results);
+	}
+
+	if(status == (uint8_t)VL53L8CX_STATUS_CORRUPTED_FRAME)
+	{
+		status = vl53l8cx_reread_ranging_data(p_dev, p_results);
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_reread_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint8_t i, status = VL53L8CX_STATUS_CORRUPTED_FRAME;
+
+	if(p_dev->max_frame_rereads == (uint8_t)0)
+	{
+		return status;
+	}
+
+	for(i = 0; (i < p_dev->max_frame_rereads)
+	    && (status == (uint8_t)VL53L8CX_STATUS_CORRUPTED_FRAME); i++)
+	{
+		p_dev->frame_stats.rereads++;
+
+		/* Same read mode than the corrupted frame, without moving the
+		 * full read period */
+		if(p_dev->fetched_outputs == VL53L8CX_OUTPUT_ALL)
+		{
+			status = _vl53l8cx_read_full_frame(p_dev);
+		}
+		else
+		{
+			status = _vl53l8cx_read_partial_frame(p_dev,
+					p_dev->partial_read_mask);
+		}
+
+		if(status == (uint8_t)VL53L8CX_STATUS_OK)
+		{
+			status = vl53l8cx_decode_ranging_data(p_dev, p_results);
+		}
+	}
+
+	if(status == (uint8_t)VL53L8CX_STATUS_OK)
+	{
+		p_dev->frame_stats.rereads_recovered++;
+	}
+	else
+	{
+		p_dev->frame_stats.rereads_exhausted++;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_set_frame_rereads(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				max_rereads)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if(max_rereads > VL53L8CX_MAX_FRAME_REREADS)
+	{
+		status |= VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->max_frame_rereads = max_rereads;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_set_partial_read(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			output_mask,
+		uint8_t				full_read_period)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if((output_mask & (uint16_t)~VL53L8CX_OUTPUT_ALL) != (uint16_t)0)
+	{
+		status |= VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		/* Target status needs the number of targets to flag empty zones */
+		if((output_mask & VL53L8CX_OUTPUT_TARGET_STATUS) != (uint16_t)0)
+		{
+			output_mask |= VL53L8CX_OUTPUT_NB_TARGET_DETECTED;
+		}
+		p_dev->partial_read_mask = output_mask;
+		p_dev->full_read_period = full_read_period;
+		p_dev->partial_read_count = 0;
+	}
+
+	return status;
+}
+
+#ifndef VL53L8CX_DISABLE_VALIDITY_MASK
+
+uint8_t vl53l8cx_update_validity(
+		VL53L8CX_ResultsData		*p_results,
+		uint8_t				nb_zones)
+{
+	uint64_t valid, mask = 0;
+	uint32_t i;
+#if VL53L8CX_NB_TARGET_PER_ZONE == 1U
+	const uint64_t ones = 0x0101010101010101ULL;
+	uint64_t status;
+#else
+	uint8_t target_status;
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	int16_t distance, nearest = VL53L8CX_NO_VALID_DISTANCE;
+#endif
+
+	if((nb_zones != VL53L8CX_RESOLUTION_4X4)
+	   && (nb_zones != VL53L8CX_RESOLUTION_8X8))
+	{
+		return VL53L8CX_STATUS_INVALID_PARAM;
+	}
+
+#if VL53L8CX_NB_TARGET_PER_ZONE == 1U
+	/* 8 zones per word: a byte is valid when its status is neither
+	 * different from 5 nor from 9, and when the zone has a target */
+	for(i = 0; i < (uint32_t)nb_zones; i += (uint32_t)8)
+	{
+		status = _vl53l8cx_load_bytes(&p_results->target_status[i]);
+		valid = ~(_vl53l8cx_nonzero_bytes(status ^ (ones * (uint64_t)5))
+			& _vl53l8cx_nonzero_bytes(status ^ (ones * (uint64_t)9)));
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+		valid &= _vl53l8cx_nonzero_bytes(_vl53l8cx_load_bytes(
+				&p_results->nb_target_detected[i]));
+#endif
+		/* Gather the high bit of each byte, byte k into bit k */
+		valid = (((valid >> 7) & ones) * 0x0102040810204080ULL) >> 56;
+		mask |= valid << i;
+	}
+#else
+	for(i = 0; i < (uint32_t)nb_zones; i++)
+	{
+		target_status = p_results->target_status[
+			(uint32_t)VL53L8CX_NB_TARGET_PER_ZONE * i];
+		valid = (uint64_t)((target_status == (uint8_t)5)
+			|| (target_status == (uint8_t)9));
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+		valid &= (uint64_t)(p_results->nb_target_detected[i]
+			!= (uint8_t)0);
+#endif
+		mask |= valid << i;
+	}
+#endif
+	p_results->valid_mask = mask;
+
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	/* Only valid zones are visited */
+	while(mask != (uint64_t)0)
+	{
+		i = _vl53l8cx_lowest_bit(mask);
+		distance = p_results->distance_mm[
+			(uint32_t)VL53L8CX_NB_TARGET_PER_ZONE * i];
+		if(distance < nearest)
+		{
+			nearest = distance;
+		}
+		mask &= mask - (uint64_t)1;
+	}
+	p_results->nearest_valid_mm = nearest;
+#endif
+
+	return VL53L8CX_STATUS_OK;
+}
+
+#endif
+
+uint8_t vl53l8cx_get_frame_stats(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_FrameStats		*p_stats)
+{
+	(void)memcpy(p_stats, &(p_dev->frame_stats), sizeof(*p_stats));
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_reset_frame_stats(
+		VL53L8CX_Configuration		*p_dev)
+{
+	(void)memset(&(p_dev->frame_stats), 0, sizeof(p_dev->frame_stats));
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_get_resolution(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	status |= vl53l8cx_dci_read_data(p_dev, p_dev->temp_buffer,
+			VL53L8CX_DCI_ZONE_CONFIG, 8);
+	*p_resolution = p_dev->temp_buffer[0x00]*p_dev->temp_buffer[0x01];
+
+	return status;
+}
+
+
+
+uint8_t vl53l8cx_set_resolution(
+		VL53L8CX_Configuration 		 *p_dev,
+		uint8_t				resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	switch(resolution){
+		case VL53L8CX_RESOLUTION_4X4:
+			status |= vl53l8cx_dci_read_data(p_dev,
 					p_dev->temp_buffer,
 					VL53L8CX_DCI_DSS_CONFIG, 16);
 			p_dev->temp_buffer[0x04] = 64;
@@ -1269,12 +2065,7 @@ uint8_t vl53l8cx_dci_read_data(
 		uint32_t			index,
 		uint16_t			data_size)
 {
-	int16_t i;
 	uint8_t status = VL53L8CX_STATUS_OK;
-        uint32_t rd_size = (uint32_t) data_size + (uint32_t)12;
-	uint8_t cmd[] = {0x00, 0x00, 0x00, 0x00,
-			0x00, 0x00, 0x00, 0x0f,
-			0x00, 0x02, 0x00, 0x08};
 
 	/* Check if tmp buffer is large enough */
 	if((data_size + (uint16_t)12)>(uint16_t)VL53L8CX_TEMPORARY_BUFFER_SIZE)
@@ -1283,27 +2074,13 @@ uint8_t vl53l8cx_dci_read_data(
 	}
 	else
 	{
-		cmd[0] = (uint8_t)(index >> 8);	
-		cmd[1] = (uint8_t)(index & (uint32_t)0xff);			
-		cmd[2] = (uint8_t)((data_size & (uint16_t)0xff0) >> 4);
-		cmd[3] = (uint8_t)((data_size & (uint16_t)0xf) << 4);
-
 	/* Request data reading from FW */
-		status |= VL53L8CX_WrMulti(&(p_dev->platform),
-			(VL53L8CX_UI_CMD_END-(uint16_t)11),cmd, sizeof(cmd));
+		status |= _vl53l8cx_dci_read_request(p_dev, index, data_size);
 		status |= _vl53l8cx_poll_for_answer(p_dev, 4, 1,
 			VL53L8CX_UI_CMD_STATUS,
 			0xff, 0x03);
 
-	/* Read new data sent (4 bytes header + data_size + 8 bytes footer) */
-		status |= VL53L8CX_RdMulti(&(p_dev->platform), VL53L8CX_UI_CMD_START,
-			p_dev->temp_buffer, rd_size);
-		VL53L8CX_SwapBuffer(p_dev->temp_buffer, data_size + (uint16_t)12);
-
-	/* Copy data from FW into input structure (-4 bytes to remove header) */
-		for(i = 0 ; i < (int16_t)data_size;i++){
-			data[i] = p_dev->temp_buffer[i + 4];
-		}
+		status |= _vl53l8cx_dci_read_answer(p_dev, data, data_size);
 	}
 
 	return status;
@@ -1316,15 +2093,6 @@ uint8_t vl53l8cx_dci_write_data(
 		uint16_t			data_size)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
-	int16_t i;
-
-	uint8_t headers[] = {0x00, 0x00, 0x00, 0x00};
-	uint8_t footer[] = {0x00, 0x00, 0x00, 0x0f, 0x05, 0x01,
-			(uint8_t)((data_size + (uint16_t)8) >> 8), 
-			(uint8_t)((data_size + (uint16_t)8) & (uint8_t)0xFF)};
-
-	uint16_t address = (uint16_t)VL53L8CX_UI_CMD_END -
-		(data_size + (uint16_t)12) + (uint16_t)1;
 
 	/* Check if cmd buffer is large enough */
 	if((data_size + (uint16_t)12) 
@@ -1334,31 +2102,10 @@ uint8_t vl53l8cx_dci_write_data(
 	}
 	else
 	{
-		headers[0] = (uint8_t)(index >> 8);
-		headers[1] = (uint8_t)(index & (uint32_t)0xff);
-		headers[2] = (uint8_t)(((data_size & (uint16_t)0xff0) >> 4));
-		headers[3] = (uint8_t)((data_size & (uint16_t)0xf) << 4);
-
-	/* Copy data from structure to FW format (+4 bytes to add header) */
-		VL53L8CX_SwapBuffer(data, data_size);
-		for(i = (int16_t)data_size - (int16_t)1 ; i >= 0; i--)
-		{
-			p_dev->temp_buffer[i + 4] = data[i];
-		}
-
-	/* Add headers and footer */
-		(void)memcpy(&p_dev->temp_buffer[0], headers, sizeof(headers));
-		(void)memcpy(&p_dev->temp_buffer[data_size + (uint16_t)4],
-			footer, sizeof(footer));
-
-	/* Send data to FW */
-		status |= VL53L8CX_WrMulti(&(p_dev->platform),address,
-			p_dev->temp_buffer,
-			(uint32_t)((uint32_t)data_size + (uint32_t)12));
+		status |= _vl53l8cx_dci_write_request(p_dev, data, index,
+				data_size);
 		status |= _vl53l8cx_poll_for_answer(p_dev, 4, 1,
 			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
-
-		VL53L8CX_SwapBuffer(data, data_size);
 	}
 
 	return status;
@@ -1381,3 +2128,794 @@ uint8_t vl53l8cx_dci_replace_data(
 
 	return status;
 }
+
+/*
+ * Non-blocking operations. Each operation replays the sequence of the matching
+ * blocking function, split at each wait: the step function runs the sequence
+ * until the next wait, sets p_op->wake_ms and returns. Polls keep the period
+ * and the number of tries of the blocking functions.
+ */
+
+#define VL53L8CX_ASYNC_OP_NONE		((uint8_t) 0U)
+#define VL53L8CX_ASYNC_OP_INIT		((uint8_t) 1U)
+#define VL53L8CX_ASYNC_OP_START		((uint8_t) 2U)
+#define VL53L8CX_ASYNC_OP_STOP		((uint8_t) 3U)
+#define VL53L8CX_ASYNC_OP_DCI_READ	((uint8_t) 4U)
+#define VL53L8CX_ASYNC_OP_DCI_WRITE	((uint8_t) 5U)
+
+/* Value of nb_polls once a poll is over, while waiting its last period */
+#define VL53L8CX_ASYNC_POLL_END		((uint16_t) 0xFFFFU)
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to prepare an operation.
+ */
+
+static void _vl53l8cx_async_begin(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				operation,
+		uint32_t			now_ms)
+{
+	(void)memset(p_op, 0, sizeof(*p_op));
+	p_op->p_dev = p_dev;
+	p_op->operation = operation;
+	p_op->wake_ms = now_ms;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to schedule the next step of an operation.
+ */
+
+static uint8_t _vl53l8cx_async_wait(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms,
+		uint32_t			delay_ms)
+{
+	p_op->step++;
+	p_op->wake_ms = now_ms + delay_ms;
+
+	return VL53L8CX_ASYNC_PENDING;
+}
+
+/**
+ * @brief Inner function, not available outside this file. Non-blocking version
+ * of _vl53l8cx_poll_for_answer(), with one read per call.
+ */
+
+static uint8_t _vl53l8cx_async_poll_for_answer(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms,
+		uint8_t				size,
+		uint8_t				pos,
+		uint16_t			address,
+		uint8_t				mask,
+		uint8_t				expected_value)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+
+	if(p_op->nb_polls == VL53L8CX_ASYNC_POLL_END)
+	{
+		p_op->nb_polls = 0;
+		return VL53L8CX_ASYNC_DONE;
+	}
+
+	p_op->status |= VL53L8CX_RdMulti(&(p_dev->platform), address,
+			p_dev->temp_buffer, size);
+
+	if(p_op->nb_polls >= (uint16_t)200)	/* 2s timeout */
+	{
+		p_op->status |= (uint8_t)VL53L8CX_STATUS_TIMEOUT_ERROR;
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+	else if((size >= (uint8_t)4)
+			&& (p_dev->temp_buffer[2] >= (uint8_t)0x7f))
+	{
+		p_op->status |= VL53L8CX_MCU_ERROR;
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+	else if((p_dev->temp_buffer[pos] & mask) == expected_value)
+	{
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+	else
+	{
+		p_op->nb_polls++;
+	}
+
+	p_op->wake_ms = now_ms + (uint32_t)10;
+	return VL53L8CX_ASYNC_PENDING;
+}
+
+/**
+ * @brief Inner function, not available outside this file. Non-blocking version
+ * of _vl53l8cx_poll_for_mcu_boot(), with one read per call.
+ */
+
+static uint8_t _vl53l8cx_async_poll_for_mcu_boot(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+	uint8_t go2_status0, go2_status1;
+
+	if(p_op->nb_polls == VL53L8CX_ASYNC_POLL_END)
+	{
+		p_op->nb_polls = 0;
+		return VL53L8CX_ASYNC_DONE;
+	}
+
+	p_op->status |= VL53L8CX_RdByte(&(p_dev->platform), 0x06, &go2_status0);
+	if((go2_status0 & (uint8_t)0x80) != (uint8_t)0){
+		p_op->status |= VL53L8CX_RdByte(&(p_dev->platform), 0x07,
+				&go2_status1);
+		if(go2_status1 & (uint8_t)0x01)
+		{
+			p_op->nb_polls = 0;
+			return VL53L8CX_ASYNC_DONE;
+		}
+	}
+
+	p_op->nb_polls++;
+	if(((go2_status0 & (uint8_t)0x1) != (uint8_t)0)
+			|| (p_op->nb_polls >= (uint16_t)500))
+	{
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+
+	p_op->wake_ms = now_ms + (uint32_t)1;
+	return VL53L8CX_ASYNC_PENDING;
+}
+
+/**
+ * @brief Inner function, not available outside this file. Non-blocking version
+ * of the GO2 status poll of vl53l8cx_stop_ranging(), with one read per call.
+ */
+
+static uint8_t _vl53l8cx_async_poll_for_stop(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+	uint8_t tmp = 0;
+
+	if(p_op->nb_polls == VL53L8CX_ASYNC_POLL_END)
+	{
+		p_op->nb_polls = 0;
+		return VL53L8CX_ASYNC_DONE;
+	}
+
+	p_op->status |= VL53L8CX_RdByte(&(p_dev->platform), 0x6, &tmp);
+	p_op->nb_polls++;	/* Timeout reached after 5 seconds */
+	if(p_op->nb_polls > (uint16_t)500)
+	{
+		p_op->status |= tmp;
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+	else if((tmp & (uint8_t)0x80) != (uint8_t)0)
+	{
+		p_op->nb_polls = VL53L8CX_ASYNC_POLL_END;
+	}
+	else
+	{
+		/* Keep polling */
+	}
+
+	p_op->wake_ms = now_ms + (uint32_t)10;
+	return VL53L8CX_ASYNC_PENDING;
+}
+
+/**
+ * @brief Inner function, not available outside this file. Non-blocking version
+ * of vl53l8cx_dci_read_data() and vl53l8cx_dci_write_data(). Parameters are
+ * only used by the first call, and by the last one for the read data.
+ */
+
+static uint8_t _vl53l8cx_async_dci(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms,
+		uint8_t				is_write,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+
+	if(p_op->dci_step == (uint8_t)0)
+	{
+		/* Check if tmp buffer is large enough */
+		if((data_size + (uint16_t)12)
+				> (uint16_t)VL53L8CX_TEMPORARY_BUFFER_SIZE)
+		{
+			p_op->status |= VL53L8CX_STATUS_ERROR;
+			return VL53L8CX_ASYNC_DONE;
+		}
+
+		if(is_write != (uint8_t)0)
+		{
+			p_op->status |= _vl53l8cx_dci_write_request(p_dev, data,
+					index, data_size);
+		}
+		else
+		{
+			p_op->status |= _vl53l8cx_dci_read_request(p_dev, index,
+					data_size);
+		}
+		p_op->dci_step = 1;
+	}
+
+	if(_vl53l8cx_async_poll_for_answer(p_op, now_ms, 4, 1,
+			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03)
+			== VL53L8CX_ASYNC_PENDING)
+	{
+		return VL53L8CX_ASYNC_PENDING;
+	}
+
+	if(is_write == (uint8_t)0)
+	{
+		p_op->status |= _vl53l8cx_dci_read_answer(p_dev, data,
+				data_size);
+	}
+	p_op->dci_step = 0;
+
+	return VL53L8CX_ASYNC_DONE;
+}
+
+/**
+ * @brief Inner function, not available outside this file. Steps of
+ * vl53l8cx_async_init(), following vl53l8cx_init().
+ */
+
+static uint8_t _vl53l8cx_async_init_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+	uint8_t pipe_ctrl[] = {VL53L8CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
+	uint32_t single_range = 0x01;
+
+	for(;;)
+	{
+		switch(p_op->step)
+		{
+			case 0:
+				p_op->status |= _vl53l8cx_init_sw_reboot(p_dev);
+				return _vl53l8cx_async_wait(p_op, now_ms, 1);
+
+			case 1:
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x000F, 0x40);
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x000A, 0x01);
+				return _vl53l8cx_async_wait(p_op, now_ms, 100);
+
+			case 2:
+				/* Wait for sensor booted */
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x7fff, 0x00);
+				p_op->step++;
+				break;
+
+			case 3:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						1, 0, 0x06, 0xff, 1)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				if(p_op->status != (uint8_t)0)
+				{
+					return VL53L8CX_ASYNC_DONE;
+				}
+
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x000E, 0x01);
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x7fff, 0x02);
+
+				/* Enable FW access */
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x7fff, 0x01);
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x06, 0x01);
+				p_op->step++;
+				break;
+
+			case 4:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						1, 0, 0x21, 0xFF, 0x4)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+
+				/* Power on MCU and download FW into VL53L8CX */
+				p_op->status |= _vl53l8cx_init_download_fw(p_dev);
+				return _vl53l8cx_async_wait(p_op, now_ms, 5);
+
+			case 5:
+				p_op->status |= _vl53l8cx_init_reset_mcu(p_dev);
+				p_op->step++;
+				break;
+
+			case 6:
+				if(_vl53l8cx_async_poll_for_mcu_boot(p_op, now_ms)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				if(p_op->status != (uint8_t)0)
+				{
+					return VL53L8CX_ASYNC_DONE;
+				}
+
+				p_op->status |= _vl53l8cx_init_check_fw(p_dev);
+				if(p_op->status != (uint8_t)0)
+				{
+					return VL53L8CX_ASYNC_DONE;
+				}
+
+				/* Get offset NVM data */
+				p_op->status |= VL53L8CX_WrMulti(&(p_dev->platform),
+						0x2fd8, (uint8_t*)VL53L8CX_GET_NVM_CMD,
+						sizeof(VL53L8CX_GET_NVM_CMD));
+				p_op->step++;
+				break;
+
+			case 7:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						4, 0, VL53L8CX_UI_CMD_STATUS, 0xff, 2)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+
+				/* Store them into the offset buffer and send them */
+				p_op->status |= VL53L8CX_RdMulti(&(p_dev->platform),
+						VL53L8CX_UI_CMD_START, p_dev->temp_buffer,
+						VL53L8CX_NVM_DATA_SIZE);
+				p_op->status |= vl53l8cx_store_caldata(p_dev,
+						VL53L8CX_CALDATA_OFFSET,
+						p_dev->temp_buffer);
+				p_op->status |= _vl53l8cx_write_offset_data(p_dev,
+						VL53L8CX_RESOLUTION_4X4);
+				p_op->step++;
+				break;
+
+			case 8:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						4, 1, VL53L8CX_UI_CMD_STATUS, 0xff, 0x03)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+
+				/* Set default Xtalk shape. Send Xtalk to sensor */
+				p_op->status |= vl53l8cx_store_caldata(p_dev,
+						VL53L8CX_CALDATA_XTALK,
+						VL53L8CX_DEFAULT_XTALK);
+				p_op->status |= _vl53l8cx_write_xtalk_data(p_dev,
+						VL53L8CX_RESOLUTION_4X4);
+				p_op->step++;
+				break;
+
+			case 9:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						4, 1, VL53L8CX_UI_CMD_STATUS, 0xff, 0x03)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+
+				/* Send default configuration to VL53L8CX firmware */
+				p_op->status |= VL53L8CX_WrMulti(&(p_dev->platform),
+						0x2c34, p_dev->default_configuration,
+						sizeof(VL53L8CX_DEFAULT_CONFIGURATION));
+				p_op->step++;
+				break;
+
+			case 10:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						4, 1, VL53L8CX_UI_CMD_STATUS, 0xff, 0x03)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->step++;
+				break;
+
+			case 11:
+				if(_vl53l8cx_async_dci(p_op, now_ms, 1,
+						(uint8_t*)&pipe_ctrl,
+						VL53L8CX_DCI_PIPE_CONTROL,
+						(uint16_t)sizeof(pipe_ctrl))
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->step++;
+				break;
+
+#if VL53L8CX_NB_TARGET_PER_ZONE != 1
+			case 12:
+				if(_vl53l8cx_async_dci(p_op, now_ms, 0,
+						p_dev->temp_buffer,
+						VL53L8CX_DCI_FW_NB_TARGET, 16)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_dev->temp_buffer[0x0C] =
+					(uint8_t)VL53L8CX_NB_TARGET_PER_ZONE;
+				p_op->step++;
+				break;
+
+			case 13:
+				if(_vl53l8cx_async_dci(p_op, now_ms, 1,
+						p_dev->temp_buffer,
+						VL53L8CX_DCI_FW_NB_TARGET, 16)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->step++;
+				break;
+#else
+			case 12:
+			case 13:
+				p_op->step = 14;
+				break;
+#endif
+
+			case 14:
+				if(_vl53l8cx_async_dci(p_op, now_ms, 1,
+						(uint8_t*)&single_range,
+						VL53L8CX_DCI_SINGLE_RANGE,
+						(uint16_t)sizeof(single_range))
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				return VL53L8CX_ASYNC_DONE;
+
+			default:
+				return VL53L8CX_ASYNC_DONE;
+		}
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. Steps of
+ * vl53l8cx_async_start_ranging(), following vl53l8cx_start_ranging().
+ */
+
+static uint8_t _vl53l8cx_async_start_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+	uint8_t state;
+	uint16_t tmp;
+	uint32_t header_config[2] = {0, 0};
+	uint32_t output[VL53L8CX_NB_OUTPUT_BLOCKS];
+	uint32_t output_bh_enable[4];
+	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
+
+	for(;;)
+	{
+		switch(p_op->step)
+		{
+			case 0:
+				if(_vl53l8cx_async_dci(p_op, now_ms, 0,
+						p_dev->temp_buffer,
+						VL53L8CX_DCI_ZONE_CONFIG, 8)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->resolution = p_dev->temp_buffer[0x00]
+					* p_dev->temp_buffer[0x01];
+				p_dev->streamcount = 255;
+				p_dev->last_streamcount = 255;
+				p_dev->partial_read_count = 0;
+				p_op->step++;
+				break;
+
+			case 1:
+			case 2:
+			case 3:
+				/* Output configuration is rebuilt for each write, the
+				 * request only uses it on the first call */
+				_vl53l8cx_get_output_config(p_dev, p_op->resolution,
+						output, output_bh_enable);
+				header_config[0] = p_dev->data_read_size;
+				header_config[1] = (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS
+					+ (uint32_t)1;
+
+				if(p_op->step == (uint8_t)1)
+				{
+					state = _vl53l8cx_async_dci(p_op, now_ms, 1,
+						(uint8_t*)&(output),
+						VL53L8CX_DCI_OUTPUT_LIST,
+						(uint16_t)sizeof(output));
+				}
+				else if(p_op->step == (uint8_t)2)
+				{
+					state = _vl53l8cx_async_dci(p_op, now_ms, 1,
+						(uint8_t*)&(header_config),
+						VL53L8CX_DCI_OUTPUT_CONFIG,
+						(uint16_t)sizeof(header_config));
+				}
+				else
+				{
+					state = _vl53l8cx_async_dci(p_op, now_ms, 1,
+						(uint8_t*)&(output_bh_enable),
+						VL53L8CX_DCI_OUTPUT_ENABLES,
+						(uint16_t)sizeof(output_bh_enable));
+				}
+				if(state == VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->step++;
+				break;
+
+			case 4:
+				/* Start xshut bypass (interrupt mode) */
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x7fff, 0x00);
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x09, 0x05);
+				p_op->status |= VL53L8CX_WrByte(&(p_dev->platform),
+						0x7fff, 0x02);
+
+				/* Start ranging session */
+				p_op->status |= VL53L8CX_WrMulti(&(p_dev->platform),
+						VL53L8CX_UI_CMD_END - (uint16_t)(4 - 1),
+						(uint8_t*)cmd, sizeof(cmd));
+				p_op->step++;
+				break;
+
+			case 5:
+				if(_vl53l8cx_async_poll_for_answer(p_op, now_ms,
+						4, 1, VL53L8CX_UI_CMD_STATUS, 0xff, 0x03)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				p_op->step++;
+				break;
+
+			case 6:
+				/* Read ui range data content and compare if data
+				 * size is the correct one */
+				if(_vl53l8cx_async_dci(p_op, now_ms, 0,
+						p_dev->temp_buffer, 0x5440, 12)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				(void)memcpy(&tmp, &(p_dev->temp_buffer[0x8]),
+						sizeof(tmp));
+				if(tmp != p_dev->data_read_size)
+				{
+					p_op->status |= VL53L8CX_STATUS_ERROR;
+				}
+				p_op->step++;
+				break;
+
+			case 7:
+				/* Ensure that there is no laser safety fault */
+				if(_vl53l8cx_async_dci(p_op, now_ms, 0,
+						p_dev->temp_buffer, 0xE0C4, 8)
+						== VL53L8CX_ASYNC_PENDING)
+				{
+					return VL53L8CX_ASYNC_PENDING;
+				}
+				if((uint8_t)p_dev->temp_buffer[0x6] != (uint8_t)0)
+				{
+					p_op->status |= VL53L8CX_STATUS_LASER_SAFETY;
+				}
+				return VL53L8CX_ASYNC_DONE;
+
+			default:
+				return VL53L8CX_ASYNC_DONE;
+		}
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. Steps of
+ * vl53l8cx_async_stop_ranging(), following vl53l8cx_stop_ranging().
+ */
+
+static uint8_t _vl53l8cx_async_stop_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	VL53L8CX_Configuration *p_dev = p_op->p_dev;
+	uint8_t is_stopping;
+
+	if(p_op->step == (uint8_t)0)
+	{
+		p_op->status |= _vl53l8cx_stop_request(p_dev, &is_stopping);
+		p_op->step = (is_stopping == (uint8_t)1) ? 1 : 2;
+	}
+
+	/* Poll for G02 status 0 MCU stop */
+	if((p_op->step == (uint8_t)1) && (_vl53l8cx_async_poll_for_stop(
+			p_op, now_ms) == VL53L8CX_ASYNC_PENDING))
+	{
+		return VL53L8CX_ASYNC_PENDING;
+	}
+
+	p_op->status |= _vl53l8cx_stop_finish(p_dev);
+
+	return VL53L8CX_ASYNC_DONE;
+}
+
+uint8_t vl53l8cx_async_init(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms)
+{
+	_vl53l8cx_async_begin(p_op, p_dev, VL53L8CX_ASYNC_OP_INIT, now_ms);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_async_start_ranging(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms)
+{
+	_vl53l8cx_async_begin(p_op, p_dev, VL53L8CX_ASYNC_OP_START, now_ms);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_async_stop_ranging(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint32_t			now_ms)
+{
+	_vl53l8cx_async_begin(p_op, p_dev, VL53L8CX_ASYNC_OP_STOP, now_ms);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_async_dci_read_data(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint32_t			now_ms)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	_vl53l8cx_async_begin(p_op, p_dev, VL53L8CX_ASYNC_OP_DCI_READ,
+			now_ms);
+	if((data_size + (uint16_t)12)>(uint16_t)VL53L8CX_TEMPORARY_BUFFER_SIZE)
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+		p_op->operation = VL53L8CX_ASYNC_OP_NONE;
+		p_op->status = status;
+	}
+	p_op->p_data = data;
+	p_op->index = index;
+	p_op->data_size = data_size;
+
+	return status;
+}
+
+uint8_t vl53l8cx_async_dci_write_data(
+		VL53L8CX_AsyncOp		*p_op,
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint32_t			now_ms)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	_vl53l8cx_async_begin(p_op, p_dev, VL53L8CX_ASYNC_OP_DCI_WRITE,
+			now_ms);
+	if((data_size + (uint16_t)12)>(uint16_t)VL53L8CX_TEMPORARY_BUFFER_SIZE)
+	{
+		status |= VL53L8CX_STATUS_ERROR;
+		p_op->operation = VL53L8CX_ASYNC_OP_NONE;
+		p_op->status = status;
+	}
+	p_op->p_data = data;
+	p_op->index = index;
+	p_op->data_size = data_size;
+
+	return status;
+}
+
+uint8_t vl53l8cx_async_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	uint8_t state;
+
+	if(p_op->operation == VL53L8CX_ASYNC_OP_NONE)
+	{
+		return VL53L8CX_ASYNC_DONE;
+	}
+
+	/* Wrap-safe comparison, now_ms may overflow */
+	if((int32_t)(now_ms - p_op->wake_ms) < 0)
+	{
+		return VL53L8CX_ASYNC_PENDING;
+	}
+
+	switch(p_op->operation)
+	{
+		case VL53L8CX_ASYNC_OP_INIT:
+			state = _vl53l8cx_async_init_step(p_op, now_ms);
+			break;
+		case VL53L8CX_ASYNC_OP_START:
+			state = _vl53l8cx_async_start_step(p_op, now_ms);
+			break;
+		case VL53L8CX_ASYNC_OP_STOP:
+			state = _vl53l8cx_async_stop_step(p_op, now_ms);
+			break;
+		case VL53L8CX_ASYNC_OP_DCI_READ:
+			state = _vl53l8cx_async_dci(p_op, now_ms, 0,
+					p_op->p_data, p_op->index,
+					p_op->data_size);
+			break;
+		case VL53L8CX_ASYNC_OP_DCI_WRITE:
+			state = _vl53l8cx_async_dci(p_op, now_ms, 1,
+					p_op->p_data, p_op->index,
+					p_op->data_size);
+			break;
+		default:
+			state = VL53L8CX_ASYNC_DONE;
+			break;
+	}
+
+	if(state == VL53L8CX_ASYNC_DONE)
+	{
+		p_op->operation = VL53L8CX_ASYNC_OP_NONE;
+	}
+
+	return state;
+}
+
+uint8_t vl53l8cx_store_caldata(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				caldata,
+		const uint8_t			*p_data)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+#ifndef VL53L8CX_SHARED_BUFFERS
+	if(caldata == VL53L8CX_CALDATA_OFFSET)
+	{
+		(void)memmove(p_dev->offset_data, p_data,
+			VL53L8CX_OFFSET_BUFFER_SIZE);
+	}
+	else
+	{
+		(void)memmove(p_dev->xtalk_data, p_data,
+			VL53L8CX_XTALK_BUFFER_SIZE);
+	}
+#else
+	if(caldata == VL53L8CX_CALDATA_OFFSET)
+	{
+		status |= vl53l8cx_share_caldata(p_dev, &(p_dev->offset_data),
+			p_data, VL53L8CX_OFFSET_BUFFER_SIZE);
+	}
+	else
+	{
+		status |= vl53l8cx_share_caldata(p_dev, &(p_dev->xtalk_data),
+			p_data, VL53L8CX_XTALK_BUFFER_SIZE);
+	}
+#endif
+
+	return status;
+}
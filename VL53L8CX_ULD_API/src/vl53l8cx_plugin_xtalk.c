@@ -231,9 +231,9 @@ uint8_t vl53l8cx_calibrate_xtalk(
                                  (uint16_t)0x80) >> 7) == (uint16_t)1))
 				{
 					default_xtalk_ptr = p_dev->default_xtalk;
-					(void)memcpy(p_dev->xtalk_data, 
-						default_xtalk_ptr,
-						sizeof(p_dev->xtalk_data));
+					status |= vl53l8cx_store_caldata(p_dev,
+						VL53L8CX_CALDATA_XTALK,
+						default_xtalk_ptr);
 					status |= VL53L8CX_STATUS_XTALK_FAILED;
 				}
 				continue_loop = (uint8_t)0;
@@ -263,10 +263,11 @@ uint8_t vl53l8cx_calibrate_xtalk(
 			p_dev->temp_buffer, 
                         VL53L8CX_XTALK_BUFFER_SIZE + (uint16_t)4);
 
-	(void)memcpy(&(p_dev->xtalk_data[0]), &(p_dev->temp_buffer[8]),
-			VL53L8CX_XTALK_BUFFER_SIZE - (uint16_t)8);
-	(void)memcpy(&(p_dev->xtalk_data[VL53L8CX_XTALK_BUFFER_SIZE
-                       - (uint16_t)8]), footer, sizeof(footer));
+	/* Append the footer after the data, then store the whole buffer */
+	(void)memcpy(&(p_dev->temp_buffer[VL53L8CX_XTALK_BUFFER_SIZE]),
+			footer, sizeof(footer));
+	status |= vl53l8cx_store_caldata(p_dev, VL53L8CX_CALDATA_XTALK,
+			&(p_dev->temp_buffer[8]));
 
 	/* Reset default buffer */
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2c34,
@@ -322,7 +323,8 @@ uint8_t vl53l8cx_set_caldata_xtalk(
 	uint8_t resolution, status = VL53L8CX_STATUS_OK;
 
 	status |= vl53l8cx_get_resolution(p_dev, &resolution);
-	(void)memcpy(p_dev->xtalk_data, p_xtalk_data, VL53L8CX_XTALK_BUFFER_SIZE);
+	status |= vl53l8cx_store_caldata(p_dev, VL53L8CX_CALDATA_XTALK,
+			p_xtalk_data);
 	status |= vl53l8cx_set_resolution(p_dev, resolution);
 
 	return status;
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vl53l8cx_filter.h"
+#include "vl53l8cx_capture.h"
+#include "test_common.h"
+
+#define BENCH_NB_FRAMES		1024U
+#define BENCH_NB_ROUNDS		20U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x85EBCA6BU;
+
+/* Noise of about sigma_mm, from the sum of 4 uniform draws */
+static int32_t _bench_noise(
+		uint32_t			sigma_mm)
+{
+	int32_t sum = 0;
+	uint32_t i;
+
+	for (i = 0; i < 4U; i++)
+	{
+		sum += (int32_t)(test_random(&seed) % ((2U * sigma_mm) + 1U))
+			- (int32_t)sigma_mm;
+	}
+
+	return sum / 2;
+}
+
+/*
+ * Synthetic stream: a target moving back and forth between 500 and 2500 mm,
+ * sigma from 5 to 40 mm, and 5% of invalid zones. The true distance of each
+ * zone is kept to measure the error.
+ */
+static void _bench_frame(
+		VL53L8CX_ResultsData		*p_results,
+		int16_t				*p_truth,
+		uint32_t			frame,
+		uint8_t				is_moving)
+{
+	uint32_t zone, idx, sigma;
+	int32_t d;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		d = 1500;
+		if (is_moving)
+		{
+			d = 500 + (int32_t)((((frame + zone) / 200U) % 2U)
+				!= 0U ? 200U - ((frame + zone) % 200U)
+				: (frame + zone) % 200U) * 10;
+		}
+		sigma = 5U + (test_random(&seed) % 36U);
+		p_truth[zone] = (int16_t)d;
+		p_results->distance_mm[idx] = (int16_t)(d
+			+ _bench_noise(sigma));
+		p_results->range_sigma_mm[idx] = (uint16_t)sigma;
+		p_results->target_status[idx] = ((test_random(&seed) % 20U)
+			== 0U) ? 255U : 5U;
+		p_results->nb_target_detected[zone] = 1;
+	}
+	(void)vl53l8cx_update_validity(p_results, VL53L8CX_RESOLUTION_8X8);
+}
+
+/*
+ * The filter one zone at a time, with the same operations as the vector
+ * kernels of vl53l8cx_filter_update().
+ */
+static void _bench_scalar_update(
+		VL53L8CX_Filter			*p_flt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+	const VL53L8CX_FilterConfig *p_cfg = &p_flt->config;
+	float z, e, v, p, r, w, a, b, gain, predict, residual, age;
+	float tracked, valid;
+	uint32_t zone, idx;
+
+	if (nb_zones != p_flt->nb_zones)
+	{
+		vl53l8cx_filter_reset(p_flt);
+		p_flt->nb_zones = nb_zones;
+	}
+
+	p_flt->tracked_mask = 0;
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		z = (float)p_results->distance_mm[idx];
+		r = (float)p_results->range_sigma_mm[idx];
+		r = (r < 1.0f) ? 1.0f : r;
+		valid = (((p_results->valid_mask >> zone) & 1U) != 0U)
+			? 1.0f : 0.0f;
+		tracked = p_flt->is_tracked[zone];
+		e = p_flt->estimate_mm[zone];
+		w = p_cfg->sigma_ref_mm / r;
+		w = (w < 1.0f) ? w : 1.0f;
+
+		switch (p_cfg->mode)
+		{
+			case VL53L8CX_FILTER_MODE_EMA:
+				gain = valid * ((tracked * (p_cfg->alpha * w))
+					+ (1.0f - tracked));
+				p_flt->estimate_mm[zone] = e + (gain * (z - e));
+				break;
+			case VL53L8CX_FILTER_MODE_ALPHA_BETA:
+				v = p_flt->velocity_mm[zone];
+				predict = e + (tracked * v);
+				residual = z - predict;
+				a = valid * ((tracked * p_cfg->alpha * w)
+					+ (1.0f - tracked));
+				b = valid * tracked * p_cfg->beta * w;
+				p_flt->estimate_mm[zone] = predict
+					+ (a * residual);
+				p_flt->velocity_mm[zone] = tracked
+					* (v + (b * residual));
+				break;
+			default:
+				r = r * r;
+				p = p_flt->variance_mm2[zone]
+					+ p_cfg->process_noise_mm2;
+				gain = valid * ((tracked * (p / (p + r)))
+					+ (1.0f - tracked));
+				p_flt->estimate_mm[zone] = e + (gain * (z - e));
+				p_flt->variance_mm2[zone] = (tracked
+					* (1.0f - gain) * p)
+					+ ((1.0f - tracked) * valid * r);
+				break;
+		}
+
+		age = (p_flt->age[zone] + 1.0f) * (1.0f - valid);
+		tracked = (age <= (float)p_cfg->hold_frames)
+			? 1.0f - ((1.0f - tracked) * (1.0f - valid)) : 0.0f;
+		p_flt->age[zone] = age;
+		p_flt->is_tracked[zone] = tracked;
+		if (tracked > 0.5f)
+		{
+			p_flt->distance_mm[zone] = (int16_t)(
+				p_flt->estimate_mm[zone] + 0.5f);
+			p_flt->tracked_mask |= (uint64_t)1U << zone;
+		}
+		else
+		{
+			p_flt->distance_mm[zone] = p_cfg->no_target_mm;
+		}
+	}
+}
+
+/*
+ * Both versions on the same stream: they must give the same distances, then
+ * each one is timed over the stream, which does not fit in the L1 cache.
+ */
+static void _bench_mode(
+		const VL53L8CX_ResultsData	*p_frames,
+		uint8_t				mode,
+		const char			*p_name)
+{
+	static VL53L8CX_Filter flt, ref;
+	uint64_t start_ns, simd_ns, scalar_ns;
+	uint32_t frame, round, zone, nb_mismatches = 0;
+
+	vl53l8cx_filter_init(&flt, NULL);
+	flt.config.mode = mode;
+	ref = flt;
+	for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+	{
+		(void)vl53l8cx_filter_update(&flt, &p_frames[frame],
+				VL53L8CX_RESOLUTION_8X8);
+		_bench_scalar_update(&ref, &p_frames[frame],
+				VL53L8CX_RESOLUTION_8X8);
+		for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+		{
+			if (abs(flt.distance_mm[zone] - ref.distance_mm[zone])
+				> 1)
+			{
+				nb_mismatches++;
+			}
+		}
+		if (flt.tracked_mask != ref.tracked_mask)
+		{
+			nb_mismatches++;
+		}
+	}
+
+	start_ns = vl53l8cx_capture_now_ns();
+	for (round = 0; round < BENCH_NB_ROUNDS; round++)
+	{
+		for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+		{
+			(void)vl53l8cx_filter_update(&flt, &p_frames[frame],
+					VL53L8CX_RESOLUTION_8X8);
+		}
+	}
+	simd_ns = vl53l8cx_capture_now_ns() - start_ns;
+
+	start_ns = vl53l8cx_capture_now_ns();
+	for (round = 0; round < BENCH_NB_ROUNDS; round++)
+	{
+		for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+		{
+			_bench_scalar_update(&ref, &p_frames[frame],
+					VL53L8CX_RESOLUTION_8X8);
+		}
+	}
+	scalar_ns = vl53l8cx_capture_now_ns() - start_ns;
+
+	(void)printf("%-10s  simd %5.0f ns/frame, scalar %5.0f ns/frame, "
+			"%u mismatches\n", p_name, (double)simd_ns
+			/ (BENCH_NB_ROUNDS * BENCH_NB_FRAMES),
+			(double)scalar_ns / (BENCH_NB_ROUNDS
+			* BENCH_NB_FRAMES), nb_mismatches);
+	if (nb_mismatches != 0U)
+	{
+		nb_failures++;
+	}
+}
+
+/* Mean error on a still target, before and after the default filter */
+static void _bench_error(void)
+{
+	static VL53L8CX_Filter flt;
+	static VL53L8CX_ResultsData results;
+	int16_t truth[VL53L8CX_RESOLUTION_8X8];
+	uint64_t raw_mm = 0, filtered_mm = 0, n = 0;
+	uint32_t frame, zone;
+
+	vl53l8cx_filter_init(&flt, NULL);
+	for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+	{
+		_bench_frame(&results, truth, frame, 0);
+		(void)vl53l8cx_filter_update(&flt, &results,
+				VL53L8CX_RESOLUTION_8X8);
+		if (frame < 20U)
+		{
+			continue;
+		}
+		for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+		{
+			if ((((results.valid_mask >> zone) & 1U) == 0U)
+				|| (((flt.tracked_mask >> zone) & 1U) == 0U))
+			{
+				continue;
+			}
+			raw_mm += (uint64_t)abs(results.distance_mm[zone
+				* VL53L8CX_NB_TARGET_PER_ZONE] - truth[zone]);
+			filtered_mm += (uint64_t)abs(flt.distance_mm[zone]
+				- truth[zone]);
+			n++;
+		}
+	}
+	(void)printf("still target: mean error %.1f mm raw, %.1f mm "
+			"filtered\n", (double)raw_mm / (double)n,
+			(double)filtered_mm / (double)n);
+	if (filtered_mm >= raw_mm)
+	{
+		nb_failures++;
+	}
+}
+
+int main(void)
+{
+	static VL53L8CX_ResultsData frames[BENCH_NB_FRAMES];
+	int16_t truth[VL53L8CX_RESOLUTION_8X8];
+	uint32_t frame;
+
+	for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+	{
+		_bench_frame(&frames[frame], truth, frame, 1);
+	}
+	_bench_mode(frames, VL53L8CX_FILTER_MODE_EMA, "ema");
+	_bench_mode(frames, VL53L8CX_FILTER_MODE_ALPHA_BETA, "alpha-beta");
+	_bench_mode(frames, VL53L8CX_FILTER_MODE_KALMAN, "kalman");
+	_bench_error();
+
+	(void)printf("bench_filter: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
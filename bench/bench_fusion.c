@@ -0,0 +1,112 @@
+#include <stdio.h>
+
+#include "vl53l8cx_fusion.h"
+#include "vl53l8cx_capture.h"
+#include "test_common.h"
+
+#define BENCH_NB_EPOCHS		20000U
+#define BENCH_N			VL53L8CX_NB_TARGET_PER_ZONE
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x165667B1U;
+
+/* 8x8 frame, 90% of valid zones with all their targets */
+static void _bench_frame(
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint32_t zone, k, idx;
+	uint8_t is_valid;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		is_valid = (uint8_t)((test_random(&seed) % 10U) != 0U);
+		p_results->nb_target_detected[zone] = is_valid ? BENCH_N : 0U;
+		for (k = 0; k < BENCH_N; k++)
+		{
+			idx = (zone * BENCH_N) + k;
+			p_results->distance_mm[idx] = (int16_t)(100U
+				+ (test_random(&seed) % 3900U));
+			p_results->target_status[idx] = is_valid ? 5U : 255U;
+		}
+	}
+	(void)vl53l8cx_update_validity(p_results, VL53L8CX_RESOLUTION_8X8);
+}
+
+/*
+ * Time of an epoch for a number of sensors on a ring, looking outwards, and
+ * a number of worker threads.
+ */
+static void _bench_epochs(
+		uint8_t				nb_sensors,
+		uint8_t				nb_workers)
+{
+	static VL53L8CX_Fusion fus;
+	static VL53L8CX_ResultsData frames[VL53L8CX_FUSION_MAX_SENSORS];
+	static float x[VL53L8CX_FUSION_MAX_POINTS];
+	static float y[VL53L8CX_FUSION_MAX_POINTS];
+	static float z[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t sensor[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t zone[VL53L8CX_FUSION_MAX_POINTS];
+	VL53L8CX_FusionCloud out = {x, y, z, sensor, zone,
+		VL53L8CX_FUSION_MAX_POINTS, 0, 0, 0};
+	const VL53L8CX_ResultsData *p_results[VL53L8CX_FUSION_MAX_SENSORS];
+	VL53L8CX_PointCloudPose pose;
+	uint64_t start_ns, elapsed_ns;
+	uint32_t i, epoch;
+	uint8_t id;
+
+	if (vl53l8cx_fusion_init(&fus) != VL53L8CX_STATUS_OK)
+	{
+		nb_failures++;
+		return;
+	}
+	for (i = 0; i < nb_sensors; i++)
+	{
+		vl53l8cx_pointcloud_pose(&pose, 0.0f, 0.0f, (float)(i * 360U)
+				/ (float)nb_sensors, NULL);
+		(void)vl53l8cx_fusion_add_sensor(&fus, &pose, &id);
+		_bench_frame(&frames[i]);
+		p_results[i] = &frames[i];
+	}
+	if (vl53l8cx_fusion_start(&fus, nb_workers) != VL53L8CX_STATUS_OK)
+	{
+		nb_failures++;
+		return;
+	}
+
+	start_ns = vl53l8cx_capture_now_ns();
+	for (epoch = 0; epoch < BENCH_NB_EPOCHS; epoch++)
+	{
+		if (vl53l8cx_fusion_process(&fus, p_results, UINT16_MAX,
+				VL53L8CX_RESOLUTION_8X8, &out)
+				!= VL53L8CX_STATUS_OK)
+		{
+			nb_failures++;
+			break;
+		}
+	}
+	elapsed_ns = vl53l8cx_capture_now_ns() - start_ns;
+	(void)vl53l8cx_fusion_stop(&fus);
+
+	(void)printf("sensors %2u, workers %u: %6.0f ns/epoch, %4u points\n",
+			nb_sensors, nb_workers, (double)elapsed_ns
+			/ BENCH_NB_EPOCHS, out.nb_points);
+}
+
+int main(void)
+{
+	uint8_t nb_sensors;
+
+	for (nb_sensors = 1; nb_sensors <= VL53L8CX_FUSION_MAX_SENSORS;
+			nb_sensors = (uint8_t)(nb_sensors * 2U))
+	{
+		_bench_epochs(nb_sensors, 0);
+	}
+	_bench_epochs(VL53L8CX_FUSION_MAX_SENSORS, 1);
+	_bench_epochs(VL53L8CX_FUSION_MAX_SENSORS, 3);
+
+	(void)printf("bench_fusion: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "vl53l8cx_pointcloud.h"
+#include "vl53l8cx_capture.h"
+#include "test_common.h"
+
+#define BENCH_NB_FRAMES		256U
+#define BENCH_NB_ROUNDS		200U
+#define BENCH_DEG_TO_RAD	0.017453292519943295
+#define BENCH_N			VL53L8CX_NB_TARGET_PER_ZONE
+
+static uint32_t nb_failures;
+static uint32_t seed = 0xC2B2AE35U;
+
+/* Mounting of the sensor: rotated around all axes, and off the origin */
+static const double roll_deg = 10.0;
+static const double pitch_deg = 25.0;
+static const double yaw_deg = -40.0;
+static const float translation_mm[3] = {120.0f, -35.0f, 60.0f};
+
+/* Random frame: 1 to BENCH_N targets per zone, 10% of invalid targets */
+static void _bench_frame(
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint32_t zone, k, idx, nt;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		nt = 1U + (test_random(&seed) % BENCH_N);
+		p_results->nb_target_detected[zone] = (uint8_t)nt;
+		for (k = 0; k < BENCH_N; k++)
+		{
+			idx = (zone * BENCH_N) + k;
+			p_results->distance_mm[idx] = (int16_t)(
+				test_random(&seed) % 4000U);
+			p_results->target_status[idx] = ((k < nt)
+				&& ((test_random(&seed) % 10U) != 0U))
+				? 5U : 255U;
+		}
+	}
+	(void)vl53l8cx_update_validity(p_results, VL53L8CX_RESOLUTION_8X8);
+}
+
+/*
+ * Rotation of the pose, Ry(yaw) * Rx(pitch) * Rz(roll), in double precision
+ * and by matrix products, independently of vl53l8cx_pointcloud_pose().
+ */
+static void _bench_rotation(
+		double				*p_r)
+{
+	double cr = cos(roll_deg * BENCH_DEG_TO_RAD);
+	double sr = sin(roll_deg * BENCH_DEG_TO_RAD);
+	double cp = cos(pitch_deg * BENCH_DEG_TO_RAD);
+	double sp = sin(pitch_deg * BENCH_DEG_TO_RAD);
+	double cy = cos(yaw_deg * BENCH_DEG_TO_RAD);
+	double sy = sin(yaw_deg * BENCH_DEG_TO_RAD);
+	const double rz[9] = {cr, -sr, 0.0, sr, cr, 0.0, 0.0, 0.0, 1.0};
+	const double rx[9] = {1.0, 0.0, 0.0, 0.0, cp, -sp, 0.0, sp, cp};
+	const double ry[9] = {cy, 0.0, sy, 0.0, 1.0, 0.0, -sy, 0.0, cy};
+	double rxz[9];
+	uint32_t i, j, k;
+
+	for (i = 0; i < 3U; i++)
+	{
+		for (j = 0; j < 3U; j++)
+		{
+			rxz[(i * 3U) + j] = 0.0;
+			for (k = 0; k < 3U; k++)
+			{
+				rxz[(i * 3U) + j] += rx[(i * 3U) + k]
+					* rz[(k * 3U) + j];
+			}
+		}
+	}
+	for (i = 0; i < 3U; i++)
+	{
+		for (j = 0; j < 3U; j++)
+		{
+			p_r[(i * 3U) + j] = 0.0;
+			for (k = 0; k < 3U; k++)
+			{
+				p_r[(i * 3U) + j] += ry[(i * 3U) + k]
+					* rxz[(k * 3U) + j];
+			}
+		}
+	}
+}
+
+/*
+ * Largest distance between the points of the converter and the same points
+ * in double precision, in mm. Invalid points must be 0 and out of the masks.
+ */
+static double _bench_error(
+		const double			*p_r,
+		const VL53L8CX_ResultsData	*p_results,
+		const VL53L8CX_PointCloud	*p_cloud,
+		uint8_t				nb_zones)
+{
+	double fov = (double)VL53L8CX_POINTCLOUD_FOV_DEG * BENCH_DEG_TO_RAD;
+	double x, y, norm, d, p[3], err, max_err = 0.0;
+	uint32_t width = (nb_zones == VL53L8CX_RESOLUTION_8X8) ? 8U : 4U;
+	uint32_t zone, t, i, idx;
+	uint8_t is_valid;
+
+	for (t = 0; t < BENCH_N; t++)
+	{
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			idx = (zone * BENCH_N) + t;
+			i = (t * nb_zones) + zone;
+			is_valid = (uint8_t)(((p_results->target_status[idx]
+				== 5U) || (p_results->target_status[idx] == 9U))
+				&& (t < p_results->nb_target_detected[zone]));
+			if (is_valid != ((p_cloud->valid_mask[t] >> zone) & 1U))
+			{
+				return INFINITY;
+			}
+			if (!is_valid)
+			{
+				if ((p_cloud->p_x_mm[i] != 0.0f)
+					|| (p_cloud->p_y_mm[i] != 0.0f)
+					|| (p_cloud->p_z_mm[i] != 0.0f))
+				{
+					return INFINITY;
+				}
+				continue;
+			}
+			x = tan(((((double)(zone % width) + 0.5)
+				/ (double)width) - 0.5) * fov);
+			y = tan((0.5 - (((double)(zone / width) + 0.5)
+				/ (double)width)) * fov);
+			norm = sqrt((x * x) + (y * y) + 1.0);
+			d = (double)p_results->distance_mm[idx] / norm;
+			p[0] = (p_r[0] * x * d) + (p_r[1] * y * d)
+				+ (p_r[2] * d) + (double)translation_mm[0];
+			p[1] = (p_r[3] * x * d) + (p_r[4] * y * d)
+				+ (p_r[5] * d) + (double)translation_mm[1];
+			p[2] = (p_r[6] * x * d) + (p_r[7] * y * d)
+				+ (p_r[8] * d) + (double)translation_mm[2];
+			err = sqrt(((p[0] - p_cloud->p_x_mm[i])
+				* (p[0] - p_cloud->p_x_mm[i]))
+				+ ((p[1] - p_cloud->p_y_mm[i])
+				* (p[1] - p_cloud->p_y_mm[i]))
+				+ ((p[2] - p_cloud->p_z_mm[i])
+				* (p[2] - p_cloud->p_z_mm[i])));
+			max_err = (err > max_err) ? err : max_err;
+		}
+	}
+
+	return max_err;
+}
+
+/*
+ * Conversion without the LUT: the direction of each zone is computed again
+ * for each frame, with tanf and sqrtf, then rotated. Same output as
+ * vl53l8cx_pointcloud_convert().
+ */
+static void _bench_trig_convert(
+		const VL53L8CX_PointCloudPose	*p_pose,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		VL53L8CX_PointCloud		*p_cloud)
+{
+	const float *r = p_pose->rotation;
+	const float *tr = p_pose->translation_mm;
+	float fov = VL53L8CX_POINTCLOUD_FOV_DEG
+		* (float)BENCH_DEG_TO_RAD;
+	uint32_t width = (nb_zones == VL53L8CX_RESOLUTION_8X8) ? 8U : 4U;
+	float x, y, z, dir[3], d;
+	uint32_t zone, t, i, idx;
+	uint8_t is_valid;
+
+	p_cloud->nb_zones = nb_zones;
+	p_cloud->nb_valid = 0;
+	for (t = 0; t < BENCH_N; t++)
+	{
+		p_cloud->valid_mask[t] = 0;
+	}
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		x = tanf(((((float)(zone % width) + 0.5f) / (float)width)
+			- 0.5f) * fov);
+		y = tanf((0.5f - (((float)(zone / width) + 0.5f)
+			/ (float)width)) * fov);
+		z = 1.0f / sqrtf((x * x) + (y * y) + 1.0f);
+		x *= z;
+		y *= z;
+		dir[0] = (r[0] * x) + (r[1] * y) + (r[2] * z);
+		dir[1] = (r[3] * x) + (r[4] * y) + (r[5] * z);
+		dir[2] = (r[6] * x) + (r[7] * y) + (r[8] * z);
+
+		for (t = 0; t < BENCH_N; t++)
+		{
+			idx = (zone * BENCH_N) + t;
+			i = (t * nb_zones) + zone;
+			is_valid = (uint8_t)(((p_results->target_status[idx]
+				== 5U) || (p_results->target_status[idx] == 9U))
+				&& (t < p_results->nb_target_detected[zone]));
+			d = (float)p_results->distance_mm[idx];
+			p_cloud->p_x_mm[i] = is_valid ? (d * dir[0]) + tr[0]
+				: 0.0f;
+			p_cloud->p_y_mm[i] = is_valid ? (d * dir[1]) + tr[1]
+				: 0.0f;
+			p_cloud->p_z_mm[i] = is_valid ? (d * dir[2]) + tr[2]
+				: 0.0f;
+			p_cloud->valid_mask[t] |= (uint64_t)is_valid << zone;
+			p_cloud->nb_valid += is_valid;
+		}
+	}
+}
+
+int main(void)
+{
+	static VL53L8CX_ResultsData frames[BENCH_NB_FRAMES];
+	static VL53L8CX_PointCloudConverter conv;
+	static float x[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	static float y[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	static float z[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	VL53L8CX_PointCloud cloud = {x, y, z, VL53L8CX_POINTCLOUD_MAX_POINTS,
+		0, 0, {0}};
+	VL53L8CX_PointCloudPose pose;
+	uint64_t start_ns, lut_ns, trig_ns;
+	double r[9], err, max_lut = 0.0, max_trig = 0.0;
+	uint32_t frame, round;
+	uint8_t nb_zones;
+
+	vl53l8cx_pointcloud_pose(&pose, (float)roll_deg, (float)pitch_deg,
+			(float)yaw_deg, translation_mm);
+	vl53l8cx_pointcloud_init(&conv, &pose);
+	_bench_rotation(r);
+	for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+	{
+		_bench_frame(&frames[frame]);
+	}
+
+	/* Accuracy, at both resolutions */
+	for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+	{
+		nb_zones = ((frame % 2U) == 0U) ? VL53L8CX_RESOLUTION_4X4
+			: VL53L8CX_RESOLUTION_8X8;
+		if (vl53l8cx_pointcloud_convert(&conv, &frames[frame],
+				nb_zones, &cloud) != VL53L8CX_STATUS_OK)
+		{
+			nb_failures++;
+		}
+		err = _bench_error(r, &frames[frame], &cloud, nb_zones);
+		max_lut = (err > max_lut) ? err : max_lut;
+		_bench_trig_convert(&pose, &frames[frame], nb_zones, &cloud);
+		err = _bench_error(r, &frames[frame], &cloud, nb_zones);
+		max_trig = (err > max_trig) ? err : max_trig;
+	}
+
+	/* Time of a 8x8 frame */
+	start_ns = vl53l8cx_capture_now_ns();
+	for (round = 0; round < BENCH_NB_ROUNDS; round++)
+	{
+		for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+		{
+			(void)vl53l8cx_pointcloud_convert(&conv, &frames[frame],
+					VL53L8CX_RESOLUTION_8X8, &cloud);
+		}
+	}
+	lut_ns = vl53l8cx_capture_now_ns() - start_ns;
+
+	start_ns = vl53l8cx_capture_now_ns();
+	for (round = 0; round < BENCH_NB_ROUNDS; round++)
+	{
+		for (frame = 0; frame < BENCH_NB_FRAMES; frame++)
+		{
+			_bench_trig_convert(&pose, &frames[frame],
+					VL53L8CX_RESOLUTION_8X8, &cloud);
+		}
+	}
+	trig_ns = vl53l8cx_capture_now_ns() - start_ns;
+
+	(void)printf("%u targets per zone, 8x8: lut %.0f ns/frame, trig %.0f "
+			"ns/frame\n", (uint32_t)BENCH_N, (double)lut_ns
+			/ (BENCH_NB_ROUNDS * BENCH_NB_FRAMES), (double)trig_ns
+			/ (BENCH_NB_ROUNDS * BENCH_NB_FRAMES));
+	(void)printf("max error vs double: lut %.2f um, trig %.2f um\n",
+			max_lut * 1000.0, max_trig * 1000.0);
+	if ((max_lut > 1e-3) || (max_trig > 1e-3))
+	{
+		nb_failures++;
+	}
+
+	(void)printf("bench_pointcloud: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -37,6 +37,10 @@
 #include <wiringPi.h>
 #include <wiringPiSPI.h>
 #include "vl53l8cx_api.h"
+#include "vl53l8cx_capture.h"
+#include "vl53l8cx_latency.h"
+#include "vl53l8cx_governor.h"
+#include "vl53l8cx_filter.h"
 
 
 #define SPI_NUMBER 0
@@ -64,7 +68,7 @@ void init_udp_socket(const char *ip, int port) {
     pico_addr.sin_addr.s_addr = inet_addr(ip);
 }
 
-void send_vibration_command(int16_t *values) {
+void send_vibration_command(const int16_t *values) {
     ssize_t sent = sendto(udp_socket, values, 16 * sizeof(int16_t), 0,
                           (struct sockaddr *)&pico_addr, sizeof(pico_addr));
     if (sent < 0) {
@@ -79,9 +83,19 @@ int main(void)
 	/*   VL53L8CX ranging variables  */
 	/*********************************/
 
-	uint8_t 				status, isAlive, isReady, j;
+	uint8_t 				status, isAlive;
 	VL53L8CX_Configuration 	Dev;			/* Sensor configuration */
-	VL53L8CX_ResultsData 	Results;		/* Results data from VL53L8CX */
+	static VL53L8CX_Capture	Capture;		/* Acquisition thread and frame ring */
+	VL53L8CX_CaptureStats	CaptureStats;	/* Capture counters */
+	VL53L8CX_FrameStats		FrameStats;		/* Driver frames accounting */
+	const VL53L8CX_CaptureFrame *p_frame;	/* Frame consumed from the ring */
+	static VL53L8CX_Latency	Latency;		/* Per-stage latency distributions */
+	VL53L8CX_LatencyReport	LatencyReport;	/* Latency summary */
+	static VL53L8CX_Governor	Governor;		/* Frame rate control */
+	VL53L8CX_GovernorReport	GovernorReport;	/* Achieved frame rate */
+	static VL53L8CX_Filter	Filter;			/* Per-zone distance filter */
+	static const char		*stage_names[VL53L8CX_LATENCY_NB_STAGES] = {
+		"SPI read", "decode", "queue", "total"};
 
 
 	/*********************************/
@@ -92,6 +106,8 @@ int main(void)
 	* example, only the I2C address is used.
 	*/
 	//Dev.platform.address = VL53L8CX_DEFAULT_I2C_ADDRESS;
+	Dev.platform.spi_channel = SPI_CHANNEL;
+	Dev.platform.spi_speed = SPI_SPEED;
 
 	/* (Optional) Reset sensor toggling PINs (see platform, not in API) */
 	//VL53L8CX_Reset_Sensor(&(Dev.platform));
@@ -136,11 +152,43 @@ int main(void)
 	printf("VL53L8CX ULD ready ! (Version : %s)\n",
 			VL53L8CX_API_REVISION);
 	
-	status = vl53l8cx_set_ranging_frequency_hz(&Dev, 30);
+	status = vl53l8cx_capture_init(&Capture);
+	if (status) {
+		printf("Failed to initialize capture\n");
+		return status;
+	}
+
+	/* The governor sets the frequency and the integration time for 30 Hz,
+	 * then corrects them from the rate actually achieved */
+	vl53l8cx_governor_init(&Governor, &Capture, 30, 0);
+	status = vl53l8cx_governor_configure(&Governor, &Dev);
 	if (status) {
 		printf("Failed to set ranging frequency\n");
 		return status;
 	}
+	vl53l8cx_governor_get_report(&Governor, &GovernorReport);
+	if (GovernorReport.infeasible) {
+		printf("30 Hz is not reachable, using %u Hz\n",
+				GovernorReport.frequency_hz);
+	}
+
+	/* Only filtered distances are forwarded to the Pico: fetch the blocks
+	 * used by the filter on most frames, and a full frame once per second */
+	status = vl53l8cx_set_partial_read(&Dev, VL53L8CX_OUTPUT_DISTANCE_MM
+			| VL53L8CX_OUTPUT_RANGE_SIGMA_MM
+			| VL53L8CX_OUTPUT_TARGET_STATUS, 30);
+	if (status) {
+		printf("Failed to set partial read mode\n");
+		return status;
+	}
+
+	/* Re-read a corrupted frame immediately instead of waiting 33 ms for
+	 * the next one */
+	status = vl53l8cx_set_frame_rereads(&Dev, 2);
+	if (status) {
+		printf("Failed to set frame re-reads\n");
+		return status;
+	}
 
 	init_udp_socket(PICO_IP, PICO_PORT);  // IP and port of the Pico
 	printf("Connected to pico!\n");
@@ -149,36 +197,82 @@ int main(void)
 	/*         Ranging loop          */
 	/*********************************/
 
-	status = vl53l8cx_start_ranging(&Dev);
+	/* The acquisition thread owns the device from now on: it polls the
+	 * sensor and pushes decoded frames into the capture ring, so a stall in
+	 * sendto() never delays the next data ready check */
+	status = vl53l8cx_capture_start(&Capture, &Dev, 0);
+	if (status) {
+		printf("Failed to start capture\n");
+		return status;
+	}
+
+	vl53l8cx_latency_reset(&Latency);
+	vl53l8cx_filter_init(&Filter, NULL);
+	/* Zones without target turn their motor off, like at the end */
+	Filter.config.no_target_mm = 4000;
 
 	int loop = 0;
 	while(loop < 2000)
 	{
-		/* Use polling function to know when a new measurement is ready.
-		 * Another way can be to wait for HW interrupt raised on PIN A1
-		 * (INT) when a new measurement is ready */
- 
-		status = vl53l8cx_check_data_ready(&Dev, &isReady);
+		if(!vl53l8cx_capture_wait(&Capture, 1000))
+		{
+			printf("No frame received for 1s\n");
+			continue;
+		}
 
-		if(isReady)
+		/* Only the most recent frame matters for the motors */
+		p_frame = vl53l8cx_capture_peek_latest(&Capture);
+		if(p_frame == NULL)
 		{
-			vl53l8cx_get_ranging_data(&Dev, &Results);
-			/* As the sensor is set in 4x4 mode by default, we have a total 
-			 * of 16 zones to print. For this example, only the data of first zone are 
-			 * print */
+			continue;
+		}
 
-			// Send intensity values to the Pico W
-			send_vibration_command(Results.distance_mm);
+		/* Filter the sensor noise out, so it does not make the motors
+		 * jitter */
+		vl53l8cx_filter_update(&Filter, &p_frame->results,
+				VL53L8CX_RESOLUTION_4X4);
 
-            		loop++;
-		}
+		// Send intensity values to the Pico W
+		send_vibration_command(Filter.distance_mm);
+		vl53l8cx_latency_record_frame(&Latency, p_frame);
+		vl53l8cx_governor_update(&Governor, p_frame);
+		vl53l8cx_capture_release(&Capture);
+
+		loop++;
+	}
 
-		/* Wait a few ms to avoid too high polling (function in platform
-		 * file, not in API) */
-		VL53L8CX_WaitMs(&(Dev.platform), 5);
+	status = vl53l8cx_capture_stop(&Capture);
+	vl53l8cx_capture_get_stats(&Capture, &CaptureStats);
+	printf("Frames captured: %u, overruns: %u, skipped: %u, errors: %u\n",
+			CaptureStats.frames_captured, CaptureStats.overruns,
+			CaptureStats.frames_skipped, CaptureStats.read_errors);
+	printf("Sensor frames dropped: %u, corrupted: %u, late: %u\n",
+			CaptureStats.frames_dropped, CaptureStats.frames_corrupted,
+			CaptureStats.frames_late);
+	vl53l8cx_capture_deinit(&Capture);
+	vl53l8cx_get_frame_stats(&Dev, &FrameStats);
+	printf("Re-reads: %u, recovered: %u, exhausted: %u\n",
+			FrameStats.rereads, FrameStats.rereads_recovered,
+			FrameStats.rereads_exhausted);
+
+	vl53l8cx_governor_get_report(&Governor, &GovernorReport);
+	printf("Frame rate: %.1f Hz for %u Hz (%u Hz, %u ms integration, "
+			"%u adjustments, infeasible 0x%x)\n",
+			(double)GovernorReport.achieved_hz,
+			GovernorReport.target_hz, GovernorReport.frequency_hz,
+			GovernorReport.integration_time_ms,
+			GovernorReport.nb_adjustments, GovernorReport.infeasible);
+
+	vl53l8cx_latency_get_report(&Latency, &LatencyReport);
+	for (int i = 0; i < VL53L8CX_LATENCY_NB_STAGES; ++i) {
+		printf("%-8s : p50 %6.3f ms, p99 %6.3f ms, max %6.3f ms (%u frames)\n",
+				stage_names[i],
+				(double)LatencyReport.stage[i].p50_ns / 1e6,
+				(double)LatencyReport.stage[i].p99_ns / 1e6,
+				(double)LatencyReport.stage[i].max_ns / 1e6,
+				LatencyReport.stage[i].count);
 	}
 
-	status = vl53l8cx_stop_ranging(&Dev);
 	// Ensure all motors are turned off at the end
 	int16_t end[16];
 	for (int i = 0; i < 16; ++i) end[i] = 4000;
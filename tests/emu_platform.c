@@ -0,0 +1,472 @@
+#include <string.h>
+
+#include "emu_platform.h"
+#include "vl53l8cx_api.h"
+#include "vl53l8cx_capture.h"
+
+EmuPlatformSensor emu_platform_sensors[EMU_PLATFORM_NB_CHANNELS];
+
+/* Page of the results and of the UI buffer */
+#define EMU_PLATFORM_UI_PAGE		2U
+
+static uint32_t _emu_platform_random(
+		EmuPlatformSensor		*p_emu)
+{
+	p_emu->seed ^= p_emu->seed << 13;
+	p_emu->seed ^= p_emu->seed >> 17;
+	p_emu->seed ^= p_emu->seed << 5;
+
+	return p_emu->seed;
+}
+
+/* Word of the firmware byte order, as the driver reads it after a swap */
+static uint32_t _emu_platform_word(
+		const uint8_t			*p_bytes)
+{
+	return ((uint32_t)p_bytes[0] << 24) | ((uint32_t)p_bytes[1] << 16)
+		| ((uint32_t)p_bytes[2] << 8) | (uint32_t)p_bytes[3];
+}
+
+/*
+ * Random results of a block, in the format of the firmware: targets and
+ * statuses are consistent enough for frames to have valid and invalid
+ * zones.
+ */
+static void _emu_platform_fill(
+		EmuPlatformSensor		*p_emu,
+		uint16_t			idx,
+		uint8_t				*p_data,
+		uint32_t			size)
+{
+	static const uint8_t statuses[] = {5, 5, 5, 9, 4, 255};
+	uint32_t i;
+	int16_t distance;
+
+	for (i = 0; i < size; i++)
+	{
+		p_data[i] = (uint8_t)_emu_platform_random(p_emu);
+	}
+
+	switch (idx)
+	{
+		case VL53L8CX_METADATA_IDX:
+			/* Silicon temperature */
+			p_data[8] = 25;
+			break;
+		case VL53L8CX_NB_TARGET_DETECTED_IDX:
+			for (i = 0; i < size; i++)
+			{
+				p_data[i] %= (uint8_t)(
+					VL53L8CX_NB_TARGET_PER_ZONE + 1U);
+			}
+			break;
+		case VL53L8CX_TARGET_STATUS_IDX:
+			for (i = 0; i < size; i++)
+			{
+				p_data[i] = statuses[p_data[i]
+					% sizeof(statuses)];
+			}
+			break;
+		case VL53L8CX_DISTANCE_IDX:
+			/* Distances are sent in quarters of mm */
+			for (i = 0; (i + 1U) < size; i += 2U)
+			{
+				distance = (int16_t)((_emu_platform_random(
+					p_emu) % 4000U) * 4U);
+				(void)memcpy(&p_data[i], &distance, 2);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+uint8_t emu_platform_frame(
+		uint8_t				channel)
+{
+	EmuPlatformSensor *p_emu = &emu_platform_sensors[channel];
+	uint8_t *frame = p_emu->mem[EMU_PLATFORM_UI_PAGE];
+	uint32_t i, word, type, size, pos = 16, frame_size;
+	uint32_t enables[4];
+
+	if (!p_emu->is_ranging)
+	{
+		return 255;
+	}
+
+	/* Layout programmed by vl53l8cx_start_ranging(). The frame is built in
+	 * the byte order of the host, then swapped in place */
+	frame_size = _emu_platform_word(
+			&p_emu->dci[VL53L8CX_DCI_OUTPUT_CONFIG]);
+	for (i = 0; i < 4U; i++)
+	{
+		enables[i] = _emu_platform_word(&p_emu->dci[
+			VL53L8CX_DCI_OUTPUT_ENABLES + (4U * i)]);
+	}
+	if ((frame_size < 24U) || (frame_size > VL53L8CX_UI_CMD_STATUS))
+	{
+		return 255;
+	}
+
+	(void)memset(frame, 0, frame_size);
+	for (i = 0; i < (uint32_t)VL53L8CX_NB_OUTPUT_BLOCKS; i++)
+	{
+		word = _emu_platform_word(&p_emu->dci[
+			VL53L8CX_DCI_OUTPUT_LIST + (4U * i)]);
+		if ((word == 0U) || (((enables[i / 32U] >> (i % 32U)) & 1U)
+				== 0U))
+		{
+			continue;
+		}
+		type = word & 0xFU;
+		size = (word >> 4) & 0xFFFU;
+		size = ((type >= 1U) && (type < 0xDU)) ? (type * size) : size;
+		if ((pos + 4U + size + 8U) > frame_size)
+		{
+			break;
+		}
+		(void)memcpy(&frame[pos], &word, 4);
+		_emu_platform_fill(p_emu, (uint16_t)(word >> 16),
+				&frame[pos + 4U], size);
+		pos += 4U + size;
+	}
+
+	/* Streamcount and status, then header and footer ids */
+	p_emu->streamcount = (uint8_t)((p_emu->streamcount + 1U) % 255U);
+	p_emu->frame_id++;
+	frame[0] = 0x10;
+	frame[1] = 0x05;
+	frame[2] = 0x05;
+	frame[3] = p_emu->streamcount;
+	frame[8] = (uint8_t)(p_emu->frame_id >> 8);
+	frame[9] = (uint8_t)p_emu->frame_id;
+	frame[frame_size - 4U] = frame[8];
+	frame[frame_size - 3U] = frame[9];
+
+	VL53L8CX_SwapBuffer(frame, (uint16_t)frame_size);
+
+	return p_emu->streamcount;
+}
+
+/* Stores the records of a DCI write or of a configuration buffer */
+static void _emu_platform_dci_write(
+		EmuPlatformSensor		*p_emu,
+		uint32_t			pos,
+		uint32_t			end)
+{
+	const uint8_t *p_ui = p_emu->mem[EMU_PLATFORM_UI_PAGE];
+	uint32_t idx, size, flags;
+
+	while ((pos + 4U) <= end)
+	{
+		idx = ((uint32_t)p_ui[pos] << 8) | p_ui[pos + 1U];
+		size = ((uint32_t)p_ui[pos + 2U] << 4) | (p_ui[pos + 3U] >> 4);
+		flags = p_ui[pos + 3U] & 0xFU;
+		/* Arrays of 16 and 32 bits words */
+		size *= ((flags == 2U) || (flags == 4U)) ? flags : 1U;
+		if ((flags == 0xFU) || ((pos + 4U + size) > end)
+			|| ((idx + size) > EMU_PLATFORM_DCI_SIZE))
+		{
+			break;
+		}
+		(void)memcpy(&p_emu->dci[idx], &p_ui[pos + 4U], size);
+		pos += 4U + size;
+	}
+
+	/* The ranging data size reported after the start is the one of the
+	 * output configuration */
+	(void)memcpy(&p_emu->dci[0x5448],
+			&p_emu->dci[VL53L8CX_DCI_OUTPUT_CONFIG], 4);
+}
+
+/* Runs a command written into the UI buffer */
+static void _emu_platform_command(
+		EmuPlatformSensor		*p_emu,
+		uint32_t			address,
+		uint32_t			size)
+{
+	uint8_t *p_ui = p_emu->mem[EMU_PLATFORM_UI_PAGE];
+	uint32_t idx, data_size, end = address + size;
+
+	if ((address == 0x2FFCU) && (size == 4U) && (p_ui[0x2FFD] == 0x03U))
+	{
+		/* Start: no frame until the first period */
+		p_emu->is_ranging = 1;
+		p_emu->next_frame_ns = vl53l8cx_capture_now_ns()
+			+ ((uint64_t)p_emu->period_us * 1000U);
+		(void)memset(p_ui, 0, 4);
+		return;
+	}
+
+	/* Other commands end with a footer, whose byte 5 is the operation */
+	if ((size < 12U) || ((p_ui[end - 5U] & 0xFU) != 0xFU))
+	{
+		return;
+	}
+	if (p_ui[end - 3U] == 0x01U)
+	{
+		_emu_platform_dci_write(p_emu, address, end - 8U);
+	}
+	else if ((p_ui[end - 3U] == 0x02U) && (size == 12U))
+	{
+		/* DCI read: header, data, then footer */
+		idx = ((uint32_t)p_ui[address] << 8) | p_ui[address + 1U];
+		data_size = ((uint32_t)p_ui[address + 2U] << 4)
+			| (p_ui[address + 3U] >> 4);
+		if ((idx + data_size) <= EMU_PLATFORM_DCI_SIZE)
+		{
+			(void)memset(&p_ui[VL53L8CX_UI_CMD_START], 0,
+					data_size + 12U);
+			(void)memcpy(&p_ui[VL53L8CX_UI_CMD_START + 4U],
+					&p_emu->dci[idx], data_size);
+		}
+	}
+	else
+	{
+		/* Commands without effect on the emulator */
+	}
+}
+
+/* Effects of a write on the firmware, after the bytes are stored */
+static void _emu_platform_written(
+		EmuPlatformSensor		*p_emu,
+		uint16_t			address,
+		uint32_t			size)
+{
+	uint8_t *p_regs = p_emu->mem[0];
+
+	if ((address == 0x7FFFU) && (size == 1U))
+	{
+		p_emu->page = (uint8_t)(p_emu->mem[p_emu->page][0x7FFF]
+			% EMU_PLATFORM_NB_PAGES);
+	}
+	else if ((p_emu->page == 0U) && (address == 0x14U) && (size == 1U))
+	{
+		/* MCU stop request, acknowledged into the GO2 status */
+		if (p_regs[0x14] == 0x01U)
+		{
+			p_emu->is_ranging = 0;
+			p_regs[0x06] |= 0x80U;
+		}
+		else
+		{
+			p_regs[0x06] &= (uint8_t)~0x80U;
+		}
+	}
+	else if ((p_emu->page == EMU_PLATFORM_UI_PAGE)
+			&& (address >= VL53L8CX_UI_CMD_START))
+	{
+		_emu_platform_command(p_emu, address, size);
+	}
+	else
+	{
+		/* Plain register */
+	}
+}
+
+/* Counts and logs a transaction, and gives the memory it accesses */
+static uint8_t *_emu_platform_access(
+		VL53L8CX_Platform		*p_platform,
+		uint8_t				is_write,
+		uint16_t			address,
+		uint32_t			size)
+{
+	EmuPlatformSensor *p_emu;
+	EmuPlatformAccess *p_access;
+	uint32_t channel = (uint32_t)p_platform->spi_channel;
+
+	if (channel >= EMU_PLATFORM_NB_CHANNELS)
+	{
+		return NULL;
+	}
+	p_emu = &emu_platform_sensors[channel];
+	if (((uint32_t)address + size) > EMU_PLATFORM_PAGE_SIZE)
+	{
+		return NULL;
+	}
+	p_emu->transactions++;
+	p_emu->bytes += size + 2U;
+
+	if ((p_emu->p_log != NULL) && (p_emu->log_count < p_emu->log_size))
+	{
+		p_access = &p_emu->p_log[p_emu->log_count];
+		p_access->is_write = is_write;
+		p_access->page = p_emu->page;
+		p_access->address = address;
+		p_access->size = size;
+		p_access->hash = 0;
+	}
+	p_emu->log_count++;
+
+	return &p_emu->mem[p_emu->page][address];
+}
+
+/* Hash of the bytes of the last transaction logged */
+static void _emu_platform_hash(
+		VL53L8CX_Platform		*p_platform,
+		const uint8_t			*p_values,
+		uint32_t			size)
+{
+	EmuPlatformSensor *p_emu =
+		&emu_platform_sensors[p_platform->spi_channel];
+	uint32_t i, hash = 2166136261U;
+
+	if ((p_emu->p_log == NULL) || (p_emu->log_count > p_emu->log_size))
+	{
+		return;
+	}
+	for (i = 0; i < size; i++)
+	{
+		hash = (hash ^ p_values[i]) * 16777619U;
+	}
+	p_emu->p_log[p_emu->log_count - 1U].hash = hash;
+}
+
+void emu_platform_reset(
+		uint8_t				channel)
+{
+	EmuPlatformSensor *p_emu = &emu_platform_sensors[channel];
+	static const uint8_t fw_checksum[] = {0x0C, 0x0B, 0x6C, 0x9E};
+	static const uint8_t cmd_status[] = {0x02, 0x03, 0x00, 0x00};
+
+	(void)memset(p_emu, 0, sizeof(*p_emu));
+	p_emu->seed = 0x2545F491U + channel;
+
+	/* Device and revision ids, booted MCU, GO2 status of a stopped MCU */
+	p_emu->mem[0][0x00] = 0xF0;
+	p_emu->mem[0][0x01] = 0x0C;
+	p_emu->mem[0][0x06] = 0x01;
+	p_emu->mem[0][0x07] = 0x84;
+	/* Firmware access enabled */
+	p_emu->mem[1][0x21] = 0x04;
+	(void)memcpy(&p_emu->mem[EMU_PLATFORM_UI_PAGE][0x2FFC], fw_checksum,
+			sizeof(fw_checksum));
+	(void)memcpy(&p_emu->mem[EMU_PLATFORM_UI_PAGE][VL53L8CX_UI_CMD_STATUS],
+			cmd_status, sizeof(cmd_status));
+}
+
+uint8_t VL53L8CX_RdByte(
+		VL53L8CX_Platform *p_platform,
+		uint16_t RegisterAdress,
+		uint8_t *p_value)
+{
+	return VL53L8CX_RdMulti(p_platform, RegisterAdress, p_value, 1);
+}
+
+uint8_t VL53L8CX_WrByte(
+		VL53L8CX_Platform *p_platform,
+		uint16_t RegisterAdress,
+		uint8_t value)
+{
+	return VL53L8CX_WrMulti(p_platform, RegisterAdress, &value, 1);
+}
+
+uint8_t VL53L8CX_WrMulti(
+		VL53L8CX_Platform *p_platform,
+		uint16_t RegisterAdress,
+		uint8_t *p_values,
+		uint32_t size)
+{
+	uint8_t *p_mem = _emu_platform_access(p_platform, 1, RegisterAdress,
+			size);
+
+	if (p_mem == NULL)
+	{
+		return 255;
+	}
+	(void)memcpy(p_mem, p_values, size);
+	_emu_platform_hash(p_platform, p_values, size);
+	_emu_platform_written(&emu_platform_sensors[p_platform->spi_channel],
+			RegisterAdress, size);
+
+	return 0;
+}
+
+uint8_t VL53L8CX_RdMulti(
+		VL53L8CX_Platform *p_platform,
+		uint16_t RegisterAdress,
+		uint8_t *p_values,
+		uint32_t size)
+{
+	EmuPlatformSensor *p_emu;
+	uint8_t *p_mem;
+	uint64_t now_ns, period_ns;
+	uint32_t footer;
+
+	p_mem = _emu_platform_access(p_platform, 0, RegisterAdress, size);
+	if (p_mem == NULL)
+	{
+		return 255;
+	}
+	p_emu = &emu_platform_sensors[p_platform->spi_channel];
+
+	/* Frames produced since the last read, only the latest is kept */
+	if ((p_emu->page == EMU_PLATFORM_UI_PAGE) && (RegisterAdress == 0U)
+		&& p_emu->is_ranging && (p_emu->period_us != 0U))
+	{
+		now_ns = vl53l8cx_capture_now_ns();
+		period_ns = (uint64_t)p_emu->period_us * 1000U;
+		if (now_ns >= p_emu->next_frame_ns)
+		{
+			p_emu->streamcount = (uint8_t)((p_emu->streamcount
+				+ ((now_ns - p_emu->next_frame_ns) / period_ns))
+				% 255U);
+			p_emu->next_frame_ns += ((now_ns - p_emu->next_frame_ns)
+				/ period_ns + 1U) * period_ns;
+			(void)emu_platform_frame(
+					(uint8_t)p_platform->spi_channel);
+		}
+	}
+
+	(void)memcpy(p_values, p_mem, size);
+
+	/* The first byte of the footer id, once swapped */
+	footer = _emu_platform_word(&p_emu->dci[VL53L8CX_DCI_OUTPUT_CONFIG])
+		- 1U;
+	if ((p_emu->torn_reads != 0U) && (p_emu->page == EMU_PLATFORM_UI_PAGE)
+		&& (footer >= RegisterAdress)
+		&& (footer < ((uint32_t)RegisterAdress + size)))
+	{
+		p_values[footer - RegisterAdress] ^= 0xFFU;
+		p_emu->torn_reads--;
+	}
+	_emu_platform_hash(p_platform, p_values, size);
+
+	return 0;
+}
+
+uint8_t VL53L8CX_Reset_Sensor(
+		VL53L8CX_Platform *p_platform)
+{
+	(void)p_platform;
+
+	return 0;
+}
+
+void VL53L8CX_SwapBuffer(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	uint32_t i, tmp;
+
+	for (i = 0; i < size; i = i + 4)
+	{
+		tmp = ((uint32_t)buffer[i] << 24)
+			| ((uint32_t)buffer[i + 1] << 16)
+			| ((uint32_t)buffer[i + 2] << 8)
+			| (uint32_t)buffer[i + 3];
+		(void)memcpy(&(buffer[i]), &tmp, 4);
+	}
+}
+
+uint8_t VL53L8CX_WaitMs(
+		VL53L8CX_Platform *p_platform,
+		uint32_t TimeMs)
+{
+	if ((uint32_t)p_platform->spi_channel < EMU_PLATFORM_NB_CHANNELS)
+	{
+		emu_platform_sensors[p_platform->spi_channel].wait_ms += TimeMs;
+	}
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef EMU_PLATFORM_H_
+#define EMU_PLATFORM_H_
+
+#include <stdint.h>
+
+#include "platform.h"
+
+/**
+ * @brief Emulated platform, used by the host tests instead of
+ * Platform/platform.c. Each SPI channel is a sensor whose pages (selected by
+ * register 0x7FFF) are memories: writes are stored, and reads return what was
+ * stored. On top of it, the emulator answers like the firmware:
+ * - registers polled by vl53l8cx_init() hold their expected values after
+ *   emu_platform_reset();
+ * - commands written into the UI buffer of page 2 are run: DCI writes store
+ *   their data, DCI reads copy it into the answer buffer, and the start
+ *   command starts ranging. The command status always reports the command as
+ *   done, a test can overwrite it to emulate a firmware which does not answer;
+ * - the MCU stop request stops ranging;
+ * - while ranging, frames are written at address 0 of page 2, following the
+ *   output list, enables and size programmed by vl53l8cx_start_ranging().
+ */
+
+#define EMU_PLATFORM_NB_CHANNELS	4U
+#define EMU_PLATFORM_NB_PAGES		16U
+#define EMU_PLATFORM_PAGE_SIZE		0x8000U
+#define EMU_PLATFORM_DCI_SIZE		0x10000U
+
+/**
+ * @brief Structure EmuPlatformAccess is a transaction recorded into the log of
+ * a sensor.
+ */
+
+typedef struct
+{
+	uint8_t			is_write;
+	uint8_t			page;
+	uint16_t		address;
+	uint32_t		size;
+	/* FNV-1a hash of the bytes written or read */
+	uint32_t		hash;
+} EmuPlatformAccess;
+
+/**
+ * @brief Structure EmuPlatformSensor is the state of an emulated sensor. Tests
+ * may change its fields between two driver calls.
+ */
+
+typedef struct
+{
+	uint8_t			mem[EMU_PLATFORM_NB_PAGES]
+					[EMU_PLATFORM_PAGE_SIZE];
+	/* Firmware parameters, in the byte order of the firmware */
+	uint8_t			dci[EMU_PLATFORM_DCI_SIZE];
+	uint8_t			page;
+	uint8_t			is_ranging;
+	/* Streamcount of the last frame. The next frame takes the next value,
+	 * modulo 255 */
+	uint8_t			streamcount;
+	/* Header and footer id of the last frame */
+	uint16_t		frame_id;
+	/* Frames are written every period_us while ranging, or by
+	 * emu_platform_frame() when period_us is 0 */
+	uint32_t		period_us;
+	uint64_t		next_frame_ns;
+	/* Number of next reads returning a footer which does not match the
+	 * header, as when the frame is read while the firmware writes it */
+	uint32_t		torn_reads;
+	/* State of the generator of the frames contents, not 0 */
+	uint32_t		seed;
+	/* Transactions, bytes transferred, and waits of the driver in ms */
+	uint32_t		transactions;
+	uint32_t		bytes;
+	uint32_t		wait_ms;
+	/* Log of the transactions when p_log is not NULL. Transactions are
+	 * counted into log_count even when the log is full */
+	EmuPlatformAccess	*p_log;
+	uint32_t		log_size;
+	uint32_t		log_count;
+} EmuPlatformSensor;
+
+extern EmuPlatformSensor emu_platform_sensors[EMU_PLATFORM_NB_CHANNELS];
+
+/**
+ * @brief This function powers on an emulated sensor: memories are cleared,
+ * and registers are set as after the boot of a sensor. Frames are written by
+ * emu_platform_frame(), counters are cleared and the log is disabled.
+ * @param (uint8_t) channel : SPI channel of the sensor.
+ */
+
+void emu_platform_reset(
+		uint8_t				channel);
+
+/**
+ * @brief This function writes the next frame of a ranging sensor, with
+ * random results.
+ * @param (uint8_t) channel : SPI channel of the sensor.
+ * @return (uint8_t) streamcount : Streamcount of the frame, or 255 if the
+ * sensor is not ranging.
+ */
+
+uint8_t emu_platform_frame(
+		uint8_t				channel);
+
+#endif /* EMU_PLATFORM_H_ */
@@ -0,0 +1,137 @@
+#include <string.h>
+#include <time.h>
+
+#include "emu_sensor.h"
+#include "vl53l8cx_capture.h"
+
+/* Holds the bus for a transaction, and detects overlapping transactions */
+static void _emu_sensor_transfer(
+		EmuBus				*p_bus,
+		uint32_t			duration_us)
+{
+	struct timespec ts;
+	uint64_t t_start_ns = vl53l8cx_capture_now_ns();
+
+	if (atomic_fetch_add(&p_bus->nb_users, 1U) != 0U)
+	{
+		(void)atomic_fetch_add(&p_bus->collisions, 1U);
+	}
+	ts.tv_sec = (time_t)(duration_us / 1000000U);
+	ts.tv_nsec = (long)(duration_us % 1000000U) * 1000L;
+	(void)clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, NULL);
+	(void)atomic_fetch_sub(&p_bus->nb_users, 1U);
+	(void)atomic_fetch_add(&p_bus->busy_ns,
+			vl53l8cx_capture_now_ns() - t_start_ns);
+}
+
+/* Index of the last frame produced */
+static uint64_t _emu_sensor_frame(
+		EmuSensor			*p_emu)
+{
+	return (vl53l8cx_capture_now_ns() - p_emu->start_ns)
+		/ ((uint64_t)p_emu->period_us * 1000U);
+}
+
+static uint8_t _emu_sensor_check_data_ready(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_isReady)
+{
+	EmuSensor *p_emu = (EmuSensor *)p_dev;
+
+	_emu_sensor_transfer(p_emu->p_bus, p_emu->check_us);
+	if (!p_emu->is_ranging)
+	{
+		p_emu->reads_stopped++;
+		*p_isReady = 0;
+		return VL53L8CX_STATUS_OK;
+	}
+	*p_isReady = (uint8_t)(_emu_sensor_frame(p_emu) > p_emu->frame_read);
+
+	return VL53L8CX_STATUS_OK;
+}
+
+static uint8_t _emu_sensor_get_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	EmuSensor *p_emu = (EmuSensor *)p_dev;
+	uint64_t frame;
+
+	_emu_sensor_transfer(p_emu->p_bus, p_emu->read_us);
+	if (!p_emu->is_ranging)
+	{
+		p_emu->reads_stopped++;
+	}
+	frame = _emu_sensor_frame(p_emu);
+	if ((p_emu->frame_read != 0U) && (frame > (p_emu->frame_read + 1U)))
+	{
+		p_emu->frames_missed += (uint32_t)(frame
+			- p_emu->frame_read - 1U);
+	}
+	p_emu->frame_read = frame;
+	p_emu->frames_read++;
+	p_results->silicon_temp_degc = 25;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+static uint8_t _emu_sensor_async_step(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	EmuSensor *p_emu = (EmuSensor *)p_op->p_dev;
+
+	_emu_sensor_transfer(p_emu->p_bus, p_emu->step_us);
+	p_emu->steps++;
+	p_op->step++;
+	if (p_op->step < p_emu->nb_steps)
+	{
+		p_op->wake_ms = now_ms + p_emu->step_gap_ms;
+		return VL53L8CX_ASYNC_PENDING;
+	}
+
+	if (p_op->operation == p_emu->start_operation)
+	{
+		p_emu->is_ranging = 1;
+	}
+	else if (p_op->operation == p_emu->stop_operation)
+	{
+		p_emu->is_ranging = 0;
+	}
+	/* A new session starts, frames before it are not missed */
+	p_emu->frame_read = 0;
+	p_emu->ops_done++;
+	p_op->status = VL53L8CX_STATUS_OK;
+
+	return VL53L8CX_ASYNC_DONE;
+}
+
+const VL53L8CX_ManagerOps emu_sensor_ops = {
+	_emu_sensor_check_data_ready,
+	_emu_sensor_get_ranging_data,
+	_emu_sensor_async_step
+};
+
+void emu_sensor_init(
+		EmuSensor			*p_emu,
+		EmuBus				*p_bus,
+		uint32_t			period_us,
+		uint32_t			check_us,
+		uint32_t			read_us)
+{
+	VL53L8CX_AsyncOp op;
+
+	(void)memset(p_emu, 0, sizeof(*p_emu));
+	/* Operation codes are private to the driver */
+	(void)vl53l8cx_async_start_ranging(&op, &p_emu->dev, 0);
+	p_emu->start_operation = op.operation;
+	(void)vl53l8cx_async_stop_ranging(&op, &p_emu->dev, 0);
+	p_emu->stop_operation = op.operation;
+	p_emu->p_bus = p_bus;
+	p_emu->start_ns = vl53l8cx_capture_now_ns();
+	p_emu->period_us = period_us;
+	p_emu->check_us = check_us;
+	p_emu->read_us = read_us;
+	p_emu->step_us = check_us;
+	p_emu->nb_steps = 1;
+}
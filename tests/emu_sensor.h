@@ -0,0 +1,83 @@
+#ifndef EMU_SENSOR_H_
+#define EMU_SENSOR_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "vl53l8cx_manager.h"
+
+/**
+ * @brief Structure EmuBus emulates a SPI bus shared by several sensors. A
+ * transaction holds the bus for its whole duration; a transaction started
+ * while another one holds the bus is counted as a collision.
+ */
+
+typedef struct
+{
+	atomic_uint		nb_users;
+	atomic_uint		collisions;
+	/* Time spent in transactions, in ns */
+	atomic_ullong		busy_ns;
+} EmuBus;
+
+/**
+ * @brief Structure EmuSensor emulates a ranging sensor for the manager: a
+ * frame is produced every period_us from emu_sensor_init(), and each check,
+ * frame read or operation step is a bus transaction of a given duration. An
+ * operation takes nb_steps steps, step_gap_ms apart; start and stop operations
+ * change the ranging state when they are done. The device must stay the
+ * first field, the emulated functions get the sensor from it.
+ */
+
+typedef struct
+{
+	VL53L8CX_Configuration	dev;
+	EmuBus			*p_bus;
+	uint64_t		start_ns;
+	uint32_t		period_us;
+	uint32_t		check_us;
+	uint32_t		read_us;
+	uint32_t		step_us;
+	uint32_t		step_gap_ms;
+	uint8_t			nb_steps;
+	/* Code of the start and stop operations of the driver */
+	uint8_t			start_operation;
+	uint8_t			stop_operation;
+	uint8_t			is_ranging;
+	/* Index of the last frame read, 0 when no frame was read in the
+	 * current session */
+	uint64_t		frame_read;
+	/* Frames produced between two frames read, and never read */
+	uint32_t		frames_missed;
+	uint32_t		frames_read;
+	/* Checks and frame reads while the sensor is not ranging */
+	uint32_t		reads_stopped;
+	/* Operation steps run, and operations done */
+	uint32_t		steps;
+	uint32_t		ops_done;
+} EmuSensor;
+
+/**
+ * @brief Functions driving emulated sensors, given to vl53l8cx_manager_init().
+ */
+
+extern const VL53L8CX_ManagerOps emu_sensor_ops;
+
+/**
+ * @brief This function initializes an emulated sensor, which is not ranging.
+ * Operations take 1 step of check_us by default.
+ * @param (EmuSensor) *p_emu : Emulated sensor.
+ * @param (EmuBus) *p_bus : Bus of the sensor.
+ * @param (uint32_t) period_us : Frame period.
+ * @param (uint32_t) check_us : Duration of a data ready check.
+ * @param (uint32_t) read_us : Duration of a frame read.
+ */
+
+void emu_sensor_init(
+		EmuSensor			*p_emu,
+		EmuBus				*p_bus,
+		uint32_t			period_us,
+		uint32_t			check_us,
+		uint32_t			read_us);
+
+#endif /* EMU_SENSOR_H_ */
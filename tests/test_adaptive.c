@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_adaptive.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		0U
+#define TEST_MS_NS		1000000ULL
+#define TEST_PERIOD_4X4_NS	((1000U / VL53L8CX_ADAPTIVE_FREQUENCY_4X4_HZ) \
+					* TEST_MS_NS)
+#define TEST_PERIOD_8X8_NS	((1000U / VL53L8CX_ADAPTIVE_FREQUENCY_8X8_HZ) \
+					* TEST_MS_NS)
+
+static uint32_t nb_failures;
+
+static VL53L8CX_Configuration dev;
+static VL53L8CX_Capture cap;
+static VL53L8CX_Adaptive ad;
+static VL53L8CX_CaptureFrame frame;
+static uint64_t t_ns;
+
+/*
+ * Next frame of the current resolution, ready after the current time, with
+ * all zones valid at far_mm except zone 0 at near_mm. Returns the resolution
+ * given by the engine.
+ */
+static uint8_t _test_frame(
+		int16_t				near_mm,
+		int16_t				far_mm)
+{
+	uint32_t zone, nb_zones = ad.frame_resolution;
+
+	t_ns += (nb_zones == VL53L8CX_RESOLUTION_8X8) ? TEST_PERIOD_8X8_NS
+		: TEST_PERIOD_4X4_NS;
+	if (t_ns < vl53l8cx_capture_now_ns())
+	{
+		t_ns = vl53l8cx_capture_now_ns();
+	}
+	frame.status = VL53L8CX_STATUS_OK;
+	frame.t_ready_ns = t_ns;
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		frame.results.distance_mm[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			(zone == 0U) ? near_mm : far_mm;
+		frame.results.target_status[zone
+			* VL53L8CX_NB_TARGET_PER_ZONE] = 5U;
+		frame.results.nb_target_detected[zone] = 1;
+	}
+	(void)vl53l8cx_update_validity(&frame.results, (uint8_t)nb_zones);
+
+	return vl53l8cx_adaptive_update(&ad, &frame);
+}
+
+/* Applies the queued switch as the acquisition thread would */
+static void _test_apply(void)
+{
+	TEST_CHECK(vl53l8cx_command_queue_apply(&cap.commands, &dev, 0) == 1U);
+}
+
+/*
+ * A target into the distance band switches to 8x8, which is kept for the
+ * hysteresis interval after the last trigger, then 4x4 comes back. The switch
+ * time is the gap between the last frame of a resolution and the first one of
+ * the next.
+ */
+static void _test_distance_band(void)
+{
+	VL53L8CX_AdaptiveReport report;
+	uint64_t t_last_ns, t_trigger_ns;
+	uint32_t first_switch_us, i;
+	uint8_t resolution;
+
+	TEST_CHECK(vl53l8cx_adaptive_configure(&ad, &dev)
+			== VL53L8CX_STATUS_OK);
+	for (i = 0; i < 10U; i++)
+	{
+		TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_4X4);
+	}
+	TEST_CHECK(ad.is_command_pending == 0U);
+	vl53l8cx_adaptive_get_report(&ad, &report);
+	TEST_CHECK(report.nearest_mm == 2000);
+	TEST_CHECK(report.variance_mm2 == 0U);
+
+	/* One zone within 1 m */
+	TEST_CHECK(_test_frame(900, 2000) == VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK(ad.is_command_pending == 1U);
+	TEST_CHECK(ad.resolution == VL53L8CX_RESOLUTION_8X8);
+	TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_4X4);
+	t_last_ns = t_ns;
+	_test_apply();
+	TEST_CHECK(vl53l8cx_get_resolution(&dev, &resolution)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(resolution == VL53L8CX_RESOLUTION_8X8);
+	t_ns += 30U * TEST_MS_NS;
+	TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_8X8);
+	vl53l8cx_adaptive_get_report(&ad, &report);
+	TEST_CHECK(report.resolution == VL53L8CX_RESOLUTION_8X8);
+	TEST_CHECK(report.switches_up == 1U);
+	TEST_CHECK(report.last_switch_us == ((t_ns - t_last_ns) / 1000U));
+	TEST_CHECK(report.max_switch_us == report.last_switch_us);
+	first_switch_us = report.last_switch_us;
+
+	/* A trigger during the hysteresis interval extends it */
+	t_trigger_ns = t_ns;
+	while ((t_ns - t_trigger_ns) < (500U * TEST_MS_NS))
+	{
+		TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_8X8);
+	}
+	TEST_CHECK(_test_frame(500, 2000) == VL53L8CX_RESOLUTION_8X8);
+	t_trigger_ns = t_ns;
+	while (!ad.is_command_pending)
+	{
+		TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_8X8);
+	}
+	TEST_CHECK(ad.resolution == VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK((t_ns - t_trigger_ns) >= (VL53L8CX_ADAPTIVE_HYSTERESIS_MS
+			* TEST_MS_NS));
+	TEST_CHECK((t_ns - t_trigger_ns) < ((VL53L8CX_ADAPTIVE_HYSTERESIS_MS
+			* TEST_MS_NS) + TEST_PERIOD_8X8_NS));
+	t_last_ns = t_ns;
+	_test_apply();
+	t_ns += 40U * TEST_MS_NS;
+	TEST_CHECK(_test_frame(2000, 2000) == VL53L8CX_RESOLUTION_4X4);
+	vl53l8cx_adaptive_get_report(&ad, &report);
+	TEST_CHECK(report.switches_down == 1U);
+	TEST_CHECK(report.last_switch_us == ((t_ns - t_last_ns) / 1000U));
+	TEST_CHECK(report.max_switch_us == report.last_switch_us);
+	TEST_CHECK(report.total_switch_us == (first_switch_us
+			+ report.last_switch_us));
+	TEST_CHECK(report.time_8x8_ms >= 1500U);
+}
+
+/*
+ * Distances which spread switch to 8x8 with no target near, and a failed
+ * switch is retried only after the hysteresis interval.
+ */
+static void _test_variance_retry(void)
+{
+	VL53L8CX_AdaptiveReport report;
+	uint64_t t_fail_ns;
+
+	TEST_CHECK(vl53l8cx_adaptive_configure(&ad, &dev)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(_test_frame(2000, 2100) == VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK(ad.is_command_pending == 0U);
+
+	/* 1 zone at 1500 mm and 15 at 4000 mm: variance of 366210 mm^2 */
+	TEST_CHECK(_test_frame(1500, 4000) == VL53L8CX_RESOLUTION_4X4);
+	vl53l8cx_adaptive_get_report(&ad, &report);
+	TEST_CHECK(report.nearest_mm == 1500);
+	TEST_CHECK(report.variance_mm2 == 366210U);
+	TEST_CHECK(ad.is_command_pending == 1U);
+
+	/* The switch fails, the spread goes on */
+	TEST_CHECK(vl53l8cx_command_queue_cancel(&cap.commands,
+			VL53L8CX_STATUS_ERROR) == 1U);
+	TEST_CHECK(_test_frame(1500, 4000) == VL53L8CX_RESOLUTION_4X4);
+	t_fail_ns = t_ns;
+	TEST_CHECK(ad.resolution == VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK(ad.is_command_pending == 0U);
+	while ((t_ns + TEST_PERIOD_4X4_NS) < (t_fail_ns
+			+ (VL53L8CX_ADAPTIVE_HYSTERESIS_MS * TEST_MS_NS)))
+	{
+		TEST_CHECK(_test_frame(1500, 4000) == VL53L8CX_RESOLUTION_4X4);
+		TEST_CHECK(ad.is_command_pending == 0U);
+	}
+	TEST_CHECK(_test_frame(1500, 4000) == VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK(ad.is_command_pending == 1U);
+	_test_apply();
+	TEST_CHECK(_test_frame(1500, 4000) == VL53L8CX_RESOLUTION_8X8);
+	vl53l8cx_adaptive_get_report(&ad, &report);
+	TEST_CHECK(report.switches_up == 2U);
+}
+
+int main(void)
+{
+	(void)memset(&dev, 0, sizeof(dev));
+	emu_platform_reset(TEST_CHANNEL);
+	dev.platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_capture_init(&cap) == VL53L8CX_STATUS_OK);
+	vl53l8cx_adaptive_init(&ad, &cap, NULL);
+
+	_test_distance_band();
+	_test_variance_retry();
+	vl53l8cx_capture_deinit(&cap);
+
+	(void)printf("test_adaptive: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
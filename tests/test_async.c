@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_LOG_SIZE		4096U
+
+/* Blocking calls on channel 0, non-blocking ones on channel 1 */
+#define TEST_BLOCKING		0U
+#define TEST_ASYNC		1U
+
+static uint32_t nb_failures;
+
+static EmuPlatformAccess logs[2][TEST_LOG_SIZE];
+
+/* Start of the logs of a blocking call and of its non-blocking version */
+static void _test_begin(void)
+{
+	uint8_t channel;
+
+	for (channel = TEST_BLOCKING; channel <= TEST_ASYNC; channel++)
+	{
+		emu_platform_sensors[channel].p_log = logs[channel];
+		emu_platform_sensors[channel].log_size = TEST_LOG_SIZE;
+		emu_platform_sensors[channel].log_count = 0;
+		emu_platform_sensors[channel].wait_ms = 0;
+	}
+}
+
+/* Byte of the command status of both sensors, from now on */
+static void _test_command_status(
+		uint8_t				pos,
+		uint8_t				value)
+{
+	uint8_t channel;
+
+	for (channel = TEST_BLOCKING; channel <= TEST_ASYNC; channel++)
+	{
+		emu_platform_sensors[channel].mem[2][VL53L8CX_UI_CMD_STATUS
+			+ pos] = value;
+	}
+}
+
+/*
+ * Runs an operation with a clock which jumps to the wake time, and returns the
+ * time it took. Each step must leave the wake time in the future.
+ */
+static uint32_t _test_run(
+		VL53L8CX_AsyncOp		*p_op,
+		uint32_t			now_ms)
+{
+	uint32_t start_ms = now_ms, nb_steps = 0;
+
+	while (vl53l8cx_async_step(p_op, now_ms) == VL53L8CX_ASYNC_PENDING)
+	{
+		TEST_CHECK((int32_t)(p_op->wake_ms - now_ms) > 0);
+		/* Too early: nothing is done */
+		TEST_CHECK(vl53l8cx_async_step(p_op, p_op->wake_ms - 1U)
+				== VL53L8CX_ASYNC_PENDING);
+		now_ms = p_op->wake_ms;
+		nb_steps++;
+		if (nb_steps > 10000U)
+		{
+			TEST_CHECK(nb_steps <= 10000U);
+			break;
+		}
+	}
+
+	return now_ms - start_ms;
+}
+
+/*
+ * Same transactions with the same bytes, and the time waited by the blocking
+ * call is the time taken by the non-blocking one.
+ */
+static void _test_compare(
+		const char			*p_name,
+		uint32_t			elapsed_ms)
+{
+	const EmuPlatformSensor *p_blocking =
+		&emu_platform_sensors[TEST_BLOCKING];
+	const EmuPlatformSensor *p_async = &emu_platform_sensors[TEST_ASYNC];
+	uint32_t i, nb_mismatches = 0;
+
+	TEST_CHECK(p_blocking->log_count <= TEST_LOG_SIZE);
+	TEST_CHECK(p_async->log_count == p_blocking->log_count);
+	for (i = 0; (i < p_blocking->log_count) && (i < p_async->log_count)
+			&& (i < TEST_LOG_SIZE); i++)
+	{
+		if (memcmp(&logs[TEST_BLOCKING][i], &logs[TEST_ASYNC][i],
+				sizeof(EmuPlatformAccess)) != 0)
+		{
+			nb_mismatches++;
+		}
+	}
+	(void)printf("%s: %u transactions, %u mismatches, %u ms waited, "
+			"%u ms elapsed\n", p_name, p_blocking->log_count,
+			nb_mismatches, p_blocking->wait_ms, elapsed_ms);
+	TEST_CHECK(nb_mismatches == 0U);
+	TEST_CHECK(elapsed_ms == p_blocking->wait_ms);
+}
+
+/* Each non-blocking operation against the blocking function */
+static void _test_sequences(void)
+{
+	static VL53L8CX_Configuration devs[2];
+	VL53L8CX_AsyncOp op;
+	VL53L8CX_Configuration *p_blocking = &devs[TEST_BLOCKING];
+	VL53L8CX_Configuration *p_async = &devs[TEST_ASYNC];
+	uint8_t blocking_data[8], async_data[8];
+	uint8_t sharpener[4] = {5, 0, 0, 0};
+	uint32_t elapsed_ms, now_ms = 0xFFFFF000U;
+	uint8_t channel;
+
+	for (channel = TEST_BLOCKING; channel <= TEST_ASYNC; channel++)
+	{
+		(void)memset(&devs[channel], 0, sizeof(devs[channel]));
+		emu_platform_reset(channel);
+		devs[channel].platform.spi_channel = channel;
+	}
+
+	/* The clock wraps during init */
+	_test_begin();
+	TEST_CHECK(vl53l8cx_init(p_blocking) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_async_init(&op, p_async, now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_OK);
+	_test_compare("init", elapsed_ms);
+	TEST_CHECK(memcmp(p_async->offset_data, p_blocking->offset_data,
+			VL53L8CX_OFFSET_BUFFER_SIZE) == 0);
+	TEST_CHECK(memcmp(p_async->xtalk_data, p_blocking->xtalk_data,
+			VL53L8CX_XTALK_BUFFER_SIZE) == 0);
+
+	_test_begin();
+	TEST_CHECK(vl53l8cx_dci_write_data(p_blocking, sharpener,
+			VL53L8CX_DCI_SHARPENER, sizeof(sharpener))
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_async_dci_write_data(&op, p_async, sharpener,
+			VL53L8CX_DCI_SHARPENER, sizeof(sharpener), now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_OK);
+	_test_compare("dci write", elapsed_ms);
+
+	_test_begin();
+	TEST_CHECK(vl53l8cx_dci_read_data(p_blocking, blocking_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(blocking_data))
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_async_dci_read_data(&op, p_async, async_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(async_data), now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_OK);
+	_test_compare("dci read", elapsed_ms);
+	TEST_CHECK(memcmp(async_data, blocking_data, sizeof(async_data)) == 0);
+
+	_test_begin();
+	TEST_CHECK(vl53l8cx_start_ranging(p_blocking) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_async_start_ranging(&op, p_async, now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_OK);
+	_test_compare("start", elapsed_ms);
+	TEST_CHECK(p_async->data_read_size == p_blocking->data_read_size);
+	TEST_CHECK(emu_platform_sensors[TEST_ASYNC].is_ranging == 1U);
+
+	_test_begin();
+	TEST_CHECK(vl53l8cx_stop_ranging(p_blocking) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_async_stop_ranging(&op, p_async, now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_OK);
+	_test_compare("stop", elapsed_ms);
+	TEST_CHECK(emu_platform_sensors[TEST_ASYNC].is_ranging == 0U);
+
+	/* Command never answered: timeout after 200 polls of 10 ms */
+	_test_command_status(1, 0x00);
+	_test_begin();
+	TEST_CHECK(vl53l8cx_dci_read_data(p_blocking, blocking_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(blocking_data))
+			== VL53L8CX_STATUS_TIMEOUT_ERROR);
+	TEST_CHECK(vl53l8cx_async_dci_read_data(&op, p_async, async_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(async_data), now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	now_ms += elapsed_ms;
+	TEST_CHECK(op.status == VL53L8CX_STATUS_TIMEOUT_ERROR);
+	_test_compare("timeout", elapsed_ms);
+	/* Request, 201 reads of the status, then the answer */
+	TEST_CHECK(emu_platform_sensors[TEST_ASYNC].log_count
+			== (1U + 201U + 1U));
+	TEST_CHECK(elapsed_ms == 2010U);
+
+	/* MCU error reported into the command status */
+	_test_command_status(2, 0x7F);
+	_test_begin();
+	TEST_CHECK(vl53l8cx_dci_read_data(p_blocking, blocking_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(blocking_data))
+			== VL53L8CX_MCU_ERROR);
+	TEST_CHECK(vl53l8cx_async_dci_read_data(&op, p_async, async_data,
+			VL53L8CX_DCI_ZONE_CONFIG, sizeof(async_data), now_ms)
+			== VL53L8CX_STATUS_OK);
+	elapsed_ms = _test_run(&op, now_ms);
+	TEST_CHECK(op.status == VL53L8CX_MCU_ERROR);
+	_test_compare("mcu error", elapsed_ms);
+
+	for (channel = TEST_BLOCKING; channel <= TEST_ASYNC; channel++)
+	{
+		emu_platform_sensors[channel].p_log = NULL;
+	}
+}
+
+int main(void)
+{
+	_test_sequences();
+
+	(void)printf("test_async: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vl53l8cx_capture.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		0U
+#define TEST_PERIOD_US		5000U
+#define TEST_POLL_US		100U
+
+static uint32_t nb_failures;
+
+static VL53L8CX_Configuration dev;
+static VL53L8CX_Capture cap;
+
+/* Frames missed between two streamcounts, which never take the value 255 */
+static uint32_t _test_gap(
+		uint8_t				previous,
+		uint8_t				streamcount)
+{
+	return (((uint32_t)streamcount + 255U - previous) % 255U) - 1U;
+}
+
+/*
+ * A consumer stalled for 20 frames: the frames not read while the ring is full
+ * are overruns, and the frames missed by the thread itself are dropped, never
+ * both.
+ */
+static void _test_overruns(void)
+{
+	static VL53L8CX_CaptureFrame frame;
+	VL53L8CX_CaptureStats stats;
+	uint32_t nb_frames = 0, nb_missed = 0;
+	uint8_t previous = 0;
+
+	TEST_CHECK(vl53l8cx_capture_start(&cap, &dev, TEST_POLL_US)
+			== VL53L8CX_STATUS_OK);
+	(void)usleep(20U * TEST_PERIOD_US);
+	vl53l8cx_capture_get_stats(&cap, &stats);
+	TEST_CHECK(stats.frames_captured == VL53L8CX_CAPTURE_RING_SIZE);
+	TEST_CHECK(stats.overruns > 0U);
+
+	/* Consume until the thread captures again, then drain after stop */
+	while (nb_frames < (2U * VL53L8CX_CAPTURE_RING_SIZE))
+	{
+		if (vl53l8cx_capture_pop(&cap, &frame) == 0U)
+		{
+			(void)vl53l8cx_capture_wait(&cap, 100);
+			continue;
+		}
+		TEST_CHECK(frame.status == VL53L8CX_STATUS_OK);
+		if (nb_frames != 0U)
+		{
+			nb_missed += _test_gap(previous, frame.streamcount);
+		}
+		previous = frame.streamcount;
+		nb_frames++;
+	}
+	TEST_CHECK(vl53l8cx_capture_stop(&cap) == VL53L8CX_STATUS_OK);
+	while (vl53l8cx_capture_pop(&cap, &frame) != 0U)
+	{
+		nb_missed += _test_gap(previous, frame.streamcount);
+		previous = frame.streamcount;
+		nb_frames++;
+	}
+
+	vl53l8cx_capture_get_stats(&cap, &stats);
+	(void)printf("%u frames, %u missed: %u overruns, %u dropped, "
+			"%u late\n", nb_frames, nb_missed, stats.overruns,
+			stats.frames_dropped, stats.frames_late);
+	TEST_CHECK(stats.frames_captured == nb_frames);
+	TEST_CHECK((stats.overruns + stats.frames_dropped) == nb_missed);
+	TEST_CHECK(stats.read_errors == 0U);
+	TEST_CHECK(stats.frames_corrupted == 0U);
+}
+
+/* The latest frame discards the older ones, and is kept until released */
+static void _test_peek_latest(void)
+{
+	const VL53L8CX_CaptureFrame *p_oldest, *p_latest;
+	VL53L8CX_CaptureStats stats;
+	uint8_t oldest;
+
+	TEST_CHECK(vl53l8cx_capture_peek_latest(&cap) == NULL);
+	TEST_CHECK(vl53l8cx_capture_start(&cap, &dev, TEST_POLL_US)
+			== VL53L8CX_STATUS_OK);
+	(void)usleep(12U * TEST_PERIOD_US);
+	TEST_CHECK(vl53l8cx_capture_stop(&cap) == VL53L8CX_STATUS_OK);
+
+	p_oldest = vl53l8cx_capture_peek(&cap);
+	TEST_CHECK(p_oldest != NULL);
+	if (p_oldest == NULL)
+	{
+		return;
+	}
+	oldest = p_oldest->streamcount;
+	p_latest = vl53l8cx_capture_peek_latest(&cap);
+	TEST_CHECK(p_latest != NULL);
+	if (p_latest == NULL)
+	{
+		return;
+	}
+	/* The ring was filled once since the start */
+	TEST_CHECK(p_latest == &cap.slots[VL53L8CX_CAPTURE_RING_SIZE - 1U]);
+	TEST_CHECK(_test_gap(oldest, p_latest->streamcount)
+			>= (VL53L8CX_CAPTURE_RING_SIZE - 2U));
+	vl53l8cx_capture_get_stats(&cap, &stats);
+	TEST_CHECK(stats.frames_skipped == (VL53L8CX_CAPTURE_RING_SIZE - 1U));
+
+	/* Still the latest until released, then the ring is empty */
+	TEST_CHECK(vl53l8cx_capture_peek(&cap) == p_latest);
+	vl53l8cx_capture_release(&cap);
+	TEST_CHECK(vl53l8cx_capture_peek(&cap) == NULL);
+	TEST_CHECK(vl53l8cx_capture_peek_latest(&cap) == NULL);
+	vl53l8cx_capture_get_stats(&cap, &stats);
+	TEST_CHECK(stats.frames_skipped == (VL53L8CX_CAPTURE_RING_SIZE - 1U));
+}
+
+/* A command queued while the engine is stopped is applied by the next start */
+static void _test_commands(void)
+{
+	static VL53L8CX_CaptureFrame frame;
+	VL53L8CX_Command cmd;
+	VL53L8CX_CaptureStats stats;
+	uint8_t sharpener = 0;
+
+	TEST_CHECK(vl53l8cx_command_init(&cmd,
+			VL53L8CX_COMMAND_SHARPENER_PERCENT, 20, NULL, NULL)
+			== VL53L8CX_STATUS_OK);
+	vl53l8cx_capture_submit(&cap, &cmd);
+	(void)usleep(2U * TEST_PERIOD_US);
+	TEST_CHECK(vl53l8cx_command_wait(&cmd, 0) == 0U);
+
+	TEST_CHECK(vl53l8cx_capture_start(&cap, &dev, TEST_POLL_US)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_command_wait(&cmd, 1000) == 1U);
+	TEST_CHECK(cmd.status == VL53L8CX_STATUS_OK);
+	vl53l8cx_command_deinit(&cmd);
+
+	/* Ranging restarted after the command */
+	TEST_CHECK(vl53l8cx_capture_wait(&cap, 1000) == 1U);
+	TEST_CHECK(vl53l8cx_capture_pop(&cap, &frame) == 1U);
+	TEST_CHECK(frame.status == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_capture_stop(&cap) == VL53L8CX_STATUS_OK);
+	vl53l8cx_capture_get_stats(&cap, &stats);
+	TEST_CHECK(stats.commands_applied == 1U);
+	TEST_CHECK(emu_platform_sensors[TEST_CHANNEL].is_ranging == 0U);
+
+	TEST_CHECK(vl53l8cx_pool_begin(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_get_sharpener_percent(&dev, &sharpener)
+			== VL53L8CX_STATUS_OK);
+	vl53l8cx_pool_end(&dev);
+	TEST_CHECK(sharpener == 20U);
+}
+
+int main(void)
+{
+	(void)memset(&dev, 0, sizeof(dev));
+	emu_platform_reset(TEST_CHANNEL);
+	emu_platform_sensors[TEST_CHANNEL].period_us = TEST_PERIOD_US;
+	dev.platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_capture_init(&cap) == VL53L8CX_STATUS_OK);
+
+	_test_overruns();
+	_test_peek_latest();
+	_test_commands();
+	vl53l8cx_capture_deinit(&cap);
+
+	(void)printf("test_capture: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
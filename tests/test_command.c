@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "vl53l8cx_command.h"
+#include "vl53l8cx_capture.h"
+#include "test_common.h"
+
+#define TEST_NB_PRODUCERS	4U
+#define TEST_NB_COMMANDS	50000U
+#define TEST_WINDOW		8U
+
+/* A command in flight, reused once it has completed */
+typedef struct
+{
+	VL53L8CX_Command	cmd;
+	uint32_t		producer;
+	uint32_t		seq;
+	atomic_uint		is_done;
+} TestSlot;
+
+typedef struct
+{
+	uint32_t		id;
+	TestSlot		slots[TEST_WINDOW];
+	uint32_t		nb_timeouts;
+} TestProducer;
+
+static uint32_t nb_failures;
+static VL53L8CX_CommandQueue queue;
+static TestProducer producers[TEST_NB_PRODUCERS];
+
+/* Only written by the consumer */
+static uint32_t next_seq[TEST_NB_PRODUCERS];
+static uint32_t nb_out_of_order;
+static uint32_t nb_run;
+
+static uint8_t _test_command_run(
+		VL53L8CX_Configuration		*p_dev,
+		void				*p_arg)
+{
+	TestSlot *p_slot = (TestSlot *)p_arg;
+
+	(void)p_dev;
+	if (p_slot->seq != next_seq[p_slot->producer])
+	{
+		nb_out_of_order++;
+	}
+	next_seq[p_slot->producer] = p_slot->seq + 1U;
+	nb_run++;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+static void _test_command_done(
+		VL53L8CX_Command		*p_cmd,
+		void				*p_user)
+{
+	(void)p_cmd;
+	atomic_store(&((TestSlot *)p_user)->is_done, 1U);
+}
+
+/*
+ * Pushes the commands of a producer, TEST_WINDOW in flight. Even producers
+ * use the done callback and odd ones vl53l8cx_command_wait(), and each command
+ * is prepared again as soon as it has completed.
+ */
+static void *_test_producer_thread(void *arg)
+{
+	TestProducer *p_prod = (TestProducer *)arg;
+	uint8_t has_callback = (uint8_t)((p_prod->id % 2U) == 0U);
+	TestSlot *p_slot;
+	uint32_t seq;
+
+	for (seq = 0; seq < TEST_NB_COMMANDS; seq++)
+	{
+		p_slot = &p_prod->slots[seq % TEST_WINDOW];
+		if (seq >= TEST_WINDOW)
+		{
+			if (has_callback)
+			{
+				while (atomic_load(&p_slot->is_done) == 0U)
+				{
+					(void)sched_yield();
+				}
+			}
+			else if (vl53l8cx_command_wait(&p_slot->cmd, 5000) == 0U)
+			{
+				p_prod->nb_timeouts++;
+				break;
+			}
+			vl53l8cx_command_deinit(&p_slot->cmd);
+		}
+
+		p_slot->producer = p_prod->id;
+		p_slot->seq = seq;
+		atomic_store(&p_slot->is_done, 0U);
+		TEST_CHECK(vl53l8cx_command_init_custom(&p_slot->cmd,
+				_test_command_run, p_slot, has_callback
+				? _test_command_done : NULL, p_slot)
+				== VL53L8CX_STATUS_OK);
+		vl53l8cx_command_queue_push(&queue, &p_slot->cmd);
+	}
+
+	return NULL;
+}
+
+/*
+ * Producers push concurrently while the consumer applies: every command must
+ * run once, in the order of its producer, and complete.
+ */
+static void _test_stress(void)
+{
+	static VL53L8CX_Configuration dev;
+	pthread_t threads[TEST_NB_PRODUCERS];
+	uint64_t start_ns, last_ns, now_ns;
+	uint32_t i, k, nb_applied = 0, nb_batches = 0, n;
+
+	vl53l8cx_command_queue_init(&queue);
+	for (i = 0; i < TEST_NB_PRODUCERS; i++)
+	{
+		producers[i].id = i;
+		TEST_CHECK(pthread_create(&threads[i], NULL,
+				_test_producer_thread, &producers[i]) == 0);
+	}
+
+	start_ns = vl53l8cx_capture_now_ns();
+	last_ns = start_ns;
+	while (nb_applied < (TEST_NB_PRODUCERS * TEST_NB_COMMANDS))
+	{
+		n = vl53l8cx_command_queue_apply(&queue, &dev, 0);
+		now_ns = vl53l8cx_capture_now_ns();
+		if (n != 0U)
+		{
+			nb_applied += n;
+			nb_batches++;
+			last_ns = now_ns;
+		}
+		else if ((now_ns - last_ns) > 5000000000ULL)
+		{
+			break;
+		}
+		else
+		{
+			(void)sched_yield();
+		}
+	}
+
+	for (i = 0; i < TEST_NB_PRODUCERS; i++)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+
+	(void)printf("%u commands in %u batches, %.1f ms\n", nb_applied,
+			nb_batches, (double)(vl53l8cx_capture_now_ns()
+			- start_ns) / 1e6);
+	TEST_CHECK(nb_applied == (TEST_NB_PRODUCERS * TEST_NB_COMMANDS));
+	TEST_CHECK(nb_run == nb_applied);
+	TEST_CHECK(nb_out_of_order == 0U);
+	for (i = 0; i < TEST_NB_PRODUCERS; i++)
+	{
+		TEST_CHECK(next_seq[i] == TEST_NB_COMMANDS);
+		TEST_CHECK(producers[i].nb_timeouts == 0U);
+		for (k = 0; k < TEST_WINDOW; k++)
+		{
+			if ((i % 2U) != 0U)
+			{
+				TEST_CHECK(vl53l8cx_command_wait(
+					&producers[i].slots[k].cmd, 0) == 1U);
+			}
+			else
+			{
+				TEST_CHECK(atomic_load(
+					&producers[i].slots[k].is_done) == 1U);
+			}
+			vl53l8cx_command_deinit(&producers[i].slots[k].cmd);
+		}
+	}
+	TEST_CHECK(vl53l8cx_command_queue_cancel(&queue,
+			VL53L8CX_STATUS_ERROR) == 0U);
+}
+
+/* Commands left in the queue are completed by a cancel, in order */
+static void _test_cancel(void)
+{
+	static VL53L8CX_Command cmd[3];
+	uint32_t i;
+
+	vl53l8cx_command_queue_init(&queue);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_command_init(&cmd[i],
+				VL53L8CX_COMMAND_FREQUENCY_HZ, 15, NULL, NULL)
+				== VL53L8CX_STATUS_OK);
+		vl53l8cx_command_queue_push(&queue, &cmd[i]);
+	}
+	TEST_CHECK(vl53l8cx_command_queue_cancel(&queue,
+			VL53L8CX_STATUS_ERROR) == 3U);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_command_wait(&cmd[i], 0) == 1U);
+		TEST_CHECK(cmd[i].status == VL53L8CX_STATUS_ERROR);
+		vl53l8cx_command_deinit(&cmd[i]);
+	}
+	TEST_CHECK(vl53l8cx_command_queue_cancel(&queue,
+			VL53L8CX_STATUS_ERROR) == 0U);
+}
+
+int main(void)
+{
+	_test_stress();
+	_test_cancel();
+
+	(void)printf("test_command: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Macro TEST_CHECK prints a condition which is false, and counts it
+ * into the nb_failures counter defined by each test.
+ */
+
+#define TEST_CHECK(cond)						\
+	do {								\
+		if (!(cond))						\
+		{							\
+			(void)printf("%s:%d: failed: %s\n", __FILE__,	\
+					__LINE__, #cond);		\
+			nb_failures++;					\
+		}							\
+	} while (0)
+
+/**
+ * @brief This function returns the next value of a xorshift generator, so the
+ * frames of the tests and benchmarks are the same on each run.
+ * @param (uint32_t) *p_seed : State of the generator, must not be 0.
+ * @return (uint32_t) value : Next value.
+ */
+
+static inline uint32_t test_random(
+		uint32_t			*p_seed)
+{
+	*p_seed ^= *p_seed << 13;
+	*p_seed ^= *p_seed >> 17;
+	*p_seed ^= *p_seed << 5;
+
+	return *p_seed;
+}
+
+#endif /* TEST_COMMON_H_ */
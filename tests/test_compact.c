@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_compact.h"
+#include "test_common.h"
+
+#define TEST_N			VL53L8CX_NB_TARGET_PER_ZONE
+
+/* Fractional bits of the rates decoded by the driver */
+#ifdef VL53L8CX_USE_RAW_FORMAT
+#define TEST_RATE_FRAC_BITS	11U
+#else
+#define TEST_RATE_FRAC_BITS	0U
+#endif
+
+/* Largest rate of a compact frame, 0xFFFF with 2 fractional bits */
+#define TEST_RATE_MAX		((uint32_t)(((uint64_t)0xFFFFU \
+	<< TEST_RATE_FRAC_BITS) >> VL53L8CX_COMPACT_RATE_FRAC_BITS))
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x85EBCA6BU;
+
+static uint8_t buffer[VL53L8CX_COMPACT_MAX_SIZE + 2U]
+	__attribute__((aligned(8)));
+
+/* Driver rate after a round trip through 2 fractional bits */
+static uint32_t _test_rate(
+		uint32_t			value)
+{
+	uint64_t fixed = ((uint64_t)value << VL53L8CX_COMPACT_RATE_FRAC_BITS)
+		>> TEST_RATE_FRAC_BITS;
+
+	if (fixed > 0xFFFFU)
+	{
+		fixed = 0xFFFFU;
+	}
+
+	return (uint32_t)((fixed << TEST_RATE_FRAC_BITS)
+		>> VL53L8CX_COMPACT_RATE_FRAC_BITS);
+}
+
+/* Random results, with rates and spads around the limits of 16 bits */
+static void _test_fill(
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint32_t i;
+
+	p_results->silicon_temp_degc = (int8_t)(test_random(&seed) % 100U);
+	for (i = 0; i < (VL53L8CX_RESOLUTION_8X8 * TEST_N); i++)
+	{
+		p_results->distance_mm[i] = (int16_t)((test_random(&seed)
+			% 4200U) - 100U);
+		p_results->range_sigma_mm[i] = (uint16_t)test_random(&seed);
+		p_results->signal_per_spad[i] = test_random(&seed)
+			>> (test_random(&seed) % 32U);
+		p_results->target_status[i] = (uint8_t)(test_random(&seed)
+			% 14U);
+		p_results->reflectance[i] = (uint8_t)test_random(&seed);
+	}
+	for (i = 0; i < VL53L8CX_RESOLUTION_8X8; i++)
+	{
+		p_results->ambient_per_spad[i] = test_random(&seed)
+			>> (test_random(&seed) % 32U);
+		p_results->nb_spads_enabled[i] = test_random(&seed)
+			>> (test_random(&seed) % 32U);
+		p_results->nb_target_detected[i] = (uint8_t)(test_random(&seed)
+			% (TEST_N + 1U));
+	}
+}
+
+/*
+ * Pack then unpack: values are kept, rates keep 2 fractional bits and
+ * saturate, and the zones above the resolution are not touched.
+ */
+static void _test_round_trip(
+		uint8_t				nb_zones)
+{
+	static VL53L8CX_ResultsData results, unpacked, untouched;
+	uint32_t frame, i, size = vl53l8cx_compact_size(nb_zones);
+	uint32_t slots = nb_zones * TEST_N;
+
+	TEST_CHECK(size <= VL53L8CX_COMPACT_MAX_SIZE);
+	for (frame = 0; frame < 100U; frame++)
+	{
+		_test_fill(&results);
+		/* Saturated rates */
+		results.signal_per_spad[0] = 0xFFFFFFFFU;
+		results.ambient_per_spad[0] = 16384U << TEST_RATE_FRAC_BITS;
+		results.nb_spads_enabled[0] = 0x10000U;
+		(void)memset(&unpacked, 0x5A, sizeof(unpacked));
+		untouched = unpacked;
+
+		TEST_CHECK(vl53l8cx_compact_pack(&results, nb_zones, buffer,
+				size) == VL53L8CX_STATUS_OK);
+		TEST_CHECK(vl53l8cx_compact_unpack(buffer, size, &unpacked)
+				== VL53L8CX_STATUS_OK);
+
+		TEST_CHECK(unpacked.silicon_temp_degc
+				== results.silicon_temp_degc);
+		TEST_CHECK(memcmp(unpacked.distance_mm, results.distance_mm,
+				slots * sizeof(int16_t)) == 0);
+		TEST_CHECK(memcmp(unpacked.range_sigma_mm,
+				results.range_sigma_mm,
+				slots * sizeof(uint16_t)) == 0);
+		TEST_CHECK(memcmp(unpacked.target_status, results.target_status,
+				slots) == 0);
+		TEST_CHECK(memcmp(unpacked.reflectance, results.reflectance,
+				slots) == 0);
+		TEST_CHECK(memcmp(unpacked.nb_target_detected,
+				results.nb_target_detected, nb_zones) == 0);
+		for (i = 0; i < slots; i++)
+		{
+			TEST_CHECK(unpacked.signal_per_spad[i]
+				== _test_rate(results.signal_per_spad[i]));
+		}
+		for (i = 0; i < nb_zones; i++)
+		{
+			TEST_CHECK(unpacked.ambient_per_spad[i]
+				== _test_rate(results.ambient_per_spad[i]));
+			TEST_CHECK(unpacked.nb_spads_enabled[i]
+				== ((results.nb_spads_enabled[i] > 0xFFFFU)
+				? 0xFFFFU : results.nb_spads_enabled[i]));
+		}
+		TEST_CHECK(unpacked.signal_per_spad[0] == TEST_RATE_MAX);
+		TEST_CHECK(unpacked.ambient_per_spad[0] == TEST_RATE_MAX);
+		TEST_CHECK(unpacked.nb_spads_enabled[0] == 0xFFFFU);
+
+		/* Validity computed again from the target status */
+		(void)vl53l8cx_update_validity(&results, nb_zones);
+		TEST_CHECK(unpacked.valid_mask == results.valid_mask);
+		TEST_CHECK(unpacked.nearest_valid_mm
+				== results.nearest_valid_mm);
+
+		TEST_CHECK(memcmp(&unpacked.distance_mm[slots],
+				&untouched.distance_mm[slots],
+				((VL53L8CX_RESOLUTION_8X8 * TEST_N) - slots)
+				* sizeof(int16_t)) == 0);
+		TEST_CHECK(memcmp(&unpacked.ambient_per_spad[nb_zones],
+				&untouched.ambient_per_spad[nb_zones],
+				(VL53L8CX_RESOLUTION_8X8 - nb_zones)
+				* sizeof(uint32_t)) == 0);
+	}
+	(void)printf("%u zones: %u bytes per compact frame, %u per results\n",
+			nb_zones, size, (uint32_t)sizeof(results));
+}
+
+/* Frames which do not match this build, and buffers too small */
+static void _test_invalid(void)
+{
+	static VL53L8CX_ResultsData results, unpacked;
+	VL53L8CX_CompactHeader *p_header = (VL53L8CX_CompactHeader *)buffer;
+	uint32_t size = vl53l8cx_compact_size(VL53L8CX_RESOLUTION_4X4);
+
+	_test_fill(&results);
+	TEST_CHECK(vl53l8cx_compact_pack(&results, 32, buffer,
+			sizeof(buffer)) == VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_compact_pack(&results, VL53L8CX_RESOLUTION_4X4,
+			buffer, size - 1U) == VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_compact_pack(&results, VL53L8CX_RESOLUTION_4X4,
+			buffer, size) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(p_header->size == size);
+
+	/* Truncated frame */
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, size - 1U, &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer,
+			sizeof(VL53L8CX_CompactHeader) - 1U, &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+
+	/* Another build of the driver */
+	p_header->outputs ^= VL53L8CX_OUTPUT_REFLECTANCE_PERCENT;
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, size, &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	p_header->outputs ^= VL53L8CX_OUTPUT_REFLECTANCE_PERCENT;
+	p_header->nb_targets++;
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, size, &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	p_header->nb_targets--;
+	p_header->nb_zones = VL53L8CX_RESOLUTION_8X8;
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, sizeof(buffer), &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	p_header->nb_zones = VL53L8CX_RESOLUTION_4X4;
+	p_header->rate_frac_bits = 17;
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, size, &unpacked)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	p_header->rate_frac_bits = VL53L8CX_COMPACT_RATE_FRAC_BITS;
+	TEST_CHECK(vl53l8cx_compact_unpack(buffer, size, &unpacked)
+			== VL53L8CX_STATUS_OK);
+}
+
+int main(void)
+{
+	_test_round_trip(VL53L8CX_RESOLUTION_4X4);
+	_test_round_trip(VL53L8CX_RESOLUTION_8X8);
+	_test_invalid();
+
+	(void)printf("test_compact: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
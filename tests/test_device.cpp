@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "vl53l8cx_device.hpp"
+
+extern "C" {
+#include "emu_platform.h"
+#include "test_common.h"
+}
+
+using vl53l8cx::Device;
+using vl53l8cx::Frame;
+using vl53l8cx::Resolution;
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x27D4EB2FU;
+
+#ifdef VL53L8CX_SHARED_BUFFERS
+/* Buffers of the devices, borrowed around each driver call */
+static VL53L8CX_Pool pool;
+#endif
+
+/* Every buffer borrowed by a call was given back */
+static void _test_check_pool(void)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	VL53L8CX_PoolStats stats;
+
+	vl53l8cx_pool_get_stats(&pool, &stats);
+	TEST_CHECK(stats.buffers_used == 0U);
+#endif
+}
+
+/* Emulated sensor on a channel, producing a frame every 2 ms */
+template <Resolution R>
+static void _test_attach(
+		Device<R>			&dev,
+		uint8_t				channel)
+{
+	emu_platform_reset(channel);
+	emu_platform_sensors[channel].period_us = 2000U;
+	dev.raw()->platform.spi_channel = channel;
+#ifdef VL53L8CX_SHARED_BUFFERS
+	vl53l8cx_pool_attach(&pool, dev.raw());
+#endif
+	TEST_CHECK(dev.init() == VL53L8CX_STATUS_OK);
+	_test_check_pool();
+}
+
+/* Waits for a frame, then reads it */
+template <Resolution R, uint8_t Targets>
+static uint8_t _test_read(
+		vl53l8cx::RangingSession<R, Targets>	&session,
+		Frame<R, Targets>		&frame)
+{
+	bool is_ready = false;
+	uint32_t i;
+
+	for (i = 0; (i < 100U) && !is_ready; i++)
+	{
+		if (session.check_data_ready(is_ready) != VL53L8CX_STATUS_OK)
+		{
+			return VL53L8CX_STATUS_ERROR;
+		}
+		if (!is_ready)
+		{
+			(void)usleep(1000);
+		}
+	}
+	if (!is_ready)
+	{
+		return VL53L8CX_STATUS_TIMEOUT_ERROR;
+	}
+
+	return session.get_ranging_data(frame);
+}
+
+/*
+ * Both resolutions: the setters checked at compile time, a frame read through
+ * a session, and a session moved to another handle.
+ */
+static void _test_sessions(void)
+{
+	static Device<Resolution::R4x4> dev_4x4(VL53L8CX_Platform{});
+	static Device<Resolution::R8x8> dev_8x8(VL53L8CX_Platform{});
+	static Frame<Resolution::R4x4> frame_4x4;
+	static Frame<Resolution::R8x8> frame_8x8;
+	uint8_t resolution = 0;
+	bool is_alive = false, is_ready = true;
+
+	_test_attach(dev_4x4, 0);
+	_test_attach(dev_8x8, 1);
+	TEST_CHECK(dev_4x4.is_alive(is_alive) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(is_alive);
+	TEST_CHECK(vl53l8cx_pool_begin(dev_8x8.raw()) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_get_resolution(dev_8x8.raw(), &resolution)
+			== VL53L8CX_STATUS_OK);
+	vl53l8cx_pool_end(dev_8x8.raw());
+	TEST_CHECK(resolution == VL53L8CX_RESOLUTION_8X8);
+
+	TEST_CHECK(dev_4x4.set_ranging_frequency_hz<60>()
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev_8x8.set_ranging_frequency_hz<15>()
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev_8x8.set_ranging_frequency_hz(16)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(dev_8x8.set_ranging_mode<VL53L8CX_RANGING_MODE_AUTONOMOUS>()
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev_8x8.set_integration_time_ms<20>()
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev_4x4.set_sharpener_percent<10>() == VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev_4x4.set_target_order<VL53L8CX_TARGET_ORDER_CLOSEST>()
+			== VL53L8CX_STATUS_OK);
+	_test_check_pool();
+
+	{
+		auto session_4x4 = dev_4x4.start_ranging();
+		auto session_8x8 = dev_8x8.start_ranging();
+
+		TEST_CHECK(session_4x4 && (session_4x4.status()
+				== VL53L8CX_STATUS_OK));
+		TEST_CHECK(session_8x8 && (session_8x8.status()
+				== VL53L8CX_STATUS_OK));
+		TEST_CHECK(emu_platform_sensors[1].is_ranging == 1U);
+		TEST_CHECK(_test_read(session_4x4, frame_4x4)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(_test_read(session_8x8, frame_8x8)
+				== VL53L8CX_STATUS_OK);
+		_test_check_pool();
+
+		/* The moved from handle is stopped, the new one still ranges */
+		auto moved = std::move(session_8x8);
+
+		TEST_CHECK(!session_8x8 && moved);
+		TEST_CHECK(session_8x8.check_data_ready(is_ready)
+				== VL53L8CX_STATUS_INVALID_PARAM);
+		TEST_CHECK(!is_ready);
+		TEST_CHECK(session_8x8.get_ranging_data(frame_8x8)
+				== VL53L8CX_STATUS_INVALID_PARAM);
+		TEST_CHECK(session_8x8.stop() == VL53L8CX_STATUS_OK);
+		TEST_CHECK(emu_platform_sensors[1].is_ranging == 1U);
+		TEST_CHECK(_test_read(moved, frame_8x8) == VL53L8CX_STATUS_OK);
+
+		TEST_CHECK(session_4x4.stop() == VL53L8CX_STATUS_OK);
+		TEST_CHECK(emu_platform_sensors[0].is_ranging == 0U);
+	}
+
+	/* Stopped when the session is destroyed */
+	TEST_CHECK(emu_platform_sensors[1].is_ranging == 0U);
+	_test_check_pool();
+#ifdef VL53L8CX_SHARED_BUFFERS
+	vl53l8cx_pool_detach(&pool, dev_4x4.raw());
+	vl53l8cx_pool_detach(&pool, dev_8x8.raw());
+#endif
+}
+
+/*
+ * Frames keeping all the targets of the driver share its layout, and frames
+ * keeping fewer targets gather the first targets of each zone.
+ */
+static void _test_decode(void)
+{
+	static VL53L8CX_ResultsData results;
+	static Frame<Resolution::R4x4> frame;
+	static Frame<Resolution::R8x8, 1> first;
+	constexpr uint32_t N = VL53L8CX_NB_TARGET_PER_ZONE;
+	uint32_t zone, target;
+
+	static_assert(Frame<Resolution::R4x4>::nb_slots == (16U * N), "");
+	static_assert(sizeof(first.distance_mm) == (64U * sizeof(int16_t)), "");
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		results.nb_target_detected[zone] = (uint8_t)test_random(&seed);
+		for (target = 0; target < N; target++)
+		{
+			results.distance_mm[(zone * N) + target] =
+				(int16_t)test_random(&seed);
+			results.target_status[(zone * N) + target] =
+				(uint8_t)test_random(&seed);
+		}
+	}
+	vl53l8cx::decode_frame(results, frame);
+	vl53l8cx::decode_frame(results, first);
+
+	TEST_CHECK(std::memcmp(frame.distance_mm.data(), results.distance_mm,
+			sizeof(frame.distance_mm)) == 0);
+	TEST_CHECK(std::memcmp(frame.nb_target_detected.data(),
+			results.nb_target_detected,
+			sizeof(frame.nb_target_detected)) == 0);
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		TEST_CHECK(first.distance_mm[zone]
+				== results.distance_mm[zone * N]);
+		TEST_CHECK(first.target_status[zone]
+				== results.target_status[zone * N]);
+	}
+}
+
+int main(void)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	TEST_CHECK(vl53l8cx_pool_init(&pool) == VL53L8CX_STATUS_OK);
+#endif
+	_test_sessions();
+	_test_decode();
+
+	(void)std::printf("test_device: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
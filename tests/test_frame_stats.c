@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		1U
+
+static uint32_t nb_failures;
+
+/* Frame written by the test, with a given streamcount */
+static void _test_frame(
+		uint8_t				streamcount)
+{
+	emu_platform_sensors[TEST_CHANNEL].streamcount = (uint8_t)(
+		(streamcount + 254U) % 255U);
+	TEST_CHECK(emu_platform_frame(TEST_CHANNEL) == streamcount);
+}
+
+/* Frames counters against the streamcount of the frames read */
+static void _test_accounting(void)
+{
+	static VL53L8CX_Configuration dev;
+	static VL53L8CX_ResultsData results;
+	EmuPlatformSensor *p_emu = &emu_platform_sensors[TEST_CHANNEL];
+	VL53L8CX_FrameStats stats;
+	uint8_t is_ready;
+
+	(void)memset(&dev, 0, sizeof(dev));
+	emu_platform_reset(TEST_CHANNEL);
+	dev.platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_start_ranging(&dev) == VL53L8CX_STATUS_OK);
+
+	/* No frame before the first period */
+	TEST_CHECK(vl53l8cx_check_data_ready(&dev, &is_ready)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(is_ready == 0U);
+
+	/* Consecutive frames, then one missed */
+	_test_frame(100);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	_test_frame(101);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	_test_frame(103);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_get_frame_stats(&dev, &stats)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(stats.frames_received == 3U);
+	TEST_CHECK(stats.frames_dropped == 1U);
+	TEST_CHECK(stats.frames_late == 0U);
+	TEST_CHECK(stats.frames_corrupted == 0U);
+
+	/* Gap across the wrap: 254 and 0 missed, 255 is never published. The
+	 * reset clears the counters, not the last streamcount */
+	_test_frame(253);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_reset_frame_stats(&dev) == VL53L8CX_STATUS_OK);
+	_test_frame(1);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev.streamcount == 1U);
+	/* 253 after 1 is a gap of 251 frames, then 254 and 0 without gap */
+	_test_frame(253);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	_test_frame(254);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	_test_frame(0);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_received == 4U);
+	TEST_CHECK(stats.frames_dropped == (2U + 251U));
+
+	/* The same frame read twice is not a gap */
+	TEST_CHECK(vl53l8cx_reset_frame_stats(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_received == 1U);
+	TEST_CHECK(stats.frames_dropped == 0U);
+	TEST_CHECK(stats.frames_late == 0U);
+
+	/* Signalled frame replaced before being read: late, and dropped */
+	_test_frame(10);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_reset_frame_stats(&dev) == VL53L8CX_STATUS_OK);
+	_test_frame(11);
+	TEST_CHECK(vl53l8cx_check_data_ready(&dev, &is_ready)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(is_ready == 1U);
+	_test_frame(12);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_late == 1U);
+	TEST_CHECK(stats.frames_dropped == 1U);
+	/* The frame signalled and read is not late */
+	TEST_CHECK(vl53l8cx_check_data_ready(&dev, &is_ready)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(is_ready == 0U);
+	_test_frame(13);
+	TEST_CHECK(vl53l8cx_check_data_ready(&dev, &is_ready)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(is_ready == 1U);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_late == 1U);
+	TEST_CHECK(stats.frames_dropped == 1U);
+
+	/* Footer different from the header: corrupted, not dropped */
+	TEST_CHECK(vl53l8cx_reset_frame_stats(&dev) == VL53L8CX_STATUS_OK);
+	_test_frame(14);
+	p_emu->torn_reads = 1;
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_CORRUPTED_FRAME);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_received == 1U);
+	TEST_CHECK(stats.frames_corrupted == 1U);
+	TEST_CHECK(stats.frames_dropped == 0U);
+	TEST_CHECK(stats.rereads == 0U);
+
+	/* Frames missed while stopped are not counted */
+	TEST_CHECK(vl53l8cx_stop_ranging(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_start_ranging(&dev) == VL53L8CX_STATUS_OK);
+	_test_frame(40);
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+			== VL53L8CX_STATUS_OK);
+	(void)vl53l8cx_get_frame_stats(&dev, &stats);
+	TEST_CHECK(stats.frames_received == 2U);
+	TEST_CHECK(stats.frames_dropped == 0U);
+	TEST_CHECK(vl53l8cx_stop_ranging(&dev) == VL53L8CX_STATUS_OK);
+}
+
+int main(void)
+{
+	_test_accounting();
+
+	(void)printf("test_frame_stats: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_fusion.h"
+#include "test_common.h"
+
+#define TEST_N			VL53L8CX_NB_TARGET_PER_ZONE
+#define TEST_NB_SENSORS		VL53L8CX_FUSION_MAX_SENSORS
+#define TEST_NB_EPOCHS		2000U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x27D4EB2FU;
+
+/* Random frame: up to TEST_N targets per zone, 10% of invalid targets */
+static void _test_random_frame(
+		VL53L8CX_ResultsData		*p_results,
+		uint8_t				nb_zones)
+{
+	uint32_t zone, k, idx, nt;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		nt = test_random(&seed) % (TEST_N + 1U);
+		p_results->nb_target_detected[zone] = (uint8_t)nt;
+		for (k = 0; k < TEST_N; k++)
+		{
+			idx = (zone * TEST_N) + k;
+			p_results->distance_mm[idx] = (int16_t)(
+				test_random(&seed) % 4000U);
+			p_results->target_status[idx] = ((k < nt)
+				&& ((test_random(&seed) % 10U) != 0U))
+				? 5U : 255U;
+		}
+	}
+	(void)vl53l8cx_update_validity(p_results, nb_zones);
+}
+
+/*
+ * Number of points of the merged cloud which differ from the reference: the
+ * valid points of vl53l8cx_pointcloud_convert() run for each sensor, sensor
+ * after sensor, target after target and zone after zone.
+ */
+static uint32_t _test_compare(
+		const VL53L8CX_PointCloudConverter *p_conv,
+		const VL53L8CX_ResultsData *const *pp_results,
+		uint16_t			sensor_mask,
+		uint8_t				nb_zones,
+		const VL53L8CX_FusionCloud	*p_out)
+{
+	static float x[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	static float y[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	static float z[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	VL53L8CX_PointCloud cloud = {x, y, z, VL53L8CX_POINTCLOUD_MAX_POINTS,
+		0, 0, {0}};
+	uint32_t sensor, t, zone, i, n = 0, nb_mismatches = 0;
+
+	for (sensor = 0; sensor < TEST_NB_SENSORS; sensor++)
+	{
+		if (((sensor_mask >> sensor) & 1U) == 0U)
+		{
+			continue;
+		}
+		TEST_CHECK(vl53l8cx_pointcloud_convert(&p_conv[sensor],
+				pp_results[sensor], nb_zones, &cloud)
+				== VL53L8CX_STATUS_OK);
+		for (t = 0; t < TEST_N; t++)
+		{
+			for (zone = 0; zone < nb_zones; zone++)
+			{
+				if (((cloud.valid_mask[t] >> zone) & 1U) == 0U)
+				{
+					continue;
+				}
+				i = (t * nb_zones) + zone;
+				/* Bit for bit, not within a tolerance */
+				if ((n >= p_out->nb_points)
+					|| (memcmp(&p_out->p_x_mm[n], &x[i],
+						sizeof(float)) != 0)
+					|| (memcmp(&p_out->p_y_mm[n], &y[i],
+						sizeof(float)) != 0)
+					|| (memcmp(&p_out->p_z_mm[n], &z[i],
+						sizeof(float)) != 0)
+					|| (p_out->p_sensor[n] != sensor)
+					|| (p_out->p_zone[n] != zone))
+				{
+					nb_mismatches++;
+				}
+				n++;
+			}
+		}
+	}
+	if (n != p_out->nb_points)
+	{
+		nb_mismatches++;
+	}
+
+	return nb_mismatches;
+}
+
+/*
+ * All sensors at random poses, random sensor masks and resolutions, with the
+ * caller alone and with worker threads.
+ */
+static void _test_random_epochs(
+		uint8_t				nb_workers)
+{
+	static VL53L8CX_Fusion fus;
+	static VL53L8CX_ResultsData frames[TEST_NB_SENSORS];
+	static float x[VL53L8CX_FUSION_MAX_POINTS];
+	static float y[VL53L8CX_FUSION_MAX_POINTS];
+	static float z[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t sensor[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t zone[VL53L8CX_FUSION_MAX_POINTS];
+	VL53L8CX_FusionCloud out = {x, y, z, sensor, zone,
+		VL53L8CX_FUSION_MAX_POINTS, 0, 0, 0};
+	const VL53L8CX_ResultsData *p_results[TEST_NB_SENSORS];
+	VL53L8CX_PointCloudPose pose;
+	VL53L8CX_FusionStats stats;
+	float t[3];
+	uint32_t epoch, i, nb_mismatches = 0;
+	uint64_t nb_points = 0;
+	uint16_t sensor_mask;
+	uint8_t id, nb_zones;
+
+	TEST_CHECK(vl53l8cx_fusion_init(&fus) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		t[0] = (float)(test_random(&seed) % 400U) - 200.0f;
+		t[1] = (float)(test_random(&seed) % 400U) - 200.0f;
+		t[2] = (float)(test_random(&seed) % 400U) - 200.0f;
+		vl53l8cx_pointcloud_pose(&pose,
+				(float)(test_random(&seed) % 360U) - 180.0f,
+				(float)(test_random(&seed) % 180U) - 90.0f,
+				(float)(i * 360U) / (float)TEST_NB_SENSORS, t);
+		TEST_CHECK(vl53l8cx_fusion_add_sensor(&fus, &pose, &id)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(id == i);
+		p_results[i] = &frames[i];
+	}
+	TEST_CHECK(vl53l8cx_fusion_add_sensor(&fus, &pose, &id)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_fusion_start(&fus, nb_workers)
+			== VL53L8CX_STATUS_OK);
+
+	for (epoch = 0; epoch < TEST_NB_EPOCHS; epoch++)
+	{
+		nb_zones = ((epoch % 2U) == 0U) ? VL53L8CX_RESOLUTION_4X4
+			: VL53L8CX_RESOLUTION_8X8;
+		for (i = 0; i < TEST_NB_SENSORS; i++)
+		{
+			_test_random_frame(&frames[i], nb_zones);
+		}
+		sensor_mask = (uint16_t)test_random(&seed);
+		sensor_mask = ((epoch % 10U) == 0U) ? UINT16_MAX : sensor_mask;
+		TEST_CHECK(vl53l8cx_fusion_process(&fus, p_results, sensor_mask,
+				nb_zones, &out) == VL53L8CX_STATUS_OK);
+		nb_mismatches += _test_compare(fus.converters, p_results,
+				sensor_mask, nb_zones, &out);
+		nb_points += out.nb_points;
+	}
+
+	/* The output must hold every zone of the sensors merged */
+	out.capacity = (VL53L8CX_RESOLUTION_8X8 * TEST_N) - 1U;
+	TEST_CHECK(vl53l8cx_fusion_process(&fus, p_results, 1U,
+			VL53L8CX_RESOLUTION_8X8, &out)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_fusion_process(&fus, p_results, 1U, 32U, &out)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+
+	TEST_CHECK(vl53l8cx_fusion_stop(&fus) == VL53L8CX_STATUS_OK);
+	vl53l8cx_fusion_get_stats(&fus, &stats);
+	(void)printf("%u workers: %u epochs, %lu points, %u mismatches\n",
+			nb_workers, stats.epochs, (unsigned long)nb_points,
+			nb_mismatches);
+	TEST_CHECK(stats.epochs == TEST_NB_EPOCHS);
+	TEST_CHECK(stats.points == nb_points);
+	TEST_CHECK(nb_mismatches == 0U);
+}
+
+/* Frames missed or read with an error are left out of a super-frame */
+static void _test_superframe(void)
+{
+	static VL53L8CX_Fusion fus;
+	static VL53L8CX_SuperFrame frame;
+	static float x[VL53L8CX_FUSION_MAX_POINTS];
+	static float y[VL53L8CX_FUSION_MAX_POINTS];
+	static float z[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t sensor[VL53L8CX_FUSION_MAX_POINTS];
+	static uint8_t zone[VL53L8CX_FUSION_MAX_POINTS];
+	VL53L8CX_FusionCloud out = {x, y, z, sensor, zone,
+		VL53L8CX_FUSION_MAX_POINTS, 0, 0, 0};
+	const VL53L8CX_ResultsData *p_results[TEST_NB_SENSORS];
+	uint32_t i;
+	uint8_t id;
+
+	TEST_CHECK(vl53l8cx_fusion_init(&fus) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < VL53L8CX_SYNC_MAX_SENSORS; i++)
+	{
+		TEST_CHECK(vl53l8cx_fusion_add_sensor(&fus, NULL, &id)
+				== VL53L8CX_STATUS_OK);
+		_test_random_frame(&frame.results[i],
+				VL53L8CX_RESOLUTION_8X8);
+		p_results[i] = &frame.results[i];
+	}
+	frame.epoch = 42;
+	frame.t_trigger_ns = 123456789ULL;
+	frame.nb_sensors = VL53L8CX_SYNC_MAX_SENSORS;
+	/* Sensor 1 missed the pulse, sensor 2 was read with an error */
+	frame.sensor_mask = (uint8_t)~(1U << 1);
+	frame.status[2] = VL53L8CX_STATUS_ERROR;
+
+	TEST_CHECK(vl53l8cx_fusion_process_superframe(&fus, &frame,
+			VL53L8CX_RESOLUTION_8X8, &out) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(out.epoch == 42U);
+	TEST_CHECK(out.t_trigger_ns == 123456789ULL);
+	TEST_CHECK(_test_compare(fus.converters, p_results,
+			(uint16_t)(frame.sensor_mask & ~(1U << 2)),
+			VL53L8CX_RESOLUTION_8X8, &out) == 0U);
+	TEST_CHECK(vl53l8cx_fusion_stop(&fus) == VL53L8CX_STATUS_OK);
+}
+
+int main(void)
+{
+	_test_random_epochs(0);
+	_test_random_epochs(3);
+	_test_superframe();
+
+	(void)printf("test_fusion: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_governor.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		0U
+
+static uint32_t nb_failures;
+
+static VL53L8CX_Configuration dev;
+static VL53L8CX_Capture cap;
+static VL53L8CX_Governor gov;
+static VL53L8CX_CaptureFrame frame;
+static uint8_t streamcount;
+static uint64_t t_ns;
+
+/* Sets the resolution and the ranging mode, then plans for them */
+static void _test_configure(
+		uint8_t				resolution,
+		uint8_t				ranging_mode,
+		uint8_t				target_hz,
+		uint32_t			latency_budget_ms)
+{
+	TEST_CHECK(vl53l8cx_set_resolution(&dev, resolution)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_set_ranging_mode(&dev, ranging_mode)
+			== VL53L8CX_STATUS_OK);
+	vl53l8cx_governor_init(&gov, &cap, target_hz, latency_budget_ms);
+	TEST_CHECK(vl53l8cx_governor_configure(&gov, &dev)
+			== VL53L8CX_STATUS_OK);
+}
+
+/*
+ * Synthetic frames at the given rate, ready after the current time and after
+ * the previous frames, enough to fill a window after the first one. Returns
+ * the change queued, if any.
+ */
+static VL53L8CX_Command *_test_window(
+		float				rate_hz)
+{
+	uint64_t period_ns = (uint64_t)(1e9f / rate_hz);
+	uint32_t i;
+
+	if (t_ns < vl53l8cx_capture_now_ns())
+	{
+		t_ns = vl53l8cx_capture_now_ns();
+	}
+	for (i = 0; i <= VL53L8CX_GOVERNOR_WINDOW_FRAMES; i++)
+	{
+		t_ns += period_ns;
+		frame.status = VL53L8CX_STATUS_OK;
+		frame.streamcount = streamcount;
+		frame.t_ready_ns = t_ns;
+		vl53l8cx_governor_update(&gov, &frame);
+		streamcount = (uint8_t)((streamcount + 1U) % 255U);
+	}
+
+	return gov.is_command_pending ? &gov.command : NULL;
+}
+
+/* Completes the queued change as the acquisition thread would */
+static void _test_complete(
+		uint8_t				status)
+{
+	TEST_CHECK(vl53l8cx_command_queue_cancel(&cap.commands, status) == 1U);
+}
+
+/*
+ * Autonomous mode too slow: the integration time is reduced down to its
+ * minimum before the frequency is raised, then the rate is reached.
+ */
+static void _test_integration_first(void)
+{
+	VL53L8CX_GovernorReport report;
+	VL53L8CX_Command *p_cmd;
+	uint32_t integration_ms, nb_steps = 0;
+
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_AUTONOMOUS, 30, 0);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.frequency_hz == 30U);
+	TEST_CHECK(report.integration_time_ms
+			== ((1000U / 30U) - VL53L8CX_GOVERNOR_READOUT_MS_4X4));
+	TEST_CHECK(report.infeasible == 0U);
+
+	for (;;)
+	{
+		integration_ms = gov.integration_time_ms;
+		p_cmd = _test_window(25.0f);
+		TEST_CHECK(p_cmd != NULL);
+		if ((p_cmd == NULL) || (p_cmd->type
+				!= VL53L8CX_COMMAND_INTEGRATION_TIME_MS))
+		{
+			break;
+		}
+		TEST_CHECK(p_cmd->value < integration_ms);
+		TEST_CHECK(p_cmd->value
+				>= VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS);
+		_test_complete(VL53L8CX_STATUS_OK);
+		nb_steps++;
+	}
+	TEST_CHECK(nb_steps == 4U);
+	TEST_CHECK(gov.integration_time_ms
+			== VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS);
+	TEST_CHECK(gov.frequency_hz == 30U);
+	TEST_CHECK((p_cmd != NULL)
+			&& (p_cmd->type == VL53L8CX_COMMAND_FREQUENCY_HZ)
+			&& (p_cmd->value == 31U));
+	_test_complete(VL53L8CX_STATUS_OK);
+
+	/* Settled at 31 Hz, the rate is then reached */
+	TEST_CHECK(_test_window(30.0f) == NULL);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.frequency_hz == 31U);
+	TEST_CHECK(report.nb_adjustments == (nb_steps + 1U));
+	TEST_CHECK((report.achieved_hz > 29.9f)
+			&& (report.achieved_hz < 30.1f));
+	TEST_CHECK(report.estimated_latency_ms
+			== (VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS
+				+ VL53L8CX_GOVERNOR_READOUT_MS_4X4));
+	TEST_CHECK(report.infeasible == 0U);
+}
+
+/*
+ * Continuous mode changes only the frequency, a failed change keeps the
+ * settings, and a rate too slow at the maximum frequency is infeasible.
+ */
+static void _test_frequency(void)
+{
+	VL53L8CX_GovernorReport report;
+	VL53L8CX_Command *p_cmd;
+
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_CONTINUOUS, 10, 0);
+	p_cmd = _test_window(8.0f);
+	TEST_CHECK((p_cmd != NULL)
+			&& (p_cmd->type == VL53L8CX_COMMAND_FREQUENCY_HZ)
+			&& (p_cmd->value == 11U));
+	_test_complete(VL53L8CX_STATUS_ERROR);
+	p_cmd = _test_window(12.0f);
+	TEST_CHECK(gov.frequency_hz == 10U);
+	TEST_CHECK(gov.report.nb_adjustments == 0U);
+	TEST_CHECK((p_cmd != NULL)
+			&& (p_cmd->type == VL53L8CX_COMMAND_FREQUENCY_HZ)
+			&& (p_cmd->value == 9U));
+	_test_complete(VL53L8CX_STATUS_OK);
+	TEST_CHECK(_test_window(10.2f) == NULL);
+	TEST_CHECK(gov.frequency_hz == 9U);
+
+	/* Maximum frequency, shortest integration, still too slow */
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_AUTONOMOUS, 60, 0);
+	while ((p_cmd = _test_window(50.0f)) != NULL)
+	{
+		TEST_CHECK(p_cmd->type == VL53L8CX_COMMAND_INTEGRATION_TIME_MS);
+		_test_complete(VL53L8CX_STATUS_OK);
+	}
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.frequency_hz == VL53L8CX_GOVERNOR_MAX_HZ_4X4);
+	TEST_CHECK(report.integration_time_ms
+			== VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS);
+	TEST_CHECK(report.infeasible == VL53L8CX_GOVERNOR_INFEASIBLE_MEASURED);
+	TEST_CHECK(_test_window(59.0f) == NULL);
+	TEST_CHECK(gov.report.infeasible == 0U);
+
+	/* Above the maximum frequency of the resolution */
+	_test_configure(VL53L8CX_RESOLUTION_8X8,
+			VL53L8CX_RANGING_MODE_CONTINUOUS, 30, 0);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.frequency_hz == VL53L8CX_GOVERNOR_MAX_HZ_8X8);
+	TEST_CHECK(report.infeasible == VL53L8CX_GOVERNOR_INFEASIBLE_RATE);
+	TEST_CHECK(_test_window(15.0f) == NULL);
+	TEST_CHECK(gov.report.infeasible == VL53L8CX_GOVERNOR_INFEASIBLE_RATE);
+}
+
+/*
+ * The latency budget shortens the integration of the autonomous mode, and is
+ * only checked against the period in continuous mode.
+ */
+static void _test_latency_budget(void)
+{
+	VL53L8CX_GovernorReport report;
+	uint32_t readout_ms = VL53L8CX_GOVERNOR_READOUT_MS_4X4;
+
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_AUTONOMOUS, 10, 20);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.latency_budget_ms == 20U);
+	TEST_CHECK(report.integration_time_ms == (20U - readout_ms));
+	TEST_CHECK(report.estimated_latency_ms == 20U);
+	TEST_CHECK(report.infeasible == 0U);
+
+	/* Shorter than the shortest frame */
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_AUTONOMOUS, 10, readout_ms + 1U);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.integration_time_ms
+			== VL53L8CX_GOVERNOR_MIN_INTEGRATION_MS);
+	TEST_CHECK(report.infeasible == VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY);
+
+	/* Continuous mode integrates during the whole period */
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_CONTINUOUS, 10, 20);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.estimated_latency_ms == (100U + readout_ms));
+	TEST_CHECK(report.infeasible == VL53L8CX_GOVERNOR_INFEASIBLE_LATENCY);
+	_test_configure(VL53L8CX_RESOLUTION_4X4,
+			VL53L8CX_RANGING_MODE_CONTINUOUS, 10,
+			100U + readout_ms);
+	vl53l8cx_governor_get_report(&gov, &report);
+	TEST_CHECK(report.infeasible == 0U);
+}
+
+int main(void)
+{
+	(void)memset(&dev, 0, sizeof(dev));
+	emu_platform_reset(TEST_CHANNEL);
+	dev.platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_capture_init(&cap) == VL53L8CX_STATUS_OK);
+
+	_test_integration_first();
+	_test_frequency();
+	_test_latency_budget();
+	vl53l8cx_capture_deinit(&cap);
+
+	(void)printf("test_governor: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_grid.h"
+#include "test_common.h"
+
+#define TEST_HALF_WIDTH		((int32_t)VL53L8CX_GRID_WIDTH / 2)
+#define TEST_NB_STEPS		300U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0xC2B2AE35U;
+
+static VL53L8CX_Grid grid;
+static VL53L8CX_GridFootprint footprints[4];
+static VL53L8CX_ResultsData results;
+
+/* Occupied cells of the grid, by cell coordinates of the grid frame */
+static int32_t cells[VL53L8CX_GRID_WIDTH * VL53L8CX_GRID_WIDTH][2];
+static uint32_t nb_cells;
+
+static uint8_t _test_is_occupied(
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	return (uint8_t)(vl53l8cx_grid_get(&grid,
+		((float)cell_x + 0.5f) * grid.config.cell_mm,
+		((float)cell_z + 0.5f) * grid.config.cell_mm)
+		>= grid.config.occupied);
+}
+
+static uint8_t _test_is_inside(
+		int32_t				cell_x,
+		int32_t				cell_z)
+{
+	return (uint8_t)((cell_x >= (grid.cell_x - TEST_HALF_WIDTH))
+		&& (cell_x < (grid.cell_x + TEST_HALF_WIDTH))
+		&& (cell_z >= (grid.cell_z - TEST_HALF_WIDTH))
+		&& (cell_z < (grid.cell_z + TEST_HALF_WIDTH)));
+}
+
+/* Occupied cells of the whole window, cell by cell */
+static uint32_t _test_scan(
+		uint8_t				is_saved)
+{
+	int32_t cell_x, cell_z;
+	uint32_t count = 0;
+
+	for (cell_z = grid.cell_z - TEST_HALF_WIDTH;
+			cell_z < (grid.cell_z + TEST_HALF_WIDTH); cell_z++)
+	{
+		for (cell_x = grid.cell_x - TEST_HALF_WIDTH;
+				cell_x < (grid.cell_x + TEST_HALF_WIDTH);
+				cell_x++)
+		{
+			if (!_test_is_occupied(cell_x, cell_z))
+			{
+				continue;
+			}
+			if (is_saved)
+			{
+				cells[count][0] = cell_x;
+				cells[count][1] = cell_z;
+			}
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* Sensors looking forward, right, backward and left, 100 mm above */
+static void _test_footprints(void)
+{
+	VL53L8CX_PointCloudPose pose;
+	const float c[4] = {1.0f, 0.0f, -1.0f, 0.0f};
+	const float s[4] = {0.0f, 1.0f, 0.0f, -1.0f};
+	uint8_t i;
+
+	for (i = 0; i < 4U; i++)
+	{
+		(void)memset(&pose, 0, sizeof(pose));
+		pose.rotation[0] = c[i];
+		pose.rotation[2] = s[i];
+		pose.rotation[4] = 1.0f;
+		pose.rotation[6] = -s[i];
+		pose.rotation[8] = c[i];
+		pose.translation_mm[1] = 100.0f;
+		TEST_CHECK(vl53l8cx_grid_footprint_init(&grid, &footprints[i],
+				&pose, VL53L8CX_RESOLUTION_8X8)
+				== VL53L8CX_STATUS_OK);
+	}
+}
+
+/* Random frame of one sensor, seen twice so its targets are occupied */
+static void _test_frame(void)
+{
+	uint32_t zone;
+	uint8_t sensor = (uint8_t)(test_random(&seed) % 4U);
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		results.distance_mm[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			(int16_t)(300U + (test_random(&seed) % 2700U));
+		results.target_status[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			((test_random(&seed) % 4U) != 0U) ? 5U : 255U;
+		results.nb_target_detected[zone] = 1;
+	}
+	(void)vl53l8cx_update_validity(&results, VL53L8CX_RESOLUTION_8X8);
+	TEST_CHECK(vl53l8cx_grid_update(&grid, &footprints[sensor], &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_grid_update(&grid, &footprints[sensor], &results)
+			== VL53L8CX_STATUS_OK);
+}
+
+/*
+ * Random moves, some of them larger than half the grid, around negative cells:
+ * the cells still inside the grid are kept, the cells entering it are empty,
+ * and the nearest obstacle is the one found by a search of all the cells.
+ */
+static void _test_moves(void)
+{
+	static VL53L8CX_GridObstacle nearest;
+	float dx_mm, dz_mm, cell = grid.config.cell_mm;
+	double ddx, ddz, d, best;
+	uint32_t step, i, kept, nb_found = 0;
+
+	vl53l8cx_grid_nearest(&grid, &nearest);
+	TEST_CHECK(nearest.is_found == 0U);
+	vl53l8cx_grid_move(&grid, -7777.0f, -5555.0f);
+
+	for (step = 0; step < TEST_NB_STEPS; step++)
+	{
+		/* Cells kept by the move, then the cells of the grid */
+		dx_mm = (float)(test_random(&seed) % 801U) - 400.0f;
+		dz_mm = (float)(test_random(&seed) % 801U) - 400.0f;
+		if ((step % 64U) == 63U)
+		{
+			dz_mm *= 30.0f;
+		}
+		else if ((step % 16U) == 15U)
+		{
+			dx_mm *= 12.0f;
+		}
+		vl53l8cx_grid_move(&grid, dx_mm, dz_mm);
+		kept = 0;
+		for (i = 0; i < nb_cells; i++)
+		{
+			if (_test_is_inside(cells[i][0], cells[i][1]))
+			{
+				TEST_CHECK(_test_is_occupied(cells[i][0],
+						cells[i][1]));
+				kept++;
+			}
+		}
+		TEST_CHECK(_test_scan(0) == kept);
+
+		_test_frame();
+		nb_cells = _test_scan(1);
+
+		best = INFINITY;
+		for (i = 0; i < nb_cells; i++)
+		{
+			ddx = (((double)cells[i][0] + 0.5) * cell) - grid.x_mm;
+			ddz = (((double)cells[i][1] + 0.5) * cell) - grid.z_mm;
+			d = sqrt((ddx * ddx) + (ddz * ddz));
+			if (d < best)
+			{
+				best = d;
+			}
+		}
+		vl53l8cx_grid_nearest(&grid, &nearest);
+		TEST_CHECK(nearest.is_found == (uint8_t)(nb_cells != 0U));
+		if (nearest.is_found)
+		{
+			nb_found++;
+			TEST_CHECK(fabs((double)nearest.distance_mm - best)
+					< 0.05);
+			TEST_CHECK(vl53l8cx_grid_get(&grid, nearest.x_mm,
+					nearest.z_mm) >= grid.config.occupied);
+		}
+	}
+	(void)printf("%u steps, %u with obstacles, %u occupied cells, "
+			"device at cell (%d, %d)\n", TEST_NB_STEPS, nb_found,
+			nb_cells, grid.cell_x, grid.cell_z);
+	TEST_CHECK(nb_found > (TEST_NB_STEPS / 2U));
+}
+
+int main(void)
+{
+	TEST_CHECK(vl53l8cx_grid_init(&grid, NULL) == VL53L8CX_STATUS_OK);
+	_test_footprints();
+	_test_moves();
+
+	(void)printf("test_grid: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l8cx_latency.h"
+#include "test_common.h"
+
+#define TEST_NB_FRAMES		1000U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x9E3779B9U;
+
+static uint64_t samples[VL53L8CX_LATENCY_NB_STAGES][TEST_NB_FRAMES];
+
+static int _test_compare(
+		const void			*p_a,
+		const void			*p_b)
+{
+	uint64_t a = *(const uint64_t *)p_a, b = *(const uint64_t *)p_b;
+
+	return (a > b) - (a < b);
+}
+
+/* Nearest rank percentile of sorted values */
+static uint64_t _test_percentile(
+		const uint64_t			*p_sorted,
+		uint32_t			count,
+		uint32_t			percent)
+{
+	return p_sorted[((((uint64_t)count * percent) + 99U) / 100U) - 1U];
+}
+
+/* Within half a bin, a 16th of the value, of the exact percentile */
+static uint8_t _test_close(
+		uint64_t			value,
+		uint64_t			exact)
+{
+	uint64_t error = (value > exact) ? (value - exact) : (exact - value);
+
+	return (error <= (exact / 16U)) ? 1U : 0U;
+}
+
+/*
+ * Frames with random stage intervals, including frames handed off as soon as
+ * decoded, against the percentiles of the sorted intervals.
+ */
+static void _test_frames(void)
+{
+	static VL53L8CX_Latency lat;
+	static VL53L8CX_CaptureFrame frame;
+	VL53L8CX_LatencyReport report;
+	uint32_t i;
+	uint8_t stage;
+
+	vl53l8cx_latency_reset(&lat);
+	for (i = 0; i < TEST_NB_FRAMES; i++)
+	{
+		frame.t_ready_ns = 1000000000U + ((uint64_t)i * 10000000U);
+		frame.t_read_ns = frame.t_ready_ns + 100000U
+			+ (test_random(&seed) % 2000000U);
+		frame.t_decoded_ns = frame.t_read_ns
+			+ (test_random(&seed) % 50000U);
+		frame.t_handoff_ns = frame.t_decoded_ns;
+		if ((i % 4U) != 0U)
+		{
+			frame.t_handoff_ns += test_random(&seed) % 10000000U;
+		}
+		vl53l8cx_latency_record_frame(&lat, &frame);
+
+		samples[VL53L8CX_LATENCY_STAGE_READ][i] = frame.t_read_ns
+			- frame.t_ready_ns;
+		samples[VL53L8CX_LATENCY_STAGE_DECODE][i] = frame.t_decoded_ns
+			- frame.t_read_ns;
+		samples[VL53L8CX_LATENCY_STAGE_QUEUE][i] = frame.t_handoff_ns
+			- frame.t_decoded_ns;
+		samples[VL53L8CX_LATENCY_STAGE_TOTAL][i] = frame.t_handoff_ns
+			- frame.t_ready_ns;
+	}
+
+	vl53l8cx_latency_get_report(&lat, &report);
+	for (stage = 0; stage < VL53L8CX_LATENCY_NB_STAGES; stage++)
+	{
+		qsort(samples[stage], TEST_NB_FRAMES, sizeof(uint64_t),
+				_test_compare);
+		TEST_CHECK(report.stage[stage].count == TEST_NB_FRAMES);
+		TEST_CHECK(_test_close(report.stage[stage].p50_ns,
+				_test_percentile(samples[stage],
+				TEST_NB_FRAMES, 50)));
+		TEST_CHECK(_test_close(report.stage[stage].p99_ns,
+				_test_percentile(samples[stage],
+				TEST_NB_FRAMES, 99)));
+		TEST_CHECK(report.stage[stage].max_ns
+				== samples[stage][TEST_NB_FRAMES - 1U]);
+	}
+
+	/* A quarter of the frames did not wait into the ring */
+	TEST_CHECK(samples[VL53L8CX_LATENCY_STAGE_QUEUE][0] == 0U);
+	TEST_CHECK(lat.stage[VL53L8CX_LATENCY_STAGE_QUEUE].bins[0]
+			>= (TEST_NB_FRAMES / 4U));
+}
+
+/*
+ * Small values are exact, and the values clamped above 2^40 ns are reported by
+ * the max rather than by the last bin.
+ */
+static void _test_limits(void)
+{
+	static VL53L8CX_Latency lat;
+	VL53L8CX_LatencyReport report;
+	const uint64_t limit_ns = (uint64_t)1 << VL53L8CX_LATENCY_MAX_BITS;
+	uint32_t i;
+
+	vl53l8cx_latency_reset(&lat);
+	vl53l8cx_latency_get_report(&lat, &report);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].count == 0U);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].p99_ns == 0U);
+
+	/* 0 to 9 ns, one sample each */
+	for (i = 0; i < 10U; i++)
+	{
+		vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_STAGE_READ, i);
+	}
+	vl53l8cx_latency_get_report(&lat, &report);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].p50_ns == 4U);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].p99_ns == 9U);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].max_ns == 9U);
+
+	/* 98 samples of 1 ms, and 2 beyond the last bin */
+	for (i = 0; i < 98U; i++)
+	{
+		vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_STAGE_TOTAL,
+				1000000U);
+	}
+	vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_STAGE_TOTAL,
+			limit_ns);
+	vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_STAGE_TOTAL,
+			limit_ns * 4U);
+	vl53l8cx_latency_get_report(&lat, &report);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_TOTAL].count == 100U);
+	TEST_CHECK(_test_close(report.stage[VL53L8CX_LATENCY_STAGE_TOTAL]
+			.p50_ns, 1000000U));
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_TOTAL].p99_ns
+			== (limit_ns * 4U));
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_TOTAL].max_ns
+			== (limit_ns * 4U));
+
+	/* Values below the last bin are not clamped */
+	vl53l8cx_latency_reset(&lat);
+	vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_STAGE_DECODE,
+			limit_ns / 2U);
+	vl53l8cx_latency_get_report(&lat, &report);
+	TEST_CHECK(_test_close(report.stage[VL53L8CX_LATENCY_STAGE_DECODE]
+			.p50_ns, limit_ns / 2U));
+
+	/* Unknown stages are ignored */
+	vl53l8cx_latency_record(&lat, VL53L8CX_LATENCY_NB_STAGES, 1U);
+	vl53l8cx_latency_get_report(&lat, &report);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_DECODE].count == 1U);
+	TEST_CHECK(report.stage[VL53L8CX_LATENCY_STAGE_READ].count == 0U);
+}
+
+int main(void)
+{
+	_test_frames();
+	_test_limits();
+
+	(void)printf("test_latency: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,327 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "vl53l8cx_manager.h"
+#include "vl53l8cx_pool.h"
+#include "emu_sensor.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+static uint32_t nb_failures;
+static uint32_t frames_cb[VL53L8CX_MANAGER_MAX_SENSORS];
+
+#ifdef VL53L8CX_SHARED_BUFFERS
+/* Buffers of the emulated devices, borrowed by the bus threads */
+static VL53L8CX_Pool pool;
+#endif
+
+/* Gives the buffers of a device, from the pool when they are shared */
+static void _test_attach(
+		VL53L8CX_Configuration		*p_dev)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	vl53l8cx_pool_attach(&pool, p_dev);
+#else
+	(void)p_dev;
+#endif
+}
+
+static void _test_frame_cb(
+		void				*p_user,
+		uint8_t				sensor_id,
+		uint8_t				status,
+		const VL53L8CX_ResultsData	*p_results)
+{
+	(void)p_user;
+	(void)status;
+	(void)p_results;
+	frames_cb[sensor_id]++;
+}
+
+/*
+ * Two sensors share bus 0 and a faster one has bus 1. A long operation runs
+ * on a sensor of bus 0 while the others range: no frame may be missed, no
+ * transactions may overlap on a bus, and the bus time of the stats must be the
+ * time spent in emulated transactions.
+ */
+static void _test_scheduling(void)
+{
+	static VL53L8CX_Manager mgr;
+	static EmuSensor emu[3];
+	static EmuBus bus[2];
+	VL53L8CX_ManagerSensorStats sensor_stats[3];
+	VL53L8CX_ManagerBusStats bus_stats[VL53L8CX_MANAGER_MAX_BUSES];
+	VL53L8CX_AsyncOp op;
+	uint64_t busy_ns, sum_ns;
+	uint8_t i, b, id[3], op_status;
+
+	emu_sensor_init(&emu[0], &bus[0], 30000, 200, 2000);
+	emu_sensor_init(&emu[1], &bus[0], 33000, 200, 2000);
+	emu_sensor_init(&emu[2], &bus[1], 15000, 200, 2000);
+	for (i = 0; i < 3U; i++)
+	{
+		_test_attach(&emu[i].dev);
+	}
+
+	TEST_CHECK(vl53l8cx_manager_init(&mgr, &emu_sensor_ops,
+			_test_frame_cb, NULL, 0) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		b = (i < 2U) ? 0 : 1;
+		TEST_CHECK(vl53l8cx_manager_add_sensor(&mgr, &emu[i].dev, b,
+				&id[i]) == VL53L8CX_STATUS_OK);
+	}
+	TEST_CHECK(vl53l8cx_manager_start(&mgr) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_manager_start_ranging(&mgr, id[i])
+				== VL53L8CX_STATUS_OK);
+	}
+	(void)usleep(400000);
+
+	/* 10 steps of 3 ms, 10 ms apart, on the second sensor */
+	emu[1].nb_steps = 10;
+	emu[1].step_us = 3000;
+	emu[1].step_gap_ms = 10;
+	(void)vl53l8cx_async_init(&op, &emu[1].dev, 0);
+	TEST_CHECK(vl53l8cx_manager_submit(&mgr, id[1], &op)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_manager_submit(&mgr, id[1], &op)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_manager_wait(&mgr, id[1], 2000, &op_status)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(op_status == VL53L8CX_STATUS_OK);
+	(void)usleep(400000);
+	TEST_CHECK(vl53l8cx_manager_stop(&mgr) == VL53L8CX_STATUS_OK);
+
+	vl53l8cx_manager_get_stats(&mgr, sensor_stats, bus_stats);
+	for (i = 0; i < 3U; i++)
+	{
+		(void)printf("sensor %u: %u frames, %u missed, %u checks, "
+			"max delay %.2f ms, period %.2f ms, utilization %.3f\n",
+			i, sensor_stats[i].frames_read, emu[i].frames_missed,
+			sensor_stats[i].checks,
+			(double)sensor_stats[i].max_check_delay_ns / 1e6,
+			(double)sensor_stats[i].frame_period_ns / 1e6,
+			(double)sensor_stats[i].utilization);
+		TEST_CHECK(emu[i].frames_missed == 0U);
+		TEST_CHECK(sensor_stats[i].frames_read == emu[i].frames_read);
+		TEST_CHECK(frames_cb[id[i]] == emu[i].frames_read);
+		TEST_CHECK(sensor_stats[i].errors == 0U);
+		TEST_CHECK(emu[i].reads_stopped == 0U);
+		/* At least 80 % of the frames of 800 ms */
+		TEST_CHECK(emu[i].frames_read
+				>= ((800000U * 8U) / (emu[i].period_us * 10U)));
+		/* The period is measured within 5 % */
+		TEST_CHECK(sensor_stats[i].frame_period_ns
+				> ((uint64_t)emu[i].period_us * 950U));
+		TEST_CHECK(sensor_stats[i].frame_period_ns
+				< ((uint64_t)emu[i].period_us * 1050U));
+	}
+	TEST_CHECK(emu[1].steps == 11U);
+	TEST_CHECK(sensor_stats[1].op_steps == 11U);
+
+	for (b = 0; b < 2U; b++)
+	{
+		busy_ns = atomic_load(&bus[b].busy_ns);
+		sum_ns = 0;
+		for (i = 0; i < 3U; i++)
+		{
+			sum_ns += (emu[i].p_bus == &bus[b])
+				? sensor_stats[i].busy_ns : 0U;
+		}
+		(void)printf("bus %u: utilization %.3f, emulated %.3f\n", b,
+			(double)bus_stats[b].utilization,
+			(double)busy_ns / (double)bus_stats[b].elapsed_ns);
+		TEST_CHECK(atomic_load(&bus[b].collisions) == 0U);
+		TEST_CHECK(sum_ns == bus_stats[b].busy_ns);
+		/* The manager counts its own overhead around transactions,
+		 * which must stay within 2 % of the time */
+		TEST_CHECK(bus_stats[b].busy_ns >= busy_ns);
+		TEST_CHECK((bus_stats[b].busy_ns - busy_ns)
+				< (bus_stats[b].elapsed_ns / 50U));
+		TEST_CHECK(bus_stats[b].utilization > ((float)busy_ns
+				/ (float)bus_stats[b].elapsed_ns) - 0.001f);
+	}
+}
+
+static VL53L8CX_Manager ops_mgr;
+static uint32_t nb_accepted[2];
+
+/* Starts or stops the ranging of sensor 0 in a loop */
+static void *_test_start_stop_thread(void *arg)
+{
+	uint32_t n, is_start = (uint32_t)(uintptr_t)arg;
+	uint8_t status;
+
+	/* Most calls find an operation running */
+	for (n = 0; n < 2000U; n++)
+	{
+		status = is_start
+			? vl53l8cx_manager_start_ranging(&ops_mgr, 0)
+			: vl53l8cx_manager_stop_ranging(&ops_mgr, 0);
+		if (status == VL53L8CX_STATUS_OK)
+		{
+			nb_accepted[is_start]++;
+		}
+		(void)usleep(100);
+	}
+
+	return NULL;
+}
+
+/*
+ * Two threads start and stop the same sensor. A call is either refused or
+ * runs its whole operation: an operation overwritten by another call would be
+ * restarted and take more steps, or leave the manager checking frames of a
+ * stopped sensor.
+ */
+static void _test_concurrent_ops(void)
+{
+	static EmuSensor emu;
+	static EmuBus bus;
+	pthread_t threads[2];
+	uint32_t n, nb_ops;
+	uint8_t id, op_status;
+
+	emu_sensor_init(&emu, &bus, 10000, 100, 500);
+	emu.nb_steps = 3;
+	emu.step_us = 100;
+	emu.step_gap_ms = 1;
+	_test_attach(&emu.dev);
+
+	TEST_CHECK(vl53l8cx_manager_init(&ops_mgr, &emu_sensor_ops, NULL,
+			NULL, 0) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_manager_add_sensor(&ops_mgr, &emu.dev, 0, &id)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_manager_start(&ops_mgr) == VL53L8CX_STATUS_OK);
+	for (n = 0; n < 2U; n++)
+	{
+		(void)pthread_create(&threads[n], NULL,
+				_test_start_stop_thread, (void *)(uintptr_t)n);
+	}
+	for (n = 0; n < 2U; n++)
+	{
+		(void)pthread_join(threads[n], NULL);
+	}
+	TEST_CHECK(vl53l8cx_manager_wait(&ops_mgr, id, 1000, &op_status)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_manager_stop(&ops_mgr) == VL53L8CX_STATUS_OK);
+
+	nb_ops = nb_accepted[0] + nb_accepted[1];
+	(void)printf("%u starts and %u stops accepted, %u steps\n",
+			nb_accepted[1], nb_accepted[0], emu.steps);
+	TEST_CHECK(nb_ops > 0U);
+	TEST_CHECK(emu.ops_done == nb_ops);
+	TEST_CHECK(emu.steps == (nb_ops * emu.nb_steps));
+	TEST_CHECK(emu.reads_stopped == 0U);
+	TEST_CHECK(ops_mgr.sensors[id].is_ranging == emu.is_ranging);
+	TEST_CHECK(atomic_load(&bus.collisions) == 0U);
+}
+
+/*
+ * The driver functions drive sensors of the emulated platform: two share bus
+ * 0 and one has bus 1. The start and stop operations are the real ones,
+ * stepped by the bus threads, and frames are read as the sensors write them.
+ */
+static void _test_uld_ops(void)
+{
+	static VL53L8CX_Manager mgr;
+	static VL53L8CX_Configuration devs[3];
+	static const uint32_t periods_us[3] = {20000, 25000, 15000};
+	VL53L8CX_ManagerSensorStats sensor_stats[3];
+	VL53L8CX_ManagerBusStats bus_stats[VL53L8CX_MANAGER_MAX_BUSES];
+	VL53L8CX_FrameStats frame_stats;
+	uint8_t i, id[3], op_status;
+
+	(void)memset(frames_cb, 0, sizeof(frames_cb));
+	TEST_CHECK(vl53l8cx_manager_init(&mgr, NULL, _test_frame_cb, NULL, 0)
+			== VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		emu_platform_reset(i);
+		(void)memset(&devs[i], 0, sizeof(devs[i]));
+		devs[i].platform.spi_channel = i;
+		_test_attach(&devs[i]);
+		TEST_CHECK(vl53l8cx_pool_begin(&devs[i]) == VL53L8CX_STATUS_OK);
+		TEST_CHECK(vl53l8cx_init(&devs[i]) == VL53L8CX_STATUS_OK);
+		vl53l8cx_pool_end(&devs[i]);
+		emu_platform_sensors[i].period_us = periods_us[i];
+		TEST_CHECK(vl53l8cx_manager_add_sensor(&mgr, &devs[i],
+				(i < 2U) ? 0 : 1, &id[i])
+				== VL53L8CX_STATUS_OK);
+	}
+	TEST_CHECK(vl53l8cx_manager_start(&mgr) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_manager_start_ranging(&mgr, id[i])
+				== VL53L8CX_STATUS_OK);
+	}
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_manager_wait(&mgr, id[i], 2000, &op_status)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(op_status == VL53L8CX_STATUS_OK);
+		TEST_CHECK(emu_platform_sensors[i].is_ranging == 1U);
+	}
+	(void)usleep(600000);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_manager_stop_ranging(&mgr, id[i])
+				== VL53L8CX_STATUS_OK);
+	}
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(vl53l8cx_manager_wait(&mgr, id[i], 2000, &op_status)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(op_status == VL53L8CX_STATUS_OK);
+		TEST_CHECK(emu_platform_sensors[i].is_ranging == 0U);
+	}
+	TEST_CHECK(vl53l8cx_manager_stop(&mgr) == VL53L8CX_STATUS_OK);
+
+	vl53l8cx_manager_get_stats(&mgr, sensor_stats, bus_stats);
+	for (i = 0; i < 3U; i++)
+	{
+		(void)vl53l8cx_get_frame_stats(&devs[i], &frame_stats);
+		(void)printf("driver sensor %u: %u frames, %u dropped, "
+			"period %.2f ms\n", i, sensor_stats[i].frames_read,
+			frame_stats.frames_dropped,
+			(double)sensor_stats[i].frame_period_ns / 1e6);
+		TEST_CHECK(sensor_stats[i].errors == 0U);
+		TEST_CHECK(frames_cb[id[i]] == sensor_stats[i].frames_read);
+		TEST_CHECK(frame_stats.frames_received
+				== sensor_stats[i].frames_read);
+		TEST_CHECK(frame_stats.frames_corrupted == 0U);
+		/* At least 80 % of the frames of 600 ms */
+		TEST_CHECK(sensor_stats[i].frames_read
+				>= ((600000U * 8U) / (periods_us[i] * 10U)));
+		TEST_CHECK(frame_stats.frames_dropped
+				<= (sensor_stats[i].frames_read / 10U));
+	}
+}
+
+int main(void)
+{
+#ifdef VL53L8CX_SHARED_BUFFERS
+	VL53L8CX_PoolStats pool_stats;
+
+	TEST_CHECK(vl53l8cx_pool_init(&pool) == VL53L8CX_STATUS_OK);
+#endif
+	_test_scheduling();
+	_test_concurrent_ops();
+	_test_uld_ops();
+#ifdef VL53L8CX_SHARED_BUFFERS
+	/* The bus threads gave back each buffer borrowed */
+	vl53l8cx_pool_get_stats(&pool, &pool_stats);
+	TEST_CHECK(pool_stats.buffers_used == 0U);
+	TEST_CHECK(pool_stats.buffers_used_max > 0U);
+	TEST_CHECK(pool_stats.timeouts == 0U);
+#endif
+
+	(void)printf("test_manager: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
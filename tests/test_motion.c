@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_motion.h"
+#include "test_common.h"
+
+#define TEST_NB_FRAMES		5000U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x6C078965U;
+
+/* State of the reference, one zone at a time in double precision */
+typedef struct
+{
+	double			mean[VL53L8CX_RESOLUTION_8X8];
+	double			variance[VL53L8CX_RESOLUTION_8X8];
+	uint8_t			is_started[VL53L8CX_RESOLUTION_8X8];
+	double			aggregate[VL53L8CX_MOTION_NB_AGGREGATES];
+} TestMotion;
+
+static void _test_reference(
+		TestMotion			*p_ref,
+		const VL53L8CX_MotionConfig	*p_config,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+	double z, delta, sigma, score[VL53L8CX_RESOLUTION_8X8];
+	uint32_t zone, idx, a, row, col;
+	uint8_t is_valid;
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		is_valid = (uint8_t)(((p_results->target_status[idx] == 5U)
+			|| (p_results->target_status[idx] == 9U))
+			&& (p_results->nb_target_detected[zone] > 0U));
+		z = (double)p_results->distance_mm[idx];
+		z = (z < (double)p_config->min_distance_mm)
+			? (double)p_config->min_distance_mm : z;
+		z = (z > (double)p_config->max_distance_mm)
+			? (double)p_config->max_distance_mm : z;
+		sigma = (double)p_results->range_sigma_mm[idx];
+		if (!is_valid || (sigma < (double)p_config->noise_mm))
+		{
+			sigma = (double)p_config->noise_mm;
+		}
+		sigma = (sigma < 1.0) ? 1.0 : sigma;
+
+		if (is_valid && p_ref->is_started[zone])
+		{
+			delta = z - p_ref->mean[zone];
+			p_ref->mean[zone] += (double)p_config->alpha * delta;
+			p_ref->variance[zone] = (1.0 - (double)p_config->alpha)
+				* (p_ref->variance[zone] + ((double)p_config->alpha
+				* delta * delta));
+		}
+		else if (is_valid)
+		{
+			p_ref->mean[zone] = z;
+			p_ref->variance[zone] = 0.0;
+			p_ref->is_started[zone] = 1;
+		}
+		score[zone] = p_ref->variance[zone] / (sigma * sigma);
+	}
+
+	/* Zones of a 4x4 frame, or blocks of 2x2 zones of a 8x8 frame */
+	for (a = 0; a < VL53L8CX_MOTION_NB_AGGREGATES; a++)
+	{
+		if (nb_zones == VL53L8CX_RESOLUTION_4X4)
+		{
+			p_ref->aggregate[a] = score[a];
+		}
+		else
+		{
+			row = (a / 4U) * 2U;
+			col = (a % 4U) * 2U;
+			p_ref->aggregate[a] = (score[(row * 8U) + col]
+				+ score[(row * 8U) + col + 1U]
+				+ score[((row + 1U) * 8U) + col]
+				+ score[((row + 1U) * 8U) + col + 1U]) / 4.0;
+		}
+		if (p_ref->aggregate[a] > 1000000.0)
+		{
+			p_ref->aggregate[a] = 1000000.0;
+		}
+	}
+}
+
+/*
+ * Random frames: a static background with noise, a few zones moving by up to
+ * a few hundred mm, distances out of the window, and invalid zones. The
+ * resolution changes every 1000 frames, which resets both.
+ */
+static void _test_random_frames(void)
+{
+	static VL53L8CX_Motion mot;
+	static VL53L8CX_ResultsData results;
+	static TestMotion ref;
+	VL53L8CX_MotionConfig config;
+	const VL53L8CX_MotionIndicator *p_ind;
+	double score, sum, tolerance;
+	uint32_t frame, zone, idx, a, bits, count;
+	uint32_t nb_mismatches = 0, nb_moving = 0;
+	int32_t d;
+	uint8_t nb_zones = 0;
+
+	config.min_distance_mm = 100;
+	config.max_distance_mm = 3000;
+	config.alpha = 0.3f;
+	config.noise_mm = 8.0f;
+	config.threshold = 9.0f;
+	config.min_aggregates = 2;
+	vl53l8cx_motion_init(&mot, &config);
+
+	for (frame = 0; frame < TEST_NB_FRAMES; frame++)
+	{
+		if ((frame % 1000U) == 0U)
+		{
+			nb_zones = (nb_zones == VL53L8CX_RESOLUTION_8X8)
+				? VL53L8CX_RESOLUTION_4X4
+				: VL53L8CX_RESOLUTION_8X8;
+			(void)memset(&ref, 0, sizeof(ref));
+		}
+		for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+		{
+			idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+			d = 1500 + (int32_t)(test_random(&seed) % 41U) - 20;
+			if ((zone % 7U) == 0U)
+			{
+				d += (int32_t)(test_random(&seed) % 600U) - 300;
+			}
+			if ((zone % 11U) == 0U)
+			{
+				d = (int32_t)(test_random(&seed) % 4000U);
+			}
+			results.distance_mm[idx] = (int16_t)d;
+			results.range_sigma_mm[idx] = (uint16_t)(
+				test_random(&seed) % 20U);
+			results.target_status[idx] = ((test_random(&seed) % 20U)
+				== 0U) ? 255U : 5U;
+			results.nb_target_detected[zone] = 1;
+		}
+		(void)vl53l8cx_update_validity(&results,
+				VL53L8CX_RESOLUTION_8X8);
+
+		_test_reference(&ref, &config, &results, nb_zones);
+		TEST_CHECK(vl53l8cx_motion_update(&mot, &results, nb_zones)
+				== VL53L8CX_STATUS_OK);
+
+		p_ind = &mot.indicator;
+		bits = 0;
+		count = 0;
+		sum = 0.0;
+		for (a = 0; a < VL53L8CX_MOTION_NB_AGGREGATES; a++)
+		{
+			score = ref.aggregate[a];
+			tolerance = 1e-4 * (1.0 + score);
+			sum += score;
+			if (fabs(score - (double)config.threshold) < tolerance)
+			{
+				/* Too close to the threshold to compare */
+				bits |= p_ind->global_indicator_1 & (1U << a);
+				count += (p_ind->global_indicator_1 >> a) & 1U;
+			}
+			else if (score >= (double)config.threshold)
+			{
+				bits |= 1U << a;
+				count++;
+			}
+			if (fabs(((double)p_ind->motion[a]
+				/ (double)VL53L8CX_MOTION_SCORE_ONE) - score)
+				> (tolerance + (1.0
+					/ (double)VL53L8CX_MOTION_SCORE_ONE)))
+			{
+				nb_mismatches++;
+			}
+		}
+		nb_moving += count;
+		if ((p_ind->global_indicator_1 != bits)
+			|| (p_ind->nb_of_detected_aggregates != count)
+			|| (p_ind->status != (uint8_t)(count
+				>= config.min_aggregates))
+			|| (fabs(((double)p_ind->global_indicator_2
+				/ (double)VL53L8CX_MOTION_SCORE_ONE)
+				- (sum / VL53L8CX_MOTION_NB_AGGREGATES))
+				> (1e-4 * (1.0 + sum) + (1.0
+					/ (double)VL53L8CX_MOTION_SCORE_ONE))))
+		{
+			nb_mismatches++;
+		}
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			if (ref.is_started[zone] && (fabs(
+				(double)mot.mean_mm[zone] - ref.mean[zone])
+				> (1e-4 * (1.0 + fabs(ref.mean[zone])))))
+			{
+				nb_mismatches++;
+			}
+		}
+	}
+	(void)printf("%u frames, %u moving aggregates, %u mismatches\n",
+			TEST_NB_FRAMES, nb_moving, nb_mismatches);
+	TEST_CHECK(nb_moving > 0U);
+	TEST_CHECK(nb_mismatches == 0U);
+}
+
+/* Frame of a wall at 2000 mm, and an object in zones 18, 19, 26 and 27 */
+static void _test_scene(
+		VL53L8CX_ResultsData		*p_results,
+		int32_t				object_mm)
+{
+	uint32_t zone;
+	uint8_t is_object;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		is_object = (uint8_t)((object_mm != 0) && ((zone == 18U)
+			|| (zone == 19U) || (zone == 26U) || (zone == 27U)));
+		p_results->distance_mm[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			(int16_t)((is_object ? object_mm : 2000)
+			+ (int32_t)(test_random(&seed) % 21U) - 10);
+		p_results->range_sigma_mm[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			8;
+		p_results->target_status[zone * VL53L8CX_NB_TARGET_PER_ZONE] =
+			5;
+		p_results->nb_target_detected[zone] = 1;
+	}
+	(void)vl53l8cx_update_validity(p_results, VL53L8CX_RESOLUTION_8X8);
+}
+
+/*
+ * With the default settings, the sensor noise alone is not motion, and an
+ * object moving by 40 mm per frame is seen in its aggregate only (block 5).
+ */
+static void _test_detection(void)
+{
+	static VL53L8CX_Motion mot;
+	static VL53L8CX_ResultsData results;
+	uint32_t frame, nb_false = 0, nb_detected = 0, nb_other = 0;
+	int32_t step;
+
+	vl53l8cx_motion_init(&mot, NULL);
+	for (frame = 0; frame < 500U; frame++)
+	{
+		_test_scene(&results, 0);
+		TEST_CHECK(vl53l8cx_motion_update(&mot, &results,
+				VL53L8CX_RESOLUTION_8X8) == VL53L8CX_STATUS_OK);
+		nb_false += (uint32_t)((frame > 20U)
+			&& (mot.indicator.status != 0U));
+	}
+	for (frame = 0; frame < 100U; frame++)
+	{
+		step = (int32_t)(frame % 10U);
+		_test_scene(&results, 1200 + (40 * ((step < 5) ? step
+			: (10 - step))));
+		TEST_CHECK(vl53l8cx_motion_update(&mot, &results,
+				VL53L8CX_RESOLUTION_8X8) == VL53L8CX_STATUS_OK);
+		nb_detected += (mot.indicator.global_indicator_1 >> 5) & 1U;
+		nb_other += (uint32_t)((mot.indicator.global_indicator_1
+			& ~(1U << 5)) != 0U);
+	}
+	(void)printf("static: %u false frames, moving: detected in %u/100 "
+			"frames, other aggregates in %u\n", nb_false,
+			nb_detected, nb_other);
+	TEST_CHECK(nb_false == 0U);
+	TEST_CHECK(nb_detected >= 95U);
+	TEST_CHECK(nb_other == 0U);
+}
+
+int main(void)
+{
+	_test_random_frames();
+	_test_detection();
+
+	(void)printf("test_motion: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
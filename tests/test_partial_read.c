@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		0U
+#define TEST_N			VL53L8CX_NB_TARGET_PER_ZONE
+#define TEST_MASK		(VL53L8CX_OUTPUT_DISTANCE_MM \
+	| VL53L8CX_OUTPUT_RANGE_SIGMA_MM | VL53L8CX_OUTPUT_TARGET_STATUS)
+
+static uint32_t nb_failures;
+
+/* Emulated sensor ranging at a resolution, frames written by the test */
+static void _test_start(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				resolution)
+{
+	(void)memset(p_dev, 0, sizeof(*p_dev));
+	emu_platform_reset(TEST_CHANNEL);
+	p_dev->platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(p_dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_set_resolution(p_dev, resolution)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_start_ranging(p_dev) == VL53L8CX_STATUS_OK);
+}
+
+/*
+ * The outputs selected by a partial read are the ones of a full read of the
+ * same frame, for fewer bytes, and the last bus read is the footer.
+ */
+static void _test_same_frame(
+		uint8_t				resolution)
+{
+	static VL53L8CX_Configuration dev;
+	static VL53L8CX_ResultsData full, partial;
+	EmuPlatformSensor *p_emu = &emu_platform_sensors[TEST_CHANNEL];
+	EmuPlatformAccess log[8];
+	uint32_t frame, size, full_bytes, partial_bytes;
+
+	_test_start(&dev, resolution);
+	size = resolution * TEST_N;
+	for (frame = 0; frame < 100U; frame++)
+	{
+		(void)emu_platform_frame(TEST_CHANNEL);
+		TEST_CHECK(vl53l8cx_set_partial_read(&dev, 0, 0)
+				== VL53L8CX_STATUS_OK);
+		full_bytes = p_emu->bytes;
+		TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &full)
+				== VL53L8CX_STATUS_OK);
+		full_bytes = p_emu->bytes - full_bytes;
+		TEST_CHECK(full_bytes == (dev.data_read_size + 2U));
+
+		(void)memset(&partial, 0, sizeof(partial));
+		TEST_CHECK(vl53l8cx_set_partial_read(&dev, TEST_MASK, 0)
+				== VL53L8CX_STATUS_OK);
+		p_emu->p_log = log;
+		p_emu->log_size = 8;
+		p_emu->log_count = 0;
+		partial_bytes = p_emu->bytes;
+		TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &partial)
+				== VL53L8CX_STATUS_OK);
+		partial_bytes = p_emu->bytes - partial_bytes;
+		p_emu->p_log = NULL;
+
+		TEST_CHECK(partial_bytes < full_bytes);
+		TEST_CHECK((p_emu->log_count >= 2U)
+				&& (p_emu->log_count <= 8U));
+		TEST_CHECK(log[0].size == VL53L8CX_PARTIAL_HEADER_SIZE);
+		TEST_CHECK((log[p_emu->log_count - 1U].address
+				+ log[p_emu->log_count - 1U].size)
+				== dev.data_read_size);
+		TEST_CHECK(memcmp(partial.distance_mm, full.distance_mm,
+				size * sizeof(int16_t)) == 0);
+		TEST_CHECK(memcmp(partial.range_sigma_mm, full.range_sigma_mm,
+				size * sizeof(uint16_t)) == 0);
+		TEST_CHECK(memcmp(partial.target_status, full.target_status,
+				size) == 0);
+		TEST_CHECK(memcmp(partial.nb_target_detected,
+				full.nb_target_detected, resolution) == 0);
+		TEST_CHECK(partial.silicon_temp_degc == full.silicon_temp_degc);
+		/* Outputs not selected are not fetched */
+		TEST_CHECK(partial.signal_per_spad[0] == 0U);
+	}
+	(void)printf("%u zones: %u bytes per full frame, %u per partial "
+			"frame\n", resolution, full_bytes, partial_bytes);
+
+	/* The footer is read at the end of the frame, even in partial mode */
+	(void)emu_platform_frame(TEST_CHANNEL);
+	p_emu->torn_reads = 1;
+	TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &partial)
+			== VL53L8CX_STATUS_CORRUPTED_FRAME);
+	TEST_CHECK(p_emu->torn_reads == 0U);
+	TEST_CHECK(vl53l8cx_stop_ranging(&dev) == VL53L8CX_STATUS_OK);
+}
+
+/* Target status needs the number of targets, and full frames are periodic */
+static void _test_period(void)
+{
+	static VL53L8CX_Configuration dev;
+	static VL53L8CX_ResultsData results;
+	uint32_t frame;
+
+	_test_start(&dev, VL53L8CX_RESOLUTION_4X4);
+	TEST_CHECK(vl53l8cx_set_partial_read(&dev, 0x0001U, 0)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_set_partial_read(&dev,
+			VL53L8CX_OUTPUT_TARGET_STATUS, 3)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(dev.partial_read_mask == (VL53L8CX_OUTPUT_TARGET_STATUS
+			| VL53L8CX_OUTPUT_NB_TARGET_DETECTED));
+
+	/* 3 partial frames, then a full one */
+	for (frame = 0; frame < 12U; frame++)
+	{
+		(void)emu_platform_frame(TEST_CHANNEL);
+		TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+				== VL53L8CX_STATUS_OK);
+		if ((frame % 4U) == 3U)
+		{
+			TEST_CHECK(dev.fetched_outputs == VL53L8CX_OUTPUT_ALL);
+		}
+		else
+		{
+			TEST_CHECK(dev.fetched_outputs
+					== dev.partial_read_mask);
+		}
+	}
+
+	/* Period 0 never reads full frames */
+	TEST_CHECK(vl53l8cx_set_partial_read(&dev,
+			VL53L8CX_OUTPUT_DISTANCE_MM, 0) == VL53L8CX_STATUS_OK);
+	for (frame = 0; frame < 300U; frame++)
+	{
+		(void)emu_platform_frame(TEST_CHANNEL);
+		TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &results)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(dev.fetched_outputs == VL53L8CX_OUTPUT_DISTANCE_MM);
+	}
+	TEST_CHECK(vl53l8cx_stop_ranging(&dev) == VL53L8CX_STATUS_OK);
+}
+
+int main(void)
+{
+	_test_same_frame(VL53L8CX_RESOLUTION_4X4);
+	_test_same_frame(VL53L8CX_RESOLUTION_8X8);
+	_test_period();
+
+	(void)printf("test_partial_read: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_plane.h"
+#include "vl53l8cx_pointcloud.h"
+#include "test_common.h"
+
+#define TEST_NB_FRAMES		2001U
+#define TEST_HEIGHT_MM		1000.0
+#define TEST_PITCH_DEG		30.0
+#define TEST_NOISE_MM		15U
+#define TEST_DEG_TO_RAD		0.017453292519943295
+#define TEST_SETTLE_FRAMES	3U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x1B873593U;
+
+/* Point cloud of a frame, and what it should show */
+typedef struct
+{
+	VL53L8CX_PointCloudConverter	conv;
+	VL53L8CX_ResultsData		results;
+	VL53L8CX_PointCloud		cloud;
+	float				x[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	float				y[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	float				z[VL53L8CX_POINTCLOUD_MAX_POINTS];
+	/* Zones whose ray hits the floor before the wall */
+	uint64_t			floor_zones;
+	/* Height of the true point of each zone above the floor, in mm */
+	double				height_mm[VL53L8CX_RESOLUTION_8X8];
+} TestScene;
+
+/*
+ * Sensor TEST_HEIGHT_MM above the floor and pitched down, in front of a wall
+ * at wall_mm. Rays are cast in double precision, independently of the LUT of
+ * the converter, then the distances get some noise.
+ */
+static void _test_scene(
+		TestScene			*p_scene,
+		double				pitch_deg,
+		double				wall_mm)
+{
+	double fov = (double)VL53L8CX_POINTCLOUD_FOV_DEG * TEST_DEG_TO_RAD;
+	double cp = cos(pitch_deg * TEST_DEG_TO_RAD);
+	double sp = sin(pitch_deg * TEST_DEG_TO_RAD);
+	double x, y, z, norm, dy, dz, t_floor, t_wall, t;
+	uint32_t row, col, zone, idx;
+
+	p_scene->floor_zones = 0;
+	for (row = 0; row < 8U; row++)
+	{
+		for (col = 0; col < 8U; col++)
+		{
+			zone = (row * 8U) + col;
+			x = tan(((((double)col + 0.5) / 8.0) - 0.5) * fov);
+			y = tan((0.5 - (((double)row + 0.5) / 8.0)) * fov);
+			z = 1.0;
+			norm = sqrt((x * x) + (y * y) + (z * z));
+			dy = ((cp * y) - (sp * z)) / norm;
+			dz = ((sp * y) + (cp * z)) / norm;
+
+			t_floor = (dy < 0.0) ? -TEST_HEIGHT_MM / dy : INFINITY;
+			t_wall = wall_mm / dz;
+			t = (t_floor < t_wall) ? t_floor : t_wall;
+			if (t_floor < t_wall)
+			{
+				p_scene->floor_zones |= (uint64_t)1U << zone;
+			}
+			p_scene->height_mm[zone] = TEST_HEIGHT_MM + (t * dy);
+
+			idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+			p_scene->results.distance_mm[idx] = (int16_t)(lround(t)
+				+ (int32_t)(test_random(&seed)
+				% ((2U * TEST_NOISE_MM) + 1U))
+				- (int32_t)TEST_NOISE_MM);
+			p_scene->results.target_status[idx] = 5;
+			p_scene->results.nb_target_detected[zone] = 1;
+		}
+	}
+	(void)vl53l8cx_update_validity(&p_scene->results,
+			VL53L8CX_RESOLUTION_8X8);
+	TEST_CHECK(vl53l8cx_pointcloud_convert(&p_scene->conv,
+			&p_scene->results, VL53L8CX_RESOLUTION_8X8,
+			&p_scene->cloud) == VL53L8CX_STATUS_OK);
+}
+
+static void _test_scene_init(
+		TestScene			*p_scene,
+		double				pitch_deg)
+{
+	VL53L8CX_PointCloudPose pose;
+
+	(void)memset(p_scene, 0, sizeof(*p_scene));
+	vl53l8cx_pointcloud_pose(&pose, 0.0f, (float)pitch_deg, 0.0f, NULL);
+	vl53l8cx_pointcloud_init(&p_scene->conv, &pose);
+	p_scene->cloud.p_x_mm = p_scene->x;
+	p_scene->cloud.p_y_mm = p_scene->y;
+	p_scene->cloud.p_z_mm = p_scene->z;
+	p_scene->cloud.capacity = VL53L8CX_POINTCLOUD_MAX_POINTS;
+}
+
+/*
+ * Least squares fit of y = a.x + b.z + c on the points of the floor zones, in
+ * double precision, as a plane normal . p + offset = 0 with the normal up.
+ */
+static void _test_reference(
+		const TestScene			*p_scene,
+		double				*p_normal,
+		double				*p_offset)
+{
+	double m[3][4] = {{0}}, v[3], f, norm;
+	uint32_t zone, i, j, k;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		if (((p_scene->floor_zones >> zone) & 1U) == 0U)
+		{
+			continue;
+		}
+		v[0] = p_scene->x[zone];
+		v[1] = p_scene->z[zone];
+		v[2] = 1.0;
+		for (i = 0; i < 3U; i++)
+		{
+			for (j = 0; j < 3U; j++)
+			{
+				m[i][j] += v[i] * v[j];
+			}
+			m[i][3] += v[i] * p_scene->y[zone];
+		}
+	}
+
+	/* Gauss elimination, the system is well conditioned */
+	for (i = 0; i < 3U; i++)
+	{
+		for (j = 0; j < 3U; j++)
+		{
+			if (j == i)
+			{
+				continue;
+			}
+			f = m[j][i] / m[i][i];
+			for (k = i; k < 4U; k++)
+			{
+				m[j][k] -= f * m[i][k];
+			}
+		}
+	}
+
+	norm = sqrt(((m[0][3] / m[0][0]) * (m[0][3] / m[0][0]))
+		+ ((m[1][3] / m[1][1]) * (m[1][3] / m[1][1])) + 1.0);
+	p_normal[0] = -(m[0][3] / m[0][0]) / norm;
+	p_normal[1] = 1.0 / norm;
+	p_normal[2] = -(m[1][3] / m[1][1]) / norm;
+	*p_offset = -(m[2][3] / m[2][2]) / norm;
+}
+
+/*
+ * 1 if a zone off the floor is close enough to it to be an inlier, like the
+ * bottom of the wall: a plane tilted towards the wall may fit such a frame as
+ * well as the floor.
+ */
+static uint8_t _test_is_ambiguous(
+		const TestScene			*p_scene,
+		const VL53L8CX_Plane		*p_plane)
+{
+	uint32_t zone;
+
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		if ((((p_scene->floor_zones >> zone) & 1U) == 0U)
+			&& (p_scene->height_mm[zone] < (2.0
+				* (double)p_plane->config.threshold_mm)))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * The moving wall scene: the floor must be found in every frame. When the
+ * frame is not ambiguous, the plane is the least squares fit of the floor
+ * zones, and its zones are the floor zones. A plane kept from an ambiguous
+ * frame may take a few frames to be replaced, so these are skipped too.
+ */
+static void _test_floor(void)
+{
+	static VL53L8CX_Plane plane;
+	static TestScene scene;
+	VL53L8CX_PlaneStats stats;
+	double normal[3], offset, wall, dot, max_ref_deg = 0.0;
+	double max_true_deg = 0.0, max_ref_mm = 0.0, max_true_mm = 0.0;
+	uint32_t frame, settle = 0, nb_checked = 0, nb_bad_masks = 0;
+
+	_test_scene_init(&scene, TEST_PITCH_DEG);
+	vl53l8cx_plane_init(&plane, NULL);
+	/* No budget: the results do not depend on the speed of the host */
+	plane.config.budget_ns = 0;
+
+	for (frame = 0; frame < TEST_NB_FRAMES; frame++)
+	{
+		wall = 1200.0 + (double)(((frame / 500U) % 2U) != 0U
+			? 500U - (frame % 500U) : frame % 500U) * 2.0;
+		_test_scene(&scene, TEST_PITCH_DEG, wall);
+		TEST_CHECK(vl53l8cx_plane_update(&plane, &scene.cloud)
+				== VL53L8CX_STATUS_OK);
+		if (_test_is_ambiguous(&scene, &plane))
+		{
+			settle = TEST_SETTLE_FRAMES;
+		}
+		if (!plane.is_found || (settle != 0U))
+		{
+			settle -= (uint32_t)(settle != 0U);
+			continue;
+		}
+
+		nb_checked++;
+		_test_reference(&scene, normal, &offset);
+		dot = (normal[0] * plane.normal[0])
+			+ (normal[1] * plane.normal[1])
+			+ (normal[2] * plane.normal[2]);
+		dot = (dot > 1.0) ? 1.0 : dot;
+		max_ref_deg = fmax(max_ref_deg, acos(dot) / TEST_DEG_TO_RAD);
+		max_ref_mm = fmax(max_ref_mm, fabs(plane.offset_mm - offset));
+		dot = (plane.normal[1] > 1.0f) ? 1.0 : plane.normal[1];
+		max_true_deg = fmax(max_true_deg, acos(dot)
+			/ TEST_DEG_TO_RAD);
+		max_true_mm = fmax(max_true_mm, fabs(plane.offset_mm
+			- TEST_HEIGHT_MM));
+		nb_bad_masks += (uint32_t)(plane.floor_mask
+			!= scene.floor_zones);
+	}
+
+	vl53l8cx_plane_get_stats(&plane, &stats);
+	(void)printf("%u frames: floor found %u, warm %u, %.1f draws/frame\n",
+			stats.frames, stats.found, stats.warm_starts,
+			(double)stats.iterations / (double)stats.frames);
+	(void)printf("%u frames checked: vs reference %.3f deg, %.2f mm, vs "
+			"truth %.3f deg, %.2f mm, %u bad masks\n", nb_checked,
+			max_ref_deg, max_ref_mm, max_true_deg, max_true_mm,
+			nb_bad_masks);
+	TEST_CHECK(stats.found == TEST_NB_FRAMES);
+	TEST_CHECK(stats.warm_starts >= ((TEST_NB_FRAMES * 9U) / 10U));
+	TEST_CHECK(stats.iterations <= ((uint64_t)TEST_NB_FRAMES
+			* (plane.config.warm_iterations + 1U)));
+	TEST_CHECK(nb_checked >= (TEST_NB_FRAMES / 2U));
+	TEST_CHECK(max_ref_deg < 0.1);
+	TEST_CHECK(max_ref_mm < 0.5);
+	TEST_CHECK(max_true_deg < 2.0);
+	TEST_CHECK(max_true_mm < 30.0);
+	TEST_CHECK(nb_bad_masks == 0U);
+}
+
+/*
+ * With a 2 us budget, the floor of the previous frame is still confirmed in
+ * every frame.
+ */
+static void _test_budget(void)
+{
+	static VL53L8CX_Plane plane;
+	static TestScene scene;
+	uint32_t frame, nb_found = 0;
+
+	_test_scene_init(&scene, TEST_PITCH_DEG);
+	vl53l8cx_plane_init(&plane, NULL);
+	_test_scene(&scene, TEST_PITCH_DEG, 1500.0);
+	plane.config.budget_ns = 0;
+	TEST_CHECK(vl53l8cx_plane_update(&plane, &scene.cloud)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(plane.is_found);
+
+	plane.config.budget_ns = 2000;
+	for (frame = 0; frame < 500U; frame++)
+	{
+		_test_scene(&scene, TEST_PITCH_DEG, 1200.0
+			+ (double)(frame * 2U));
+		TEST_CHECK(vl53l8cx_plane_update(&plane, &scene.cloud)
+				== VL53L8CX_STATUS_OK);
+		nb_found += plane.is_found;
+	}
+	(void)printf("2 us budget: floor found %u/500, %u budget hits, max "
+			"%.1f us\n", nb_found, plane.stats.budget_hits,
+			(double)plane.stats.max_ns / 1000.0);
+	TEST_CHECK(nb_found == 500U);
+}
+
+/* A level sensor in front of a wall sees no floor */
+static void _test_wall_only(void)
+{
+	static VL53L8CX_Plane plane;
+	static TestScene scene;
+	uint32_t frame, nb_found = 0;
+
+	_test_scene_init(&scene, 0.0);
+	vl53l8cx_plane_init(&plane, NULL);
+	plane.config.budget_ns = 0;
+	for (frame = 0; frame < 200U; frame++)
+	{
+		_test_scene(&scene, 0.0, 1500.0);
+		TEST_CHECK(scene.floor_zones == 0U);
+		TEST_CHECK(vl53l8cx_plane_update(&plane, &scene.cloud)
+				== VL53L8CX_STATUS_OK);
+		nb_found += plane.is_found;
+		TEST_CHECK(plane.floor_mask == 0U);
+	}
+	(void)printf("wall only: floor found %u/200\n", nb_found);
+	TEST_CHECK(nb_found == 0U);
+}
+
+int main(void)
+{
+	_test_floor();
+	_test_budget();
+	_test_wall_only();
+
+	(void)printf("test_plane: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_CHANNEL		2U
+#define TEST_N			VL53L8CX_NB_TARGET_PER_ZONE
+
+static uint32_t nb_failures;
+
+/*
+ * Frames torn by 0 to VL53L8CX_MAX_FRAME_REREADS + 1 reads, for each number of
+ * re-reads allowed.
+ */
+static void _test_rereads(
+		uint16_t			output_mask)
+{
+	static VL53L8CX_Configuration dev;
+	static VL53L8CX_ResultsData clean, results;
+	EmuPlatformSensor *p_emu = &emu_platform_sensors[TEST_CHANNEL];
+	VL53L8CX_FrameStats stats;
+	uint32_t torn, max_rereads, transactions, frame_transactions = 0;
+	uint8_t status, count;
+
+	(void)memset(&dev, 0, sizeof(dev));
+	emu_platform_reset(TEST_CHANNEL);
+	dev.platform.spi_channel = TEST_CHANNEL;
+	TEST_CHECK(vl53l8cx_init(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_start_ranging(&dev) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_set_partial_read(&dev, output_mask, 100)
+			== VL53L8CX_STATUS_OK);
+
+	TEST_CHECK(vl53l8cx_set_frame_rereads(&dev,
+			VL53L8CX_MAX_FRAME_REREADS + 1U)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(dev.max_frame_rereads == 0U);
+
+	for (max_rereads = 0; max_rereads <= VL53L8CX_MAX_FRAME_REREADS;
+			max_rereads++)
+	{
+		TEST_CHECK(vl53l8cx_set_frame_rereads(&dev,
+				(uint8_t)max_rereads) == VL53L8CX_STATUS_OK);
+		for (torn = 0; torn <= (VL53L8CX_MAX_FRAME_REREADS + 1U);
+				torn++)
+		{
+			(void)emu_platform_frame(TEST_CHANNEL);
+			TEST_CHECK(vl53l8cx_get_ranging_data(&dev, &clean)
+					== VL53L8CX_STATUS_OK);
+			count = dev.partial_read_count;
+			TEST_CHECK(vl53l8cx_reset_frame_stats(&dev)
+					== VL53L8CX_STATUS_OK);
+
+			/* The same frame, read while the firmware writes it */
+			(void)memset(&results, 0, sizeof(results));
+			p_emu->torn_reads = torn;
+			transactions = p_emu->transactions;
+			status = vl53l8cx_get_ranging_data(&dev, &results);
+			transactions = p_emu->transactions - transactions;
+			p_emu->torn_reads = 0;
+			(void)vl53l8cx_get_frame_stats(&dev, &stats);
+
+			TEST_CHECK(stats.frames_dropped == 0U);
+			TEST_CHECK(stats.frames_corrupted == ((torn
+					<= max_rereads) ? torn
+					: (max_rereads + 1U)));
+			if (torn == 0U)
+			{
+				TEST_CHECK(status == VL53L8CX_STATUS_OK);
+				TEST_CHECK(stats.rereads == 0U);
+				TEST_CHECK(stats.frames_received == 1U);
+			}
+			else if (torn <= max_rereads)
+			{
+				/* Recovered, without moving the full read
+				 * period */
+				TEST_CHECK(status == VL53L8CX_STATUS_OK);
+				TEST_CHECK(stats.rereads == torn);
+				TEST_CHECK(stats.rereads_recovered == 1U);
+				TEST_CHECK(stats.rereads_exhausted == 0U);
+				TEST_CHECK(stats.frames_received
+						== (torn + 1U));
+				TEST_CHECK(dev.partial_read_count
+						== ((output_mask != 0U)
+						? (uint8_t)(count + 1U) : 0U));
+				TEST_CHECK(memcmp(results.distance_mm,
+						clean.distance_mm,
+						16U * TEST_N * sizeof(int16_t))
+						== 0);
+				TEST_CHECK(memcmp(results.target_status,
+						clean.target_status,
+						16U * TEST_N) == 0);
+			}
+			else
+			{
+				TEST_CHECK(status
+					== VL53L8CX_STATUS_CORRUPTED_FRAME);
+				TEST_CHECK(stats.rereads == max_rereads);
+				TEST_CHECK(stats.rereads_recovered == 0U);
+				TEST_CHECK(stats.rereads_exhausted
+						== ((max_rereads != 0U) ? 1U
+						: 0U));
+				TEST_CHECK(stats.frames_received
+						== (max_rereads + 1U));
+			}
+
+			/* A re-read costs the transactions of a frame */
+			if (torn == 0U)
+			{
+				frame_transactions = transactions;
+			}
+			TEST_CHECK(transactions == (frame_transactions
+					* stats.frames_received));
+		}
+	}
+	TEST_CHECK(vl53l8cx_stop_ranging(&dev) == VL53L8CX_STATUS_OK);
+}
+
+int main(void)
+{
+	/* Full frames, then partial frames */
+	_test_rereads(0);
+	_test_rereads(VL53L8CX_OUTPUT_DISTANCE_MM
+			| VL53L8CX_OUTPUT_TARGET_STATUS);
+
+	(void)printf("test_reread: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
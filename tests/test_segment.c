@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_segment.h"
+#include "vl53l8cx_pointcloud.h"
+#include "test_common.h"
+
+#define TEST_NB_FRAMES		20000U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x2545F491U;
+
+/*
+ * Random frame: each zone is on one of a few surfaces with some noise, or at
+ * a random distance, and about 10% of the zones are invalid. Steps between
+ * surfaces are around the link threshold.
+ */
+static void _test_random_frame(
+		VL53L8CX_ResultsData		*p_results)
+{
+	int32_t surfaces[4];
+	uint32_t i, zone, idx, pick;
+
+	for (i = 0; i < 4U; i++)
+	{
+		surfaces[i] = 200 + (int32_t)(test_random(&seed) % 3000U);
+	}
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		idx = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		pick = test_random(&seed) % 6U;
+		p_results->distance_mm[idx] = (int16_t)((pick < 4U)
+			? surfaces[pick]
+				+ (int32_t)(test_random(&seed) % 121U) - 60
+			: (int32_t)(test_random(&seed) % 4000U));
+		p_results->target_status[idx] =
+			((test_random(&seed) % 10U) == 0U) ? 255U : 5U;
+		p_results->nb_target_detected[zone] = 1;
+	}
+	(void)vl53l8cx_update_validity(p_results, VL53L8CX_RESOLUTION_8X8);
+}
+
+/* Same link rule as the segmentation, in integers */
+static uint8_t _test_linked(
+		const VL53L8CX_SegmentConfig	*p_config,
+		int32_t				a,
+		int32_t				b)
+{
+	int32_t diff = (a > b) ? a - b : b - a;
+	int32_t near = (a < b) ? a : b;
+
+	return (uint8_t)((diff * 100) <= (((int32_t)p_config->max_step_mm
+		* 100) + (near * (int32_t)p_config->max_step_percent)));
+}
+
+/*
+ * Breadth first search from each zone left, in zone order, then a stable
+ * sort of the obstacles by nearest distance.
+ */
+static void _test_reference(
+		const VL53L8CX_SegmentConfig	*p_config,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		VL53L8CX_Obstacle		*p_obstacles,
+		uint8_t				*p_nb_obstacles)
+{
+	static const int32_t steps[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+	uint32_t width = (nb_zones == VL53L8CX_RESOLUTION_4X4) ? 4U : 8U;
+	int32_t dist[VL53L8CX_RESOLUTION_8X8];
+	uint8_t valid[VL53L8CX_RESOLUTION_8X8], seen[VL53L8CX_RESOLUTION_8X8];
+	uint32_t queue[VL53L8CX_RESOLUTION_8X8];
+	uint32_t zone, start, head, tail, k, row, col, n, i;
+	int32_t r, c, sum, min, sum_row, sum_col;
+	VL53L8CX_Obstacle obs;
+	uint64_t comp;
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		i = zone * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		dist[zone] = p_results->distance_mm[i];
+		valid[zone] = (uint8_t)(((p_results->target_status[i] == 5U)
+			|| (p_results->target_status[i] == 9U))
+			&& (p_results->nb_target_detected[zone] > 0U));
+		seen[zone] = 0;
+	}
+
+	*p_nb_obstacles = 0;
+	for (start = 0; start < nb_zones; start++)
+	{
+		if (!valid[start] || seen[start])
+		{
+			continue;
+		}
+		head = 0;
+		tail = 0;
+		queue[tail++] = start;
+		seen[start] = 1;
+		while (head < tail)
+		{
+			zone = queue[head++];
+			row = zone / width;
+			col = zone % width;
+			for (k = 0; k < 4U; k++)
+			{
+				r = (int32_t)row + steps[k][0];
+				c = (int32_t)col + steps[k][1];
+				if ((r < 0) || (c < 0) || (r >= (int32_t)width)
+					|| (c >= (int32_t)width))
+				{
+					continue;
+				}
+				i = ((uint32_t)r * width) + (uint32_t)c;
+				if (valid[i] && !seen[i] && _test_linked(
+					p_config, dist[zone], dist[i]))
+				{
+					seen[i] = 1;
+					queue[tail++] = i;
+				}
+			}
+		}
+		if (tail < p_config->min_zones)
+		{
+			continue;
+		}
+
+		comp = 0;
+		sum = 0;
+		min = INT16_MAX;
+		sum_row = 0;
+		sum_col = 0;
+		(void)memset(&obs, 0, sizeof(obs));
+		obs.min_row = UINT8_MAX;
+		obs.min_col = UINT8_MAX;
+		for (k = 0; k < tail; k++)
+		{
+			zone = queue[k];
+			row = zone / width;
+			col = zone % width;
+			comp |= 1ULL << zone;
+			sum += dist[zone];
+			min = (dist[zone] < min) ? dist[zone] : min;
+			sum_row += (int32_t)row;
+			sum_col += (int32_t)col;
+			obs.min_row = (row < obs.min_row) ? (uint8_t)row
+				: obs.min_row;
+			obs.max_row = (row > obs.max_row) ? (uint8_t)row
+				: obs.max_row;
+			obs.min_col = (col < obs.min_col) ? (uint8_t)col
+				: obs.min_col;
+			obs.max_col = (col > obs.max_col) ? (uint8_t)col
+				: obs.max_col;
+		}
+		n = tail;
+		obs.zones = comp;
+		obs.nb_zones = (uint8_t)n;
+		obs.min_distance_mm = (int16_t)min;
+		obs.mean_distance_mm = (int16_t)lround((double)sum
+			/ (double)n);
+		obs.azimuth_deg = (float)(((((double)sum_col / (double)n)
+			+ 0.5) / (double)width - 0.5)
+			* VL53L8CX_POINTCLOUD_FOV_DEG);
+		obs.elevation_deg = (float)((0.5 - (((double)sum_row
+			/ (double)n) + 0.5) / (double)width)
+			* VL53L8CX_POINTCLOUD_FOV_DEG);
+
+		for (i = *p_nb_obstacles; (i > 0U)
+			&& (p_obstacles[i - 1U].min_distance_mm
+				> obs.min_distance_mm); i--)
+		{
+			p_obstacles[i] = p_obstacles[i - 1U];
+		}
+		p_obstacles[i] = obs;
+		(*p_nb_obstacles)++;
+	}
+}
+
+/* The segmentation against the reference, with random settings */
+static void _test_random_frames(void)
+{
+	static VL53L8CX_Segment seg;
+	static VL53L8CX_ResultsData results;
+	static VL53L8CX_Obstacle ref[VL53L8CX_SEGMENT_MAX_OBSTACLES];
+	VL53L8CX_SegmentConfig config;
+	const VL53L8CX_Obstacle *p_obs;
+	uint32_t n, i, zone, nb_mismatches = 0, nb_obstacles = 0;
+	uint8_t nb_zones, nb_ref, label;
+
+	for (n = 0; n < TEST_NB_FRAMES; n++)
+	{
+		nb_zones = ((n % 2U) == 0U) ? VL53L8CX_RESOLUTION_4X4
+			: VL53L8CX_RESOLUTION_8X8;
+		config.max_step_mm = (uint16_t)(test_random(&seed) % 200U);
+		config.max_step_percent = (uint8_t)(test_random(&seed) % 20U);
+		config.min_zones = (uint8_t)(1U + (test_random(&seed) % 3U));
+		vl53l8cx_segment_init(&seg, &config);
+		_test_random_frame(&results);
+
+		_test_reference(&config, &results, nb_zones, ref, &nb_ref);
+		TEST_CHECK(vl53l8cx_segment_update(&seg, &results, nb_zones)
+				== VL53L8CX_STATUS_OK);
+		nb_obstacles += nb_ref;
+		if (seg.nb_obstacles != nb_ref)
+		{
+			nb_mismatches++;
+			continue;
+		}
+		for (i = 0; i < nb_ref; i++)
+		{
+			p_obs = &seg.obstacles[i];
+			if ((p_obs->zones != ref[i].zones)
+				|| (p_obs->nb_zones != ref[i].nb_zones)
+				|| (p_obs->min_row != ref[i].min_row)
+				|| (p_obs->max_row != ref[i].max_row)
+				|| (p_obs->min_col != ref[i].min_col)
+				|| (p_obs->max_col != ref[i].max_col)
+				|| (p_obs->min_distance_mm
+					!= ref[i].min_distance_mm)
+				|| (abs(p_obs->mean_distance_mm
+					- ref[i].mean_distance_mm) > 1)
+				|| (fabsf(p_obs->azimuth_deg
+					- ref[i].azimuth_deg) > 1e-3f)
+				|| (fabsf(p_obs->elevation_deg
+					- ref[i].elevation_deg) > 1e-3f))
+			{
+				nb_mismatches++;
+			}
+		}
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			label = VL53L8CX_SEGMENT_NO_LABEL;
+			for (i = 0; i < nb_ref; i++)
+			{
+				if ((ref[i].zones >> zone) & 1U)
+				{
+					label = (uint8_t)i;
+				}
+			}
+			if (seg.label[zone] != label)
+			{
+				nb_mismatches++;
+			}
+		}
+	}
+	(void)printf("%u frames, %u obstacles\n", TEST_NB_FRAMES,
+			nb_obstacles);
+	TEST_CHECK(nb_mismatches == 0U);
+}
+
+int main(void)
+{
+	_test_random_frames();
+
+	(void)printf("test_segment: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
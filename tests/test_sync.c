@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vl53l8cx_sync.h"
+#include "vl53l8cx_capture.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_NB_SENSORS		2U
+#define TEST_MS_NS		1000000ULL
+
+static uint32_t nb_failures;
+
+static VL53L8CX_Configuration devs[TEST_NB_SENSORS];
+static VL53L8CX_Sync sync_ctrl;
+static VL53L8CX_SuperFrame superframe;
+static VL53L8CX_ResultsData results;
+static uint32_t nb_pulses;
+
+static void _test_pulse(
+		void				*p_user)
+{
+	(void)p_user;
+	nb_pulses++;
+}
+
+/* Controller over the emulated sensors, with a pulse period in us */
+static uint8_t _test_configure(
+		uint32_t			period_us)
+{
+	uint8_t i, id;
+
+	TEST_CHECK(vl53l8cx_sync_init(&sync_ctrl, _test_pulse, NULL, period_us)
+			== VL53L8CX_STATUS_OK);
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		TEST_CHECK(vl53l8cx_sync_add_sensor(&sync_ctrl, &devs[i], &id)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(id == i);
+	}
+
+	return vl53l8cx_sync_configure(&sync_ctrl);
+}
+
+/*
+ * The pulse period must leave VL53L8CX_SYNC_MIN_DELAY_US after the ranging
+ * period, which is also the delay allowed to a late pulse.
+ */
+static void _test_periods(void)
+{
+	uint8_t i, mode = 0, is_sync = 0;
+
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		TEST_CHECK(vl53l8cx_set_ranging_frequency_hz(&devs[i],
+				(uint8_t)(10U + (5U * i)))
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(vl53l8cx_set_integration_time_ms(&devs[i], 20)
+				== VL53L8CX_STATUS_OK);
+	}
+
+	/* The slowest sensor is at 10 Hz */
+	TEST_CHECK(_test_configure(1000000U / 15U)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(_test_configure(100000U) == VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(_test_configure(100000U + VL53L8CX_SYNC_MIN_DELAY_US - 1U)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(_test_configure(100000U + VL53L8CX_SYNC_MIN_DELAY_US)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(sync_ctrl.max_delay_ns
+			== ((uint64_t)VL53L8CX_SYNC_MIN_DELAY_US * 1000U));
+	TEST_CHECK(_test_configure(250000U) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(sync_ctrl.max_delay_ns == (150000U * 1000U));
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		TEST_CHECK(sync_ctrl.min_latency_ns[i] == (20U * TEST_MS_NS));
+		TEST_CHECK(vl53l8cx_get_ranging_mode(&devs[i], &mode)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(mode == VL53L8CX_RANGING_MODE_AUTONOMOUS);
+		TEST_CHECK(vl53l8cx_get_external_sync_pin_enable(&devs[i],
+				&is_sync) == VL53L8CX_STATUS_OK);
+		TEST_CHECK(is_sync == 1U);
+	}
+
+	/* Integration time as long as the period */
+	TEST_CHECK(vl53l8cx_set_integration_time_ms(&devs[0], 250)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(_test_configure(250000U) == VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_set_integration_time_ms(&devs[0], 20)
+			== VL53L8CX_STATUS_OK);
+}
+
+/*
+ * Pulses at the shortest period allowed for sensors at 15 Hz: the thread
+ * wakes up within the delay allowed, so pulses are sent rather than skipped.
+ */
+static void _test_pulses(void)
+{
+	VL53L8CX_SyncStats stats;
+	uint32_t period_us = (1000000U / 15U) + VL53L8CX_SYNC_MIN_DELAY_US;
+	uint8_t i;
+
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		TEST_CHECK(vl53l8cx_set_ranging_frequency_hz(&devs[i], 15)
+				== VL53L8CX_STATUS_OK);
+	}
+	TEST_CHECK(_test_configure(period_us) == VL53L8CX_STATUS_OK);
+	nb_pulses = 0;
+	TEST_CHECK(vl53l8cx_sync_start(&sync_ctrl) == VL53L8CX_STATUS_OK);
+	(void)usleep(10U * period_us);
+	TEST_CHECK(vl53l8cx_sync_stop(&sync_ctrl) == VL53L8CX_STATUS_OK);
+
+	vl53l8cx_sync_get_stats(&sync_ctrl, &stats);
+	(void)printf("%u pulses sent, %u skipped\n", stats.triggers,
+			stats.pulses_skipped);
+	TEST_CHECK(stats.triggers == nb_pulses);
+	TEST_CHECK(stats.triggers >= 5U);
+	TEST_CHECK(stats.triggers > stats.pulses_skipped);
+	TEST_CHECK((stats.triggers + stats.pulses_skipped) <= 13U);
+}
+
+/*
+ * Frames matched to the latest pulse one integration time before them: a
+ * super-frame is published once complete, frames of a published pulse are
+ * late, frames before any pulse are unmatched, and stop publishes the partial
+ * super-frames.
+ */
+static void _test_matching(void)
+{
+	VL53L8CX_SyncStats stats;
+	const uint64_t t0_ns = 1000U * TEST_MS_NS;
+	const uint64_t period_ns = 100U * TEST_MS_NS;
+	uint32_t epoch;
+
+	/* Pulses 0 to 2, sent by hand */
+	TEST_CHECK(_test_configure(250000U) == VL53L8CX_STATUS_OK);
+	for (epoch = 0; epoch < 3U; epoch++)
+	{
+		sync_ctrl.t_triggers_ns[epoch] = t0_ns + (epoch * period_ns);
+	}
+	sync_ctrl.nb_epochs = 3;
+
+	/* Within the integration time of pulse 0: no pulse before */
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 0, t0_ns + (10U * TEST_MS_NS),
+			VL53L8CX_STATUS_OK, &results) == VL53L8CX_STATUS_OK);
+	/* Pulse 1 gets both frames, after the frame of sensor 1 for pulse 0 */
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 1, t0_ns + (30U * TEST_MS_NS),
+			VL53L8CX_STATUS_OK, &results) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 0, t0_ns + period_ns
+			+ (25U * TEST_MS_NS), VL53L8CX_STATUS_OK, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 1, t0_ns + period_ns
+			+ (35U * TEST_MS_NS), VL53L8CX_STATUS_ERROR, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 2, t0_ns + period_ns,
+			VL53L8CX_STATUS_OK, &results)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+
+	/* Pulse 0 is published as partial before pulse 1 */
+	TEST_CHECK(vl53l8cx_sync_pop(&sync_ctrl, &superframe, 0) == 1U);
+	TEST_CHECK(superframe.epoch == 0U);
+	TEST_CHECK(superframe.t_trigger_ns == t0_ns);
+	TEST_CHECK(superframe.sensor_mask == 2U);
+	TEST_CHECK(vl53l8cx_sync_pop(&sync_ctrl, &superframe, 0) == 1U);
+	TEST_CHECK(superframe.epoch == 1U);
+	TEST_CHECK(superframe.sensor_mask == 3U);
+	TEST_CHECK(superframe.status[1] == VL53L8CX_STATUS_ERROR);
+	TEST_CHECK(vl53l8cx_sync_pop(&sync_ctrl, &superframe, 0) == 0U);
+
+	/* A frame for pulse 1 comes too late, pulse 2 stays partial */
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 0, t0_ns + period_ns
+			+ (90U * TEST_MS_NS), VL53L8CX_STATUS_OK, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_push(&sync_ctrl, 1, t0_ns + (2U * period_ns)
+			+ (20U * TEST_MS_NS), VL53L8CX_STATUS_OK, &results)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_stop(&sync_ctrl) == VL53L8CX_STATUS_OK);
+	TEST_CHECK(vl53l8cx_sync_pop(&sync_ctrl, &superframe, 0) == 1U);
+	TEST_CHECK((superframe.epoch == 2U) && (superframe.sensor_mask == 2U));
+
+	vl53l8cx_sync_get_stats(&sync_ctrl, &stats);
+	TEST_CHECK(stats.frames_unmatched == 1U);
+	TEST_CHECK(stats.frames_late == 1U);
+	TEST_CHECK(stats.superframes_complete == 1U);
+	TEST_CHECK(stats.superframes_partial == 2U);
+}
+
+int main(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < TEST_NB_SENSORS; i++)
+	{
+		(void)memset(&devs[i], 0, sizeof(devs[i]));
+		emu_platform_reset(i);
+		devs[i].platform.spi_channel = i;
+		TEST_CHECK(vl53l8cx_init(&devs[i]) == VL53L8CX_STATUS_OK);
+	}
+
+	_test_periods();
+	_test_pulses();
+	_test_matching();
+
+	(void)printf("test_sync: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "vl53l8cx_targets.h"
+#include "test_common.h"
+
+#define TEST_N			VL53L8CX_NB_TARGET_PER_ZONE
+#define TEST_NB_FRAMES		3000U
+#define TEST_GLASS_MM		600
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x9E3779B9U;
+
+static int32_t _test_noise(void)
+{
+	return (int32_t)(test_random(&seed) % 31U) - 15;
+}
+
+/*
+ * Closest first greedy association, one zone and one pair at a time: the
+ * pair of a tracked slot and a valid target with the lowest difference within
+ * the gate is assigned, until none is left. Targets left start in the first
+ * free slots.
+ */
+static void _test_reference(
+		VL53L8CX_Targets		*p_tgt,
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones)
+{
+	float z[TEST_N], taken[TEST_N], e, age, best, cost;
+	uint8_t target_free[TEST_N], slot_free[TEST_N];
+	uint8_t matched[TEST_N], started[TEST_N], is_tracked;
+	uint32_t zone, s, m, idx, best_s, best_m;
+
+	for (zone = 0; zone < nb_zones; zone++)
+	{
+		for (m = 0; m < TEST_N; m++)
+		{
+			idx = (zone * TEST_N) + m;
+			z[m] = (float)p_results->distance_mm[idx];
+			target_free[m] = (uint8_t)(((p_results->target_status[idx]
+				== 5U) || (p_results->target_status[idx] == 9U))
+				&& (m < p_results->nb_target_detected[zone]));
+		}
+		for (s = 0; s < TEST_N; s++)
+		{
+			slot_free[s] = (uint8_t)(p_tgt->is_tracked[s][zone]
+				> 0.5f);
+			matched[s] = 0;
+			started[s] = 0;
+			taken[s] = 0.0f;
+		}
+
+		for (;;)
+		{
+			best = p_tgt->config.gate_mm;
+			best_s = TEST_N;
+			best_m = TEST_N;
+			for (s = 0; s < TEST_N; s++)
+			{
+				for (m = 0; m < TEST_N; m++)
+				{
+					cost = fabsf(z[m]
+						- p_tgt->estimate_mm[s][zone]);
+					if (slot_free[s] && target_free[m]
+						&& (cost < best))
+					{
+						best = cost;
+						best_s = s;
+						best_m = m;
+					}
+				}
+			}
+			if (best_s == TEST_N)
+			{
+				break;
+			}
+			slot_free[best_s] = 0;
+			target_free[best_m] = 0;
+			matched[best_s] = 1;
+			taken[best_s] = z[best_m];
+		}
+
+		for (s = 0; s < TEST_N; s++)
+		{
+			if (p_tgt->is_tracked[s][zone] > 0.5f)
+			{
+				continue;
+			}
+			for (m = 0; m < TEST_N; m++)
+			{
+				if (target_free[m])
+				{
+					target_free[m] = 0;
+					started[s] = 1;
+					taken[s] = z[m];
+					break;
+				}
+			}
+		}
+
+		for (s = 0; s < TEST_N; s++)
+		{
+			e = p_tgt->estimate_mm[s][zone];
+			if (matched[s])
+			{
+				e += p_tgt->config.alpha * (taken[s] - e);
+			}
+			if (started[s])
+			{
+				e = taken[s];
+			}
+			age = (matched[s] || started[s]) ? 0.0f
+				: p_tgt->age[s][zone] + 1.0f;
+			is_tracked = (uint8_t)(((p_tgt->is_tracked[s][zone]
+				> 0.5f) || started[s])
+				&& (age <= (float)p_tgt->config.hold_frames));
+			p_tgt->estimate_mm[s][zone] = e;
+			p_tgt->age[s][zone] = age;
+			p_tgt->is_tracked[s][zone] = is_tracked ? 1.0f : 0.0f;
+		}
+	}
+}
+
+/*
+ * A glass pane in front of a wall moving back and forth, and a far target in
+ * half of the zones. The order of the targets is shuffled in each frame, and
+ * a target drops out of 2% of the zones.
+ */
+static void _test_random_frame(
+		VL53L8CX_ResultsData		*p_results,
+		uint32_t			frame)
+{
+	int32_t d[4], wall, x;
+	uint32_t zone, k, j, nt;
+
+	wall = 1500 + (int32_t)((((frame / 500U) % 2U) != 0U)
+		? (frame % 500U) * 300U / 500U
+		: (500U - (frame % 500U)) * 300U / 500U);
+	for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+	{
+		nt = 0;
+		if ((zone % 3U) != 0U)
+		{
+			d[nt++] = TEST_GLASS_MM + _test_noise();
+		}
+		d[nt++] = wall + _test_noise();
+		if ((TEST_N > 2U) && (zone < 32U))
+		{
+			d[nt++] = 3000 + _test_noise();
+		}
+		nt = (nt > TEST_N) ? TEST_N : nt;
+		for (k = nt - 1U; k > 0U; k--)
+		{
+			j = test_random(&seed) % (k + 1U);
+			x = d[k];
+			d[k] = d[j];
+			d[j] = x;
+		}
+		if (((test_random(&seed) % 50U) == 0U) && (nt > 1U))
+		{
+			nt--;
+		}
+
+		p_results->nb_target_detected[zone] = (uint8_t)nt;
+		for (k = 0; k < TEST_N; k++)
+		{
+			p_results->distance_mm[(zone * TEST_N) + k] =
+				(int16_t)((k < nt) ? d[k] : 0);
+			p_results->target_status[(zone * TEST_N) + k] =
+				(k < nt) ? 5U : 255U;
+		}
+	}
+}
+
+/*
+ * The association against the reference. With several targets per zone, the
+ * glass pane must also stay in its slot in every zone.
+ */
+static void _test_random_frames(void)
+{
+	static VL53L8CX_Targets tgt, ref;
+	static VL53L8CX_ResultsData results;
+	int32_t glass_slot[VL53L8CX_RESOLUTION_8X8], slot;
+	uint32_t frame, zone, s, nb_mismatches = 0, nb_slot_changes = 0;
+	uint8_t nb_zones;
+
+	vl53l8cx_targets_init(&tgt, NULL);
+	vl53l8cx_targets_init(&ref, NULL);
+
+	for (frame = 0; frame < TEST_NB_FRAMES; frame++)
+	{
+		/* A few 4x4 frames, which reset both */
+		nb_zones = ((frame / 1000U) == 1U) ? VL53L8CX_RESOLUTION_4X4
+			: VL53L8CX_RESOLUTION_8X8;
+		_test_random_frame(&results, frame);
+		if (nb_zones != ref.nb_zones)
+		{
+			vl53l8cx_targets_reset(&ref);
+			ref.nb_zones = nb_zones;
+			for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+			{
+				glass_slot[zone] = -1;
+			}
+		}
+		_test_reference(&ref, &results, nb_zones);
+		TEST_CHECK(vl53l8cx_targets_update(&tgt, &results, nb_zones)
+				== VL53L8CX_STATUS_OK);
+
+		for (s = 0; s < TEST_N; s++)
+		{
+			for (zone = 0; zone < nb_zones; zone++)
+			{
+				if ((fabsf(tgt.estimate_mm[s][zone]
+					- ref.estimate_mm[s][zone]) > 1e-3f)
+					|| (tgt.is_tracked[s][zone]
+						!= ref.is_tracked[s][zone])
+					|| (tgt.age[s][zone]
+						!= ref.age[s][zone]))
+				{
+					nb_mismatches++;
+				}
+			}
+		}
+
+		if ((TEST_N < 2U) || (nb_zones != VL53L8CX_RESOLUTION_8X8))
+		{
+			continue;
+		}
+		for (zone = 0; zone < nb_zones; zone++)
+		{
+			if ((zone % 3U) == 0U)
+			{
+				continue;
+			}
+			slot = -1;
+			for (s = 0; s < TEST_N; s++)
+			{
+				if (((tgt.tracked_mask[s] >> zone) & 1U)
+					&& (abs(tgt.distance_mm[(zone * TEST_N)
+					+ s] - TEST_GLASS_MM) < 100))
+				{
+					slot = (int32_t)s;
+				}
+			}
+			if (glass_slot[zone] < 0)
+			{
+				glass_slot[zone] = slot;
+			}
+			else if (slot != glass_slot[zone])
+			{
+				nb_slot_changes++;
+			}
+		}
+	}
+	(void)printf("%u targets per zone: %u mismatches, %u glass slot "
+			"changes\n", (uint32_t)TEST_N, nb_mismatches,
+			nb_slot_changes);
+	TEST_CHECK(nb_mismatches == 0U);
+	TEST_CHECK(nb_slot_changes == 0U);
+}
+
+/*
+ * Targets within a few gates of each other, so slots compete for them and
+ * the closest first order matters. Only the reference is checked.
+ */
+static void _test_crowded_frames(void)
+{
+	static VL53L8CX_Targets tgt, ref;
+	static VL53L8CX_ResultsData results;
+	uint32_t frame, zone, s, k, idx, nt, nb_mismatches = 0;
+
+	vl53l8cx_targets_init(&tgt, NULL);
+	vl53l8cx_targets_init(&ref, NULL);
+	ref.nb_zones = VL53L8CX_RESOLUTION_8X8;
+
+	for (frame = 0; frame < TEST_NB_FRAMES; frame++)
+	{
+		for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+		{
+			nt = test_random(&seed) % (TEST_N + 1U);
+			results.nb_target_detected[zone] = (uint8_t)nt;
+			for (k = 0; k < TEST_N; k++)
+			{
+				idx = (zone * TEST_N) + k;
+				results.distance_mm[idx] = (int16_t)(1000
+					+ (test_random(&seed) % 400U));
+				results.target_status[idx] = ((k < nt)
+					&& ((test_random(&seed) % 10U) != 0U))
+					? 5U : 255U;
+			}
+		}
+		_test_reference(&ref, &results, VL53L8CX_RESOLUTION_8X8);
+		TEST_CHECK(vl53l8cx_targets_update(&tgt, &results,
+				VL53L8CX_RESOLUTION_8X8) == VL53L8CX_STATUS_OK);
+
+		for (s = 0; s < TEST_N; s++)
+		{
+			for (zone = 0; zone < VL53L8CX_RESOLUTION_8X8; zone++)
+			{
+				if ((fabsf(tgt.estimate_mm[s][zone]
+					- ref.estimate_mm[s][zone]) > 1e-3f)
+					|| (tgt.is_tracked[s][zone]
+						!= ref.is_tracked[s][zone])
+					|| (tgt.age[s][zone]
+						!= ref.age[s][zone]))
+				{
+					nb_mismatches++;
+				}
+			}
+		}
+	}
+	(void)printf("%u targets per zone, crowded: %u mismatches\n",
+			(uint32_t)TEST_N, nb_mismatches);
+	TEST_CHECK(nb_mismatches == 0U);
+}
+
+int main(void)
+{
+	_test_random_frames();
+	_test_crowded_frames();
+
+	(void)printf("test_targets: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
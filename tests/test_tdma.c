@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vl53l8cx_tdma.h"
+#include "vl53l8cx_capture.h"
+#include "emu_platform.h"
+#include "test_common.h"
+
+#define TEST_GUARD_US		1000U
+#define TEST_NB_TRIGGERS	256U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x165667B1U;
+
+static VL53L8CX_Tdma tdma;
+
+/* Sync edges sent by the scheduler thread */
+static uint64_t trigger_ns[TEST_NB_TRIGGERS];
+static uint8_t trigger_id[TEST_NB_TRIGGERS];
+static uint32_t nb_triggers;
+static uint32_t late_us;
+
+/*
+ * Sensors which overlap are never in the same slot, each slot lasts its
+ * longest emission and the guard time, and the cycle is extended to the
+ * maximum frequency of the sensors.
+ */
+static void _test_check_plan(void)
+{
+	uint32_t cycle_us = 0, slot_us = 0, min_cycle_us = 0;
+	uint8_t i, slot, members = 0;
+
+	TEST_CHECK((tdma.nb_slots >= 1U) && (tdma.nb_slots <= tdma.nb_sensors));
+	for (slot = 0; slot < tdma.nb_slots; slot++)
+	{
+		TEST_CHECK(tdma.slot_members[slot] != 0U);
+		TEST_CHECK((members & tdma.slot_members[slot]) == 0U);
+		members |= tdma.slot_members[slot];
+		slot_us = 0;
+		for (i = 0; i < tdma.nb_sensors; i++)
+		{
+			if ((tdma.slot_members[slot] & (1U << i)) == 0U)
+			{
+				continue;
+			}
+			TEST_CHECK(tdma.slot_of[i] == slot);
+			TEST_CHECK((tdma.overlap[i] & tdma.slot_members[slot])
+					== 0U);
+			if ((tdma.emission_us[i] + tdma.guard_us) > slot_us)
+			{
+				slot_us = tdma.emission_us[i] + tdma.guard_us;
+			}
+		}
+		if (slot < (tdma.nb_slots - 1U))
+		{
+			TEST_CHECK(tdma.slot_us[slot] == slot_us);
+		}
+		else
+		{
+			TEST_CHECK(tdma.slot_us[slot] >= slot_us);
+		}
+		cycle_us += tdma.slot_us[slot];
+	}
+	TEST_CHECK(members == (uint8_t)((1U << tdma.nb_sensors) - 1U));
+
+	for (i = 0; i < tdma.nb_sensors; i++)
+	{
+		if (tdma.min_period_us[i] > min_cycle_us)
+		{
+			min_cycle_us = tdma.min_period_us[i];
+		}
+	}
+	TEST_CHECK(tdma.cycle_us == cycle_us);
+	TEST_CHECK(tdma.cycle_us >= min_cycle_us);
+	/* Padded only up to the period of the fastest allowed cycle */
+	if (tdma.slot_us[tdma.nb_slots - 1U] != slot_us)
+	{
+		TEST_CHECK(tdma.cycle_us == min_cycle_us);
+	}
+}
+
+/* Plans of fixed and random overlaps, without sensor ranging */
+static void _test_plans(void)
+{
+	static VL53L8CX_Configuration devs[VL53L8CX_TDMA_MAX_SENSORS];
+	uint32_t round;
+	uint8_t i, j, id;
+
+	/* 4 sensors without overlap at 60 Hz: one slot, padded */
+	vl53l8cx_tdma_init(&tdma, NULL, NULL, TEST_GUARD_US);
+	for (i = 0; i < 4U; i++)
+	{
+		TEST_CHECK(vl53l8cx_tdma_add_sensor(&tdma, &devs[i], &id)
+				== VL53L8CX_STATUS_OK);
+		TEST_CHECK(id == i);
+		tdma.emission_us[i] = 5000U;
+		tdma.min_period_us[i] = 1000000U / 60U;
+	}
+	TEST_CHECK(vl53l8cx_tdma_set_overlap(&tdma, 1, 1)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_tdma_set_overlap(&tdma, 0, 4)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	vl53l8cx_tdma_plan(&tdma);
+	_test_check_plan();
+	TEST_CHECK(tdma.nb_slots == 1U);
+	TEST_CHECK(tdma.cycle_us == (1000000U / 60U));
+
+	/* All overlapping: one slot each, longer than the period */
+	for (i = 0; i < 4U; i++)
+	{
+		for (j = (uint8_t)(i + 1U); j < 4U; j++)
+		{
+			TEST_CHECK(vl53l8cx_tdma_set_overlap(&tdma, i, j)
+					== VL53L8CX_STATUS_OK);
+		}
+	}
+	vl53l8cx_tdma_plan(&tdma);
+	_test_check_plan();
+	TEST_CHECK(tdma.nb_slots == 4U);
+	TEST_CHECK(tdma.cycle_us == (4U * (5000U + TEST_GUARD_US)));
+
+	/* A ring of 5 sensors needs 3 slots */
+	vl53l8cx_tdma_init(&tdma, NULL, NULL, TEST_GUARD_US);
+	for (i = 0; i < 5U; i++)
+	{
+		(void)vl53l8cx_tdma_add_sensor(&tdma, &devs[i], &id);
+		tdma.emission_us[i] = 10000U + (i * 1000U);
+	}
+	for (i = 0; i < 5U; i++)
+	{
+		(void)vl53l8cx_tdma_set_overlap(&tdma, i,
+				(uint8_t)((i + 1U) % 5U));
+	}
+	vl53l8cx_tdma_plan(&tdma);
+	_test_check_plan();
+	TEST_CHECK(tdma.nb_slots == 3U);
+
+	for (round = 0; round < 1000U; round++)
+	{
+		vl53l8cx_tdma_init(&tdma, NULL, NULL,
+				1U + (test_random(&seed) % 2000U));
+		for (i = 0; i < VL53L8CX_TDMA_MAX_SENSORS; i++)
+		{
+			TEST_CHECK(vl53l8cx_tdma_add_sensor(&tdma, &devs[i],
+					&id) == VL53L8CX_STATUS_OK);
+			tdma.emission_us[i] = 1000U
+				+ (test_random(&seed) % 60000U);
+			tdma.min_period_us[i] = ((test_random(&seed) % 2U)
+				!= 0U) ? (1000000U / 15U) : (1000000U / 60U);
+		}
+		TEST_CHECK(vl53l8cx_tdma_add_sensor(&tdma, &devs[0], &id)
+				== VL53L8CX_STATUS_INVALID_PARAM);
+		for (i = 0; i < VL53L8CX_TDMA_MAX_SENSORS; i++)
+		{
+			for (j = (uint8_t)(i + 1U);
+					j < VL53L8CX_TDMA_MAX_SENSORS; j++)
+			{
+				if ((test_random(&seed) % 3U) == 0U)
+				{
+					(void)vl53l8cx_tdma_set_overlap(&tdma,
+							i, j);
+				}
+			}
+		}
+		vl53l8cx_tdma_plan(&tdma);
+		_test_check_plan();
+	}
+}
+
+/* Sync edge recorder, which sometimes blocks the thread past a slot */
+static void _test_trigger(
+		void				*p_user,
+		uint8_t				sensor_id)
+{
+	(void)p_user;
+	if (nb_triggers < TEST_NB_TRIGGERS)
+	{
+		trigger_ns[nb_triggers] = vl53l8cx_capture_now_ns();
+		trigger_id[nb_triggers] = sensor_id;
+		nb_triggers++;
+	}
+	if ((nb_triggers % 8U) == 4U)
+	{
+		(void)usleep(late_us);
+	}
+}
+
+/*
+ * Emulated sensors, all overlapping: after a late wakeup the slots already
+ * started are skipped, so each sync edge comes after the emission of the
+ * previous one.
+ */
+static void _test_late_slots(void)
+{
+	static VL53L8CX_Configuration devs[3];
+	VL53L8CX_TdmaReport report;
+	uint64_t gap_ns;
+	uint32_t i, nb_late = 0;
+	uint8_t id;
+
+	vl53l8cx_tdma_init(&tdma, _test_trigger, NULL, TEST_GUARD_US);
+	for (i = 0; i < 3U; i++)
+	{
+		(void)memset(&devs[i], 0, sizeof(devs[i]));
+		emu_platform_reset((uint8_t)i);
+		devs[i].platform.spi_channel = (uint8_t)i;
+		TEST_CHECK(vl53l8cx_init(&devs[i]) == VL53L8CX_STATUS_OK);
+		TEST_CHECK(vl53l8cx_tdma_add_sensor(&tdma, &devs[i], &id)
+				== VL53L8CX_STATUS_OK);
+	}
+	TEST_CHECK(vl53l8cx_tdma_start(&tdma) == VL53L8CX_STATUS_INVALID_PARAM);
+	(void)vl53l8cx_tdma_set_overlap(&tdma, 0, 1);
+	(void)vl53l8cx_tdma_set_overlap(&tdma, 1, 2);
+	(void)vl53l8cx_tdma_set_overlap(&tdma, 0, 2);
+	TEST_CHECK(vl53l8cx_tdma_configure(&tdma) == VL53L8CX_STATUS_OK);
+	_test_check_plan();
+	TEST_CHECK(tdma.nb_slots == 3U);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(tdma.emission_us[i] != 0U);
+	}
+
+	/* Blocked for more than a slot and its guard time */
+	late_us = tdma.slot_us[0] + (3U * TEST_GUARD_US);
+	nb_triggers = 0;
+	TEST_CHECK(vl53l8cx_tdma_start(&tdma) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(emu_platform_sensors[i].is_ranging == 1U);
+	}
+	(void)usleep(24U * tdma.cycle_us);
+	TEST_CHECK(vl53l8cx_tdma_stop(&tdma) == VL53L8CX_STATUS_OK);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(emu_platform_sensors[i].is_ranging == 0U);
+	}
+
+	for (i = 1; i < nb_triggers; i++)
+	{
+		gap_ns = trigger_ns[i] - trigger_ns[i - 1U];
+		TEST_CHECK(gap_ns >= ((uint64_t)tdma.emission_us[
+				trigger_id[i - 1U]] * 1000U));
+		if (gap_ns > ((uint64_t)(tdma.slot_us[tdma.slot_of[
+				trigger_id[i - 1U]]] + TEST_GUARD_US) * 1000U))
+		{
+			nb_late++;
+		}
+	}
+	vl53l8cx_tdma_get_report(&tdma, &report);
+	(void)printf("%u sync edges, %u after a late wakeup, %u slots "
+			"skipped, cycle of %u us\n", nb_triggers, nb_late,
+			report.skipped_slots, report.cycle_us);
+	TEST_CHECK(nb_late >= ((nb_triggers - 1U) / 8U));
+	TEST_CHECK(report.skipped_slots >= nb_late);
+	TEST_CHECK(report.nb_slots == 3U);
+	for (i = 0; i < 3U; i++)
+	{
+		TEST_CHECK(report.sensors[i].triggered_hz > 0.0f);
+		TEST_CHECK(report.sensors[i].triggered_hz
+				< report.sensors[i].planned_hz * 1.05f);
+	}
+}
+
+int main(void)
+{
+	_test_plans();
+	_test_late_slots();
+
+	(void)printf("test_tdma: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vl53l8cx_tracker.h"
+#include "test_common.h"
+
+/* 15 Hz frames, an obstacle coming closer at 500 mm/s */
+#define TEST_PERIOD_NS		66666667ULL
+#define TEST_T0_NS		1000000000ULL
+#define TEST_SPEED_MM_S		500.0f
+
+static uint32_t nb_failures;
+
+static VL53L8CX_Segment seg;
+
+static void _test_obstacle(
+		uint8_t				index,
+		float				distance_mm,
+		float				azimuth_deg)
+{
+	VL53L8CX_Obstacle *p_obs = &seg.obstacles[index];
+
+	(void)memset(p_obs, 0, sizeof(*p_obs));
+	p_obs->min_distance_mm = (int16_t)lrintf(distance_mm);
+	p_obs->mean_distance_mm = p_obs->min_distance_mm;
+	p_obs->azimuth_deg = azimuth_deg;
+	p_obs->elevation_deg = 0.0f;
+	p_obs->nb_zones = 4;
+	if (seg.nb_obstacles <= index)
+	{
+		seg.nb_obstacles = (uint8_t)(index + 1U);
+	}
+}
+
+static const VL53L8CX_Track *_test_find(
+		const VL53L8CX_Tracker		*p_trk,
+		uint16_t			id)
+{
+	uint8_t i;
+
+	for (i = 0; i < p_trk->nb_tracks; i++)
+	{
+		if (p_trk->tracks[i].id == id)
+		{
+			return &p_trk->tracks[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * An approaching obstacle and a static one: stable ids, confirmation after 3
+ * frames, and the range and rate of a scalar alpha-beta filter.
+ */
+static void _test_approach(void)
+{
+	static VL53L8CX_Tracker trk;
+	const VL53L8CX_Track *p_near, *p_static;
+	float range = 0.0f, rate = 0.0f, dt = (float)TEST_PERIOD_NS * 1e-9f;
+	float distance, residual;
+	uint32_t frame;
+
+	vl53l8cx_tracker_init(&trk, NULL);
+	for (frame = 0; frame < 40U; frame++)
+	{
+		distance = 2000.0f - (TEST_SPEED_MM_S * dt * (float)frame);
+		seg.nb_obstacles = 0;
+		_test_obstacle(0, distance, 5.0f);
+		_test_obstacle(1, 3000.0f, -20.0f);
+		TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, TEST_T0_NS
+				+ ((uint64_t)frame * TEST_PERIOD_NS))
+				== VL53L8CX_STATUS_OK);
+
+		/* Scalar reference of the range */
+		if (frame == 0U)
+		{
+			range = (float)lrintf(distance);
+		}
+		else
+		{
+			range += rate * dt;
+			residual = (float)lrintf(distance) - range;
+			range += VL53L8CX_TRACKER_DEFAULT_ALPHA * residual;
+			rate += (VL53L8CX_TRACKER_DEFAULT_BETA / dt) * residual;
+		}
+
+		TEST_CHECK(trk.nb_tracks == 2U);
+		p_near = _test_find(&trk, 1);
+		p_static = _test_find(&trk, 2);
+		TEST_CHECK((p_near != NULL) && (p_static != NULL));
+		if ((p_near == NULL) || (p_static == NULL))
+		{
+			return;
+		}
+		TEST_CHECK(p_near->obstacle == 0U);
+		TEST_CHECK(p_near->hits == (frame + 1U));
+		TEST_CHECK(p_near->is_confirmed == (uint8_t)(frame >= 2U));
+		TEST_CHECK(fabsf(p_near->range_mm - range) < 0.01f);
+		TEST_CHECK(fabsf(p_near->range_rate_mm_s - rate) < 0.1f);
+		TEST_CHECK(fabsf(p_static->range_rate_mm_s) < 0.01f);
+		TEST_CHECK(p_static->time_to_contact_s
+				== VL53L8CX_TRACKER_NO_CONTACT);
+	}
+
+	/* The closing speed and time to contact have converged */
+	TEST_CHECK(fabsf(p_near->closing_speed_mm_s - TEST_SPEED_MM_S) < 5.0f);
+	TEST_CHECK(fabsf(p_near->time_to_contact_s
+			- (p_near->range_mm / p_near->closing_speed_mm_s))
+			< 1e-4f);
+	TEST_CHECK(fabsf(p_near->time_to_contact_s
+			- (distance / TEST_SPEED_MM_S)) < 0.05f);
+	(void)printf("closing at %.1f mm/s, contact in %.3f s\n",
+			(double)p_near->closing_speed_mm_s,
+			(double)p_near->time_to_contact_s);
+}
+
+/*
+ * Obstacles out of the gate start new tracks. Tentative tracks are deleted at
+ * the first missed frame, confirmed ones after max_missed frames, and a time
+ * which does not increase is rejected without changing the tracks.
+ */
+static void _test_lifetime(void)
+{
+	static VL53L8CX_Tracker trk, saved;
+	const VL53L8CX_Track *p_track;
+	uint64_t t_ns = TEST_T0_NS;
+	uint32_t frame;
+
+	vl53l8cx_tracker_init(&trk, NULL);
+	for (frame = 0; frame < 3U; frame++)
+	{
+		seg.nb_obstacles = 0;
+		_test_obstacle(0, 1000.0f, 0.0f);
+		TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns)
+				== VL53L8CX_STATUS_OK);
+		t_ns += TEST_PERIOD_NS;
+	}
+	TEST_CHECK((trk.nb_tracks == 1U) && trk.tracks[0].is_confirmed);
+
+	/* Beyond the range gate, then beyond the angle gate */
+	seg.nb_obstacles = 0;
+	_test_obstacle(0, 1000.0f + (1.01f
+			* VL53L8CX_TRACKER_DEFAULT_GATE_MM), 0.0f);
+	_test_obstacle(1, 1000.0f, 1.01f * VL53L8CX_TRACKER_DEFAULT_GATE_DEG);
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns)
+			== VL53L8CX_STATUS_OK);
+	t_ns += TEST_PERIOD_NS;
+	TEST_CHECK(trk.nb_tracks == 3U);
+	p_track = _test_find(&trk, 1);
+	TEST_CHECK((p_track != NULL) && (p_track->missed == 1U));
+	TEST_CHECK(_test_find(&trk, 2) != NULL);
+	TEST_CHECK(_test_find(&trk, 3) != NULL);
+
+	/* Within the gate again: tracks 2 and 3 were only tentative */
+	seg.nb_obstacles = 0;
+	_test_obstacle(0, 1000.0f + (0.3f
+			* VL53L8CX_TRACKER_DEFAULT_GATE_MM), 0.0f);
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns)
+			== VL53L8CX_STATUS_OK);
+	t_ns += TEST_PERIOD_NS;
+	TEST_CHECK(trk.nb_tracks == 1U);
+	TEST_CHECK(trk.tracks[0].id == 1U);
+	TEST_CHECK(trk.tracks[0].missed == 0U);
+
+	/* Time not increasing */
+	saved = trk;
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns - TEST_PERIOD_NS)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg,
+			t_ns - (2U * TEST_PERIOD_NS))
+			== VL53L8CX_STATUS_INVALID_PARAM);
+	TEST_CHECK(memcmp(&trk, &saved, sizeof(trk)) == 0);
+
+	/* Kept while predicted for max_missed frames, then deleted */
+	seg.nb_obstacles = 0;
+	for (frame = 1; frame <= VL53L8CX_TRACKER_DEFAULT_MAX_MISSED; frame++)
+	{
+		TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns)
+				== VL53L8CX_STATUS_OK);
+		t_ns += TEST_PERIOD_NS;
+		TEST_CHECK(trk.nb_tracks == 1U);
+		TEST_CHECK(trk.tracks[0].missed == frame);
+		TEST_CHECK(trk.tracks[0].obstacle
+				== VL53L8CX_SEGMENT_NO_LABEL);
+	}
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(trk.nb_tracks == 0U);
+
+	/* Ids are not reused */
+	_test_obstacle(0, 1000.0f, 0.0f);
+	TEST_CHECK(vl53l8cx_tracker_update(&trk, &seg, t_ns + TEST_PERIOD_NS)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK((trk.nb_tracks == 1U) && (trk.tracks[0].id == 4U));
+}
+
+int main(void)
+{
+	_test_approach();
+	_test_lifetime();
+
+	(void)printf("test_tracker: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>
+
+#include "vl53l8cx_api.h"
+#include "test_common.h"
+
+#define TEST_NB_FRAMES		20000U
+
+static uint32_t nb_failures;
+static uint32_t seed = 0x12345678U;
+
+/*
+ * Random frame: statuses are mostly 5 and 9, or differ from them by a single
+ * bit, so a byte lane borrowing from its neighbour would be seen. All bytes
+ * are written, including the zones after nb_zones.
+ */
+static void _test_random_frame(
+		VL53L8CX_ResultsData		*p_results)
+{
+	static const uint8_t statuses[] = {5, 9, 5, 9, 0, 1, 4, 8, 13, 0x85,
+		0x89, 255};
+	uint32_t i;
+
+	for (i = 0; i < (VL53L8CX_RESOLUTION_8X8
+			* VL53L8CX_NB_TARGET_PER_ZONE); i++)
+	{
+		p_results->target_status[i] = statuses[test_random(&seed)
+			% sizeof(statuses)];
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+		p_results->distance_mm[i] = (int16_t)((int32_t)(
+			test_random(&seed) % 4200U) - 100);
+#endif
+	}
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	for (i = 0; i < VL53L8CX_RESOLUTION_8X8; i++)
+	{
+		p_results->nb_target_detected[i] = (uint8_t)((test_random(&seed)
+			% 8U) == 0U ? 0U : 1U + (test_random(&seed) % 4U));
+	}
+#endif
+}
+
+/* One zone at a time, as documented into VL53L8CX_ResultsData */
+static void _test_reference(
+		const VL53L8CX_ResultsData	*p_results,
+		uint8_t				nb_zones,
+		uint64_t			*p_mask,
+		int16_t				*p_nearest)
+{
+	uint32_t i, idx;
+	uint8_t is_valid;
+
+	*p_mask = 0;
+	*p_nearest = VL53L8CX_NO_VALID_DISTANCE;
+	for (i = 0; i < nb_zones; i++)
+	{
+		idx = i * (uint32_t)VL53L8CX_NB_TARGET_PER_ZONE;
+		is_valid = (uint8_t)((p_results->target_status[idx] == 5U)
+			|| (p_results->target_status[idx] == 9U));
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+		is_valid &= (uint8_t)(p_results->nb_target_detected[i] != 0U);
+#endif
+		if (is_valid)
+		{
+			*p_mask |= (uint64_t)1 << i;
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+			if (p_results->distance_mm[idx] < *p_nearest)
+			{
+				*p_nearest = p_results->distance_mm[idx];
+			}
+#endif
+		}
+	}
+}
+
+/* The validity mask against the reference, at both resolutions */
+static void _test_random_frames(void)
+{
+	static VL53L8CX_ResultsData results;
+	uint64_t mask;
+	uint32_t n, nb_mismatches = 0;
+	int16_t nearest;
+	uint8_t nb_zones;
+
+	for (n = 0; n < TEST_NB_FRAMES; n++)
+	{
+		nb_zones = ((n % 2U) == 0U) ? VL53L8CX_RESOLUTION_4X4
+			: VL53L8CX_RESOLUTION_8X8;
+		_test_random_frame(&results);
+		_test_reference(&results, nb_zones, &mask, &nearest);
+		TEST_CHECK(vl53l8cx_update_validity(&results, nb_zones)
+				== VL53L8CX_STATUS_OK);
+		if (results.valid_mask != mask)
+		{
+			nb_mismatches++;
+		}
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+		if (results.nearest_valid_mm != nearest)
+		{
+			nb_mismatches++;
+		}
+#else
+		(void)nearest;
+#endif
+	}
+	TEST_CHECK(nb_mismatches == 0U);
+}
+
+/* Frames without valid zone, and every zone valid */
+static void _test_edges(void)
+{
+	static VL53L8CX_ResultsData results;
+	uint32_t i;
+
+	for (i = 0; i < (VL53L8CX_RESOLUTION_8X8
+			* VL53L8CX_NB_TARGET_PER_ZONE); i++)
+	{
+		results.target_status[i] = 255;
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+		results.distance_mm[i] = (int16_t)(100 + i);
+#endif
+	}
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	for (i = 0; i < VL53L8CX_RESOLUTION_8X8; i++)
+	{
+		results.nb_target_detected[i] = 1;
+	}
+#endif
+	TEST_CHECK(vl53l8cx_update_validity(&results, VL53L8CX_RESOLUTION_8X8)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(results.valid_mask == 0U);
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	TEST_CHECK(results.nearest_valid_mm == VL53L8CX_NO_VALID_DISTANCE);
+#endif
+
+	for (i = 0; i < (VL53L8CX_RESOLUTION_8X8
+			* VL53L8CX_NB_TARGET_PER_ZONE); i++)
+	{
+		results.target_status[i] = 5;
+	}
+	TEST_CHECK(vl53l8cx_update_validity(&results, VL53L8CX_RESOLUTION_8X8)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(results.valid_mask == UINT64_MAX);
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	TEST_CHECK(results.nearest_valid_mm == 100);
+#endif
+	TEST_CHECK(vl53l8cx_update_validity(&results, VL53L8CX_RESOLUTION_4X4)
+			== VL53L8CX_STATUS_OK);
+	TEST_CHECK(results.valid_mask == 0xFFFFU);
+
+	TEST_CHECK(vl53l8cx_update_validity(&results, 32)
+			== VL53L8CX_STATUS_INVALID_PARAM);
+}
+
+int main(void)
+{
+	_test_random_frames();
+	_test_edges();
+
+	(void)printf("test_validity: %s\n", (nb_failures == 0U) ? "OK"
+			: "FAILED");
+
+	return (nb_failures == 0U) ? 0 : 1;
+}